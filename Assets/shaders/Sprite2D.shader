@@ -0,0 +1,2 @@
+#Vertex shaders/spv/Sprite2D.vert.spv
+#Fragment shaders/spv/Batch2D.frag.spv
\ No newline at end of file
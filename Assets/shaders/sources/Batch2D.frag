@@ -9,17 +9,17 @@ layout (location = 0) in OutData
 	vec3 position;
 	vec2 uv;
 	vec4 color;
-	int textureID;
+	int layer;
 } data;
 
-layout(set = 1, binding = 0) uniform sampler2D textures[16];
+layout(set = 1, binding = 0) uniform sampler2DArray pages;
 
 void main()
 {
 	vec4 texColor = data.color;
-    if (data.textureID >= 0)
+    if (data.layer >= 0)
     {
-        texColor *= texture(textures[data.textureID], data.uv);
+        texColor *= texture(pages, vec3(data.uv, data.layer));
     }
 	outColor = texColor;
 }
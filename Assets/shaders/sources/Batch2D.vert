@@ -16,7 +16,7 @@ layout (location = 0) out OutData
 	vec3 position;
 	vec2 uv;
 	vec4 color;
-	int textureID;
+	int layer;
 } data;
 
 void main()
@@ -24,6 +24,6 @@ void main()
 	gl_Position =  ubo.projView * vec4(position,1.0);
 	data.position = position;
 	data.uv = uv.xy;
-	data.textureID = int(uv.z - 0.5);
+	data.layer = int(uv.z - 0.5);
 	data.color = inColor;
 }
\ No newline at end of file
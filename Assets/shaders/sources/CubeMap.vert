@@ -19,10 +19,6 @@ out gl_PerVertex
 };
 
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec4 inColor;
-layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
 
 
 layout(location = 0) out vec3 outPosition;
@@ -7,16 +7,26 @@ layout(set = 0,binding = 0) uniform UniformBufferObject
 	mat4 projView;
 } ubo;
 
-layout(push_constant) uniform PushConsts
+//one transform per instance, the draw passes the offset of its run as firstInstance.
+layout(set = 0,binding = 1) readonly buffer InstanceBuffer
 {
-	mat4 transform;
-} pushConsts;
+	mat4 transforms[];
+} instances;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec4 inColor;
 layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
+layout(location = 3) in vec2 inNormal;
+layout(location = 4) in vec2 inTangent;
+
+//normals and tangents are octahedral encoded (VertexFormat.h)
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
 
 
 layout(location = 0) out vec3 fragColor;
@@ -34,12 +44,13 @@ out gl_PerVertex
 
 void main() 
 {
-	fragPosition =  pushConsts.transform * vec4(inPosition, 1.0);
+	mat4 transform = instances.transforms[gl_InstanceIndex];
+	fragPosition =  transform * vec4(inPosition, 1.0);
     gl_Position = ubo.projView * fragPosition;
     
     fragColor = inColor.xyz;
 	fragTexCoord = inTexCoord;
-    fragNormal = transpose(inverse(mat3(pushConsts.transform))) * normalize(inNormal);
+    fragNormal = transpose(inverse(mat3(transform))) * decodeOctahedral(inNormal);
     
-    fragTangent = inTangent;
+    fragTangent = decodeOctahedral(inTangent);
 }
\ No newline at end of file
@@ -91,8 +91,28 @@ layout(std140, binding = 0) uniform UniformBufferLight
 	int padding1;
 	int padding2;
 	int padding3;
+
+	ivec4 clusterGrid;//x, y, z, enabled
+	vec4 clusterDepth;//near, far, scale, bias
 } ubo;
 
+//point and spot lights, binned per cluster on the cpu
+layout(std430, set = 0, binding = 1) readonly buffer LightBuffer
+{
+	Light localLights[];
+};
+
+//offset and count into lightIndices for every cluster
+layout(std430, set = 0, binding = 2) readonly buffer ClusterBuffer
+{
+	uvec2 clusters[];
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
 
 const vec2 poissonDistribution16[16] = vec2[](
 		vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725), vec2(-0.094184101, -0.92938870), vec2(0.34495938, 0.29387760),
@@ -337,6 +357,35 @@ float calculateShadow(vec3 wsPos, int cascadeIndex, float bias, vec3 lightDirect
 	return PCSS_DirectionalLight(uShadowMap, shadowCoord * ( 1.0 / shadowCoord.w), ubo.lightSize, lightDirection, normal, wsPos, cascadeIndex );
 }
 
+vec3 brdf(vec3 F0, vec3 Li, vec3 Lradiance, Material material)
+{
+	vec3 Lh = normalize(Li + material.view);//half vector
+
+	// Calculate angles between surface normal and various light vectors.
+	float cosLi = max(0.0, dot(material.normal, Li));
+	float cosLh = max(0.0, dot(material.normal, Lh));
+
+//(Fresnel Rquation)
+//(Normal Distribution Function)
+//(Geometry Function)
+
+	vec3  F = fresnelSchlick(F0, max(0.0, dot(Lh, material.view)));
+	float D = ndfGGX(cosLh, material.roughness);
+	float G = geometrySmith(cosLi, material.normalDotV, material.roughness);
+	//diffuse
+	vec3 kd = (1.0 - F) * (1.0 - material.metallic.x);
+	vec3 diffuseBRDF = kd * material.albedo.xyz;
+//
+//				D * F * G
+//BRDF = ---------------------
+//			4(wo dot n)(wi dot n)
+
+	// Cook-Torrance
+	vec3 specularBRDF = (F * D * G) / max(Epsilon, 4.0 * cosLi * material.normalDotV);
+
+	return (diffuseBRDF + specularBRDF) * Lradiance * cosLi;
+}
+
 vec3 lighting(vec3 F0, vec3 fragPos, Material material,int cascadeLevel)
 {
 	vec3 result = vec3(0.0);
@@ -351,35 +400,51 @@ vec3 lighting(vec3 F0, vec3 fragPos, Material material,int cascadeLevel)
 	    float bias = ubo.bias;
 		bias = bias + (bias * tan(acos(clamp(dot(material.normal, light.direction.xyz), 0.0, 1.0))) * 0.5);
 		value = calculateShadow(fragPos,cascadeLevel, bias, light.direction.xyz, material.normal);
-		
 
 		vec3 Li = light.direction.xyz;//input 
 		vec3 Lradiance = light.color.xyz * light.intensity;//radiance
-		vec3 Lh = normalize(Li + material.view);//half vector
 
-		// Calculate angles between surface normal and various light vectors.
-		float cosLi = max(0.0, dot(material.normal, Li));
-		float cosLh = max(0.0, dot(material.normal, Lh));
+		result += brdf(F0, Li, Lradiance, material) * value * material.ao;
+	}
+	return result;
+}
 
-//(Fresnel Rquation)
-//(Normal Distribution Function)��
-//(Geometry Function)
+#define SPOT_LIGHT 1.0
 
-		vec3  F = fresnelSchlick(F0, max(0.0, dot(Lh, material.view)));
-		float D = ndfGGX(cosLh, material.roughness);
-		float G = geometrySmith(cosLi, material.normalDotV, material.roughness);
-		//diffuse
-		vec3 kd = (1.0 - F) * (1.0 - material.metallic.x);
-		vec3 diffuseBRDF = kd * material.albedo.xyz;
-//
-//				D * F * G
-//BRDF = ---------------------
-//			4(wo dot n)(wi dot n)
+vec3 localLighting(vec3 F0, vec3 fragPos, Material material)
+{
+	if(ubo.clusterGrid.w == 0)
+		return vec3(0.0);
 
-		// Cook-Torrance
-		vec3 specularBRDF = (F * D * G) / max(Epsilon, 4.0 * cosLi * material.normalDotV);
+	float depth = -(ubo.viewPos * vec4(fragPos, 1.0)).z;
+	int slice = int(log(max(depth, ubo.clusterDepth.x)) * ubo.clusterDepth.z + ubo.clusterDepth.w);
+	ivec3 cluster = clamp(ivec3(ivec2(fragTexCoord * vec2(ubo.clusterGrid.xy)), slice), ivec3(0), ubo.clusterGrid.xyz - 1);
+	uvec2 range = clusters[cluster.x + ubo.clusterGrid.x * (cluster.y + ubo.clusterGrid.y * cluster.z)];
+
+	vec3 result = vec3(0.0);
+	for(uint i = 0; i < range.y; i++)
+	{
+		Light light = localLights[lightIndices[range.x + i]];
+
+		vec3 L = light.position.xyz - fragPos;
+		float dist = length(L);
+		if(dist >= light.radius)
+			continue;
+
+		vec3 Li = L / max(dist, Epsilon);
+		//smooth window, reaches zero at the radius used for binning
+		float falloff = clamp(1.0 - pow(dist / light.radius, 4.0), 0.0, 1.0);
+		float attenuation = falloff * falloff / (dist * dist + 1.0);
+
+		//same convention as the directional lights : direction points towards the light
+		if(light.type == SPOT_LIGHT)
+		{
+			float cosTheta = dot(Li, normalize(light.direction.xyz));
+			attenuation *= smoothstep(light.angle, mix(light.angle, 1.0, 0.1), cosTheta);
+		}
 
-		result += (diffuseBRDF + specularBRDF) * Lradiance * cosLi * value * material.ao;
+		vec3 Lradiance = light.color.xyz * light.intensity * attenuation;
+		result += brdf(F0, Li, Lradiance, material) * material.ao;
 	}
 	return result;
 }
@@ -412,7 +477,7 @@ void main()
 	vec3 F0 = mix(FresnelDielectric, material.albedo.xyz, material.metallic.x);
 
 
-	vec3 lightPart = lighting(F0, fragPosXyzw.xyz, material,cascadeIndex); 
+	vec3 lightPart = lighting(F0, fragPosXyzw.xyz, material,cascadeIndex) + localLighting(F0, fragPosXyzw.xyz, material); 
 	vec3 iblPart = ibl(F0, Lr, material) * 2.0;
 	vec3 finalColour = lightPart + iblPart;// + material.emissive;
 	outColor = vec4(finalColour, 1.0);
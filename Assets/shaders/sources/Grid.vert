@@ -3,10 +3,7 @@
 #extension GL_ARB_shading_language_420pack : enable
 
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec4 inColor;
 layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
 
 layout(set = 0,binding = 0) uniform UniformBufferObject 
 {    
@@ -25,6 +22,5 @@ void main()
 {
     gl_Position  = ubo.mvp * vec4(inPosition, 1.0);
 	fragPosition = inPosition;
-	vec4 test = inColor; //SPV vertex layout incorrect when inColor not used
 	fragTexCoord = inTexCoord;
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+//unit quad, (0,0) (1,0) (1,1) (0,1)
+layout (location = 0) in vec2 inCorner;
+//one SpriteInstance per sprite, inputs named inst* advance per instance
+layout (location = 1) in vec4 instAxes;
+layout (location = 2) in vec4 instOrigin;
+layout (location = 3) in uvec2 instTexCoords;
+layout (location = 4) in uint instColor;
+
+layout(set = 0,binding = 0) uniform UniformBufferObject
+{
+	mat4 projView;
+} ubo;
+
+layout (location = 0) out OutData
+{
+	vec3 position;
+	vec2 uv;
+	vec4 color;
+	int layer;
+} data;
+
+void main()
+{
+	vec3 position = instOrigin.xyz + vec3(instAxes.xy * inCorner.x + instAxes.zw * inCorner.y, 0.0);
+	gl_Position =  ubo.projView * vec4(position,1.0);
+	data.position = position;
+	data.uv = mix(unpackUnorm2x16(instTexCoords.x), unpackUnorm2x16(instTexCoords.y), inCorner);
+	data.layer = int(instOrigin.w - 0.5);
+	data.color = unpackUnorm4x8(instColor);
+}
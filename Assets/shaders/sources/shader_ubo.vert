@@ -10,7 +10,16 @@ layout(set = 0,binding = 0) uniform UniformBufferObject {
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec4 inColor;
 layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
+layout(location = 3) in vec2 inNormal;
+
+//normals and tangents are octahedral encoded (VertexFormat.h)
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
 
 
 layout(location = 0) out vec4 fragColor;
@@ -22,7 +31,7 @@ void main() {
     gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
-	fragNormal =  mat3(transpose(inverse(ubo.model))) * inNormal;
+	fragNormal =  mat3(transpose(inverse(ubo.model))) * decodeOctahedral(inNormal);
 	vec4 pos =  ubo.model * vec4(inPosition,1.0);
 	fragPos = pos.xyz / pos.w;
 }
\ No newline at end of file
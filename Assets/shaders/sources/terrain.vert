@@ -18,7 +18,16 @@ layout(set = 0,binding = 1) uniform sampler2D heightMap;
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec4 inColor;
 layout(location = 2) in vec2 inTexCoord;
-layout(location = 3) in vec3 inNormal;
+layout(location = 3) in vec2 inNormal;
+
+//normals and tangents are octahedral encoded (VertexFormat.h)
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
 
 
 layout(location = 0) out vec4 fragColor;
@@ -59,7 +68,7 @@ void calPosAndNormal(inout vec3 pos, inout vec3 normal,inout vec2 texCoord)
 void main() {
 	
 	vec3 inPos = inPosition;
-	vec3 normal = inNormal;
+	vec3 normal = decodeOctahedral(inNormal);
 	vec2 texCoord = inTexCoord;
 
 	if(ubo.calInVertex == 1){
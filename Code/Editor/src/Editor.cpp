@@ -15,11 +15,13 @@
 #include "PropertiesWindow.h"
 #include "AssetsWindow.h"
 #include "DisplayZeroWindow.h"
+#include "MemoryWindow.h"
 
 #include "Engine/TextureAtlas.h"
 #include "Engine/Camera.h"
 #include "Scene/Scene.h"
 #include "Scene/SceneManager.h"
+#include "Scene/SceneBVH.h"
 #include "Scene/Component/Component.h"
 #include "Scene/Component/Transform.h"
 #include "Scene/Component/Light.h"
@@ -32,6 +34,7 @@
 #include "FileSystem/File.h"
 #include "FileSystem/MeshLoader.h"
 #include "Others/StringUtils.h"
+#include "Others/Serialization.h"
 #include "Scene/Component/MeshRenderer.h"
 
 #include "Engine/Renderer/RenderManager.h"
@@ -85,6 +88,7 @@ namespace Maple
 		addWindow(HierarchyWindow);
 		addWindow(PropertiesWindow);
 		addWindow(AssetsWindow); 
+		addWindow(MemoryWindow);
 	
 
 	
@@ -423,6 +427,11 @@ namespace Maple
 				if (ImGui::MenuItem("Save (Ctrl + S)")) {
 					serialize();
 				}
+
+				if (ImGui::MenuItem("Cook Binary Scene")) {
+					auto scene = getSceneManager()->getCurrentScene();
+					Serialization::serializeBinary(scene, Serialization::getBinaryPath(scene->getPath()));
+				}
 				ImGui::EndMenu();
 			}
 
@@ -439,6 +448,16 @@ namespace Maple
 				ImGui::EndMenu();
 			}
 
+			if (ImGui::BeginMenu("Window"))
+			{
+				auto memoryWindow = getEditorWindow<MemoryWindow>();
+				if (ImGui::MenuItem("Memory", nullptr, memoryWindow->isActive()))
+				{
+					memoryWindow->setActive(!memoryWindow->isActive());
+				}
+				ImGui::EndMenu();
+			}
+
 			if (ImGui::BeginMenu("GBuffer"))
 			{
 				auto event = std::make_unique<DeferredTypeEvent>();
@@ -733,6 +752,7 @@ namespace Maple
 			cacheIcons[static_cast<FileType>(i++)] = str;
 			textureAtlas->addSprite(str);
 		}
+		textureAtlas->flush();
 	}
 
 	auto Editor::addPlugin(EditorPlugin* plugin) -> void
@@ -750,27 +770,7 @@ namespace Maple
 		auto& registry = getSceneManager()->getCurrentScene()->getRegistry();
 	
 		float closestDist = INFINITY;
-		entt::entity closestEntity = entt::null;
-
-		auto group = registry.group<MeshRenderer>(entt::get<Transform>);
-		for (auto entity : group)
-		{
-			const auto& [mesh, trans] = group.get<MeshRenderer, Transform>(entity);
-			if (mesh.getMesh() != nullptr)
-			{
-				auto& worldTransform = trans.getWorldMatrix();
-
-				auto bbCopy = mesh.getMesh()->getBoundingBox()->transform(worldTransform);
-				float dist = ray.hit(bbCopy);
-				LOGI("dist {0} {1}", (int32_t)entity, dist);
-				if (dist < INFINITY && dist < closestDist)
-				{
-					closestDist = dist;
-					closestEntity = entity;
-				}
-			}
-		}
-
+		entt::entity closestEntity = getSceneManager()->getCurrentScene()->getBVH()->rayCast(ray, closestDist);
 	
 		static auto lastClick = timer.current();
 		
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "MemoryWindow.h"
+#include "Engine/Vulkan/VulkanAllocator.h"
+#include "Engine/Vulkan/VulkanRingBuffer.h"
+#include "Engine/Vulkan/VulkanUploadQueue.h"
+#include "Engine/MaterialPool.h"
+#include <imgui.h>
+
+namespace Maple 
+{
+	namespace
+	{
+		inline auto toMB(VkDeviceSize size) -> float
+		{
+			return size / (1024.f * 1024.f);
+		}
+	};
+
+	MemoryWindow::MemoryWindow()
+	{
+		title = "Memory";
+	}
+
+	auto MemoryWindow::onImGui() -> void
+	{
+		if (!active)
+			return;
+
+		if (ImGui::Begin(title.c_str(), &active))
+		{
+			auto allocator = VulkanAllocator::get();
+			auto stats = allocator->getPoolStats();
+
+			VkDeviceSize reserved = 0;
+			VkDeviceSize used = 0;
+			for (auto& stat : stats)
+			{
+				reserved += stat.reserved;
+				used += stat.used;
+			}
+
+			ImGui::Text("Reserved : %.2f MB, Used : %.2f MB, Block Size : %.0f MB", toMB(reserved), toMB(used), toMB(allocator->getBlockSize()));
+
+			auto ring = VulkanRingBuffer::get();
+			ImGui::Text("Frame Ring : %.2f / %.2f MB", toMB(ring->getUsed()), toMB(ring->getFrameSize()));
+			auto uploadQueue = VulkanUploadQueue::get();
+			ImGui::Text("Upload Batches In Flight : %d, Pending : %.2f MB", static_cast<int32_t>(uploadQueue->getInFlightCount()), toMB(uploadQueue->getPendingBytes()));
+
+			auto materialPool = MaterialPool::get();
+			ImGui::Text("Materials : %u in %u buffers, %u bytes per slot", materialPool->getCount(), materialPool->getPageCount(), materialPool->getStride());
+
+			if (ImGui::Button("Defragment"))
+			{
+				lastReleased = allocator->defragment();
+			}
+			ImGui::SameLine();
+			ImGui::Text("Released Blocks : %u", lastReleased);
+
+			ImGui::Separator();
+			ImGui::Columns(8);
+			for (auto name : { "Type", "Tiling", "Flags", "Blocks", "Dedicated", "Allocations", "Used / Reserved (MB)", "Largest Free (MB)" })
+			{
+				ImGui::TextUnformatted(name);
+				ImGui::NextColumn();
+			}
+			ImGui::Separator();
+
+			for (auto& stat : stats)
+			{
+				ImGui::Text("%u", stat.memoryType);
+				ImGui::NextColumn();
+				ImGui::TextUnformatted(stat.linear ? "Linear" : "Optimal");
+				ImGui::NextColumn();
+				ImGui::Text("%s%s%s",
+					stat.flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ? "Device " : "",
+					stat.flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ? "Host " : "",
+					stat.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT ? "Coherent" : "");
+				ImGui::NextColumn();
+				ImGui::Text("%u", stat.blockCount);
+				ImGui::NextColumn();
+				ImGui::Text("%u", stat.dedicatedCount);
+				ImGui::NextColumn();
+				ImGui::Text("%u", stat.allocationCount);
+				ImGui::NextColumn();
+				ImGui::Text("%.2f / %.2f", toMB(stat.used), toMB(stat.reserved));
+				ImGui::NextColumn();
+				//free space split in many small ranges is fragmentation
+				ImGui::Text("%.2f (%u ranges)", toMB(stat.largestFree), stat.freeRangeCount);
+				ImGui::NextColumn();
+			}
+			ImGui::Columns(1);
+		}
+		ImGui::End();
+	}
+};
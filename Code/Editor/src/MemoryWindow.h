@@ -0,0 +1,21 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma  once
+#include <string>
+#include "EditorWindow.h"
+
+namespace Maple 
+{
+	//GPU memory pools of the Vulkan allocator.
+	class MemoryWindow : public EditorWindow
+	{
+	public:
+		MemoryWindow();
+		virtual auto onImGui() -> void override;
+	private:
+		uint32_t lastReleased = 0;
+	};
+};
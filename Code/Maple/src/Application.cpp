@@ -35,6 +35,8 @@
 #include <imgui_impl_glfw.h>
 
 #include "Engine/Vulkan/VulkanContext.h"
+#include "Engine/Vulkan/VulkanDevice.h"
+#include "Engine/Vulkan/VulkanPipeline.h"
 #include "Scripts/Mono/MonoVirtualMachine.h"
 
 //Maple::Application* app;
@@ -48,8 +50,9 @@ namespace Maple
 		sceneManager		= std::make_unique<SceneManager>();
 		rendererDevice		= std::make_unique<VkRenderDevice>(window->getWidth(), window->getHeight());
 		imGuiManager		= std::make_unique<ImGuiSystem>(false);
-		threadPool			= std::make_unique<ThreadPool>(4);
+		threadPool			= std::make_unique<ThreadPool>(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
 		texturePool			= std::make_unique<TexturePool>();
+		assetStreamer		= std::make_unique<AssetStreamer>(*threadPool);
 		luaVm				= std::make_unique<LuaVirtualMachine>();
 		monoVm				= std::make_shared<MonoVirtualMachine>();
 		systemManager		= std::make_unique<SystemManager>();
@@ -58,6 +61,7 @@ namespace Maple
 	auto Application::init() -> void
 	{
 		PROFILE_FUNCTION();
+		const auto initBegin = timer.current();
 		Input::create();
 		window->init();
 		timer.start();
@@ -81,6 +85,13 @@ namespace Maple
 		systemManager->addSystem<MonoSystem>()->onInit();
 		imGuiManager = systemManager->addSystem<ImGuiSystem>(false);
 		imGuiManager->onInit();
+
+		//pipelines are compiled on the workers while the rest of the init runs.
+		//the cache is saved as soon as they are done, the process is usually killed rather than shut down.
+		VulkanPipeline::waitAllCompiled();
+		VulkanDevice::get()->savePipelineCache();
+		LOGI("Startup : {0} ms ({1} pipeline cache)", timer.elapsed(initBegin, timer.current()) / 1000.f,
+			VulkanDevice::get()->getLoadedPipelineCacheSize() > 0 ? "warm" : "cold");
 	}
 
 	auto Application::start() -> int32_t
@@ -101,6 +112,7 @@ namespace Maple
 				sceneManager->apply();
 				//auto tStart = std::chrono::high_resolution_clock::now();
 				executeAll();
+				assetStreamer->update();
 				onUpdate(timestep);
 				onRender();
 
@@ -150,6 +162,7 @@ namespace Maple
 			}
 		}
 
+		texturePool->flush();
 		rendererDevice->begin();
 
 		for (auto& r : renderManagers)
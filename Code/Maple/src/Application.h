@@ -22,6 +22,7 @@
 #include "Engine/Renderer/DebugRenderer.h"
 #include "Thread/ThreadPool.h"
 #include "Engine/TexturePool.h"
+#include "Engine/AssetStreamer.h"
 #include "Scene/System/SystemManager.h"
 #include "Scripts/Lua/LuaVirtualMachine.h"
 
@@ -96,6 +97,7 @@ namespace Maple
 		template<class T>
 		inline auto getAppDelegate() { return std::static_pointer_cast<T>(appDelegate); }
 		inline auto& getTexturePool() { return texturePool; }
+		inline auto& getAssetStreamer() { return assetStreamer; }
 		inline auto& getLuaVirtualMachine() { return luaVm; }
 		inline auto& getSystemManager() { return systemManager; }
 		inline auto& getMonoVm() { return monoVm; }
@@ -110,6 +112,7 @@ namespace Maple
 		std::unique_ptr<SceneManager> sceneManager;
 		std::unique_ptr<ThreadPool>	  threadPool;
 		std::unique_ptr<TexturePool>  texturePool;
+		std::unique_ptr<AssetStreamer> assetStreamer;
 		std::unique_ptr<LuaVirtualMachine>  luaVm;
 		std::shared_ptr<MonoVirtualMachine> monoVm;
 		std::unique_ptr<SystemManager> systemManager;
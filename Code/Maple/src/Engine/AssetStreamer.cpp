@@ -0,0 +1,196 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "AssetStreamer.h"
+#include "Engine/Interface/Texture.h"
+#include "Engine/Profiler.h"
+#include "FileSystem/ImageLoader.h"
+#include "FileSystem/File.h"
+#include "Resources/TextureCache.h"
+#include "Thread/ThreadPool.h"
+#include "Others/Console.h"
+#include <algorithm>
+
+namespace Maple
+{
+	namespace
+	{
+		//box filter RGBA8 pixels down until the largest side fits maxSize.
+		inline auto downsample(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t maxSize, std::vector<uint8_t>& out, uint32_t& outWidth, uint32_t& outHeight) -> void
+		{
+			uint32_t factor = 1;
+			while (std::max(width, height) / factor > maxSize)
+				factor *= 2;
+
+			outWidth = std::max(1u, width / factor);
+			outHeight = std::max(1u, height / factor);
+			out.resize(outWidth * outHeight * 4);
+
+			for (uint32_t y = 0; y < outHeight; y++)
+			{
+				for (uint32_t x = 0; x < outWidth; x++)
+				{
+					uint32_t sum[4] = {};
+					uint32_t count = 0;
+					for (uint32_t sy = y * factor; sy < std::min(height, (y + 1) * factor); sy++)
+					{
+						for (uint32_t sx = x * factor; sx < std::min(width, (x + 1) * factor); sx++)
+						{
+							const auto src = pixels + (sy * width + sx) * 4;
+							sum[0] += src[0];
+							sum[1] += src[1];
+							sum[2] += src[2];
+							sum[3] += src[3];
+							count++;
+						}
+					}
+					auto dst = out.data() + (y * outWidth + x) * 4;
+					for (int32_t c = 0; c < 4; c++)
+						dst[c] = static_cast<uint8_t>(sum[c] / std::max(count, 1u));
+				}
+			}
+		}
+	};
+
+	AssetStreamer::AssetStreamer(ThreadPool& pool, uint64_t frameBudget)
+		:pool(pool), frameBudget(frameBudget)
+	{
+	}
+
+	AssetStreamer::~AssetStreamer()
+	{
+		//jobs capture this, wait for them and discard their results as update() is not called anymore.
+		while (pendingCount.load() > 0)
+		{
+			std::deque<std::unique_ptr<Decoded>> ready;
+			{
+				std::lock_guard<std::mutex> lock(decodedMutex);
+				ready.swap(decoded);
+			}
+
+			for (auto& item : ready)
+			{
+				pendingCount.fetch_sub(1, std::memory_order_relaxed);
+				fail(item->target);
+			}
+
+			if (ready.empty() && !pool.helpOne())
+				std::this_thread::yield();
+		}
+
+		for (auto& item : fullUploads)
+			fail(item->target);
+	}
+
+	auto AssetStreamer::loadTexture(const std::string& path) -> std::shared_ptr<StreamedTexture>
+	{
+		PROFILE_FUNCTION();
+		if (auto iter = textures.find(path); iter != textures.end())
+		{
+			if (auto streamed = iter->second.lock())
+				return streamed;
+		}
+
+		uint32_t whiteTextureData = 0xffffffff;
+		auto streamed = std::make_shared<StreamedTexture>();
+		streamed->path = path;
+		streamed->future = streamed->promise.get_future().share();
+		streamed->texture = Texture2D::createFromSource(1, 1, (uint8_t*)&whiteTextureData);
+		streamed->texture->setFilePath(path);
+		//Texture2D::create(path) returns the streamed texture from now on
+		TextureCache::add(path, streamed->texture);
+		textures[path] = streamed;
+
+		pendingCount.fetch_add(1, std::memory_order_relaxed);
+		pool.addTask([this, streamed]() -> void* {
+			decode(streamed);
+			return nullptr;
+		});
+		return streamed;
+	}
+
+	auto AssetStreamer::decode(const std::shared_ptr<StreamedTexture>& target) -> void
+	{
+		PROFILE_FUNCTION();
+		auto result = std::make_unique<Decoded>();
+		result->target = target;
+
+		if (File::fileExists(target->path))
+		{
+			result->image = ImageLoader::loadAsset(target->path);
+			if (result->image->getPixelFormat() == TextureFormat::RGBA8)
+			{
+				downsample(reinterpret_cast<const uint8_t*>(result->image->getData()),
+					result->image->getWidth(), result->image->getHeight(), LOW_MIP_SIZE,
+					result->low, result->lowWidth, result->lowHeight);
+			}
+			else
+			{
+				LOGW("{0} : only 8 bit images can be streamed", target->path);
+				result->image.reset();
+			}
+		}
+		else
+		{
+			LOGW("{0} : file does not exist", target->path);
+		}
+
+		std::lock_guard<std::mutex> lock(decodedMutex);
+		decoded.emplace_back(std::move(result));
+	}
+
+	auto AssetStreamer::fail(const std::shared_ptr<StreamedTexture>& target) -> void
+	{
+		target->quality.store(StreamedTexture::Quality::Failed, std::memory_order_release);
+		target->promise.set_value(nullptr);
+	}
+
+	auto AssetStreamer::update() -> void
+	{
+		PROFILE_FUNCTION();
+		std::deque<std::unique_ptr<Decoded>> ready;
+		{
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			ready.swap(decoded);
+		}
+
+		//the low mips are small, all of them go out in the frame they arrive.
+		for (auto& item : ready)
+		{
+			pendingCount.fetch_sub(1, std::memory_order_relaxed);
+			if (item->image == nullptr)
+			{
+				fail(item->target);
+				continue;
+			}
+
+			auto target = item->target;
+			target->texture->uploadAsync(item->lowWidth, item->lowHeight, item->low.data(), true, [target]() {
+				auto expected = StreamedTexture::Quality::Placeholder;
+				target->quality.compare_exchange_strong(expected, StreamedTexture::Quality::Low, std::memory_order_acq_rel);
+			});
+			item->low.clear();
+			item->low.shrink_to_fit();
+			fullUploads.emplace_back(std::move(item));
+		}
+
+		uint64_t bytes = 0;
+		//at least one full image per frame, so a single image larger than the budget still gets through.
+		while (!fullUploads.empty() && (bytes == 0 || bytes + fullUploads.front()->image->getImageSize() <= frameBudget))
+		{
+			auto item = std::move(fullUploads.front());
+			fullUploads.pop_front();
+
+			auto& image = item->image;
+			auto target = item->target;
+			bytes += image->getImageSize();
+			target->texture->uploadAsync(image->getWidth(), image->getHeight(), reinterpret_cast<const uint8_t*>(image->getData()), image->isGenerateMipmaps(), [target]() {
+				target->quality.store(StreamedTexture::Quality::Full, std::memory_order_release);
+				target->promise.set_value(target->texture);
+			});
+		}
+		PROFILE_PLOT("Streamed Bytes", static_cast<int64_t>(bytes));
+	}
+};
@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <unordered_map>
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	class Texture2D;
+	class Image;
+	class ThreadPool;
+
+	//Handle of a streamed texture.
+	//getTexture() is valid right away and is refined in place : placeholder -> low mip -> full image.
+	class MAPLE_EXPORT StreamedTexture
+	{
+	public:
+		enum class Quality : uint8_t
+		{
+			Placeholder,
+			Low,
+			Full,
+			Failed
+		};
+
+		inline auto& getTexture() const { return texture; }
+		inline auto& getPath() const { return path; }
+		inline auto getQuality() const { return quality.load(std::memory_order_acquire); }
+		//ready once the full image is in use (nullptr if the file could not be loaded).
+		inline auto& getFuture() const { return future; }
+
+	private:
+		friend class AssetStreamer;
+		std::string path;
+		std::shared_ptr<Texture2D> texture;
+		std::atomic<Quality> quality{ Quality::Placeholder };
+		std::promise<std::shared_ptr<Texture2D>> promise;
+		std::shared_future<std::shared_ptr<Texture2D>> future;
+	};
+
+	//Reads and decodes on the worker threads, uploads on the main thread through the batched upload queue
+	//with a per-frame byte budget.
+	class MAPLE_EXPORT AssetStreamer final
+	{
+	public:
+		//largest side of the low mip which is uploaded first.
+		static constexpr uint32_t LOW_MIP_SIZE = 64;
+
+		AssetStreamer(ThreadPool& pool, uint64_t frameBudget = 32 * 1024 * 1024);
+		~AssetStreamer();
+
+		//main thread.
+		auto loadTexture(const std::string& path) -> std::shared_ptr<StreamedTexture>;
+		//main thread, once per frame before rendering.
+		auto update() -> void;
+
+		inline auto setFrameBudget(uint64_t bytes) { frameBudget = bytes; }
+		inline auto getFrameBudget() const { return frameBudget; }
+		inline auto getPendingCount() const { return pendingCount.load(std::memory_order_relaxed); }
+
+	private:
+		struct Decoded
+		{
+			std::shared_ptr<StreamedTexture> target;
+			std::unique_ptr<Image> image;
+			std::vector<uint8_t> low;
+			uint32_t lowWidth = 0;
+			uint32_t lowHeight = 0;
+		};
+
+		auto decode(const std::shared_ptr<StreamedTexture>& target) -> void;
+		auto fail(const std::shared_ptr<StreamedTexture>& target) -> void;
+
+		ThreadPool& pool;
+		uint64_t frameBudget;
+		std::atomic<int32_t> pendingCount{ 0 };
+
+		std::unordered_map<std::string, std::weak_ptr<StreamedTexture>> textures;
+
+		//filled by the workers
+		std::mutex decodedMutex;
+		std::deque<std::unique_ptr<Decoded>> decoded;
+
+		//main thread
+		std::deque<std::unique_ptr<Decoded>> fullUploads;
+	};
+};
@@ -25,7 +25,8 @@ namespace Maple
 	{
 		UNIFORM_BUFFER,
 		UNIFORM_BUFFER_DYNAMIC,
-		IMAGE_SAMPLER
+		IMAGE_SAMPLER,
+		STORAGE_BUFFER
 	};
 
 
@@ -30,6 +30,7 @@ namespace Maple
 		//will be used in future
 		bool transparencyEnabled;
 		bool depthBiasEnabled;
+		bool depthClampEnabled = false;
 		bool depthWriteEnable = true;
 		bool depthTestEnable = true;
 	};
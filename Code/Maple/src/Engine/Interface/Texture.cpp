@@ -79,6 +79,11 @@ namespace Maple
 	}
 
 
+	auto Texture2DArray::create(uint32_t width, uint32_t height, uint32_t count) ->std::shared_ptr<Texture2DArray>
+	{
+		return std::make_shared<VulkanTexture2DArray>(width, height, count);
+	}
+
 	auto TextureDepthArray::create(uint32_t width, uint32_t height, uint32_t count) ->std::shared_ptr<TextureDepthArray>
 	{
 		return std::make_shared<VulkanTextureDepthArray>(width, height, count);
@@ -9,6 +9,8 @@
 #include "ktx.h"
 #include <memory>
 #include <string>
+#include <functional>
+#include <vector>
 #include "Engine/Core.h"
 
 namespace Maple
@@ -16,6 +18,15 @@ namespace Maple
 	class FrameBuffer;
 	class CommandBuffer;
 
+	//rectangle of a texture in pixels
+	struct TextureRegion
+	{
+		uint32_t x = 0;
+		uint32_t y = 0;
+		uint32_t w = 0;
+		uint32_t h = 0;
+	};
+
 	class MAPLE_EXPORT Texture {
 	public:
 		Texture() = default;
@@ -23,7 +34,8 @@ namespace Maple
 		virtual ~Texture() = default;
 		inline auto getWidth() const { return width; }
 		inline auto getHeight() const { return height; }
-		
+		//changes when the underlying image is replaced, descriptor sets which reference the texture need to be updated.
+		inline auto getVersion() const { return version; }
 
 		//implement by user
 		virtual auto getHandle() const -> void* { return nullptr; };
@@ -33,6 +45,7 @@ namespace Maple
 	protected:
 		uint32_t width = 0;
 		uint32_t height = 0;
+		uint32_t version = 0;
 	};
 
 	class MAPLE_EXPORT Texture2D : public Texture {
@@ -47,9 +60,16 @@ namespace Maple
 		virtual auto buildTexture(TextureFormat internalformat, uint32_t width, uint32_t height, bool srgb, bool depth, bool samplerShadow) ->void = 0;
 		auto loadKTXFile(std::string filename, ktxTexture** target)->ktxResult;
 		inline auto getFilePath() const -> const std::string& { return fileName; };
+		inline auto setFilePath(const std::string& path) -> void { fileName = path; };
 		inline auto getMipmapLevel() const { return mipLevels; }
 
 		virtual auto update(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint8_t* data) -> void{};
+		//copy the regions of pixels, RGBA8 with the size of the texture, without stalling the frame.
+		//all the regions go up in one copy of the batched uploads.
+		virtual auto update(const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void {};
+		//replace the content with RGBA8 pixels without stalling the frame.
+		//the old image is used until the upload is finished, onReady is called on the main thread after the swap.
+		virtual auto uploadAsync(uint32_t w, uint32_t h, const uint8_t* data, bool mipmaps, const std::function<void()>& onReady = nullptr) -> void {};
 
 	protected:
 		std::string fileName;
@@ -85,6 +105,20 @@ namespace Maple
 	};
 
 
+	//layers of the same size, RGBA8, sampled as one sampler2DArray.
+	class MAPLE_EXPORT Texture2DArray : public Texture
+	{
+	public:
+		static auto create(uint32_t width, uint32_t height, uint32_t count)->std::shared_ptr<Texture2DArray>;
+		inline auto getCount() const { return count; }
+		//copy the regions of pixels, RGBA8 with the size of a layer, into one layer. same as Texture2D::update.
+		virtual auto update(uint32_t layer, const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void = 0;
+		//change the number of layers, the layers which are kept keep their content. the version changes.
+		virtual auto resize(uint32_t count) -> void = 0;
+	protected:
+		uint32_t count = 0;
+	};
+
 	class MAPLE_EXPORT TextureDepthArray : public Texture
 	{
 	public:
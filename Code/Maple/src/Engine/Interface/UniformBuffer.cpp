@@ -13,4 +13,9 @@ namespace Maple
 		return std::make_shared<VulkanUniformBuffer>(size,data);
 	}
 
+	auto UniformBuffer::createStorage(uint32_t size, const void* data) ->std::shared_ptr<UniformBuffer>
+	{
+		return std::make_shared<VulkanUniformBuffer>(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, size, data);
+	}
+
 };
\ No newline at end of file
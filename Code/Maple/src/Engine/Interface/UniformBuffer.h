@@ -14,5 +14,7 @@ namespace Maple
 		virtual ~UniformBuffer() {};
 		virtual auto setData(uint32_t size, const void* data, uint32_t offset = 0) -> void = 0;
 		static auto create(uint32_t size, const void* data)->std::shared_ptr<UniformBuffer>;
+		//bound as DescriptorType::STORAGE_BUFFER
+		static auto createStorage(uint32_t size, const void* data)->std::shared_ptr<UniformBuffer>;
 	};
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "Engine/Interface/Pipeline.h"
 #include "Engine/Interface/UniformBuffer.h"
 #include "Engine/Interface/Shader.h"
+#include "MaterialPool.h"
 
 namespace Maple
 {
@@ -24,6 +25,8 @@ namespace Maple
 
 	Material::~Material()
 	{
+		if (materialId != MaterialPool::INVALID_ID && MaterialPool::isCreated())
+			MaterialPool::get()->free(materialId);
 	}
 
 	auto Material::loadPBRMaterial(const std::string& name, const std::string& path, const std::string& extension) -> void
@@ -48,9 +51,9 @@ namespace Maple
 
 		//this->pipeline = pipeline;
 
-		if (materialPropertiesBuffer == nullptr && pbr)
+		if (materialId == MaterialPool::INVALID_ID && pbr)
 		{
-			materialPropertiesBuffer = UniformBuffer::create(sizeof(MaterialProperties),nullptr);
+			materialId = MaterialPool::get()->allocate();
 		}
 
 		if (descriptorSets[pipeline] == nullptr) {
@@ -93,19 +96,33 @@ namespace Maple
 			getImageInfo(pbrMaterialTextures.emissive, "emissiveMap", materialProperties.usingAOMap, 5);
 
 
-			BufferInfo bufferInfo = {};
-			bufferInfo.buffer = materialPropertiesBuffer;
-			bufferInfo.offset = 0;
-			bufferInfo.size = sizeof(MaterialProperties);
-			bufferInfo.type = DescriptorType::UNIFORM_BUFFER;
+			auto bufferInfo = MaterialPool::get()->getBufferInfo(materialId);
 			bufferInfo.binding = 6;
 			bufferInfo.shaderType = ShaderType::FRAGMENT_SHADER;
 			bufferInfo.name = "UniformMaterialData";
 			bufferInfos.push_back(bufferInfo);
-			materialPropertiesBuffer->setData(sizeof(MaterialProperties), &materialProperties);
+			MaterialPool::get()->update(materialId, materialProperties);
 		}
 
 		descriptorSets[pipeline]->update(imageInfos, bufferInfos);
+		texturesVersion = getTexturesVersion();
+	}
+
+	auto Material::getTexturesVersion() const -> uint32_t
+	{
+		uint32_t version = 0;
+		for (auto& texture : { pbrMaterialTextures.albedo,pbrMaterialTextures.normal,pbrMaterialTextures.metallic,
+			pbrMaterialTextures.roughness,pbrMaterialTextures.ao,pbrMaterialTextures.emissive })
+		{
+			if (texture)
+				version += texture->getVersion();
+		}
+		return version;
+	}
+
+	auto Material::isTexturesOutdated() const -> bool
+	{
+		return texturesVersion != getTexturesVersion();
 	}
 
 	auto Material::setTextures(const PBRMataterialTextures& textures) -> void
@@ -116,8 +133,8 @@ namespace Maple
 	auto Material::setMaterialProperites(const MaterialProperties& properties) -> void
 	{
 		materialProperties = properties;
-		if (materialPropertiesBuffer) {
-			materialPropertiesBuffer->setData(sizeof(MaterialProperties), &materialProperties);
+		if (materialId != MaterialPool::INVALID_ID) {
+			MaterialPool::get()->update(materialId, materialProperties);
 		}
 	}
 
@@ -6,6 +6,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <string>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include "Engine/Core.h"
@@ -69,6 +70,9 @@ namespace Maple
 	public:
 		Material(const std::shared_ptr<Shader>& shader, const MaterialProperties& properties = MaterialProperties(), const PBRMataterialTextures& textures = PBRMataterialTextures());
 		Material();
+		//owns a slot of the MaterialPool
+		Material(const Material&) = delete;
+		auto operator=(const Material&) -> Material& = delete;
 
 		~Material();
 
@@ -107,6 +111,9 @@ namespace Maple
 			texturesUpdated = updated;
 		}
 
+		//true if one of the textures was replaced (e.g. by a streamed upload) after the descriptor sets were written.
+		auto isTexturesOutdated() const -> bool;
+
 		inline auto& getTextures()
 		{
 			return pbrMaterialTextures;
@@ -126,6 +133,12 @@ namespace Maple
 			return descriptorSets[pipeline];
 		}
 
+		//slot in the MaterialPool, MaterialPool::INVALID_ID until the first descriptor set is created.
+		inline auto getMaterialId() const
+		{
+			return materialId;
+		}
+
 		inline auto getRenderFlags() const
 		{
 			return renderFlags;
@@ -222,15 +235,18 @@ namespace Maple
 		auto getShaderPath() const->std::string;
 
 	private:
+		auto getTexturesVersion() const->uint32_t;
+
 		PBRMataterialTextures pbrMaterialTextures;
 		MaterialProperties materialProperties;
 
 		std::shared_ptr	<Shader> shader;
-		std::shared_ptr <UniformBuffer> materialPropertiesBuffer;
+		uint32_t materialId = UINT32_MAX;
 		//std::shared_ptr <DescriptorSet> descriptorSet;
 		//Pipeline* pipeline = nullptr;
 		std::string name;
 		bool texturesUpdated = false;
+		uint32_t texturesVersion = 0;
 		std::unordered_map<Pipeline*, std::shared_ptr <DescriptorSet>> descriptorSets;
 
 	};
@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "MaterialPool.h"
+#include "Material.h"
+#include "Engine/Interface/UniformBuffer.h"
+#include "Engine/Vulkan/VulkanDevice.h"
+#include "Engine/Profiler.h"
+#include <cstring>
+
+namespace Maple
+{
+	std::shared_ptr<MaterialPool> MaterialPool::instance;
+
+	MaterialPool::MaterialPool()
+	{
+		//every slot has to start at a valid uniform buffer offset
+		const auto alignment = static_cast<uint32_t>(VulkanDevice::get()->getPhysicalDevice()->getProperties().limits.minUniformBufferOffsetAlignment);
+		stride = sizeof(MaterialProperties);
+		if (alignment > 0)
+			stride = (stride + alignment - 1) & ~(alignment - 1);
+	}
+
+	auto MaterialPool::allocate() -> uint32_t
+	{
+		uint32_t id = INVALID_ID;
+		if (!freeIds.empty())
+		{
+			id = freeIds.back();
+			freeIds.pop_back();
+		}
+		else
+		{
+			if (count == pages.size() * PAGE_SIZE)
+			{
+				auto& page = pages.emplace_back();
+				page.buffer = UniformBuffer::create(stride * PAGE_SIZE, nullptr);
+				page.data.resize(stride * PAGE_SIZE);
+				page.dirty.resize(PAGE_SIZE);
+			}
+			id = count++;
+		}
+		update(id, MaterialProperties{});
+		return id;
+	}
+
+	auto MaterialPool::free(uint32_t id) -> void
+	{
+		//the pool may have been released before the last materials.
+		if (isValid(id))
+			freeIds.emplace_back(id);
+	}
+
+	auto MaterialPool::update(uint32_t id, const MaterialProperties& properties) -> void
+	{
+		if (!isValid(id))
+			return;
+		auto& page = pages[id / PAGE_SIZE];
+		const auto slot = id % PAGE_SIZE;
+		std::memcpy(page.data.data() + slot * stride, &properties, sizeof(MaterialProperties));
+		page.dirty[slot] = true;
+		page.hasDirty = true;
+	}
+
+	auto MaterialPool::flush() -> void
+	{
+		PROFILE_FUNCTION();
+		for (auto& page : pages)
+		{
+			if (!page.hasDirty)
+				continue;
+
+			uint32_t slot = 0;
+			while (slot < PAGE_SIZE)
+			{
+				if (!page.dirty[slot])
+				{
+					slot++;
+					continue;
+				}
+
+				const auto begin = slot;
+				while (slot < PAGE_SIZE && page.dirty[slot])
+				{
+					page.dirty[slot] = false;
+					slot++;
+				}
+				page.buffer->setData((slot - begin) * stride, page.data.data() + begin * stride, begin * stride);
+			}
+			page.hasDirty = false;
+		}
+	}
+
+	auto MaterialPool::getBufferInfo(uint32_t id) const -> BufferInfo
+	{
+		BufferInfo info = {};
+		if (isValid(id))
+		{
+			info.buffer = pages[id / PAGE_SIZE].buffer;
+			info.offset = (id % PAGE_SIZE) * stride;
+			info.size = sizeof(MaterialProperties);
+			info.type = DescriptorType::UNIFORM_BUFFER;
+		}
+		return info;
+	}
+
+	auto MaterialPool::isValid(uint32_t id) const -> bool
+	{
+		return id < count;
+	}
+
+	auto MaterialPool::get() -> std::shared_ptr<MaterialPool>
+	{
+		if (instance == nullptr)
+		{
+			instance = std::make_shared<MaterialPool>();
+		}
+		return instance;
+	}
+
+	auto MaterialPool::release() -> void
+	{
+		instance.reset();
+	}
+
+	auto MaterialPool::isCreated() -> bool
+	{
+		return instance != nullptr;
+	}
+};
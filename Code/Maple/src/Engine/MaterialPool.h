@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Engine/Core.h"
+#include "Engine/Interface/DescriptorSet.h"
+
+namespace Maple
+{
+	class UniformBuffer;
+	struct MaterialProperties;
+
+	//MaterialProperties of all the materials, packed into a few large uniform buffers and indexed by material id.
+	//Buffers are never reallocated so the descriptor sets pointing into them are written once.
+	class MAPLE_EXPORT MaterialPool final
+	{
+	public:
+		static constexpr uint32_t INVALID_ID = UINT32_MAX;
+		//materials per buffer
+		static constexpr uint32_t PAGE_SIZE = 256;
+
+		MaterialPool();
+
+		auto allocate() -> uint32_t;
+		auto free(uint32_t id) -> void;
+		//copies the properties, the slot is uploaded by the next flush.
+		auto update(uint32_t id, const MaterialProperties& properties) -> void;
+		//uploads the changed slots, neighbouring slots are merged into one copy.
+		auto flush() -> void;
+
+		//buffer, offset and size of the slot, the caller fills in binding and name.
+		auto getBufferInfo(uint32_t id) const -> BufferInfo;
+
+		inline auto getStride() const { return stride; }
+		inline auto getCount() const { return count; }
+		inline auto getPageCount() const { return static_cast<uint32_t>(pages.size()); }
+
+		static auto get() -> std::shared_ptr<MaterialPool>;
+		static auto release() -> void;
+		//false after release(), materials destroyed at shutdown must not create the pool again.
+		static auto isCreated() -> bool;
+
+	private:
+		struct Page
+		{
+			std::shared_ptr<UniformBuffer> buffer;
+			//shadow copy of the buffer
+			std::vector<uint8_t> data;
+			std::vector<bool> dirty;
+			bool hasDirty = false;
+		};
+
+		auto isValid(uint32_t id) const -> bool;
+
+		std::vector<Page> pages;
+		std::vector<uint32_t> freeIds;
+		uint32_t stride = 0;
+		uint32_t count = 0;
+
+		static std::shared_ptr<MaterialPool> instance;
+	};
+};
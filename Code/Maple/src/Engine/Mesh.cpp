@@ -13,6 +13,12 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include "Math/BoundingBox.h"
+#include "VertexFormat.h"
+#include "MeshOptimizer.h"
+#include "Interface/Pipeline.h"
+#include "Vulkan/VulkanShader.h"
+#include "Others/Console.h"
+#include <algorithm>
 
 namespace Maple 
 {
@@ -29,11 +35,98 @@ namespace Maple
 		{
 			boundingBox->merge(vertex.pos);
 		}
-		vertexBuffer = std::make_shared<VertexBuffer>();
-		vertexBuffer->setData(sizeof(Vertex) * vertices.size(), vertices.data());
+		setVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
 		indexBuffer = std::make_shared<IndexBuffer>(indices.data(), indices.size());
 	}
 
+	Mesh::Mesh(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const BoundingBox& box)
+	{
+		boundingBox = std::make_shared<BoundingBox>(box);
+		setVertices(vertices, vertexCount);
+		indexBuffer = std::make_shared<IndexBuffer>(indices, indexCount);
+	}
+
+	Mesh::Mesh(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const BoundingBox& box, const std::vector<MeshLod>& lods)
+		: Mesh(vertices, vertexCount, indices, indexCount, box)
+	{
+		this->lods = lods;
+	}
+
+	Mesh::Mesh(const glm::vec3* positions, const VertexFormat::PackedAttributes* attributes, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const BoundingBox& box, const std::vector<MeshLod>& lods)
+		: lods(lods)
+	{
+		boundingBox = std::make_shared<BoundingBox>(box);
+		setStreams(positions, attributes, vertexCount);
+		indexBuffer = std::make_shared<IndexBuffer>(indices, indexCount);
+	}
+
+	auto Mesh::getLod(uint32_t lod) const -> MeshLod
+	{
+		if (lods.empty())
+			return { 0, indexBuffer != nullptr ? indexBuffer->getCount() : 0, 0.f };
+		return lods[std::min<uint32_t>(lod, static_cast<uint32_t>(lods.size()) - 1)];
+	}
+
+	auto Mesh::setVertices(const Vertex* vertices, uint32_t count) -> void
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<VertexFormat::PackedAttributes> attributes;
+		VertexFormat::pack(vertices, count, positions, attributes);
+		setStreams(positions.data(), attributes.data(), count);
+	}
+
+	auto Mesh::setStreams(const glm::vec3* positions, const VertexFormat::PackedAttributes* attributes, uint32_t count) -> void
+	{
+		if (vertexBuffer == nullptr)
+			vertexBuffer = std::make_shared<VertexBuffer>();
+		if (attributeBuffer == nullptr)
+			attributeBuffer = std::make_shared<VertexBuffer>();
+
+		vertexBuffer->setData(sizeof(glm::vec3) * count, positions);
+		attributeBuffer->setData(sizeof(VertexFormat::PackedAttributes) * count, attributes);
+
+		if (VertexFormat::isInterleavedUsed())
+		{
+			std::vector<Vertex> vertices(count);
+			for (uint32_t i = 0; i < count; i++)
+				vertices[i] = VertexFormat::unpack(positions[i], attributes[i]);
+
+			if (interleavedBuffer == nullptr)
+				interleavedBuffer = std::make_shared<VertexBuffer>();
+			interleavedBuffer->setData(sizeof(Vertex) * count, vertices.data());
+		}
+	}
+
+	auto Mesh::bindVertexBuffers(CommandBuffer* commandBuffer, Pipeline* pipeline) -> void
+	{
+		auto shader = static_cast<VulkanShader*>(pipeline->getShader().get());
+		const auto streams = shader->getVertexStreams();
+		if (attributeBuffer == nullptr)
+		{
+			vertexBuffer->bind(commandBuffer, pipeline);
+			return;
+		}
+
+		if (shader->isInterleavedMesh())
+		{
+			//meshes uploaded before the shader was loaded have no interleaved copy
+			static bool warned = false;
+			if (interleavedBuffer != nullptr)
+				interleavedBuffer->bind(commandBuffer, pipeline);
+			else if (!warned)
+			{
+				LOGW("{0} was uploaded before {1} and has no interleaved vertices", name, shader->getFilePath());
+				warned = true;
+			}
+			return;
+		}
+
+		if (streams & (1u << VertexFormat::PositionStream))
+			vertexBuffer->bind(commandBuffer, pipeline, VertexFormat::PositionStream);
+		if (streams & (1u << VertexFormat::AttributeStream))
+			attributeBuffer->bind(commandBuffer, pipeline, VertexFormat::AttributeStream);
+	}
+
 	auto Mesh::createQuad() ->std::shared_ptr<Mesh>
 	{
 		std::vector<Vertex> data(4);
@@ -249,6 +342,7 @@ namespace Maple
 			}
 		}
 
+		MeshOptimizer::optimize(data, indices, {});
 		return std::make_shared<Mesh>(indices,data);
 	}
 
@@ -288,89 +382,4 @@ namespace Maple
 
 		return std::make_shared<Mesh>(indices, data);
 	}
-
-	auto Mesh::generateNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void
-	{
-		std::vector<glm::vec3> normals(vertices.size());
-
-		if (!indices.empty())
-		{
-			for (uint32_t i = 0; i < indices.size(); i += 3)
-			{
-				const auto a = indices[i];
-				const auto b = indices[i + 1];
-				const auto c = indices[i + 2];
-				const auto normal = glm::cross((vertices[b].pos - vertices[a].pos), (vertices[c].pos - vertices[a].pos));
-				normals[a] += normal;
-				normals[b] += normal;
-				normals[c] += normal;
-			}
-		}
-		else
-		{
-			for (uint32_t i = 0; i < vertices.size(); i += 3)
-			{
-				auto& a = vertices[i];
-				auto& b = vertices[i + 1];
-				auto& c = vertices[i + 2];
-				const auto normal = glm::cross(b.pos - a.pos, c.pos - a.pos);
-				normals[i] = normal;
-				normals[i + 1] = normal;
-				normals[i + 2] = normal;
-			}
-		}
-		for (uint32_t i = 0; i < normals.size(); ++i)
-		{
-			vertices[i].normal = glm::normalize(normals[i]);
-		}
-	}
-
-	auto Mesh::generateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void
-	{
-		std::vector<glm::vec3> tangents(vertices.size());
-
-		if (!indices.empty())
-		{
-			for (uint32_t i = 0; i < indices.size(); i += 3)
-			{
-				int a = indices[i];
-				int b = indices[i + 1];
-				int c = indices[i + 2];
-
-				const auto tangent =
-					generateTangent(vertices[a].pos, vertices[b].pos, vertices[c].pos, vertices[a].texCoord, vertices[b].texCoord, vertices[c].texCoord);
-
-				tangents[a] += tangent;
-				tangents[b] += tangent;
-				tangents[c] += tangent;
-			}
-		}
-		else
-		{
-			for (uint32_t i = 0; i < vertices.size(); i += 3)
-			{
-				const auto tangent = 
-					generateTangent(vertices[i].pos, vertices[i + 1].pos, vertices[i + 2].pos, vertices[i].texCoord, vertices[i + 1].texCoord,vertices[i + 2].texCoord);
-
-				tangents[i] += tangent;
-				tangents[i + 1] += tangent;
-				tangents[i + 2] += tangent;
-			}
-		}
-		for (uint32_t i = 0; i < vertices.size(); ++i)
-		{
-			vertices[i].tangent = glm::normalize(tangents[i]);
-		}
-	}
-
-	auto Mesh::generateTangent(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec2& ta, const glm::vec2& tb, const glm::vec2& tc) -> glm::vec3
-	{
-		const glm::vec2 coord1 = tb - ta;
-		const glm::vec2 coord2 = tc - ta;
-		const glm::vec3 vertex1 = b - a;
-		const glm::vec3 vertex2 = c - a;
-		const glm::vec3 axis =(vertex1 * coord2.y - vertex2 * coord1.y);
-		const float factor = 1.0f / (coord1.x * coord2.y - coord2.x * coord1.y);
-		return axis * factor;
-	}
 };
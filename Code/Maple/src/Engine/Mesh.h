@@ -9,6 +9,8 @@
 #include <memory>
 #include "Timestep.h"
 #include "Engine/Vertex.h"
+#include "Engine/VertexFormat.h"
+#include "Engine/MeshSimplifier.h"
 #include "Engine/Vulkan/IndexBuffer.h"
 #include "Engine/Vulkan/VertexBuffer.h"
 #include "Engine/Interface/Texture.h"
@@ -22,6 +24,8 @@ namespace Maple
 	};
 
 	class DescriptorSet;
+	class CommandBuffer;
+	class Pipeline;
 	class Camera;
 	class BoundingBox;
 
@@ -32,6 +36,12 @@ namespace Maple
 		Mesh(const std::shared_ptr<VertexBuffer> & vertexBuffer,
 			const std::shared_ptr<IndexBuffer> & indexBuffer);
 		Mesh(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+		//bounds computed beforehand, e.g. by the mesh cooker
+		Mesh(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const BoundingBox& box);
+		//indices holds every level of the chain, see MeshSimplifier::buildLods
+		Mesh(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const BoundingBox& box, const std::vector<MeshLod>& lods);
+		//streams packed beforehand, e.g. read from a cooked mesh
+		Mesh(const glm::vec3* positions, const VertexFormat::PackedAttributes* attributes, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const BoundingBox& box, const std::vector<MeshLod>& lods);
 
 
 		inline auto setMaterial(const std::shared_ptr<Material>& material) {this->material = material;}
@@ -39,7 +49,20 @@ namespace Maple
 		inline auto setIndicesSize(uint32_t size) { this->size = size; }
 		inline auto getSize() { return size; }
 		inline auto& getIndexBuffer() { return indexBuffer; }
+		//position stream, or the interleaved vertices of a mesh created from its own buffers
 		inline auto& getVertexBuffer() { return vertexBuffer; }
+		inline auto& getAttributeBuffer() { return attributeBuffer; }
+
+		//splits the vertices into the streams of VertexFormat and uploads them
+		auto setVertices(const Vertex* vertices, uint32_t count) -> void;
+		auto setStreams(const glm::vec3* positions, const VertexFormat::PackedAttributes* attributes, uint32_t count) -> void;
+		//binds the streams the vertex shader of the pipeline reads
+		auto bindVertexBuffers(CommandBuffer* commandBuffer, Pipeline* pipeline) -> void;
+
+		inline auto getLodCount() const { return lods.empty() ? 1u : static_cast<uint32_t>(lods.size()); }
+		//the range of the index buffer to draw for a level, the whole buffer if the mesh has no chain
+		auto getLod(uint32_t lod) const -> MeshLod;
+
 		inline auto& getMaterial() { return material; }
 		inline auto& getDescriptorSet() { return descriptorSet; }
 		inline void setDescriptorSet(const std::shared_ptr<DescriptorSet> & set) { descriptorSet = set; }
@@ -68,11 +91,15 @@ namespace Maple
 
 		std::shared_ptr<IndexBuffer> indexBuffer;
 		std::shared_ptr<VertexBuffer> vertexBuffer;
+		std::shared_ptr<VertexBuffer> attributeBuffer;
+		//only when a shader reads the interleaved layout, see VertexFormat::setInterleavedUsed
+		std::shared_ptr<VertexBuffer> interleavedBuffer;
 		std::shared_ptr<Texture> texture;
 		std::shared_ptr<DescriptorSet> descriptorSet;
 		std::shared_ptr<Material> material;
 
 		std::shared_ptr<BoundingBox> boundingBox;
+		std::vector<MeshLod> lods;
 
 		uint32_t size = 0;
 		bool active = true;
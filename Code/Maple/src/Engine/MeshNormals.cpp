@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//normal and tangent generation, kept apart from the GPU side of Mesh so CPU tools can build it on its own.
+#include "Mesh.h"
+
+namespace Maple 
+{
+	//the face terms do not depend on each other, they are computed in a flat loop the compiler can vectorize.
+	//the sums run in triangle order afterwards, so the result is the same as summing in one loop.
+	auto Mesh::generateNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void
+	{
+		std::vector<glm::vec3> normals(vertices.size());
+		const auto triangleCount = (indices.empty() ? vertices.size() : indices.size()) / 3;
+		std::vector<glm::vec3> faces(triangleCount);
+
+		if (!indices.empty())
+		{
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				const auto& a = vertices[indices[t * 3]].pos;
+				const auto& b = vertices[indices[t * 3 + 1]].pos;
+				const auto& c = vertices[indices[t * 3 + 2]].pos;
+				faces[t] = glm::cross(b - a, c - a);
+			}
+
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				normals[indices[t * 3]] += faces[t];
+				normals[indices[t * 3 + 1]] += faces[t];
+				normals[indices[t * 3 + 2]] += faces[t];
+			}
+		}
+		else
+		{
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				const auto& a = vertices[t * 3].pos;
+				faces[t] = glm::cross(vertices[t * 3 + 1].pos - a, vertices[t * 3 + 2].pos - a);
+			}
+
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				normals[t * 3] = faces[t];
+				normals[t * 3 + 1] = faces[t];
+				normals[t * 3 + 2] = faces[t];
+			}
+		}
+
+		for (size_t i = 0; i < normals.size(); ++i)
+		{
+			vertices[i].normal = glm::normalize(normals[i]);
+		}
+	}
+
+	auto Mesh::generateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void
+	{
+		std::vector<glm::vec3> tangents(vertices.size());
+		const auto triangleCount = (indices.empty() ? vertices.size() : indices.size()) / 3;
+		std::vector<glm::vec3> faces(triangleCount);
+
+		if (!indices.empty())
+		{
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				const auto& a = vertices[indices[t * 3]];
+				const auto& b = vertices[indices[t * 3 + 1]];
+				const auto& c = vertices[indices[t * 3 + 2]];
+				faces[t] = generateTangent(a.pos, b.pos, c.pos, a.texCoord, b.texCoord, c.texCoord);
+			}
+
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				tangents[indices[t * 3]] += faces[t];
+				tangents[indices[t * 3 + 1]] += faces[t];
+				tangents[indices[t * 3 + 2]] += faces[t];
+			}
+		}
+		else
+		{
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				const auto& a = vertices[t * 3];
+				const auto& b = vertices[t * 3 + 1];
+				const auto& c = vertices[t * 3 + 2];
+				faces[t] = generateTangent(a.pos, b.pos, c.pos, a.texCoord, b.texCoord, c.texCoord);
+			}
+
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				tangents[t * 3] += faces[t];
+				tangents[t * 3 + 1] += faces[t];
+				tangents[t * 3 + 2] += faces[t];
+			}
+		}
+
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			vertices[i].tangent = glm::normalize(tangents[i]);
+		}
+	}
+
+	auto Mesh::generateTangent(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec2& ta, const glm::vec2& tb, const glm::vec2& tc) -> glm::vec3
+	{
+		const glm::vec2 coord1 = tb - ta;
+		const glm::vec2 coord2 = tc - ta;
+		const glm::vec3 vertex1 = b - a;
+		const glm::vec3 vertex2 = c - a;
+		const glm::vec3 axis =(vertex1 * coord2.y - vertex2 * coord1.y);
+		const float factor = 1.0f / (coord1.x * coord2.y - coord2.x * coord1.y);
+		return axis * factor;
+	}
+};
@@ -0,0 +1,351 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+#include "Engine/Profiler.h"
+#include <algorithm>
+#include <numeric>
+
+namespace Maple
+{
+	namespace
+	{
+		constexpr uint32_t INVALID = UINT32_MAX;
+
+		//fifo cache, a vertex is in the cache if it has been transformed less than size misses ago
+		struct FifoCache
+		{
+			FifoCache(uint32_t vertexCount, uint32_t size)
+				:stamps(vertexCount, 0), time(size + 1), size(size)
+			{
+			}
+
+			//returns true on a miss
+			inline auto access(uint32_t vertex) -> bool
+			{
+				if (time - stamps[vertex] > size)
+				{
+					stamps[vertex] = time++;
+					return true;
+				}
+				return false;
+			}
+
+			inline auto flush() -> void
+			{
+				time += size + 1;
+			}
+
+			std::vector<uint32_t> stamps;
+			uint32_t time;
+			uint32_t size;
+		};
+
+		inline auto getVertexCount(const uint32_t* indices, uint32_t indexCount) -> uint32_t
+		{
+			uint32_t count = 0;
+			for (uint32_t i = 0; i < indexCount; i++)
+				count = std::max(count, indices[i] + 1);
+			return count;
+		}
+	};
+
+	auto MeshOptimizer::analyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize) -> CacheStatistics
+	{
+		CacheStatistics stats;
+		stats.triangles = indexCount / 3;
+
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<uint8_t> used(vertexCount, 0);
+		for (uint32_t i = 0; i < stats.triangles * 3; i++)
+		{
+			const auto vertex = indices[i];
+			if (!used[vertex])
+			{
+				used[vertex] = 1;
+				stats.vertices++;
+			}
+			if (cache.access(vertex))
+				stats.transformed++;
+		}
+		return stats;
+	}
+
+	auto MeshOptimizer::optimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>* clusters, uint32_t cacheSize) -> void
+	{
+		PROFILE_FUNCTION();
+		const uint32_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		//triangles around every vertex, live counts the ones which have not been emitted
+		std::vector<uint32_t> live(vertexCount, 0);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+			live[indices[i]]++;
+
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (uint32_t i = 0; i < vertexCount; i++)
+			offsets[i + 1] = offsets[i] + live[i];
+
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		{
+			auto cursor = offsets;
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+				adjacency[cursor[indices[i]]++] = i / 3;
+		}
+
+		std::vector<uint32_t> stamps(vertexCount, 0);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> result;
+		deadEnd.reserve(triangleCount * 3);
+		result.reserve(triangleCount * 3);
+
+		uint32_t time = cacheSize + 1;
+		uint32_t cursor = 0;
+
+		auto nextUnused = [&]() {
+			while (cursor < vertexCount && live[cursor] == 0)
+				cursor++;
+			return cursor < vertexCount ? cursor : INVALID;
+		};
+
+		auto startCluster = [&]() {
+			const auto triangle = static_cast<uint32_t>(result.size() / 3);
+			if (clusters != nullptr && (clusters->empty() || clusters->back() != triangle))
+				clusters->emplace_back(triangle);
+		};
+
+		if (clusters != nullptr)
+			clusters->clear();
+
+		auto fan = nextUnused();
+		startCluster();
+
+		while (fan != INVALID)
+		{
+			//emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (auto k = offsets[fan]; k < offsets[fan + 1]; k++)
+			{
+				const auto triangle = adjacency[k];
+				if (emitted[triangle])
+					continue;
+
+				for (uint32_t j = 0; j < 3; j++)
+				{
+					const auto vertex = indices[triangle * 3 + j];
+					result.emplace_back(vertex);
+					deadEnd.emplace_back(vertex);
+					candidates.emplace_back(vertex);
+					live[vertex]--;
+					if (time - stamps[vertex] > cacheSize)
+						stamps[vertex] = time++;
+				}
+				emitted[triangle] = 1;
+			}
+
+			//the candidate which stays in the cache while its own fan is emitted, the oldest one first
+			fan = INVALID;
+			int32_t best = -1;
+			for (auto vertex : candidates)
+			{
+				if (live[vertex] == 0)
+					continue;
+
+				int32_t priority = 0;
+				if (time - stamps[vertex] + 2 * live[vertex] <= cacheSize)
+					priority = static_cast<int32_t>(time - stamps[vertex]);
+
+				if (priority > best)
+				{
+					best = priority;
+					fan = vertex;
+				}
+			}
+
+			if (fan == INVALID)
+			{
+				//dead end, go back to a recently used vertex, or start over with a cold cache
+				while (!deadEnd.empty() && fan == INVALID)
+				{
+					const auto vertex = deadEnd.back();
+					deadEnd.pop_back();
+					if (live[vertex] > 0)
+						fan = vertex;
+				}
+
+				if (fan == INVALID)
+					fan = nextUnused();
+
+				if (fan != INVALID)
+					startCluster();
+			}
+		}
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	auto MeshOptimizer::optimizeOverdraw(uint32_t* indices, uint32_t indexCount, const Vertex* vertices, const std::vector<uint32_t>& clusters, float threshold, uint32_t cacheSize) -> void
+	{
+		PROFILE_FUNCTION();
+		const uint32_t triangleCount = indexCount / 3;
+		if (triangleCount == 0 || clusters.empty())
+			return;
+
+		//split the clusters where the cache miss ratio of the part so far is close to the one of the whole cluster,
+		//a flush there costs next to nothing.
+		FifoCache cache(getVertexCount(indices, indexCount), cacheSize);
+		std::vector<uint32_t> splits;
+
+		auto missesOf = [&](uint32_t triangle) {
+			uint32_t misses = 0;
+			for (uint32_t j = 0; j < 3; j++)
+				misses += cache.access(indices[triangle * 3 + j]) ? 1 : 0;
+			return misses;
+		};
+
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			const auto begin = clusters[c];
+			const auto end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+			cache.flush();
+			uint32_t clusterMisses = 0;
+			for (auto t = begin; t < end; t++)
+				clusterMisses += missesOf(t);
+
+			const float clusterThreshold = threshold * clusterMisses / float(end - begin);
+
+			splits.emplace_back(begin);
+			cache.flush();
+			uint32_t misses = 0;
+			uint32_t runBegin = begin;
+			for (auto t = begin; t < end; t++)
+			{
+				misses += missesOf(t);
+				if (t + 1 < end && misses / float(t + 1 - runBegin) <= clusterThreshold)
+				{
+					splits.emplace_back(t + 1);
+					cache.flush();
+					misses = 0;
+					runBegin = t + 1;
+				}
+			}
+		}
+
+		struct Cluster
+		{
+			uint32_t begin;
+			uint32_t end;
+			glm::vec3 centroid;
+			glm::vec3 normal;
+			float sort;
+		};
+
+		std::vector<Cluster> sorted(splits.size());
+		glm::vec3 meshCentroid(0.f);
+		float meshArea = 0.f;
+
+		for (size_t c = 0; c < splits.size(); c++)
+		{
+			auto& cluster = sorted[c];
+			cluster.begin = splits[c];
+			cluster.end = c + 1 < splits.size() ? splits[c + 1] : triangleCount;
+			cluster.centroid = glm::vec3(0.f);
+			cluster.normal = glm::vec3(0.f);
+
+			float area = 0.f;
+			for (auto t = cluster.begin; t < cluster.end; t++)
+			{
+				const auto& p0 = vertices[indices[t * 3]].pos;
+				const auto& p1 = vertices[indices[t * 3 + 1]].pos;
+				const auto& p2 = vertices[indices[t * 3 + 2]].pos;
+				const auto normal = glm::cross(p1 - p0, p2 - p0);
+				const float triangleArea = glm::length(normal);
+				cluster.centroid += (p0 + p1 + p2) * (triangleArea / 3.f);
+				cluster.normal += normal;
+				area += triangleArea;
+			}
+
+			meshCentroid += cluster.centroid;
+			meshArea += area;
+			cluster.centroid = area > 0.f ? cluster.centroid / area : vertices[indices[cluster.begin * 3]].pos;
+		}
+
+		if (meshArea > 0.f)
+			meshCentroid /= meshArea;
+
+		//clusters far out along their normal are likely in front of the rest of the mesh
+		for (auto& cluster : sorted)
+		{
+			const float length = glm::length(cluster.normal);
+			cluster.sort = length > 0.f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.f;
+		}
+
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+			return a.sort > b.sort;
+		});
+
+		std::vector<uint32_t> result;
+		result.reserve(triangleCount * 3);
+		for (auto& cluster : sorted)
+			result.insert(result.end(), indices + cluster.begin * 3, indices + cluster.end * 3);
+
+		std::copy(result.begin(), result.end(), indices);
+	}
+
+	auto MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, uint32_t* indices, uint32_t indexCount) -> void
+	{
+		PROFILE_FUNCTION();
+		std::vector<uint32_t> remap(vertices.size(), INVALID);
+		uint32_t next = 0;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			auto& index = indices[i];
+			if (remap[index] == INVALID)
+				remap[index] = next++;
+			index = remap[index];
+		}
+
+		//vertices no triangle uses are kept at the end
+		for (auto& index : remap)
+		{
+			if (index == INVALID)
+				index = next++;
+		}
+
+		std::vector<Vertex> reordered(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+			reordered[remap[i]] = vertices[i];
+		vertices.swap(reordered);
+	}
+
+	auto MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods) -> void
+	{
+		PROFILE_FUNCTION();
+		const auto vertexCount = static_cast<uint32_t>(vertices.size());
+		std::vector<uint32_t> clusters;
+
+		auto optimizeRange = [&](uint32_t offset, uint32_t count) {
+			optimizeVertexCache(indices.data() + offset, count, vertexCount, &clusters);
+			optimizeOverdraw(indices.data() + offset, count, vertices.data(), clusters);
+		};
+
+		if (lods.empty())
+		{
+			optimizeRange(0, static_cast<uint32_t>(indices.size()));
+		}
+		else
+		{
+			for (auto& lod : lods)
+				optimizeRange(lod.indexOffset, lod.indexCount);
+		}
+
+		//the full mesh comes first, so its order decides the layout of the vertices
+		optimizeVertexFetch(vertices, indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+};
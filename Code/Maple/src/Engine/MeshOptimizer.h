@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Vertex.h"
+#include "MeshSimplifier.h"
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	//Reorders meshes for the GPU :
+	//triangles for the post transform vertex cache (Tipsify, Sander et al. 2007),
+	//clusters of triangles front to back to cut overdraw, vertices in the order they are fetched.
+	namespace MeshOptimizer
+	{
+		//typical size of the post transform cache, in vertices
+		static constexpr uint32_t CACHE_SIZE = 16;
+
+		struct CacheStatistics
+		{
+			uint32_t triangles = 0;
+			uint32_t vertices = 0;
+			//vertices shaded, cache misses of a fifo cache
+			uint32_t transformed = 0;
+
+			//average cache miss ratio, transformed vertices per triangle (0.5 is the best a regular grid can do)
+			inline auto getAcmr() const { return triangles == 0 ? 0.f : float(transformed) / triangles; }
+			//transformed vertices per vertex (1 is the best)
+			inline auto getAtvr() const { return vertices == 0 ? 0.f : float(transformed) / vertices; }
+
+			inline auto operator+=(const CacheStatistics& rhs) -> CacheStatistics&
+			{
+				triangles += rhs.triangles;
+				vertices += rhs.vertices;
+				transformed += rhs.transformed;
+				return *this;
+			}
+		};
+
+		MAPLE_EXPORT auto analyzeVertexCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = CACHE_SIZE) -> CacheStatistics;
+
+		//clusters receives the first triangle of every run which starts with a cold cache.
+		MAPLE_EXPORT auto optimizeVertexCache(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>* clusters = nullptr, uint32_t cacheSize = CACHE_SIZE) -> void;
+		//sorts the clusters of optimizeVertexCache so outward facing ones are drawn first.
+		//clusters are split further as long as the cache miss ratio stays within threshold of the original order.
+		MAPLE_EXPORT auto optimizeOverdraw(uint32_t* indices, uint32_t indexCount, const Vertex* vertices, const std::vector<uint32_t>& clusters, float threshold = 1.05f, uint32_t cacheSize = CACHE_SIZE) -> void;
+		//vertices in the order of first use, the indices are remapped.
+		MAPLE_EXPORT auto optimizeVertexFetch(std::vector<Vertex>& vertices, uint32_t* indices, uint32_t indexCount) -> void;
+
+		//all of the above, every level of detail is ordered on its own. lods may be empty for a single level.
+		MAPLE_EXPORT auto optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<MeshLod>& lods) -> void;
+	};
+};
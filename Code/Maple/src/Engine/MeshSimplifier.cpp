@@ -0,0 +1,335 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "MeshSimplifier.h"
+#include "Engine/Profiler.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+namespace Maple
+{
+	namespace
+	{
+		//a level is not worth its indices below this
+		constexpr uint32_t MIN_LOD_INDICES = 64 * 3;
+		//borders are more visible than a bump in the middle of a surface
+		constexpr float BORDER_WEIGHT = 10.f;
+
+		//symmetric 4x4 matrix of the plane equations, w is the sum of the plane weights
+		struct Quadric
+		{
+			float a00 = 0, a11 = 0, a22 = 0;
+			float a01 = 0, a02 = 0, a12 = 0;
+			float b0 = 0, b1 = 0, b2 = 0;
+			float c = 0;
+			float w = 0;
+		};
+
+		struct Collapse
+		{
+			uint32_t from;
+			uint32_t to;
+			float error;
+		};
+
+		inline auto makePlane(const glm::vec3& n, float d, float w) -> Quadric
+		{
+			Quadric q;
+			q.a00 = w * n.x * n.x;
+			q.a11 = w * n.y * n.y;
+			q.a22 = w * n.z * n.z;
+			q.a01 = w * n.x * n.y;
+			q.a02 = w * n.x * n.z;
+			q.a12 = w * n.y * n.z;
+			q.b0 = w * n.x * d;
+			q.b1 = w * n.y * d;
+			q.b2 = w * n.z * d;
+			q.c = w * d * d;
+			q.w = w;
+			return q;
+		}
+
+		inline auto add(Quadric& q, const Quadric& r) -> void
+		{
+			q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+			q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+			q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+			q.c += r.c;
+			q.w += r.w;
+		}
+
+		//weighted mean of the squared distances to the planes
+		inline auto evaluate(const Quadric& q, const glm::vec3& v) -> float
+		{
+			const float r =
+				v.x * (q.a00 * v.x + 2.f * (q.a01 * v.y + q.a02 * v.z + q.b0)) +
+				v.y * (q.a11 * v.y + 2.f * (q.a12 * v.z + q.b1)) +
+				v.z * (q.a22 * v.z + 2.f * q.b2) + q.c;
+			return q.w > 0.f ? std::fabs(r) / q.w : 0.f;
+		}
+
+		inline auto edgeKey(uint32_t a, uint32_t b) -> uint64_t
+		{
+			return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+		}
+	};
+
+	auto MeshSimplifier::simplify(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, uint32_t targetIndexCount, float& error) -> std::vector<uint32_t>
+	{
+		PROFILE_FUNCTION();
+		error = 0.f;
+		std::vector<uint32_t> result(indices, indices + indexCount);
+		if (indexCount <= targetIndexCount)
+			return result;
+
+		//vertices which share a position, the first one keeps the quadric of all of them
+		std::vector<uint32_t> wedge(vertexCount);
+		std::vector<uint32_t> wedgeCount(vertexCount, 0);
+		{
+			std::unordered_map<glm::vec3, uint32_t> positions;
+			positions.reserve(vertexCount);
+			for (uint32_t i = 0; i < vertexCount; i++)
+			{
+				wedge[i] = positions.emplace(vertices[i].pos, i).first->second;
+				wedgeCount[wedge[i]]++;
+			}
+		}
+
+		std::vector<uint8_t> locked(vertexCount, 0);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			//moving one side of a seam would tear the mesh apart
+			locked[i] = wedgeCount[wedge[i]] > 1;
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		std::unordered_map<uint64_t, uint32_t> edges;
+		edges.reserve(indexCount);
+
+		for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			const auto& p0 = vertices[result[i]].pos;
+			const auto& p1 = vertices[result[i + 1]].pos;
+			const auto& p2 = vertices[result[i + 2]].pos;
+			const auto cross = glm::cross(p1 - p0, p2 - p0);
+			const float length = glm::length(cross);
+			if (length > 0.f)
+			{
+				const auto normal = cross / length;
+				const auto plane = makePlane(normal, -glm::dot(normal, p0), length * 0.5f);
+				for (uint32_t j = 0; j < 3; j++)
+					add(quadrics[wedge[result[i + j]]], plane);
+			}
+
+			for (uint32_t j = 0; j < 3; j++)
+				edges[edgeKey(wedge[result[i + j]], wedge[result[i + (j + 1) % 3]])]++;
+		}
+
+		//edges with one triangle get a plane through the edge, perpendicular to the triangle
+		for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			const auto& p0 = vertices[result[i]].pos;
+			const auto& p1 = vertices[result[i + 1]].pos;
+			const auto& p2 = vertices[result[i + 2]].pos;
+			const auto normal = glm::cross(p1 - p0, p2 - p0);
+			if (glm::dot(normal, normal) == 0.f)
+				continue;
+
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				const auto a = wedge[result[i + j]];
+				const auto b = wedge[result[i + (j + 1) % 3]];
+				const auto count = edges[edgeKey(a, b)];
+				if (count == 2)
+					continue;
+
+				if (count > 2)
+				{
+					//non manifold
+					locked[a] = locked[b] = 1;
+					continue;
+				}
+
+				const auto edge = vertices[b].pos - vertices[a].pos;
+				const float length2 = glm::dot(edge, edge);
+				const auto side = glm::cross(edge, normal);
+				const float sideLength = glm::length(side);
+				if (sideLength == 0.f)
+					continue;
+
+				const auto sideNormal = side / sideLength;
+				const auto plane = makePlane(sideNormal, -glm::dot(sideNormal, vertices[a].pos), length2 * BORDER_WEIGHT);
+				add(quadrics[a], plane);
+				add(quadrics[b], plane);
+			}
+		}
+
+		auto cost = [&](uint32_t from, uint32_t to) {
+			auto q = quadrics[wedge[from]];
+			add(q, quadrics[wedge[to]]);
+			return evaluate(q, vertices[to].pos);
+		};
+
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<uint8_t> touched(vertexCount);
+		std::vector<Collapse> collapses;
+		float maxError = 0.f;
+
+		//every pass collapses the cheapest independent edges, then the triangles are rebuilt
+		while (result.size() > targetIndexCount)
+		{
+			const auto triangleCount = static_cast<uint32_t>(result.size() / 3);
+
+			offsets.assign(vertexCount + 1, 0);
+			for (auto index : result)
+				offsets[index + 1]++;
+			for (uint32_t i = 0; i < vertexCount; i++)
+				offsets[i + 1] += offsets[i];
+
+			triangles.resize(result.size());
+			{
+				auto cursor = offsets;
+				for (uint32_t i = 0; i < result.size(); i++)
+					triangles[cursor[result[i]]++] = i / 3;
+			}
+
+			collapses.clear();
+			for (uint32_t i = 0; i < triangleCount; i++)
+			{
+				for (uint32_t j = 0; j < 3; j++)
+				{
+					const auto a = result[i * 3 + j];
+					const auto b = result[i * 3 + (j + 1) % 3];
+					Collapse collapse{ a, b, INFINITY };
+					if (!locked[a])
+						collapse.error = cost(a, b);
+					if (!locked[b])
+					{
+						const float reverse = cost(b, a);
+						if (reverse < collapse.error)
+							collapse = { b, a, reverse };
+					}
+					if (collapse.error < INFINITY)
+						collapses.emplace_back(collapse);
+				}
+			}
+
+			if (collapses.empty())
+				break;
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+				return a.error < b.error;
+			});
+
+			//a collapse removes two triangles of a closed surface
+			const size_t goal = (result.size() - targetIndexCount) / 6 + 1;
+
+			auto flips = [&](uint32_t from, uint32_t to) {
+				const auto& target = vertices[to].pos;
+				for (auto k = offsets[from]; k < offsets[from + 1]; k++)
+				{
+					const auto t = triangles[k] * 3;
+					const uint32_t ids[3] = { result[t], result[t + 1], result[t + 2] };
+					if (ids[0] == to || ids[1] == to || ids[2] == to)
+						continue;
+
+					glm::vec3 p[3];
+					glm::vec3 moved[3];
+					for (uint32_t j = 0; j < 3; j++)
+					{
+						p[j] = vertices[ids[j]].pos;
+						moved[j] = ids[j] == from ? target : p[j];
+					}
+
+					const auto before = glm::cross(p[1] - p[0], p[2] - p[0]);
+					const auto after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+					if (glm::dot(before, after) <= 0.f)
+						return true;
+				}
+				return false;
+			};
+
+			for (uint32_t i = 0; i < vertexCount; i++)
+				remap[i] = i;
+			std::fill(touched.begin(), touched.end(), 0);
+
+			size_t done = 0;
+			for (auto& collapse : collapses)
+			{
+				if (done >= goal)
+					break;
+
+				if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to))
+					continue;
+
+				remap[collapse.from] = collapse.to;
+				add(quadrics[wedge[collapse.to]], quadrics[wedge[collapse.from]]);
+
+				//the triangles around both vertices change, their neighbours are checked again in the next pass
+				for (auto k = offsets[collapse.from]; k < offsets[collapse.from + 1]; k++)
+				{
+					const auto t = triangles[k] * 3;
+					touched[result[t]] = touched[result[t + 1]] = touched[result[t + 2]] = 1;
+				}
+				touched[collapse.to] = 1;
+
+				maxError = std::max(maxError, collapse.error);
+				done++;
+			}
+
+			if (done == 0)
+				break;
+
+			size_t write = 0;
+			for (size_t i = 0; i < result.size(); i += 3)
+			{
+				const auto a = remap[result[i]];
+				const auto b = remap[result[i + 1]];
+				const auto c = remap[result[i + 2]];
+				if (a == b || b == c || a == c)
+					continue;
+
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+			result.resize(write);
+		}
+
+		error = std::sqrt(maxError);
+		return result;
+	}
+
+	auto MeshSimplifier::buildLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods) -> void
+	{
+		PROFILE_FUNCTION();
+		lods.clear();
+		lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.f });
+
+		const auto vertexCount = static_cast<uint32_t>(vertices.size());
+		std::vector<uint32_t> current(indices);
+		float error = 0.f;
+
+		while (lods.size() < MAX_LODS && current.size() >= MIN_LOD_INDICES * 2)
+		{
+			const auto target = static_cast<uint32_t>(current.size() / 2 / 3 * 3);
+			float levelError = 0.f;
+			auto next = simplify(vertices.data(), vertexCount, current.data(), static_cast<uint32_t>(current.size()), target, levelError);
+
+			//locked seams and borders, the level would cost more than it saves
+			if (next.size() > current.size() * 3 / 4)
+				break;
+
+			//each level is simplified from the previous one, so the errors add up
+			error += levelError;
+			lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(next.size()), error });
+			indices.insert(indices.end(), next.begin(), next.end());
+			current = std::move(next);
+		}
+	}
+};
@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Vertex.h"
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	//one level of detail, a range of the index buffer of the mesh. every level uses the vertices of the full mesh.
+	struct MeshLod
+	{
+		uint32_t indexOffset = 0;
+		uint32_t indexCount = 0;
+		//largest distance between the level and the full mesh, in model units
+		float error = 0.f;
+	};
+
+	//Quadric error metric simplification (Garland & Heckbert) with half edge collapses,
+	//a vertex is always moved onto one of its neighbours so the simplified mesh only needs new indices.
+	//Vertices on uv or normal seams stay where they are, borders are kept by plane constraints.
+	namespace MeshSimplifier
+	{
+		static constexpr uint32_t MAX_LODS = 6;
+
+		//simplifies the triangles until targetIndexCount is reached or no collapse is left.
+		//error receives the largest error of the collapses which have been done.
+		MAPLE_EXPORT auto simplify(const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, uint32_t targetIndexCount, float& error) -> std::vector<uint32_t>;
+
+		//appends the levels after the full mesh to indices, every level has about half the triangles of the previous one.
+		//lods receives all the levels including the full mesh.
+		MAPLE_EXPORT auto buildLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods) -> void;
+	};
+};
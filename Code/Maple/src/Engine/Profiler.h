@@ -11,6 +11,7 @@
 #define PROFILE_LOCK(type, var, name) TracyLockableN(type, var, name)
 #define PROFILE_LOCKMARKER(var) LockMark(var)
 #define PROFILE_SETTHREADNAME(name) tracy::SetThreadName(name)
+#define PROFILE_PLOT(name, value) TracyPlot(name, value)
 #else
 #define PROFILE_SCOPE(name)
 #define PROFILE_FUNCTION()
@@ -18,4 +19,5 @@
 #define PROFILE_LOCK(type, var, name) type var
 #define PROFILE_LOCKMARKER(var)
 #define PROFILE_SETTHREADNAME(name)
+#define PROFILE_PLOT(name, value)
 #endif
@@ -10,7 +10,7 @@
 #include "Engine/Core.h"
 namespace Maple 
 {
-	class Texture2D;
+	class Texture;
 
 	class MAPLE_EXPORT Quad2D
 	{
@@ -29,7 +29,10 @@ namespace Maple
 
 		inline auto setOffset(const glm::vec2& c) { offset = c; }
 
-		inline auto setTexture(const std::shared_ptr<Texture2D>& texture) { this->texture = texture; }
+		inline auto setTexture(const std::shared_ptr<Texture>& texture) { this->texture = texture; }
+		//layer of a texture array, 0 for a 2D texture
+		inline auto getLayer() const { return layer; }
+		inline auto setLayer(uint32_t layer) { this->layer = layer; }
 		friend class Sprite;
 
 		auto setTexCoords(uint32_t x, uint32_t y, uint32_t w, uint32_t h) -> void;
@@ -42,7 +45,8 @@ namespace Maple
 		inline auto& getPivot() const { return pivot; }
 		inline auto setPivot(const glm::vec2 & val) { pivot = val; }
 	protected:
-		std::shared_ptr<Texture2D> texture;
+		std::shared_ptr<Texture> texture;
+		uint32_t layer = 0;
 		glm::vec4 color = {};
 		glm::vec2 offset = {};
 		std::array<glm::vec2, 4> texCoords = {};
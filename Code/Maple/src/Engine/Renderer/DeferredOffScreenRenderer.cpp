@@ -22,17 +22,64 @@
 #include "Engine/Camera.h"
 #include "Engine/Light.h"
 #include "Engine/Material.h"
+#include "Engine/MaterialPool.h"
 #include "Scene/Scene.h"
+#include "Scene/SceneBVH.h"
+#include "Terrain/QuadCollapseMesh.h"
 #include "FileSystem/File.h"
 #include "Application.h"
 #include "Engine/Vulkan/VulkanContext.h"
+#include "Engine/Vulkan/VulkanShader.h"
+#include "Engine/Profiler.h"
+#include "Others/Console.h"
+#include "Math/Frustum.h"
+#include "Math/BoundingBox.h"
 
 
 #include "ImGui/ImGuiHelpers.h"
 #include "OmniShadowRenderer.h"
 
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
 namespace Maple 
 {
+	namespace
+	{
+		constexpr uint32_t INITIAL_INSTANCE_CAPACITY = 1024;
+		//batches recorded by one worker, smaller lists are not worth a secondary command buffer
+		constexpr int32_t BATCHES_PER_CHUNK = 256;
+		//the profiler keeps the names, they have to live as long as the program
+		constexpr const char* LOD_TRIANGLE_PLOTS[MeshSimplifier::MAX_LODS] = {
+			"GBuffer LOD0 Triangles", "GBuffer LOD1 Triangles", "GBuffer LOD2 Triangles",
+			"GBuffer LOD3 Triangles", "GBuffer LOD4 Triangles", "GBuffer LOD5 Triangles"
+		};
+
+		//| pipeline : 4 | material : 20 | mesh : 20 | depth : 20 |
+		//state changes are ordered from the most to the least expensive, depth sorts the instances front to back.
+		inline auto makeSortKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth) -> uint64_t
+		{
+			//positive floats sort like their bit patterns, keep sign, exponent and the top mantissa bits.
+			uint32_t depthBits = 0;
+			depth = std::max(depth, 0.f);
+			std::memcpy(&depthBits, &depth, sizeof(float));
+
+			return (uint64_t(pipeline & 0xF) << 60) |
+				(uint64_t(material & 0xFFFFF) << 40) |
+				(uint64_t(mesh & 0xFFFFF) << 20) |
+				uint64_t(depthBits >> 12);
+		}
+
+		//ids are handed out in submission order, they only have to be stable within a frame.
+		template<typename T>
+		inline auto getSortId(std::unordered_map<const T*, uint32_t>& ids, const T* ptr) -> uint32_t
+		{
+			return ids.emplace(ptr, static_cast<uint32_t>(ids.size())).first->second;
+		}
+	};
+
 	DeferredOffScreenRenderer::DeferredOffScreenRenderer(uint32_t width, uint32_t height)
 	{
 		this->width = width;
@@ -60,6 +107,14 @@ namespace Maple
 
 		pipeline = Pipeline::create(pipeInfo);
 
+		//shaders compiled before the instance buffer was added still use push constants.
+		auto& layouts = std::static_pointer_cast<VulkanShader>(shader)->getDescriptorLayoutInfo();
+		instancing = std::any_of(layouts.begin(), layouts.end(), [](const DescriptorLayoutInfo& info) {
+			return info.type == DescriptorType::STORAGE_BUFFER;
+		});
+		if (!instancing)
+			LOGW("DeferredOffScreenRenderer : shader has no instance buffer, falling back to one draw per mesh");
+
 		createFrameBuffers();
 		createBuffers();
 
@@ -68,6 +123,8 @@ namespace Maple
 
 	auto DeferredOffScreenRenderer::begin() -> void
 	{
+		//properties edited or created during beginScene
+		MaterialPool::get()->flush();
 		renderPass->beginRenderPass(getCommandBuffer(),
 			{ 0.3,0.3,0.3,1 }, frameBuffers[0].get(), SubPassContents::INLINE, width,height);
 		uniformBuffer->setData(sizeof(UniformBufferObject), &systemVsUniformBuffer);
@@ -75,28 +132,186 @@ namespace Maple
 
 	auto DeferredOffScreenRenderer::present() -> void
 	{
-		pipeline->bind(getCommandBuffer());
-		for (auto& cmd : commandQueue)
+		PROFILE_FUNCTION();
+		const auto count = static_cast<int32_t>(batches.size());
+		if (instancing)
+		{
+			//batches are independent draws, long lists are recorded on the worker threads
+			std::mutex statsMutex;
+			recordParallel(count, [&](CommandBuffer* commandBuffer, int32_t begin, int32_t end) {
+				const auto stats = recordBatches(commandBuffer, begin, end);
+				std::lock_guard<std::mutex> lock(statsMutex);
+				drawStats.drawCalls += stats.drawCalls;
+				drawStats.stateChanges += stats.stateChanges;
+			}, BATCHES_PER_CHUNK);
+		}
+		else
+		{
+			//the transforms go through the push constants of the shader, which are shared
+			const auto stats = recordBatches(getCommandBuffer(), 0, count);
+			drawStats.drawCalls += stats.drawCalls;
+			drawStats.stateChanges += stats.stateChanges;
+		}
+
+		PROFILE_PLOT("GBuffer Draw Calls", static_cast<int64_t>(drawStats.drawCalls));
+		PROFILE_PLOT("GBuffer State Changes", static_cast<int64_t>(drawStats.stateChanges));
+		PROFILE_PLOT("GBuffer Triangles", static_cast<int64_t>(drawStats.triangles));
+		for (uint32_t i = 0; i < MeshSimplifier::MAX_LODS; i++)
+		{
+			PROFILE_PLOT(LOD_TRIANGLE_PLOTS[i], static_cast<int64_t>(drawStats.lodTriangles[i]));
+		}
+	}
+
+	auto DeferredOffScreenRenderer::recordBatches(CommandBuffer* commandBuffer, int32_t begin, int32_t end) -> DrawStats
+	{
+		DrawStats stats;
+		pipeline->bind(commandBuffer);
+		stats.stateChanges++;
+
+		Mesh* boundMesh = nullptr;
+		DescriptorSet* boundMaterial = nullptr;
+
+		for (auto i = begin; i < end; i++)
 		{
-			/*if (!cmd.material || !cmd.material->getShader())
-				continue;*/
+			auto& batch = batches[i];
+			if (batch.material.get() != boundMaterial)
+			{
+				bindDescriptorSets(pipeline.get(), commandBuffer, 0, { pipeline->getDescriptorSet(), batch.material });
+				boundMaterial = batch.material.get();
+				stats.stateChanges++;
+			}
 
-			const auto& sets = pipeline->getDescriptorSet();
-			const auto material = cmd.material != nullptr ? cmd.material->getDescriptorSet(pipeline.get()) : defaultMaterial->getDescriptorSet(pipeline.get());
-			
-			auto& pushConstants = shader->getPushConstants();
-			memcpy(pushConstants[0].data.get(), &cmd.transform, sizeof(glm::mat4));
-			shader->bindPushConstants(getCommandBuffer(), pipeline.get());
+			if (batch.mesh != boundMesh)
+			{
+				if (boundMesh != nullptr)
+				{
+					boundMesh->getVertexBuffer()->unbind();
+					boundMesh->getIndexBuffer()->unbind();
+				}
+				batch.mesh->bindVertexBuffers(commandBuffer, pipeline.get());
+				batch.mesh->getIndexBuffer()->bind(commandBuffer);
+				boundMesh = batch.mesh;
+				stats.stateChanges += 2;
+			}
 
-			cmd.mesh->getVertexBuffer()->bind(getCommandBuffer(), pipeline.get());
-			cmd.mesh->getIndexBuffer()-> bind(getCommandBuffer());
+			const auto lod = batch.mesh->getLod(batch.lod);
 
-			bindDescriptorSets(pipeline.get(), getCommandBuffer(), 0, { pipeline->getDescriptorSet(),material});
-			drawIndexed(getCommandBuffer(), DrawType::TRIANGLE, cmd.mesh->getIndexBuffer()->getCount(), 0);
+			if (instancing)
+			{
+				drawIndexed(commandBuffer, DrawType::TRIANGLE, lod.indexCount, lod.indexOffset, batch.instanceCount, batch.firstInstance);
+				stats.drawCalls++;
+			}
+			else
+			{
+				auto& pushConstants = shader->getPushConstants();
+				for (auto j = batch.firstInstance; j < batch.firstInstance + batch.instanceCount; j++)
+				{
+					memcpy(pushConstants[0].data.get(), &instanceTransforms[j], sizeof(glm::mat4));
+					shader->bindPushConstants(commandBuffer, pipeline.get());
+					drawIndexed(commandBuffer, DrawType::TRIANGLE, lod.indexCount, lod.indexOffset);
+					stats.drawCalls++;
+					stats.stateChanges++;
+				}
+			}
+		}
 
-			cmd.mesh->getVertexBuffer()->unbind();
-			cmd.mesh->getIndexBuffer()->unbind();
+		if (boundMesh != nullptr)
+		{
+			boundMesh->getVertexBuffer()->unbind();
+			boundMesh->getIndexBuffer()->unbind();
 		}
+		return stats;
+	}
+
+	auto DeferredOffScreenRenderer::buildBatches() -> void
+	{
+		PROFILE_FUNCTION();
+		std::unordered_map<const DescriptorSet*, uint32_t> materialIds;
+		std::unordered_map<const Mesh*, uint32_t> meshIds;
+
+		std::vector<std::shared_ptr<DescriptorSet>> materials;
+		materials.reserve(commandQueue.size());
+
+		sortKeys.clear();
+		sortKeys.reserve(commandQueue.size());
+
+		for (uint32_t i = 0; i < commandQueue.size(); i++)
+		{
+			auto& cmd = commandQueue[i];
+			auto& material = materials.emplace_back(cmd.material != nullptr ? 
+				cmd.material->getDescriptorSet(pipeline.get()) : defaultMaterial->getDescriptorSet(pipeline.get()));
+
+			const float depth = glm::length(glm::vec3(cmd.transform[3]) - eyePosition);
+			//every level of a mesh is its own batch
+			const auto meshId = getSortId(meshIds, static_cast<const Mesh*>(cmd.mesh)) * MeshSimplifier::MAX_LODS + cmd.lod;
+			sortKeys.emplace_back(makeSortKey(0, getSortId(materialIds, material.get()), meshId, depth), i);
+		}
+
+		std::sort(sortKeys.begin(), sortKeys.end(), [](const auto& a, const auto& b) {
+			return a.first < b.first;
+		});
+
+		batches.clear();
+		instanceTransforms.clear();
+		instanceTransforms.reserve(sortKeys.size());
+
+		constexpr uint64_t DEPTH_MASK = (uint64_t(1) << 20) - 1;
+		uint64_t lastState = ~uint64_t(0);
+
+		for (auto& [key, index] : sortKeys)
+		{
+			auto& cmd = commandQueue[index];
+			//same pipeline, material and mesh, only the depth differs
+			if ((key & ~DEPTH_MASK) != lastState)
+			{
+				auto& batch = batches.emplace_back();
+				batch.mesh = cmd.mesh;
+				batch.lod = cmd.lod;
+				batch.material = materials[index];
+				batch.firstInstance = static_cast<uint32_t>(instanceTransforms.size());
+				lastState = key & ~DEPTH_MASK;
+			}
+			batches.back().instanceCount++;
+			instanceTransforms.emplace_back(cmd.transform);
+		}
+
+		drawStats = {};
+		drawStats.instances = static_cast<uint32_t>(instanceTransforms.size());
+		for (auto& batch : batches)
+		{
+			const auto triangles = batch.mesh->getLod(batch.lod).indexCount / 3 * batch.instanceCount;
+			const auto level = std::min<uint32_t>(batch.lod, MeshSimplifier::MAX_LODS - 1);
+			drawStats.triangles += triangles;
+			drawStats.lodTriangles[level] += triangles;
+			drawStats.lodInstances[level] += batch.instanceCount;
+		}
+	}
+
+	auto DeferredOffScreenRenderer::updateInstanceBuffer() -> void
+	{
+		if (!instancing || instanceTransforms.empty())
+			return;
+
+		const auto count = static_cast<uint32_t>(instanceTransforms.size());
+		if (instanceBuffer == nullptr || count > instanceCapacity)
+		{
+			instanceCapacity = std::max(INITIAL_INSTANCE_CAPACITY, instanceCapacity);
+			while (instanceCapacity < count)
+				instanceCapacity *= 2;
+
+			instanceBuffer = UniformBuffer::createStorage(instanceCapacity * sizeof(glm::mat4), nullptr);
+
+			BufferInfo bufferInfo = {};
+			bufferInfo.buffer = instanceBuffer;
+			bufferInfo.offset = 0;
+			bufferInfo.size = instanceCapacity * sizeof(glm::mat4);
+			bufferInfo.type = DescriptorType::STORAGE_BUFFER;
+			bufferInfo.binding = 1;
+			bufferInfo.shaderType = ShaderType::VERTEX_SHADER;
+			bufferInfo.name = "InstanceBuffer";
+			pipeline->getDescriptorSet()->update({ bufferInfo });
+		}
+		instanceBuffer->setData(count * sizeof(glm::mat4), instanceTransforms.data());
 	}
 	
 
@@ -120,6 +335,7 @@ namespace Maple
 	auto DeferredOffScreenRenderer::beginScene(Scene* scene) -> void
 	{
 		commandQueue.clear();
+		batches.clear();
 		auto camera = scene->getCamera();
 
 		if (camera.first != nullptr)
@@ -136,17 +352,35 @@ namespace Maple
 
 
 			auto projView = camera.first->getProjectionMatrix() * view;
+			eyePosition = glm::inverse(view)[3];
 
 			systemVsUniformBuffer.projView = projView;
 
-			for (auto entity : group)
-			{
+			Frustum frustum;
+			frustum.from(projView);
+
+			//size of one unit at distance one, in pixels
+			const float pixelsPerUnit = camera.first->getProjectionMatrix()[1][1] * height * 0.5f;
+
+			totalCount = static_cast<uint32_t>(group.size());
+			visibleCount = 0;
+
+			auto submitMesh = [&](entt::entity entity) {
 				const auto& [mesh, trans] = group.get<MeshRenderer, Transform>(entity);
 
+				if (mesh.getMesh() == nullptr)
+					return;
+
+				//the terrain lod follows the camera, not the faces of an omni light
+				if (omniIndex == -1 && mesh.getMesh()->getType() == TERRAIN)
+					static_cast<QuadCollapseMesh*>(mesh.getMesh().get())->update(camera.first, view * trans.getWorldMatrix());
+
+				visibleCount++;
+
 				auto material = mesh.getMesh()->getMaterial();
 				if (material)
 				{
-					if (material->getDescriptorSet(pipeline.get()) == nullptr || material->getTexturesUpdated())
+					if (material->getDescriptorSet(pipeline.get()) == nullptr || material->getTexturesUpdated() || material->isTexturesOutdated())
 					{
 						material->createDescriptorSet(pipeline.get(), 1);
 						material->setTexturesUpdated(false);
@@ -157,8 +391,29 @@ namespace Maple
 				command.mesh = mesh.getMesh().get();
 				command.material = material;
 				command.transform = trans.getWorldMatrix();
+				command.lod = mesh.selectLod(command.transform, eyePosition, pixelsPerUnit, lodBias);
 				submit(command);
+			};
+
+			if (frustumCulling)
+			{
+				scene->getBVH()->query(frustum, [&](entt::entity entity, const BoundingBox&) {
+					submitMesh(entity);
+				});
+			}
+			else
+			{
+				for (auto entity : group)
+				{
+					submitMesh(entity);
+				}
 			}
+
+			buildBatches();
+			updateInstanceBuffer();
+
+			PROFILE_PLOT("GBuffer Visible", static_cast<int64_t>(visibleCount));
+			PROFILE_PLOT("GBuffer Total", static_cast<int64_t>(totalCount));
 		}
 	}
 
@@ -174,6 +429,17 @@ namespace Maple
 	auto DeferredOffScreenRenderer::onImGui() -> void
 	{
 		ImGuiHelper::property("Omni Index", omniIndex, -1, 5);
+		ImGuiHelper::property("Frustum Culling", frustumCulling);
+		ImGui::Text("Visible Meshes : %u / %u", visibleCount, totalCount);
+		ImGui::Text("Draw Calls : %u, Instances : %u, Batches : %u", drawStats.drawCalls, drawStats.instances, static_cast<uint32_t>(batches.size()));
+		ImGui::Text("State Changes : %u%s", drawStats.stateChanges, instancing ? "" : " (instancing disabled)");
+		ImGuiHelper::property("LOD Bias", lodBias, -4.f, 4.f);
+		ImGui::Text("Triangles : %u", drawStats.triangles);
+		for (uint32_t i = 0; i < MeshSimplifier::MAX_LODS; i++)
+		{
+			if (drawStats.lodInstances[i] > 0)
+				ImGui::Text("LOD %u : %u meshes, %u triangles", i, drawStats.lodInstances[i], drawStats.lodTriangles[i]);
+		}
 	}
 
 	auto DeferredOffScreenRenderer::createDefaultMaterial() -> void
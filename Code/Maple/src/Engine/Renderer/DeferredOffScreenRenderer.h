@@ -6,9 +6,11 @@
 #include <cstdint>
 #include <memory>
 #include <vector>
+#include <array>
 #include <glm/glm.hpp>
 #include "RenderParam.h"
 #include "Renderer.h"
+#include "Engine/MeshSimplifier.h"
 
 namespace Maple 
 {
@@ -18,6 +20,7 @@ namespace Maple
 	class FrameBuffer;
 	class Camera;
 	class Material;
+	class Mesh;
 
 	class MAPLE_EXPORT DeferredOffScreenRenderer : public Renderer
 	{
@@ -49,8 +52,46 @@ namespace Maple
 		};
 
 		auto createFrameBuffers() -> void;
+		//sort the queue and merge runs of the same mesh and material into instanced batches.
+		auto buildBatches() -> void;
+		auto updateInstanceBuffer() -> void;
+
+		//one draw (or one draw per instance without instancing support)
+		struct DrawBatch
+		{
+			Mesh* mesh = nullptr;
+			uint32_t lod = 0;
+			std::shared_ptr<DescriptorSet> material;
+			uint32_t firstInstance = 0;
+			uint32_t instanceCount = 0;
+		};
+
+		struct DrawStats
+		{
+			uint32_t drawCalls = 0;
+			uint32_t instances = 0;
+			//pipeline, descriptor set, vertex/index buffer and push constant binds
+			uint32_t stateChanges = 0;
+			uint32_t triangles = 0;
+			std::array<uint32_t, MeshSimplifier::MAX_LODS> lodInstances = {};
+			std::array<uint32_t, MeshSimplifier::MAX_LODS> lodTriangles = {};
+		};
+
+		//binds everything it needs, so chunks of the batch list can be recorded into separate command buffers.
+		auto recordBatches(CommandBuffer* commandBuffer, int32_t begin, int32_t end) -> DrawStats;
 
 		std::shared_ptr<UniformBuffer> uniformBuffer;
+		//per instance transforms, read by the vertex shader with gl_InstanceIndex
+		std::shared_ptr<UniformBuffer> instanceBuffer;
+		uint32_t instanceCapacity = 0;
+		//false if the shader still takes the transform as a push constant
+		bool instancing = false;
+
+		glm::vec3 eyePosition = {};
+		std::vector<std::pair<uint64_t, uint32_t>> sortKeys;
+		std::vector<glm::mat4> instanceTransforms;
+		std::vector<DrawBatch> batches;
+		DrawStats drawStats;
 
 		UniformBufferObject systemVsUniformBuffer;
 
@@ -59,5 +100,11 @@ namespace Maple
 
 		//##################
 		int32_t omniIndex = -1;
+
+		bool frustumCulling = true;
+		//log2 of the error in pixels a level of detail may show
+		float lodBias = 0.f;
+		uint32_t visibleCount = 0;
+		uint32_t totalCount = 0;
 	};
 };
\ No newline at end of file
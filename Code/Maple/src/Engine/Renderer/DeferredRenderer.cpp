@@ -38,6 +38,10 @@
 #include "OmniShadowRenderer.h"
 #include "ShadowRenderer.h"
 #include "Application.h"
+#include "Engine/Profiler.h"
+#include "Others/Console.h"
+#include "Thread/ThreadPool.h"
+#include <algorithm>
 
 namespace Maple 
 {
@@ -94,6 +98,14 @@ namespace Maple
 		pipeInfo.depthBiasEnabled = false;
 		pipeline = Pipeline::create(pipeInfo);
 
+		//shaders compiled before the cluster buffers were added read every light from the uniform buffer.
+		auto& layouts = std::static_pointer_cast<VulkanShader>(shader)->getDescriptorLayoutInfo();
+		clustered = std::any_of(layouts.begin(), layouts.end(), [](const DescriptorLayoutInfo& info) {
+			return info.type == DescriptorType::STORAGE_BUFFER;
+		});
+		if (!clustered)
+			LOGW("DeferredRenderer : shader has no cluster buffers, falling back to {0} lights", MAX_LIGHTS);
+
 		createFrameBuffers();
 		createLightBuffer();
 
@@ -124,12 +136,13 @@ namespace Maple
 		auto& sets = pipeline->getDescriptorSet();
 			
 		lightUniformBuffer->setData(sizeof(UniformBufferObject), &systemVsUniformBuffer);
+		updateClusterBuffers();
 		
 		const std::vector<std::shared_ptr<DescriptorSet>> desSets{ sets,descriptorSet };
 			
 		pipeline->bind(getCommandBuffer());
 	
-		screenQuad->getVertexBuffer()->bind(getCommandBuffer(), pipeline.get());
+		screenQuad->bindVertexBuffers(getCommandBuffer(), pipeline.get());
 		screenQuad->getIndexBuffer() ->bind(getCommandBuffer());
 
 
@@ -224,6 +237,63 @@ namespace Maple
 		bufferInfo.binding = 0;
 		bufferInfo.shaderType = ShaderType::FRAGMENT_SHADER;
 		pipeline->getDescriptorSet()->update({ bufferInfo });
+
+		if (clustered && clusterBuffer == nullptr)
+		{
+			const auto dimensions = lightClusters.getDimensions();
+			const uint32_t size = dimensions.x * dimensions.y * dimensions.z * sizeof(glm::uvec2);
+			clusterBuffer = UniformBuffer::createStorage(size, nullptr);
+
+			BufferInfo clusterInfo = {};
+			clusterInfo.name = "ClusterBuffer";
+			clusterInfo.buffer = clusterBuffer;
+			clusterInfo.offset = 0;
+			clusterInfo.size = size;
+			clusterInfo.type = DescriptorType::STORAGE_BUFFER;
+			clusterInfo.binding = 2;
+			clusterInfo.shaderType = ShaderType::FRAGMENT_SHADER;
+			pipeline->getDescriptorSet()->update({ clusterInfo });
+		}
+	}
+
+	auto DeferredRenderer::updateClusterBuffers() -> void
+	{
+		PROFILE_FUNCTION();
+		if (!clustered)
+			return;
+
+		auto createStorage = [&](std::shared_ptr<UniformBuffer>& buffer, uint32_t& capacity, uint32_t count, uint32_t stride, uint32_t binding, const std::string& name) {
+			if (buffer != nullptr && count <= capacity)
+				return;
+
+			capacity = std::max(capacity, 64u);
+			while (capacity < count)
+				capacity *= 2;
+
+			buffer = UniformBuffer::createStorage(capacity * stride, nullptr);
+
+			BufferInfo bufferInfo = {};
+			bufferInfo.name = name;
+			bufferInfo.buffer = buffer;
+			bufferInfo.offset = 0;
+			bufferInfo.size = capacity * stride;
+			bufferInfo.type = DescriptorType::STORAGE_BUFFER;
+			bufferInfo.binding = binding;
+			bufferInfo.shaderType = ShaderType::FRAGMENT_SHADER;
+			pipeline->getDescriptorSet()->update({ bufferInfo });
+		};
+
+		auto& indices = lightClusters.getIndices();
+		createStorage(localLightBuffer, localLightCapacity, static_cast<uint32_t>(localLights.size()), sizeof(LightData), 1, "LightBuffer");
+		createStorage(lightIndexBuffer, lightIndexCapacity, static_cast<uint32_t>(indices.size()), sizeof(uint32_t), 3, "LightIndexBuffer");
+
+		if (!localLights.empty())
+			localLightBuffer->setData(static_cast<uint32_t>(localLights.size() * sizeof(LightData)), localLights.data());
+		if (!indices.empty())
+			lightIndexBuffer->setData(static_cast<uint32_t>(indices.size() * sizeof(uint32_t)), indices.data());
+
+		auto& grid = lightClusters.getGrid();
+		clusterBuffer->setData(static_cast<uint32_t>(grid.size() * sizeof(glm::uvec2)), grid.data());
 	}
 
 	auto DeferredRenderer::onImGui() -> void
@@ -232,6 +302,17 @@ namespace Maple
 
 		ImGuiHelper::property("Cascade Color", systemVsUniformBuffer.colorCascade, 0, 1);
 
+		ImGui::Text("Lights : %u directional, %u local, %u dropped", lightStats.directional, lightStats.local, lightStats.dropped);
+		if (clustered)
+		{
+			const auto dimensions = lightClusters.getDimensions();
+			ImGui::Text("Clusters : %u x %u x %u, Indices : %u, Max Per Cluster : %u", dimensions.x, dimensions.y, dimensions.z, lightStats.indices, lightStats.maxPerCluster);
+		}
+		else
+		{
+			ImGui::Text("Clusters : disabled (shader has no cluster buffers)");
+		}
+
 		if (deferredOffScreenRenderer != nullptr) {
 			deferredOffScreenRenderer->onImGui();
 		}
@@ -339,8 +420,11 @@ namespace Maple
 		{
 			auto& registry = scene->getRegistry();
 			auto lights = registry.view<Light>();
-			systemVsUniformBuffer.lightCount = lights.size();
-	
+
+			lightStats = {};
+			localLights.clear();
+			lightSpheres.clear();
+
 			int32_t i = 0;
 			for (auto entity : lights)
 			{
@@ -348,9 +432,46 @@ namespace Maple
 				auto forward = trans.getWorldOrientation() * Maple::FORWARD;
 				light.lightData.direction = { glm::normalize(forward),1 };
 				light.lightData.position =  { trans.getWorldPosition(),1 };
-				systemVsUniformBuffer.lights[i++] = light.lightData;
+
+				if (clustered && static_cast<LightType>(static_cast<int32_t>(light.lightData.type)) != LightType::DirectionalLight)
+				{
+					localLights.emplace_back(light.lightData);
+					lightSpheres.emplace_back(glm::vec3(light.lightData.position), light.lightData.radius);
+				}
+				else if (i < MAX_LIGHTS)
+				{
+					systemVsUniformBuffer.lights[i++] = light.lightData;
+				}
+				else
+				{
+					lightStats.dropped++;
+				}
+			}
+			systemVsUniformBuffer.lightCount = i;
+
+			lightStats.directional = i;
+			lightStats.local = static_cast<uint32_t>(localLights.size());
+
+			if (clustered)
+			{
+				auto view = glm::inverse(camera.second->getWorldMatrix());
+				lightClusters.build(view, camera.first->getProjectionMatrix(), camera.first->getNear(), camera.first->getFar(),
+					lightSpheres.data(), static_cast<uint32_t>(lightSpheres.size()), Application::get()->getThreadPool().get());
+
+				const auto dimensions = lightClusters.getDimensions();
+				systemVsUniformBuffer.clusterGrid = { dimensions, 1 };
+				systemVsUniformBuffer.clusterDepth = lightClusters.getDepthParams();
+				lightStats.indices = static_cast<uint32_t>(lightClusters.getIndices().size());
+				lightStats.maxPerCluster = lightClusters.getMaxLightsPerCluster();
+			}
+			else
+			{
+				systemVsUniformBuffer.clusterGrid = {};
 			}
 
+			PROFILE_PLOT("Local Lights", static_cast<int64_t>(lightStats.local));
+			PROFILE_PLOT("Cluster Light Indices", static_cast<int64_t>(lightStats.indices));
+
 			systemVsUniformBuffer.viewPos = glm::inverse(camera.second->getWorldMatrix());
 			systemVsUniformBuffer.cameraPos = glm::vec4(camera.second->getWorldPosition(),1.0);
 			systemVsUniformBuffer.prefilterLODLevel = environmentMap ? environmentMap->getMipLevel() : 0;
@@ -11,6 +11,7 @@
 #include "Renderer.h"
 #include "Event/EventHandler.h"
 #include "Scene/Component/Light.h"
+#include "LightClusters.h"
 
 namespace Maple 
 {
@@ -48,6 +49,7 @@ namespace Maple
 		auto updateScreenDescriptorSet() -> void;
 
 		auto submitLight(Scene* scene) -> void;
+		auto updateClusterBuffers() -> void;
 
 
 		struct UniformBufferObject {
@@ -76,6 +78,20 @@ namespace Maple
 			int32_t padding2;
 			int32_t padding3;
 
+			//x, y, z, 1 if local lights are read from the cluster buffers
+			glm::ivec4 clusterGrid;
+			//near, far, scale, bias : slice = log(viewDepth) * scale + bias
+			glm::vec4 clusterDepth;
+		};
+
+		struct LightStats
+		{
+			uint32_t directional = 0;
+			uint32_t local = 0;
+			//lights beyond MAX_LIGHTS in the uniform buffer
+			uint32_t dropped = 0;
+			uint32_t indices = 0;
+			uint32_t maxPerCluster = 0;
 		};
 
 		auto createFrameBuffers() -> void;
@@ -89,6 +105,19 @@ namespace Maple
 		std::shared_ptr<DescriptorSet> descriptorSet;
 		std::shared_ptr<UniformBuffer> lightUniformBuffer;
 
+		//point and spot lights are binned into clusters, only directional lights stay in the uniform buffer.
+		//false if the shader was compiled before the cluster buffers were added.
+		bool clustered = false;
+		LightClusters lightClusters;
+		std::vector<LightData> localLights;
+		std::vector<glm::vec4> lightSpheres;
+		std::shared_ptr<UniformBuffer> localLightBuffer;
+		std::shared_ptr<UniformBuffer> clusterBuffer;
+		std::shared_ptr<UniformBuffer> lightIndexBuffer;
+		uint32_t localLightCapacity = 0;
+		uint32_t lightIndexCapacity = 0;
+		LightStats lightStats;
+
 		std::shared_ptr<Texture2D> defaultTexture;
 		std::shared_ptr <Mesh> screenQuad;
 
@@ -121,7 +121,7 @@ namespace Maple
 
 		/*	
 			pipeline->bind(commandBuffers[bufferId].get());
-			cmd.mesh->getVertexBuffer()->bind(commandBuffers[bufferId].get(), pipeline.get());
+			cmd.mesh->bindVertexBuffers(commandBuffers[bufferId].get(), pipeline.get());
 			cmd.mesh->getIndexBuffer()->bind(commandBuffers[bufferId].get());
 */
 
@@ -67,7 +67,7 @@ namespace Maple
 	{
 		pipeline->bind(getCommandBuffer());
 
-		quad->getVertexBuffer()->bind(getCommandBuffer(), pipeline.get());
+		quad->bindVertexBuffers(getCommandBuffer(), pipeline.get());
 		quad->getIndexBuffer()->bind(getCommandBuffer());
 
 		bindDescriptorSets(pipeline.get(), getCommandBuffer(), 0, {pipeline->getDescriptorSet()});
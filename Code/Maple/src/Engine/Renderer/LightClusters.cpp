@@ -0,0 +1,156 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "LightClusters.h"
+#include "Thread/ThreadPool.h"
+#include "Engine/Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Maple
+{
+	namespace
+	{
+		//distance from v to the range [min, max], 0 inside
+		inline auto distanceToRange(float v, float min, float max) -> float
+		{
+			return std::max(std::max(min - v, 0.f), v - max);
+		}
+	};
+
+	LightClusters::LightClusters(uint32_t x, uint32_t y, uint32_t z)
+		:dimX(x), dimY(y), dimZ(z)
+	{
+		clusterLights.resize(dimX * dimY * dimZ);
+		grid.resize(dimX * dimY * dimZ);
+	}
+
+	auto LightClusters::build(const glm::mat4& view, const glm::mat4& projection, float near, float far,
+		const glm::vec4* lights, uint32_t count, ThreadPool* pool) -> void
+	{
+		PROFILE_FUNCTION();
+		near_ = std::max(near, 0.0001f);
+		far_ = std::max(far, near_ * 1.001f);
+
+		const float logRatio = std::log(far_ / near_);
+		sliceScale = dimZ / logRatio;
+		sliceBias = -(dimZ * std::log(near_)) / logRatio;
+
+		//perspective : view = ndc * depth / p[i][i], orthographic : view = ndc / p[i][i]
+		const bool perspective = projection[2][3] != 0.f;
+		const glm::vec2 inverseScale = { 1.f / projection[0][0], 1.f / projection[1][1] };
+		extentSlope = perspective ? inverseScale : glm::vec2(0.f);
+		extentOffset = perspective ? glm::vec2(0.f) : inverseScale;
+
+		spheres.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto& sphere = spheres[i];
+			sphere.center = glm::vec3(view * glm::vec4(glm::vec3(lights[i]), 1.f));
+			sphere.radius = lights[i].w;
+			sphere.minDepth = -sphere.center.z - sphere.radius;
+			sphere.maxDepth = -sphere.center.z + sphere.radius;
+		}
+
+		if (pool != nullptr)
+		{
+			pool->parallelFor(0, dimZ, [&](int32_t slice) {
+				binSlice(slice);
+			});
+		}
+		else
+		{
+			for (uint32_t slice = 0; slice < dimZ; slice++)
+				binSlice(slice);
+		}
+
+		indices.clear();
+		maxLightsPerCluster = 0;
+		for (uint32_t i = 0; i < clusterLights.size(); i++)
+		{
+			auto& list = clusterLights[i];
+			grid[i] = { static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(list.size()) };
+			indices.insert(indices.end(), list.begin(), list.end());
+			maxLightsPerCluster = std::max(maxLightsPerCluster, static_cast<uint32_t>(list.size()));
+		}
+	}
+
+	auto LightClusters::getSlice(float depth) const -> uint32_t
+	{
+		const float slice = std::floor(std::log(std::max(depth, near_)) * sliceScale + sliceBias);
+		return static_cast<uint32_t>(std::clamp(slice, 0.f, float(dimZ - 1)));
+	}
+
+	auto LightClusters::getSliceDepth(uint32_t slice) const -> float
+	{
+		return near_ * std::pow(far_ / near_, float(slice) / dimZ);
+	}
+
+	auto LightClusters::binSlice(uint32_t slice) -> void
+	{
+		const float minDepth = getSliceDepth(slice);
+		const float maxDepth = getSliceDepth(slice + 1);
+
+		//clusters are separable : the x range of a column only depends on the slice, the same goes for rows.
+		//the range of a column is the union over the depth range of the slice.
+		std::vector<glm::vec2> columns(dimX);
+		std::vector<glm::vec2> rows(dimY);
+
+		auto extent = [&](float ndc0, float ndc1, int32_t axis) -> glm::vec2 {
+			const float e0 = minDepth * extentSlope[axis] + extentOffset[axis];
+			const float e1 = maxDepth * extentSlope[axis] + extentOffset[axis];
+			const float a = ndc0 * e0, b = ndc0 * e1, c = ndc1 * e0, d = ndc1 * e1;
+			return { std::min(std::min(a, b), std::min(c, d)), std::max(std::max(a, b), std::max(c, d)) };
+		};
+
+		for (uint32_t x = 0; x < dimX; x++)
+			columns[x] = extent(2.f * x / dimX - 1.f, 2.f * (x + 1) / dimX - 1.f, 0);
+
+		//rows follow the texture coordinates of the screen quad, ndc y = 2 * v - 1
+		for (uint32_t y = 0; y < dimY; y++)
+			rows[y] = extent(2.f * y / dimY - 1.f, 2.f * (y + 1) / dimY - 1.f, 1);
+
+		for (uint32_t i = 0; i < dimX * dimY; i++)
+			clusterLights[slice * dimX * dimY + i].clear();
+
+		std::vector<float> dx2(dimX);
+
+		for (uint32_t light = 0; light < spheres.size(); light++)
+		{
+			const auto& sphere = spheres[light];
+			if (sphere.maxDepth < minDepth || sphere.minDepth > maxDepth)
+				continue;
+
+			const float dz = distanceToRange(-sphere.center.z, minDepth, maxDepth);
+			const float r2 = sphere.radius * sphere.radius - dz * dz;
+			if (r2 < 0.f)
+				continue;
+
+			for (uint32_t x = 0; x < dimX; x++)
+			{
+				const float d = distanceToRange(sphere.center.x, columns[x].x, columns[x].y);
+				dx2[x] = d * d;
+			}
+
+			for (uint32_t y = 0; y < dimY; y++)
+			{
+				const float d = distanceToRange(sphere.center.y, rows[y].x, rows[y].y);
+				const float dy2 = d * d;
+				if (dy2 > r2)
+					continue;
+
+				for (uint32_t x = 0; x < dimX; x++)
+				{
+					if (dx2[x] + dy2 > r2)
+						continue;
+
+					auto& list = clusterLights[getClusterIndex(x, y, slice)];
+					if (list.size() < MAX_LIGHTS_PER_CLUSTER)
+						list.emplace_back(light);
+				}
+			}
+		}
+	}
+};
@@ -0,0 +1,81 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	class ThreadPool;
+
+	//Assigns local lights to the clusters (froxels) of the view frustum.
+	//Tiles are uniform in screen space, slices are exponential in view depth.
+	//Only uses glm, so it can run (and be tested) without a device.
+	class MAPLE_EXPORT LightClusters final
+	{
+	public:
+		static constexpr uint32_t DEFAULT_X = 16;
+		static constexpr uint32_t DEFAULT_Y = 9;
+		static constexpr uint32_t DEFAULT_Z = 24;
+		//lights beyond this are dropped from a cluster.
+		static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+
+		LightClusters(uint32_t x = DEFAULT_X, uint32_t y = DEFAULT_Y, uint32_t z = DEFAULT_Z);
+
+		//spheres : xyz world position, w radius.
+		//projection is only read for the extents of the frustum, both perspective and orthographic work.
+		//with a pool the depth slices are binned in parallel.
+		auto build(const glm::mat4& view, const glm::mat4& projection, float near, float far,
+			const glm::vec4* spheres, uint32_t count, ThreadPool* pool = nullptr) -> void;
+
+		inline auto getClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return x + dimX * (y + dimY * z); }
+		//slice of a positive view depth, the shader does the same with getDepthParams()
+		auto getSlice(float depth) const -> uint32_t;
+
+		//per cluster : x = offset into getIndices(), y = count
+		inline auto& getGrid() const { return grid; }
+		inline auto& getIndices() const { return indices; }
+		inline auto getDimensions() const { return glm::uvec3(dimX, dimY, dimZ); }
+		//near, far, scale, bias : slice = log(depth) * scale + bias
+		inline auto getDepthParams() const { return glm::vec4(near_, far_, sliceScale, sliceBias); }
+		inline auto getMaxLightsPerCluster() const { return maxLightsPerCluster; }
+
+	private:
+		struct ViewSphere
+		{
+			glm::vec3 center;
+			float radius;
+			//view depth range, depth = -z
+			float minDepth;
+			float maxDepth;
+		};
+
+		auto binSlice(uint32_t slice) -> void;
+		auto getSliceDepth(uint32_t slice) const -> float;
+
+		uint32_t dimX;
+		uint32_t dimY;
+		uint32_t dimZ;
+
+		float near_ = 0.1f;
+		float far_ = 1000.f;
+		float sliceScale = 0.f;
+		float sliceBias = 0.f;
+
+		//view extent at depth d for ndc 1 : d * slope + offset (slope is 0 for orthographic)
+		glm::vec2 extentSlope = {};
+		glm::vec2 extentOffset = {};
+
+		std::vector<ViewSphere> spheres;
+		//lights of every cluster, filled per slice so slices can run in parallel.
+		std::vector<std::vector<uint32_t>> clusterLights;
+
+		std::vector<glm::uvec2> grid;
+		std::vector<uint32_t> indices;
+		uint32_t maxLightsPerCluster = 0;
+	};
+};
@@ -273,7 +273,7 @@ namespace Maple
 		vertexBuffers.resize(100);
 		for (auto& vertexBuffer : vertexBuffers)
 		{
-			vertexBuffer.reset(new VertexBuffer());
+			vertexBuffer.reset(new VertexBuffer(BufferUsage::DYNAMIC));
 			vertexBuffer->resize(RENDERER_BUFFER_SIZE, nullptr);
 		}
 		std::vector<uint32_t> indices;
@@ -31,12 +31,14 @@
 #include "Engine/Light.h"
 #include "Engine/Material.h"
 #include "Scene/Scene.h"
+#include "Scene/SceneBVH.h"
 #include "FileSystem/File.h"
 #include "DeferredOffScreenRenderer.h"
 
 #include "ImGui/ImGuiHelpers.h"
 
 #include "Application.h"
+#include "Math/BoundingBox.h"
 
 namespace Maple 
 {
@@ -87,7 +89,7 @@ namespace Maple
 		{
 			Mesh* mesh = command.mesh;
 
-			mesh->getVertexBuffer()->bind(getCommandBuffer(), pipeline.get());
+			mesh->bindVertexBuffers(getCommandBuffer(), pipeline.get());
 			mesh->getIndexBuffer()->bind (getCommandBuffer());
 
 			auto & constants = shader->getPushConstants();
@@ -98,7 +100,8 @@ namespace Maple
 			shader->bindPushConstants(getCommandBuffer(), pipeline.get());
 
 			bindDescriptorSets(pipeline.get(), getCommandBuffer(), 0, { pipeline->getDescriptorSet() });
-			drawIndexed(getCommandBuffer(), DrawType::TRIANGLE, mesh->getIndexBuffer()->getCount());
+			const auto lod = mesh->getLod(command.lod);
+			drawIndexed(getCommandBuffer(), DrawType::TRIANGLE, lod.indexCount, lod.indexOffset);
 
 			mesh->getVertexBuffer()->unbind();
 			mesh->getIndexBuffer()->unbind();
@@ -170,27 +173,45 @@ namespace Maple
 			q.clear();
 		}
 
-		auto group = registry.group<MeshRenderer>(entt::get<Transform>);
-		for (uint32_t i = 0; i < shadowCommandQueue.size(); ++i)
+		const float radius = systemUniformBuffer.radius;
+		for (auto i = 0; i < 6; i++)
 		{
-		
-			if (group.empty())
-				continue;
+			faceFrustums[i].from(systemUniformBuffer.projView * lightViews[i]);
+		}
 
-			for (auto entity : group)
-			{
-				const auto& [render, trans] = group.get<MeshRenderer,Transform>(entity);
+		auto group = registry.group<MeshRenderer>(entt::get<Transform>);
 
-				if (render.getMesh()) 
+		auto submitCaster = [&](entt::entity entity, const BoundingBox& worldBox) {
+			const auto& [render, trans] = group.get<MeshRenderer, Transform>(entity);
+			if (render.getMesh())
+			{
+				RenderCommand command;
+				command.mesh = render.getMesh().get();
+				command.transform = trans.getWorldMatrix();
+				command.material = nullptr;
+				//the level the gbuffer pass picked for the camera
+				command.lod = render.getLod();
+
+				for (uint32_t i = 0; i < shadowCommandQueue.size(); ++i)
 				{
-					//TODO calculate if the mesh is in the light view.
-					RenderCommand command;
-					command.mesh = render.getMesh().get();
-					command.transform = trans.getWorldMatrix();;
-					command.material = nullptr;
-					submit(command,i);
+					if (faceCulling && !faceFrustums[i].isInside(worldBox))
+						continue;
+					submit(command, i);
 				}
 			}
+		};
+
+		if (faceCulling)
+		{
+			//only the casters inside the light's sphere of influence
+			scene->getBVH()->query(lightPos, radius, submitCaster);
+		}
+		else
+		{
+			for (auto entity : group)
+			{
+				submitCaster(entity, BoundingBox{});
+			}
 		}
 	}
 
@@ -198,6 +219,11 @@ namespace Maple
 	{
 		//ImGuiHelper::property("cascadeSplitLambda", cascadeSplitLambda, 0.01f, 1.f);
 		//ImGuiHelper::property("bias", initialBias, 0.0001f, 0.5f);
+		ImGuiHelper::property("Face Culling", faceCulling);
+		for (uint32_t i = 0; i < shadowCommandQueue.size(); ++i)
+		{
+			ImGui::Text("Face %u Casters : %u", i, static_cast<uint32_t>(shadowCommandQueue[i].size()));
+		}
 	}
 
 	auto OmniShadowRenderer::end() -> void
@@ -225,10 +251,16 @@ namespace Maple
 		{
 			for (int32_t i = 0; i < 6; i++)
 			{
+				//an empty face only needs to be cleared once, after that the cube face already holds the cleared result.
+				const bool empty = shadowCommandQueue[i].empty();
+				if (empty && faceCleared[i])
+					continue;
+
 				commandQueueId = i;
 				begin();
 				present();
 				end();
+				faceCleared[i] = empty;
 			}
 		}
 	}
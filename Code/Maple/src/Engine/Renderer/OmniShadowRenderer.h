@@ -10,6 +10,7 @@
 #include "RenderParam.h"
 #include "Renderer.h"
 #include "Scene/Component/Light.h"
+#include "Math/Frustum.h"
 
 namespace Maple 
 {
@@ -66,6 +67,9 @@ namespace Maple
 		std::shared_ptr<FrameBuffer>  shadowFrameBuffer;
 		std::array<std::vector<RenderCommand>, 6> shadowCommandQueue;
 		std::array<glm::mat4, 6> lightViews;
+		std::array<Frustum, 6> faceFrustums;
+		std::array<bool, 6> faceCleared = {};
+		bool faceCulling = true;
 		uint32_t shadowMapSize = 0;
 		uint32_t commandQueueId = 0;
 
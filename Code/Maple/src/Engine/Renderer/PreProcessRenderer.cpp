@@ -152,7 +152,7 @@ namespace Maple
 			//uniform
 		auto& constants = currentShader->getPushConstants();
 
-		cube->getVertexBuffer()->bind(cmd, currentPipeline);
+		cube->bindVertexBuffers(cmd, currentPipeline);
 		cube->getIndexBuffer()->bind(cmd);
 		if (constants.size() > 0)
 		{
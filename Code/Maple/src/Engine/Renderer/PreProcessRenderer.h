@@ -36,6 +36,8 @@ namespace Maple
 		auto submit(const RenderCommand& cmd) -> void override {};
 		auto renderScene() -> void override;
 		auto beginScene(Scene* scene) -> void override;
+		//executes its own command buffers
+		inline auto canRecordParallel() const -> bool override { return false; }
 
 	private:
 		auto updateIrradianceDescriptor() -> void;
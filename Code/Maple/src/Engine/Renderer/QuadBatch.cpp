@@ -0,0 +1,160 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#include "QuadBatch.h"
+#include "Thread/ThreadPool.h"
+#include "Engine/Profiler.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SPRITE_SSE
+#endif
+
+namespace Maple
+{
+	namespace
+	{
+		constexpr int32_t SORT_CHUNK = 16384;
+		//32 bits of depth and 16 bits of layer
+		constexpr uint32_t SORT_PASSES = 6;
+
+		static_assert(sizeof(Vertex2D) == sizeof(float) * 10, "writeQuad expects a tightly packed Vertex2D");
+
+		//float bits which sort in the same order as the float
+		inline auto orderedBits(float value) -> uint32_t
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+		}
+
+		//the four corners of the quad, transform * (x, y, 0, 1) with the shared products computed once
+		inline auto writeQuad(Vertex2D* out, const Quad2D& quad, const glm::mat4& transform) -> void
+		{
+			const auto& min = quad.getOffset();
+			const glm::vec2 max = min + glm::vec2{ quad.getWidth(), quad.getHeight() };
+			const auto& uv = quad.getTexCoords();
+			const auto& color = quad.getColor();
+			//sprites come from the texture pool, a textured quad samples its layer of the pages
+			const float layer = quad.getTexture() ? quad.getLayer() + 1.f : -1.f;
+
+#ifdef SPRITE_SSE
+			const __m128 column0 = _mm_loadu_ps(&transform[0][0]);
+			const __m128 column1 = _mm_loadu_ps(&transform[1][0]);
+			const __m128 column3 = _mm_loadu_ps(&transform[3][0]);
+			const __m128 left = _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(min.x)), column3);
+			const __m128 right = _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(max.x)), column3);
+			const __m128 bottom = _mm_mul_ps(column1, _mm_set1_ps(min.y));
+			const __m128 top = _mm_mul_ps(column1, _mm_set1_ps(max.y));
+			const __m128 corners[4] = {
+				_mm_add_ps(left, bottom),
+				_mm_add_ps(right, bottom),
+				_mm_add_ps(right, top),
+				_mm_add_ps(left, top)
+			};
+			const __m128 rgba = _mm_loadu_ps(&color.x);
+			const __m128 ba = _mm_movehl_ps(rgba, rgba);
+
+			//every vertex is written as xyzu, v layer rg, ba
+			for (int32_t i = 0; i < 4; i++)
+			{
+				auto dst = reinterpret_cast<float*>(out + i);
+				const __m128 texCoord = _mm_setr_ps(uv[i].x, uv[i].y, layer, 0.f);
+				const __m128 zu = _mm_shuffle_ps(corners[i], texCoord, _MM_SHUFFLE(0, 0, 2, 2));
+				_mm_storeu_ps(dst, _mm_shuffle_ps(corners[i], zu, _MM_SHUFFLE(2, 0, 1, 0)));
+				_mm_storeu_ps(dst + 4, _mm_shuffle_ps(texCoord, rgba, _MM_SHUFFLE(1, 0, 2, 1)));
+				_mm_storel_pi(reinterpret_cast<__m64*>(dst + 8), ba);
+			}
+#else
+			const glm::vec3 left = glm::vec3(transform[0]) * min.x + glm::vec3(transform[3]);
+			const glm::vec3 right = glm::vec3(transform[0]) * max.x + glm::vec3(transform[3]);
+			const glm::vec3 bottom = glm::vec3(transform[1]) * min.y;
+			const glm::vec3 top = glm::vec3(transform[1]) * max.y;
+			const glm::vec3 corners[4] = { left + bottom, right + bottom, right + top, left + top };
+
+			for (int32_t i = 0; i < 4; i++)
+			{
+				out[i].vertex = corners[i];
+				out[i].uv = glm::vec3(uv[i], layer);
+				out[i].color = color;
+			}
+#endif
+		}
+	};
+
+	namespace QuadBatch
+	{
+		auto buildSortKeys(const std::vector<Command2D>& commands, std::vector<SortKey2D>& keys, ThreadPool& pool) -> void
+		{
+			keys.resize(commands.size());
+			pool.parallelFor(0, static_cast<int32_t>(commands.size()), [&](int32_t i) {
+				auto& command = commands[i];
+				const uint32_t layer = command.quad->getTexture() ? command.quad->getLayer() : 0;
+				keys[i].key = (uint64_t(orderedBits(command.transform[3][2])) << 16) | (layer & 0xffff);
+				keys[i].command = i;
+			}, SORT_CHUNK);
+		}
+
+		auto radixSort(std::vector<SortKey2D>& keys, std::vector<SortKey2D>& scratch, ThreadPool& pool) -> void
+		{
+			PROFILE_FUNCTION();
+			const auto count = static_cast<int32_t>(keys.size());
+			const int32_t chunks = std::max(1, (count + SORT_CHUNK - 1) / SORT_CHUNK);
+			std::vector<std::array<uint32_t, 256>> histograms(chunks);
+			scratch.resize(keys.size());
+
+			for (uint32_t pass = 0; pass < SORT_PASSES; pass++)
+			{
+				const uint32_t shift = pass * 8;
+				pool.parallelFor(0, chunks, [&](int32_t chunk) {
+					auto& histogram = histograms[chunk];
+					histogram.fill(0);
+					const auto end = std::min(count, (chunk + 1) * SORT_CHUNK);
+					for (auto i = chunk * SORT_CHUNK; i < end; i++)
+						histogram[(keys[i].key >> shift) & 0xff]++;
+				}, 1);
+
+				//offsets of every chunk in every bucket, the chunks keep their order within a bucket
+				uint32_t offset = 0;
+				bool sorted = false;
+				for (uint32_t bucket = 0; bucket < 256; bucket++)
+				{
+					const auto start = offset;
+					for (auto& histogram : histograms)
+					{
+						const auto size = histogram[bucket];
+						histogram[bucket] = offset;
+						offset += size;
+					}
+					//all the keys share the digit
+					if (offset - start == static_cast<uint32_t>(count))
+						sorted = true;
+				}
+
+				if (sorted)
+					continue;
+
+				pool.parallelFor(0, chunks, [&](int32_t chunk) {
+					auto& histogram = histograms[chunk];
+					const auto end = std::min(count, (chunk + 1) * SORT_CHUNK);
+					for (auto i = chunk * SORT_CHUNK; i < end; i++)
+						scratch[histogram[(keys[i].key >> shift) & 0xff]++] = keys[i];
+				}, 1);
+				keys.swap(scratch);
+			}
+		}
+
+		auto writeQuads(Vertex2D* out, const std::vector<Command2D>& commands, const SortKey2D* keys, int32_t begin, int32_t end) -> void
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				auto& command = commands[keys[i].command];
+				writeQuad(out + i * 4, *command.quad, command.transform);
+			}
+		}
+	};
+};
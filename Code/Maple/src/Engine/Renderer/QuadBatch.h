@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Engine/Vertex.h"
+#include "Engine/Quad2D.h"
+
+namespace Maple
+{
+	class ThreadPool;
+
+	struct Command2D
+	{
+		const Quad2D* quad;
+		glm::mat4 transform;
+	};
+
+	//commands are drawn in the order of the keys, depth first then the layer of the texture pool
+	struct SortKey2D
+	{
+		uint64_t key;
+		uint32_t command;
+	};
+
+	//The CPU side of the batched quads in Renderer2D : sort keys, the radix sort and the vertices of the quads.
+	//Only uses glm and the thread pool, so it can run (and be benchmarked) without a device.
+	namespace QuadBatch
+	{
+		//32 bits of depth (transform[3][2]) and 16 bits of the texture pool layer
+		auto buildSortKeys(const std::vector<Command2D>& commands, std::vector<SortKey2D>& keys, ThreadPool& pool) -> void;
+		//stable lsd radix sort, the histograms and the scatter of every pass run on the workers chunk by chunk
+		auto radixSort(std::vector<SortKey2D>& keys, std::vector<SortKey2D>& scratch, ThreadPool& pool) -> void;
+		//the four Vertex2D of the commands of keys[begin, end) from out onwards
+		auto writeQuads(Vertex2D* out, const std::vector<Command2D>& commands, const SortKey2D* keys, int32_t begin, int32_t end) -> void;
+	};
+};
@@ -10,6 +10,9 @@
 #include "Window/NativeWindow.h"
 #include "Scene/Scene.h"
 #include "Engine/Profiler.h"
+#include "Engine/Vulkan/VulkanContext.h"
+#include "Engine/Vulkan/VulkanCommandRecorder.h"
+#include "Engine/Interface/SwapChain.h"
 
 namespace Maple 
 {
@@ -40,10 +43,56 @@ namespace Maple
 
 	auto RenderManager::onRender() -> void
 	{
-		for (auto& render : renders)
+		PROFILE_FUNCTION();
+		auto& threadPool = Application::get()->getThreadPool();
+		if (!parallelRecording || threadPool->getThreadCount() == 0)
+		{
+			for (auto& render : renders)
+			{
+				render->renderScene();
+			}
+			return;
+		}
+
+		while (recorders.size() < renders.size())
+		{
+			recorders.emplace_back(std::make_shared<VulkanCommandRecorder>());
+		}
+
+		auto primary = static_cast<VulkanCommandBuffer*>(VulkanContext::get()->getSwapChain()->getCurrentCommandBuffer());
+		const auto count = static_cast<int32_t>(renders.size());
+		uint32_t secondaryCount = 0;
+
+		//renderers which have to stay on the main thread split the list, the renderers in between are recorded at once.
+		for (int32_t begin = 0; begin < count;)
 		{
-			render->renderScene();
+			if (!renders[begin]->canRecordParallel())
+			{
+				renders[begin++]->renderScene();
+				continue;
+			}
+
+			auto end = begin;
+			while (end < count && renders[end]->canRecordParallel())
+				end++;
+
+			threadPool->parallelFor(begin, end, [&](int32_t i) {
+				auto& recorder = recorders[i];
+				auto previous = Renderer::setThreadRecorder(recorder.get());
+				recorder->beginRecording();
+				renders[i]->renderScene();
+				recorder->endRecording();
+				Renderer::setThreadRecorder(previous);
+			}, 1);
+
+			for (auto i = begin; i < end; i++)
+			{
+				recorders[i]->executeInto(primary);
+				secondaryCount += recorders[i]->getSecondaryCount();
+			}
+			begin = end;
 		}
+		PROFILE_PLOT("Secondary Command Buffers", static_cast<int64_t>(secondaryCount));
 	}
 
 	auto RenderManager::onUpdate(const Timestep& step, Scene* scene) -> void
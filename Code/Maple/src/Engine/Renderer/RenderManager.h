@@ -20,6 +20,7 @@ namespace Maple
 	class ShadowRenderer;
 	class OmniShadowRenderer;
 	class PreProcessRenderer;
+	class VulkanCommandRecorder;
 	class MAPLE_EXPORT RenderManager
 	{
 	public:
@@ -53,6 +54,10 @@ namespace Maple
 		inline auto isEditor() const { return editor; }
 		inline auto setEditor(bool val) { editor = val; }
 
+		//record the renderers on the worker threads into secondary command buffers
+		inline auto isParallelRecording() const { return parallelRecording; }
+		inline auto setParallelRecording(bool val) { parallelRecording = val; }
+
 	private:
 		std::vector<std::shared_ptr<Renderer>> renders;
 		std::shared_ptr<GBuffer> gbuffer;
@@ -62,6 +67,10 @@ namespace Maple
 		OmniShadowRenderer* omniShadowRenderer = nullptr;
 		PreProcessRenderer* preProcessRenderer = nullptr;
 
+		//one per renderer, replayed into the frame command buffer in order
+		std::vector<std::shared_ptr<VulkanCommandRecorder>> recorders;
+
 		bool editor = false;
+		bool parallelRecording = true;
 	};
 };
\ No newline at end of file
@@ -97,5 +97,7 @@ namespace Maple
 		Mesh* mesh = nullptr;
 		std::shared_ptr<Material> material;
 		glm::mat4 transform;
+		//level of detail of the mesh
+		uint32_t lod = 0;
 	};
 };
\ No newline at end of file
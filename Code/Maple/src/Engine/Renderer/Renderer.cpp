@@ -8,6 +8,7 @@
 
 #include "Engine/Vulkan/VulkanPipeline.h"
 #include "Engine/Vulkan/VulkanCommandBuffer.h"
+#include "Engine/Vulkan/VulkanCommandRecorder.h"
 #include "Engine/Vulkan/VulkanDescriptorSet.h"
 #include "Engine/Vulkan/VulkanContext.h"
 #include "Engine/Interface/SwapChain.h"
@@ -15,6 +16,10 @@
 
 namespace Maple 
 {
+	namespace
+	{
+		thread_local VulkanCommandRecorder* threadRecorder = nullptr;
+	};
 
 	auto Renderer::init(const std::shared_ptr<GBuffer>& buffer) -> void
 	{
@@ -63,23 +68,40 @@ namespace Maple
 				auto vkDesSet = std::static_pointer_cast<VulkanDescriptorSet>(descriptorSet);
 				if (vkDesSet->isDynamic())
 					numDynamicDescriptorSets++;
-				descriptorSetPool[numDesciptorSets] = *vkDesSet;
+				descriptorSetPool[numDesciptorSets] = vkDesSet->getCurrentSet();
 				numDesciptorSets++;
 			}
 		}
 		vkCmdBindDescriptorSets(*static_cast<VulkanCommandBuffer*>(cmdBuffer), VK_PIPELINE_BIND_POINT_GRAPHICS, static_cast<VulkanPipeline*>(pipeline)->getPipelineLayout(), 0, numDesciptorSets, descriptorSetPool, numDynamicDescriptorSets, &dynamicOffset);
 	}
 
-	auto Renderer::drawIndexed(CommandBuffer* commandBuffer, DrawType type, uint32_t count, uint32_t start) -> void
+	auto Renderer::drawIndexed(CommandBuffer* commandBuffer, DrawType type, uint32_t count, uint32_t start, uint32_t instanceCount, uint32_t firstInstance) -> void
 	{
-		vkCmdDrawIndexed(*static_cast<VulkanCommandBuffer*>(commandBuffer), count, 1, 0, 0, 0);
+		vkCmdDrawIndexed(*static_cast<VulkanCommandBuffer*>(commandBuffer), count, instanceCount, start, 0, firstInstance);
 	}
 
 	auto Renderer::getCommandBuffer() -> CommandBuffer*
 	{
+		if (threadRecorder != nullptr)
+			return threadRecorder;
 		return VulkanContext::get()->getSwapChain()->getCurrentCommandBuffer();
 	}
 
+	auto Renderer::recordParallel(int32_t count, const std::function<void(CommandBuffer*, int32_t, int32_t)>& record, int32_t grainSize) -> void
+	{
+		if (threadRecorder != nullptr)
+			threadRecorder->recordParallel(0, count, record, grainSize);
+		else
+			record(getCommandBuffer(), 0, count);
+	}
+
+	auto Renderer::setThreadRecorder(VulkanCommandRecorder* recorder) -> VulkanCommandRecorder*
+	{
+		auto previous = threadRecorder;
+		threadRecorder = recorder;
+		return previous;
+	}
+
 	auto Renderer::setRenderManager(RenderManager* manager) -> void
 	{
 		this->manager = manager;
@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <memory>
 #include <vector>
+#include <functional>
 #include <glm/glm.hpp>
 #include "RenderParam.h"
 #include "Engine/Core.h"
@@ -24,6 +25,7 @@ namespace Maple
 	class CommandBuffer;
 	class DescriptorSet;
 	class RenderManager;
+	class VulkanCommandRecorder;
 
 	class MAPLE_EXPORT Renderer
 	{
@@ -42,11 +44,23 @@ namespace Maple
 
 
 		auto bindDescriptorSets(Pipeline* pipeline, CommandBuffer* cmdBuffer, uint32_t dynamicOffset, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets) -> void;
-		auto drawIndexed(CommandBuffer* commandBuffer, DrawType type, uint32_t count, uint32_t start = 0) -> void;
+		auto drawIndexed(CommandBuffer* commandBuffer, DrawType type, uint32_t count, uint32_t start = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0) -> void;
 
 
+		//the recorder of the calling thread if the renderer is recorded in parallel, otherwise the swap chain's.
 		auto getCommandBuffer()->CommandBuffer*;
 		auto setRenderManager(RenderManager* manager) -> void;
+
+		//false if the renderer submits command buffers by itself, it is recorded on the main thread then.
+		virtual auto canRecordParallel() const -> bool { return true; }
+
+		//record(commandBuffer, begin, end) for chunks of [0, count), on the worker threads if the renderer is being recorded
+		//into a recorder and inside a render pass. every chunk has to bind its own states, and so do the commands after it.
+		auto recordParallel(int32_t count, const std::function<void(CommandBuffer*, int32_t, int32_t)>& record, int32_t grainSize) -> void;
+
+		//commands recorded by renderers on the calling thread go into recorder, nullptr for the swap chain's command buffer.
+		//returns the previous one, a thread which waits for other jobs can pick up another renderer in between.
+		static auto setThreadRecorder(VulkanCommandRecorder* recorder) -> VulkanCommandRecorder*;
 	protected:
 		uint32_t width;
 		uint32_t height;
@@ -33,17 +33,47 @@
 #include "FileSystem/File.h"
 #include "Scene/Component/Light.h"
 #include "Application.h"
+#include "Engine/Profiler.h"
 
 #include <imgui.h>
+#include <chrono>
+#include <cstring>
+#include <array>
+#include <algorithm>
 
 namespace Maple 
 {
+	namespace
+	{
+		//a job of sprites below this is not worth the hand off
+		constexpr int32_t QUAD_GRAIN = 2048;
+		constexpr uint32_t FREE_SLOT = UINT32_MAX;
+		constexpr uint32_t MIN_INSTANCES = 1024;
+		//dirty slots this close are uploaded as one range, a few unchanged instances cost less than another copy region
+		constexpr uint32_t RANGE_GAP = 8;
+
+		//the same corners and uvs as QuadBatch::writeQuads, the axes of the transform are taken in the xy plane
+		inline auto makeInstance(const Quad2D& quad, const glm::mat4& transform) -> SpriteInstance
+		{
+			const auto& offset = quad.getOffset();
+			const auto& uv = quad.getTexCoords();
+			SpriteInstance instance;
+			instance.axes = glm::vec4(glm::vec2(transform[0]) * float(quad.getWidth()), glm::vec2(transform[1]) * float(quad.getHeight()));
+			instance.origin = glm::vec4(
+				glm::vec3(transform[0]) * offset.x + glm::vec3(transform[1]) * offset.y + glm::vec3(transform[3]),
+				quad.getTexture() ? quad.getLayer() + 1.f : -1.f
+			);
+			instance.texCoords = { glm::packUnorm2x16(uv[0]), glm::packUnorm2x16(uv[2]) };
+			instance.color = glm::packUnorm4x8(quad.getColor());
+			return instance;
+		}
+	};
+
 	Renderer2D::Renderer2D(uint32_t width, uint32_t height, bool enableDepth)
 		:enableDepth(enableDepth)
 	{
 		this->width = width;
 		this->height = height;
-		textures.resize(16);
 	}
 
 	Renderer2D::~Renderer2D()
@@ -120,16 +150,53 @@ namespace Maple
 			shader,
 			1
 		});
+
+		for (auto group : { &sprites, &animatedSprites })
+			group->vertexBuffer = VertexBuffer::create(BufferUsage::STATIC);
+	}
+
+	auto Renderer2D::createInstancePipeline() -> void
+	{
+		instanceShader = Shader::create("shaders/Sprite2D.shader");
+
+		PipelineInfo pipeInfo;
+		pipeInfo.renderPass = renderPass;
+		pipeInfo.shader = instanceShader;
+		pipeInfo.cullMode = CullMode::NONE;
+		pipeInfo.transparencyEnabled = true;
+		pipeInfo.depthBiasEnabled = false;
+		instancePipeline = Pipeline::create(pipeInfo);
+
+		BufferInfo bufferInfo;
+		bufferInfo.buffer = uniformBuffer;
+		bufferInfo.offset = 0;
+		bufferInfo.binding = 0;
+		bufferInfo.size = sizeof(UniformBufferObject);
+		bufferInfo.type = DescriptorType::UNIFORM_BUFFER;
+		instancePipeline->getDescriptorSet()->update({ bufferInfo });
+
+		instanceDescriptorSet = DescriptorSet::create({
+			instancePipeline.get(),
+			1,
+			instanceShader,
+			1
+		});
+
+		const glm::vec2 corners[4] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+		quadVertexBuffer = VertexBuffer::create(BufferUsage::STATIC);
+		quadVertexBuffer->setData(sizeof(corners), corners);
+
+		//the pages are only written again when the texture pool replaces them
+		pages = nullptr;
 	}
 
 	auto Renderer2D::begin() -> void
 	{
 		auto bufferId = renderTexture != nullptr ? 0 : VulkanContext::get()->getSwapChain()->getCurrentBuffer();
 		renderPass->beginRenderPass(
-			VulkanContext::get()->getSwapChain()->getCurrentCommandBuffer(),
+			getCommandBuffer(),
 			{ 0.3,0.3,0.8,1 }, frameBuffers[bufferId].get(), SubPassContents::INLINE, width,height
 		);
-		textureCount = 0;
 		buffer = static_cast<Vertex2D*>(vertexBuffers[batchDrawCallIndex]->getPointer());
 	}
 
@@ -141,7 +208,7 @@ namespace Maple
 			return;
 		}
 
-		auto cmd = VulkanContext::get()->getSwapChain()->getCurrentCommandBuffer();
+		auto cmd = getCommandBuffer();
 		updateDesciptorSet();
 		pipeline->bind(cmd);
 
@@ -166,56 +233,35 @@ namespace Maple
 
 	auto Renderer2D::submitQuad() -> void
 	{
+		PROFILE_FUNCTION();
+		const auto start = std::chrono::high_resolution_clock::now();
 		uniformBuffer->setData(sizeof(UniformBufferObject), &systemVsUniformBuffer);
 
-		for (auto& command : commands)
+		//every batch fills its vertex buffer in disjoint ranges on the workers
+		const auto count = static_cast<uint32_t>(sortKeys.size());
+		for (uint32_t first = 0; first < count;)
 		{
 			if (indexCount >= config.indiciesSize) {
 				flush();
 			}
-			auto& quad2d = command.quad;
-			auto& transform = command.transform;
-
-
-			const glm::vec2 & min = quad2d->getOffset();
-
-			glm::vec2 max = min + glm::vec2{ quad2d->getWidth(), quad2d->getHeight() };
-
-			const auto& color = quad2d->getColor();
-			const auto& uv = quad2d->getTexCoords();
-			const auto texture = quad2d->getTexture();
-
-			int32_t textureSlot = -1;
-			if (quad2d->getTexture())
-				textureSlot = submitTexture(quad2d->getTexture());
-
-			buffer->vertex = transform * glm::vec4(min.x, min.y, 0.0f, 1);
-			buffer->uv = glm::vec3(uv[0], textureSlot);
-			buffer->color = color;
-			buffer++;
-
-			buffer->vertex = transform * glm::vec4(max.x, min.y, 0.0f, 1);
-			buffer->uv = glm::vec3(uv[1], textureSlot);
-			buffer->color = color;
-			buffer++;
-
-			buffer->vertex = transform * glm::vec4(max.x, max.y, 0.0f, 1.0);
-			buffer->uv = glm::vec3(uv[2], textureSlot);
-			buffer->color = color;
-			buffer++;
-
-			buffer->vertex = transform * glm::vec4(min.x, max.y, 0.0f, 1.0);
-			buffer->uv = glm::vec3(uv[3], textureSlot);
-			buffer->color = color;
-			buffer++;
-
-			indexCount += 6;
+			const auto quads = std::min(count - first, (config.indiciesSize - indexCount) / 6);
+			auto out = buffer;
+			Application::get()->getThreadPool()->parallelRange(0, quads, [&](int32_t begin, int32_t end) {
+				QuadBatch::writeQuads(out, commands, sortKeys.data() + first, begin, end);
+			}, QUAD_GRAIN);
+
+			buffer += quads * 4;
+			indexCount += quads * 6;
+			first += quads;
 		}
+
+		quadCount = count;
+		quadMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 	}
 
 	auto Renderer2D::end() -> void
 	{
-		renderPass->endRenderpass(VulkanContext::get()->getSwapChain()->getCurrentCommandBuffer());
+		renderPass->endRenderpass(getCommandBuffer());
 		batchDrawCallIndex = 0;
 	}
 
@@ -235,6 +281,13 @@ namespace Maple
 	auto Renderer2D::onImGui() -> void
 	{
 		ImGui::DragInt("Pivot Type", &pivotType);
+		ImGui::Text("Quads : %u, %.3f ms", quadCount, quadMilliseconds);
+		if (quadMilliseconds > 0.f)
+			ImGui::Text("Quads / ms : %.0f", quadCount / quadMilliseconds);
+		ImGui::Checkbox("Instanced Sprites", &sprites.enabled);
+		ImGui::Checkbox("Instanced Animated Sprites", &animatedSprites.enabled);
+		ImGui::Text("Instances : %u, uploaded %u",
+			static_cast<uint32_t>(sprites.slots.size() + animatedSprites.slots.size()), sprites.uploaded + animatedSprites.uploaded);
 	}
 
 	auto Renderer2D::renderScene() -> void
@@ -242,6 +295,7 @@ namespace Maple
 		begin();
 		submitQuad();
 		present();
+		drawInstances();
 		end();
 	}
 
@@ -256,13 +310,17 @@ namespace Maple
 			camera.first->getProjectionMatrix() * glm::inverse(camera.second->getWorldMatrix());
 	
 		commands.clear();
+		instanceFrame++;
 		auto& registry = scene->getRegistry();
 		auto group = registry.group<Sprite>(entt::get<Transform>);
 
 		for (auto entity : group)
 		{
 			const auto& [sprite, trans] = group.get<Sprite, Transform>(entity);
-			submit(&sprite.getQuad(), trans.getWorldMatrix());
+			if (sprites.enabled)
+				submitInstance(sprites, static_cast<uint32_t>(entity), sprite.getQuad(), trans.getWorldMatrix());
+			else
+				submit(&sprite.getQuad(), trans.getWorldMatrix());
 		}
 
 
@@ -271,12 +329,153 @@ namespace Maple
 		for (auto entity : group2)
 		{
 			const auto& [anim, trans] = group2.get<AnimatedSprite, Transform>(entity);
-			submit(&anim.getQuad(), trans.getWorldMatrix());
+			if (animatedSprites.enabled)
+				submitInstance(animatedSprites, static_cast<uint32_t>(entity), anim.getQuad(), trans.getWorldMatrix());
+			else
+				submit(&anim.getQuad(), trans.getWorldMatrix());
 		}
 
-		std::sort(commands.begin(), commands.end(), [](Command2D & a,Command2D & b) {
-			return a.transform[3][2] < b.transform[3][2];
-		});
+		uploadInstances(sprites);
+		uploadInstances(animatedSprites);
+		sortCommands();
+	}
+
+	auto Renderer2D::sortCommands() -> void
+	{
+		PROFILE_FUNCTION();
+		//the keys are sorted instead of the commands, a command is 80 bytes
+		auto& pool = *Application::get()->getThreadPool();
+		QuadBatch::buildSortKeys(commands, sortKeys, pool);
+		QuadBatch::radixSort(sortKeys, sortScratch, pool);
+	}
+
+	auto Renderer2D::submitInstance(InstanceGroup2D& group, uint32_t entity, const Quad2D& quad, const glm::mat4& transform) -> void
+	{
+		auto [iter, inserted] = group.slots.try_emplace(entity, 0);
+		if (inserted)
+		{
+			if (!group.freeSlots.empty())
+			{
+				iter->second = group.freeSlots.back();
+				group.freeSlots.pop_back();
+			}
+			else
+			{
+				iter->second = static_cast<uint32_t>(group.instances.size());
+				group.instances.emplace_back();
+				group.owners.emplace_back();
+				group.frames.emplace_back();
+			}
+			group.owners[iter->second] = entity;
+		}
+
+		const auto slot = iter->second;
+		group.frames[slot] = instanceFrame;
+
+		const auto instance = makeInstance(quad, transform);
+		if (inserted || std::memcmp(&instance, &group.instances[slot], sizeof(SpriteInstance)) != 0)
+		{
+			group.instances[slot] = instance;
+			group.dirty.emplace_back(slot);
+		}
+	}
+
+	auto Renderer2D::uploadInstances(InstanceGroup2D& group) -> void
+	{
+		PROFILE_FUNCTION();
+		if (!group.enabled)
+		{
+			//the sprites went back to the batched path
+			if (!group.instances.empty())
+			{
+				group.instances.clear();
+				group.slots.clear();
+				group.owners.clear();
+				group.frames.clear();
+				group.freeSlots.clear();
+				group.dirty.clear();
+			}
+			group.uploaded = 0;
+			return;
+		}
+
+		if (instancePipeline == nullptr)
+			createInstancePipeline();
+
+		//sprites which are gone keep their slot as an empty quad until it is used again
+		for (uint32_t slot = 0; slot < group.owners.size(); slot++)
+		{
+			if (group.owners[slot] != FREE_SLOT && group.frames[slot] != instanceFrame)
+			{
+				group.slots.erase(group.owners[slot]);
+				group.owners[slot] = FREE_SLOT;
+				group.instances[slot] = {};
+				group.dirty.emplace_back(slot);
+				group.freeSlots.emplace_back(slot);
+			}
+		}
+
+		const auto count = static_cast<uint32_t>(group.instances.size());
+		if (count > group.capacity)
+		{
+			//the new buffer starts empty, so everything is uploaded
+			group.capacity = std::max({ count, group.capacity * 2, MIN_INSTANCES });
+			group.vertexBuffer->resize(group.capacity * sizeof(SpriteInstance), nullptr);
+			group.vertexBuffer->setDataRanges(group.instances.data(), { { 0, static_cast<uint32_t>(count * sizeof(SpriteInstance)) } });
+			group.uploaded = count;
+			group.dirty.clear();
+			return;
+		}
+
+		group.uploaded = static_cast<uint32_t>(group.dirty.size());
+		if (group.dirty.empty())
+			return;
+
+		std::sort(group.dirty.begin(), group.dirty.end());
+		std::vector<BufferRange> ranges;
+		uint32_t first = group.dirty.front();
+		uint32_t last = first;
+		for (auto slot : group.dirty)
+		{
+			if (slot > last + RANGE_GAP)
+			{
+				ranges.push_back({ static_cast<uint32_t>(first * sizeof(SpriteInstance)), static_cast<uint32_t>((last - first + 1) * sizeof(SpriteInstance)) });
+				first = slot;
+			}
+			last = slot;
+		}
+		ranges.push_back({ static_cast<uint32_t>(first * sizeof(SpriteInstance)), static_cast<uint32_t>((last - first + 1) * sizeof(SpriteInstance)) });
+
+		group.vertexBuffer->setDataRanges(group.instances.data(), ranges);
+		group.dirty.clear();
+	}
+
+	auto Renderer2D::drawInstances() -> void
+	{
+		auto cmd = getCommandBuffer();
+		bool bound = false;
+		for (auto group : { &sprites, &animatedSprites })
+		{
+			if (!group->enabled || group->instances.empty())
+				continue;
+
+			if (!bound)
+			{
+				updateDesciptorSet();
+				instancePipeline->bind(cmd);
+				indexBuffer->bind(cmd);
+				quadVertexBuffer->bind(cmd, instancePipeline.get(), 0);
+				bindDescriptorSets(instancePipeline.get(), cmd, 0, { instancePipeline->getDescriptorSet(),instanceDescriptorSet });
+				bound = true;
+			}
+
+			//the first quad of the index buffer, once per instance
+			group->vertexBuffer->bind(cmd, instancePipeline.get(), 1);
+			drawIndexed(cmd, DrawType::TRIANGLE, 6, 0, static_cast<uint32_t>(group->instances.size()));
+		}
+
+		if (bound)
+			indexBuffer->unbind();
 	}
 
 	auto Renderer2D::onResize(uint32_t width, uint32_t height) -> void
@@ -296,45 +495,33 @@ namespace Maple
 		}
 	}
 
-	auto Renderer2D::submitTexture(const std::shared_ptr<Texture> & texture) ->int32_t
-	{
-		float result = 0.0f;
-		bool found = false;
-		for (uint32_t i = 0; i < textureCount; i++)
-		{
-			if (textures[i] == texture) //Temp
-			{
-				return i + 1;
-			}
-		}
-		
-		if (textureCount >= config.maxTextures)
-		{
-			flush();
-		}
-		textures[textureCount] = texture;
-		textureCount++;
-		return textureCount;
-	}
-
 	auto Renderer2D::updateDesciptorSet() -> void
 	{
-		if (textureCount == 0)
+		auto& texture = Application::get()->getTexturePool()->getTexture();
+		if (texture == nullptr || (texture == pages && texture->getVersion() == pagesVersion))
 			return;
 
+		pages = texture;
+		pagesVersion = texture->getVersion();
+
 		ImageInfo imageInfo{};
 		imageInfo.binding = 0;
-		imageInfo.name = "textures";
-		imageInfo.textures = { textures };
+		imageInfo.name = "pages";
+		imageInfo.textures = { pages };
 		imageInfo.type = TextureType::COLOR;
 		descriptorSet->update({ imageInfo });
-
+		if (instanceDescriptorSet != nullptr)
+			instanceDescriptorSet->update({ imageInfo });
 	}
 
 	auto Renderer2D::flush() -> void
 	{
 		present();
-		textureCount = 0;
+		if (batchDrawCallIndex >= vertexBuffers.size())
+		{
+			auto& vertexBuffer = vertexBuffers.emplace_back(VertexBuffer::create(BufferUsage::DYNAMIC));
+			vertexBuffer->resize(config.bufferSize, nullptr);
+		}
 		vertexBuffers[batchDrawCallIndex]->unbind();
 		buffer = static_cast<Vertex2D*>(vertexBuffers[batchDrawCallIndex]->getPointer());
 	}
@@ -6,9 +6,11 @@
 #include <cstdint>
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include "Engine/Vertex.h"
 #include "Engine/Quad2D.h"
+#include "QuadBatch.h"
 #include "RenderParam.h"
 #include "Renderer.h"
 #include "Engine/Interface/DescriptorSet.h"
@@ -25,7 +27,6 @@ namespace Maple
 		uint32_t quadsSize = sizeof(Vertex2D) * 4;
 		uint32_t bufferSize = 10000 * sizeof(Vertex2D) * 4;
 		uint32_t indiciesSize = 10000 * 6;
-		uint32_t maxTextures = 16;
 		uint32_t maxBatchDrawCalls = 10;
 
 		auto setMaxQuads(uint32_t quads) -> void
@@ -44,10 +45,23 @@ namespace Maple
 		glm::vec4 color;
 	};
 
-	struct Command2D 
+	//sprites of one component type drawn by instancing, their SpriteInstances stay in a device local buffer across frames.
+	//only the slots which changed since the last frame are uploaded again.
+	struct InstanceGroup2D
 	{
-		const Quad2D* quad;
-		glm::mat4 transform;
+		bool enabled = false;
+		std::vector<SpriteInstance> instances;
+		//entity -> slot, the owner of a free slot is UINT32_MAX
+		std::unordered_map<uint32_t, uint32_t> slots;
+		std::vector<uint32_t> owners;
+		//the last frame a slot was submitted in
+		std::vector<uint32_t> frames;
+		std::vector<uint32_t> freeSlots;
+		std::vector<uint32_t> dirty;
+		std::shared_ptr<VertexBuffer> vertexBuffer;
+		uint32_t capacity = 0;
+		//instances uploaded in the last frame
+		uint32_t uploaded = 0;
 	};
 
 	class MAPLE_EXPORT Renderer2D : public Renderer
@@ -71,9 +85,12 @@ namespace Maple
 		auto submit(const Quad2D * quad, const glm::mat4 & transform) -> void;
 		auto onImGui() -> void override;
 
+		//instanced groups are drawn after the batched quads in the order of their slots, not sorted by depth.
+		inline auto setInstanceSprites(bool instance) { sprites.enabled = instance; }
+		inline auto setInstanceAnimatedSprites(bool instance) { animatedSprites.enabled = instance; }
+
 	private:
 
-		auto submitTexture(const std::shared_ptr<Texture>& texture)->int32_t;
 		auto updateDesciptorSet() -> void;
 		struct UniformBufferObject {
 			glm::mat4 projView;
@@ -81,20 +98,40 @@ namespace Maple
 
 		auto flush() -> void;
 		auto createFrameBuffers() -> void;
+		auto sortCommands() -> void;
+		auto submitInstance(InstanceGroup2D& group, uint32_t entity, const Quad2D& quad, const glm::mat4& transform) -> void;
+		auto uploadInstances(InstanceGroup2D& group) -> void;
+		auto drawInstances() -> void;
+		//the instanced shader and pipeline are only created once a group is instanced
+		auto createInstancePipeline() -> void;
 		std::vector<Command2D> commands;
+		std::vector<SortKey2D> sortKeys;
+		std::vector<SortKey2D> sortScratch;
 		std::shared_ptr<UniformBuffer> uniformBuffer;
 		UniformBufferObject systemVsUniformBuffer;
 		std::vector<std::shared_ptr<CommandBuffer>> secondaryCommandBuffers;
 		std::vector<std::shared_ptr<VertexBuffer>> vertexBuffers;
 		std::shared_ptr<IndexBuffer> indexBuffer;
-		std::vector<std::shared_ptr<Texture>> textures;
+		//the texture array of the texture pool, written into the descriptor set again when it is replaced
+		std::shared_ptr<Texture> pages;
+		uint32_t pagesVersion = 0;
 
 		std::shared_ptr<DescriptorSet> descriptorSet;
 
+		std::shared_ptr<Shader> instanceShader;
+		std::shared_ptr<Pipeline> instancePipeline;
+		std::shared_ptr<DescriptorSet> instanceDescriptorSet;
+		//the unit quad every instance is expanded from
+		std::shared_ptr<VertexBuffer> quadVertexBuffer;
+		InstanceGroup2D sprites;
+		InstanceGroup2D animatedSprites;
+		uint32_t instanceFrame = 0;
+
 		Vertex2D * buffer = nullptr;
 		Config2D config;
 		uint32_t indexCount = 0;
-		uint32_t textureCount = 0;
+		uint32_t quadCount = 0;
+		float quadMilliseconds = 0.f;
 		uint32_t batchDrawCallIndex = 0;
 		bool enableDepth = true;
 
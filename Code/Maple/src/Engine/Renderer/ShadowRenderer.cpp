@@ -31,15 +31,20 @@
 #include "Engine/Light.h"
 #include "Engine/Material.h"
 #include "Scene/Scene.h"
+#include "Scene/SceneBVH.h"
 #include "FileSystem/File.h"
 #include "DeferredOffScreenRenderer.h"
 
 #include "ImGui/ImGuiHelpers.h"
 
 #include "Application.h"
+#include "Engine/Profiler.h"
+#include "Math/BoundingBox.h"
 
 namespace Maple 
 {
+	static const char* CASCADE_PLOT_NAMES[SHADOWMAP_MAX] = { "Cascade 0 Casters","Cascade 1 Casters","Cascade 2 Casters","Cascade 3 Casters" };
+
 	ShadowRenderer::ShadowRenderer(const std::shared_ptr<TextureDepthArray>& texture, uint32_t size , uint32_t numMaps)
 		:shadowMapSize(size), numMaps(numMaps)
 	{
@@ -83,7 +88,7 @@ namespace Maple
 		{
 			Mesh* mesh = command.mesh;
 
-			mesh->getVertexBuffer()->bind(getCommandBuffer(), pipeline.get());
+			mesh->bindVertexBuffers(getCommandBuffer(), pipeline.get());
 			mesh->getIndexBuffer()->bind(getCommandBuffer());
 
 			auto& pushConstants = shader->getPushConstants();
@@ -97,7 +102,8 @@ namespace Maple
 			shader->bindPushConstants(getCommandBuffer(), pipeline.get());
 
 			bindDescriptorSets(pipeline.get(), getCommandBuffer(), 0, { pipeline->getDescriptorSet() });
-			drawIndexed(getCommandBuffer(), DrawType::TRIANGLE, mesh->getIndexBuffer()->getCount());
+			const auto lod = mesh->getLod(command.lod);
+			drawIndexed(getCommandBuffer(), DrawType::TRIANGLE, lod.indexCount, lod.indexOffset);
 
 
 			mesh->getVertexBuffer()->unbind();
@@ -142,35 +148,66 @@ namespace Maple
 		}
 	
 		auto group = registry.group<MeshRenderer>(entt::get<Transform>);
-		for (uint32_t i = 0; i < SHADOWMAP_MAX; ++i)
-		{
-			if (group.empty())
-				continue;
 
-			for (auto entity : group)
+		auto submitCaster = [&](entt::entity entity, uint32_t cascade) {
+			const auto& [render, trans] = group.get<MeshRenderer, Transform>(entity);
+			if (render.getMesh())
 			{
-				const auto& [render, trans] = group.get<MeshRenderer,Transform>(entity);
+				RenderCommand command;
+				command.mesh = render.getMesh().get();
+				command.transform = trans.getWorldMatrix();
+				command.material = nullptr;
+				command.lod = selectLod(*command.mesh, command.transform, cascade);
+				submit(command, cascade);
+			}
+		};
 
-				if (render.getMesh())
+		for (uint32_t i = 0; i < numMaps; ++i)
+		{
+			if (cascadeCulling)
+			{
+				//casters between the light and the cascade still throw shadows into it, so the near plane is not tested.
+				scene->getBVH()->query(cascadeFrustums[i], [&](entt::entity entity, const BoundingBox&) {
+					submitCaster(entity, i);
+				}, false);
+			}
+			else
+			{
+				for (auto entity : group)
 				{
-					auto& worldTransform = trans.getWorldMatrix();
-					//TODO calculate if the mesh is in the light view.
-					RenderCommand command;
-					command.mesh = render.getMesh().get();
-					command.transform = worldTransform;
-					command.material = nullptr;
-					submit(command,i);
+					submitCaster(entity, i);
 				}
 			}
 		}
 
+		for (uint32_t i = 0; i < numMaps; ++i)
+		{
+			PROFILE_PLOT(CASCADE_PLOT_NAMES[i], static_cast<int64_t>(cascadeCommandQueue[i].size()));
+		}
+	}
 
+	//the camera lod is from the last gbuffer pass and only covers visible meshes, so the level is picked per cascade :
+	//the projection is orthographic, the coarsest level whose error stays under one shadow map texel.
+	auto ShadowRenderer::selectLod(const Mesh& mesh, const glm::mat4& transform, uint32_t cascade) const -> uint32_t
+	{
+		const float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		for (uint32_t i = mesh.getLodCount() - 1; i > 0; i--)
+		{
+			if (mesh.getLod(i).error * scale * cascadeTexelsPerUnit[cascade] <= 1.f)
+				return i;
+		}
+		return 0;
 	}
 
 	auto ShadowRenderer::onImGui() -> void
 	{
 		ImGuiHelper::property("cascadeSplitLambda", cascadeSplitLambda, 0.01f, 1.f);
 		ImGuiHelper::property("bias", initialBias, 0.00001f, 0.5f);
+		ImGuiHelper::property("Cascade Culling", cascadeCulling);
+		for (uint32_t i = 0; i < numMaps; ++i)
+		{
+			ImGui::Text("Cascade %u Casters : %u", i, static_cast<uint32_t>(cascadeCommandQueue[i].size()));
+		}
 	}
 
 	auto ShadowRenderer::end() -> void
@@ -245,6 +282,7 @@ namespace Maple
 		pipelineCreateInfo.cullMode = CullMode::NONE;
 		pipelineCreateInfo.transparencyEnabled = false;
 		pipelineCreateInfo.depthBiasEnabled = true;
+		pipelineCreateInfo.depthClampEnabled = true;
 		pipeline = Pipeline::create(pipelineCreateInfo);
 	}
 
@@ -327,6 +365,8 @@ namespace Maple
 			glm::mat4 lightOrthoMatrix = glm::ortho(minExtents.x, maxExtents.x, minExtents.y, maxExtents.y, 0.0f, maxExtents.z - minExtents.z);
 			splitDepth[i] = (camera->getNear() + splitDist * clipRange) * -1.f;
 			systemUniformBuffer.projView[i] = lightOrthoMatrix * lightViewMatrix;
+			cascadeFrustums[i].from(systemUniformBuffer.projView[i]);
+			cascadeTexelsPerUnit[i] = shadowMapSize / (maxExtents.x - minExtents.x);
 			lastSplitDist = cascadeSplits[i];
 			if (i == 0)
 			{
@@ -10,6 +10,7 @@
 #include "RenderParam.h"
 #include "Renderer.h"
 #include "Scene/Component/Light.h"
+#include "Math/Frustum.h"
 
 namespace Maple 
 {
@@ -54,6 +55,7 @@ namespace Maple
 		auto createUniformBuffer() -> void;
 
 		auto updateCascades(const Scene* scene, Camera* camera, Transform * transform, const Light* light) -> void;
+		auto selectLod(const Mesh& mesh, const glm::mat4& transform, uint32_t cascade) const -> uint32_t;
 
 
 		struct UniformBufferObject
@@ -84,6 +86,9 @@ namespace Maple
 		int32_t cascadeIndex = 0;
 		std::array<std::shared_ptr<FrameBuffer>, SHADOWMAP_MAX> shadowFrameBuffers;
 		std::array<std::vector<RenderCommand>, SHADOWMAP_MAX> cascadeCommandQueue;
+		std::array<Frustum, SHADOWMAP_MAX> cascadeFrustums;
+		std::array<float, SHADOWMAP_MAX> cascadeTexelsPerUnit = {};
+		bool cascadeCulling = true;
 		glm::mat4 lightViewMatrix;
 
 		std::shared_ptr<FrameBuffer> omniFrameBuffer;
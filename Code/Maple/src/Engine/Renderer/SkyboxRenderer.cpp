@@ -87,7 +87,7 @@ namespace Maple
 		uniformBufferLodLevel->setData(sizeof(float), &lodLevel);
 		//uniform
 		pipeline->bind(getCommandBuffer());
-		skybox->getVertexBuffer()->bind(getCommandBuffer(), pipeline.get());
+		skybox->bindVertexBuffers(getCommandBuffer(), pipeline.get());
 		skybox->getIndexBuffer()->bind(getCommandBuffer());
 
 		bindDescriptorSets(pipeline.get(), getCommandBuffer(), 0, { pipeline->getDescriptorSet() });
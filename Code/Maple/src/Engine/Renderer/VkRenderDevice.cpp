@@ -8,6 +8,9 @@
 #include "Engine/Vulkan/VulkanDevice.h"
 #include "Engine/Vulkan/VulkanSwapChain.h"
 #include "Engine/Vulkan/VulkanCommandBuffer.h"
+#include "Engine/Vulkan/VulkanUploadQueue.h"
+#include "Engine/Vulkan/VulkanRingBuffer.h"
+#include "Engine/MaterialPool.h"
 #include "Others/Console.h"
 #include "Application.h"
 
@@ -22,6 +25,12 @@ namespace Maple
 
 	VkRenderDevice::~VkRenderDevice()
 	{
+		VulkanContext::get()->waiteIdle();
+		MaterialPool::release();
+		VulkanRingBuffer::release();
+		VulkanUploadQueue::release();
+		//run the deferred releases of the resources destroyed above
+		VulkanContext::get()->waiteIdle();
 		/*for (int i = 0; i < NUM_SEMAPHORES; i++)
 		{
 			vkDestroySemaphore(*VulkanDevice::get(),imageAvailableSemaphore[i], nullptr);
@@ -41,7 +50,9 @@ namespace Maple
 	auto VkRenderDevice::begin() -> void
 	{
 		acquireNextImage();
-		VulkanContext::get()->getSwapChain()->getCurrentCommandBuffer()->beginRecording();
+		auto vkSwapChain = std::static_pointer_cast<VulkanSwapChain>(VulkanContext::get()->getSwapChain());
+		vkSwapChain->getCurrentCommandBuffer()->beginRecording();
+		vkSwapChain->writeTimestamp(VulkanSwapChain::FrameBegin);
 	}
 
 
@@ -81,11 +92,18 @@ namespace Maple
 
 	auto VkRenderDevice::present() -> void
 	{
+		//uploads recorded during the frame go to the queue before the frame which samples them
+		VulkanUploadQueue::get()->flush();
 		auto vkSwapChain = std::static_pointer_cast<VulkanSwapChain>(VulkanContext::get()->getSwapChain());
 		auto result = vkSwapChain->present(nullptr);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
 			onResize(width, height);
 		}
+		//wait for the oldest frame here rather than in begin(), so the uniform/ring buffer writes of
+		//the next frame never touch memory the GPU is still reading.
+		VulkanContext::get()->nextFrame();
+		VulkanUploadQueue::get()->update();
+		VulkanRingBuffer::get()->nextFrame();
 	}	
 
 
@@ -102,6 +120,7 @@ namespace Maple
 	auto VkRenderDevice::end() -> void
 	{
 		auto vkSwapChain = std::static_pointer_cast<VulkanSwapChain>(VulkanContext::get()->getSwapChain());
+		vkSwapChain->writeTimestamp(VulkanSwapChain::FrameEnd);
 		vkSwapChain->getCurrentCommandBuffer()->endRecording();
 	}
 
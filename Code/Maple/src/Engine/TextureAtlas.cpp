@@ -6,35 +6,29 @@
 
 #include "TextureAtlas.h"
 #include "Engine/Interface/Texture.h"
+#include "Engine/Profiler.h"
 #include "FileSystem/ImageLoader.h"
+#include <algorithm>
+#include <cstring>
 
 namespace Maple
 {
 
 	TextureAtlas::TextureAtlas(uint32_t w, uint32_t h)
+		:width(w), height(h)
 	{
-		texture = Texture2D::create();
-		texture->buildTexture(TextureFormat::RGBA8, w, h, true, false, false);
-
-		leftovers = QuadTree<size_t, LeftOver>([](const LeftOver& first, const LeftOver& second)
-		{
-				bool wcomp = first.width() >= second.width();
-				bool hcomp = first.height() >= second.height();
-				if (wcomp && hcomp)
-				{
-					return QuadTree<size_t, LeftOver>::RIGHT;
-				}
-				if (wcomp)
-				{
-					return QuadTree<size_t, LeftOver>::DOWN;
-				}
-				if (hcomp)
-				{
-					return QuadTree<size_t, LeftOver>::UP;
-				}
-				return QuadTree<size_t, LeftOver>::LEFT;
-		});
+		auto image = Texture2D::create();
+		image->buildTexture(TextureFormat::RGBA8, w, h, true, false, false);
+		texture = image;
+		pixels.resize(static_cast<size_t>(w) * h * 4);
+		skyline.push_back({ 0, 0, w });
+	}
 
+	TextureAtlas::TextureAtlas(const std::shared_ptr<Texture2DArray>& pages, uint32_t layer)
+		:width(pages->getWidth()), height(pages->getHeight()), texture(pages), pages(pages), layer(layer)
+	{
+		pixels.resize(static_cast<size_t>(width) * height * 4);
+		skyline.push_back({ 0, 0, width });
 	}
 
 	auto TextureAtlas::addSprite(const std::string& file) ->Quad2D *
@@ -57,116 +51,123 @@ namespace Maple
 		return update(uniqueName, buffer.data(), w, h);
 	}
 
-	auto TextureAtlas::update(const std::string& uniqueName, const uint8_t* buffer, uint32_t width, uint32_t height) -> Quad2D*
+	auto TextureAtlas::flush() -> void
 	{
-		if (width <= 0 || height <= 0)
-			return nullptr;
+		if (dirty.empty())
+			return;
 
-		int16_t x = 0;
-		int16_t y = 0;
-		int16_t w = static_cast<int16_t>(width);
-		int16_t h = static_cast<int16_t>(height);
+		PROFILE_FUNCTION();
+		if (pages != nullptr)
+			pages->update(layer, pixels.data(), dirty);
+		else
+			std::static_pointer_cast<Texture2D>(texture)->update(pixels.data(), dirty);
+		dirty.clear();
+	}
 
-		LeftOver value(x, y, w, h);
-		size_t lid = leftovers.findNode(value, [](const LeftOver& val, const LeftOver& leaf)
+	auto TextureAtlas::findPosition(uint32_t w, uint32_t h, size_t& node, uint32_t& x, uint32_t& y) const -> bool
+	{
+		uint32_t bestTop = UINT32_MAX;
+		uint32_t bestWidth = UINT32_MAX;
+
+		for (size_t i = 0; i < skyline.size(); i++)
 		{
-				return val.width() <= leaf.width() && val.height() <= leaf.height();
-		});
+			//the nodes are sorted by x
+			if (skyline[i].x + w > width)
+				break;
+
+			//the rectangle rests on the highest node under it
+			uint32_t top = skyline[i].y;
+			uint32_t covered = 0;
+			for (size_t j = i; covered < w; j++)
+			{
+				top = std::max(top, skyline[j].y);
+				covered += skyline[j].width;
+			}
+
+			if (top + h > height)
+				continue;
 
+			if (top + h < bestTop || (top + h == bestTop && skyline[i].width < bestWidth))
+			{
+				bestTop = top + h;
+				bestWidth = skyline[i].width;
+				node = i;
+				x = skyline[i].x;
+				y = top;
+			}
+		}
+		return bestTop != UINT32_MAX;
+	}
 
-		if (lid > 0)
+	auto TextureAtlas::addSkyline(size_t node, uint32_t x, uint32_t y, uint32_t w, uint32_t h) -> void
+	{
+		//the gaps between the bottom of the rectangle and the nodes under it are lost
+		for (size_t j = node, covered = 0; covered < w; j++)
 		{
-			const LeftOver& leftover = leftovers[lid];
-			x = leftover.l;
-			y = leftover.t;
+			const auto span = std::min<size_t>(skyline[j].width, w - covered);
+			wasted += (y - skyline[j].y) * span;
+			covered += span;
+		}
 
-			auto wdelta = leftover.width() - w;
-			auto hdelta = leftover.height() - h;
+		skyline.insert(skyline.begin() + node, { x, y + h, w });
 
-			leftovers.erase(lid);
+		//cut the nodes which are now covered by the rectangle
+		for (size_t i = node + 1; i < skyline.size();)
+		{
+			const auto right = skyline[i - 1].x + skyline[i - 1].width;
+			if (skyline[i].x >= right)
+				break;
 
-			wasted -= w * h;
-			if (wdelta >= MINLOSIZE && hdelta >= MINLOSIZE)
-			{
-				leftovers.add(rlid, LeftOver(x + w, y + h, wdelta, hdelta));
-				rlid++;
-
-				if (w >= MINLOSIZE)
-				{
-					leftovers.add(rlid, LeftOver(x, y + h, w, hdelta));
-					rlid++;
-				}
-
-				if (h >= MINLOSIZE)
-				{
-					leftovers.add(rlid, LeftOver(x + w, y, wdelta, h));
-					rlid++;
-				}
-			}
-			else if (wdelta >= MINLOSIZE)
-			{
-				leftovers.add(rlid, LeftOver(x + w, y, wdelta, h + hdelta));
-				rlid++;
-			}
-			else if (hdelta >= MINLOSIZE)
+			const auto shrink = right - skyline[i].x;
+			if (skyline[i].width <= shrink)
 			{
-				leftovers.add(rlid, LeftOver(x, y + h, w + wdelta, hdelta));
-				rlid++;
+				skyline.erase(skyline.begin() + i);
+				continue;
 			}
+			skyline[i].x += shrink;
+			skyline[i].width -= shrink;
+			break;
 		}
-		else
+
+		for (size_t i = 0; i + 1 < skyline.size();)
 		{
-			if (border.first + w > texture->getWidth())
+			if (skyline[i].y == skyline[i + 1].y)
 			{
-				auto prevBorder = border.first;
-				border.first = 0;
-				border.second += yRange.second;
-				if (border.second + h > texture->getHeight())
-				{
-					border.first = prevBorder;
-					border.second -= yRange.second;
-					return nullptr;
-				}
-				yRange = {};
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+				continue;
 			}
-			else if (border.second + h > texture->getHeight())
-			{
-				return nullptr;
-			}
-			x = border.first;
-			y = border.second;
+			i++;
+		}
+	}
 
-			border.first += w;
-			if (h > yRange.second)
-			{
-				if (x >= MINLOSIZE && h - yRange.second >= MINLOSIZE)
-				{
-					leftovers.add(rlid, LeftOver(0, yRange.first, x, h - yRange.second));
-					rlid++;
-				}
-				wasted += x * (h - yRange.second);
-				yRange = { y + h, h };
-			}
-			else if (h < yRange.first - y)
-			{
-				if (w >= MINLOSIZE && yRange.first - y - h >= MINLOSIZE)
-				{
-					leftovers.add(rlid, LeftOver(x, y + h, w, yRange.first - y - h));
-					rlid++;
-				}
-				wasted += w * (yRange.first - y - h);
-			}
+	auto TextureAtlas::update(const std::string& uniqueName, const uint8_t* buffer, uint32_t w, uint32_t h) -> Quad2D*
+	{
+		if (w == 0 || h == 0)
+			return nullptr;
+
+		size_t node = 0;
+		uint32_t x = 0;
+		uint32_t y = 0;
+		if (!findPosition(w, h, node, x, y))
+			return nullptr;
+
+		addSkyline(node, x, y, w, h);
+
+		for (uint32_t row = 0; row < h; row++)
+		{
+			std::memcpy(pixels.data() + ((static_cast<size_t>(y) + row) * width + x) * 4, buffer + static_cast<size_t>(row) * w * 4, w * 4);
 		}
+		dirty.push_back({ x, y, w, h });
 
-		texture->bind();
-		texture->update(x, y, w, h, buffer);
 		auto& offset = offsets[uniqueName];
 		offset.setTexture(texture);
+		offset.setLayer(layer);
 		offset.setTexCoords(x, y, w, h);
 
-		size_t used_i = texture->getWidth() * border.second + border.first * yRange.second;
-		usage = static_cast<double>(used_i) / (texture->getWidth() * texture->getHeight());
+		used += static_cast<size_t>(w) * h;
+		usage = static_cast<float>(static_cast<double>(used) / (static_cast<double>(width) * height));
 		return &offset;
 	}
 
-};
\ No newline at end of file
+};
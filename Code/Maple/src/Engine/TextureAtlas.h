@@ -5,40 +5,60 @@
 
 
 #pragma once
-#include "QuadTree.h"
 #include "Quad2D.h"
 #include "Engine/Core.h"
+#include "Engine/Interface/Texture.h"
+#include <unordered_map>
+#include <vector>
 
 namespace Maple
 {
-	class Texture;
+	//Sprites are packed with a bottom left skyline and written into a copy of the atlas in memory,
+	//the rectangles written since the last flush go up to the texture together.
+	//The atlas is either a texture of its own or one layer of a texture array.
 	class MAPLE_EXPORT TextureAtlas
 	{
 	public:
 		TextureAtlas(uint32_t w = 4096, uint32_t h = 4096);
+		TextureAtlas(const std::shared_ptr<Texture2DArray>& pages, uint32_t layer);
 
 		auto addSprite(const std::string& file)->Quad2D*;
 		auto addSprite(const std::string& uniqueName,const std::vector<uint8_t> &, uint32_t w,uint32_t h)->Quad2D*;
 
+		//upload the sprites added since the last flush, once per frame.
+		auto flush() -> void;
+
 		inline auto getTexture() { return texture; }
+		inline auto getLayer() const { return layer; }
+		//pixels covered by sprites / pixels of the atlas
 		inline auto getUsage() { return usage; }
+		//pixels under the skyline which no sprite can reach any more
+		inline auto getWasted() { return wasted; }
 
 	private:
-		
+		struct SkylineNode
+		{
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+		};
+
 		auto update(const std::string& uniqueName,const uint8_t * buffer,uint32_t w,uint32_t h)->Quad2D*;
+		//lowest position for the rectangle, the leftmost one if several are as low. returns false if it does not fit.
+		auto findPosition(uint32_t w, uint32_t h, size_t& node, uint32_t& x, uint32_t& y) const -> bool;
+		auto addSkyline(size_t node, uint32_t x, uint32_t y, uint32_t w, uint32_t h) -> void;
 
-		size_t rlid = 1;
+		uint32_t width;
+		uint32_t height;
+		size_t used = 0;
 		size_t wasted = 0;
 		float usage = 0.f;
-		std::shared_ptr<Texture2D> texture;
+		std::shared_ptr<Texture> texture;
+		std::shared_ptr<Texture2DArray> pages;
+		uint32_t layer = 0;
 		std::unordered_map<std::string, Quad2D> offsets;
-		QuadTree<size_t, LeftOver> leftovers;
-
-		static const int16_t MINLOSIZE = 4;
-
-		std::pair<int16_t, int16_t> border;
-		std::pair<int16_t, int16_t> yRange;
-
-
+		std::vector<SkylineNode> skyline;
+		std::vector<uint8_t> pixels;
+		std::vector<TextureRegion> dirty;
 	};
-};
\ No newline at end of file
+};
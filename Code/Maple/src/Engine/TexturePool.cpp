@@ -1,44 +1,73 @@
 #include "TexturePool.h"
+#include "Others/Console.h"
 
 namespace Maple
 {
+    TexturePool::TexturePool(uint32_t pageSize)
+        :pageSize(pageSize)
+    {
+    }
+
     auto TexturePool::addSprite(const std::string& file) -> Quad2D*
     {
-        if (auto iter = mapping.find(file); iter != mapping.end()) {
-            return iter->second->addSprite(file);
+        return addSprite(file, [&](TextureAtlas& page) {
+            return page.addSprite(file);
+        });
+    }
+
+    auto TexturePool::addSprite(const std::string& uniqueName, const std::vector<uint8_t>& data, uint32_t w, uint32_t h) -> Quad2D*
+    {
+        return addSprite(uniqueName, [&](TextureAtlas& page) {
+            return page.addSprite(uniqueName, data, w, h);
+        });
+    }
+
+    auto TexturePool::addSprite(const std::string& uniqueName, const std::function<Quad2D*(TextureAtlas&)>& insert) -> Quad2D*
+    {
+        if (auto iter = mapping.find(uniqueName); iter != mapping.end()) {
+            return pages[iter->second]->addSprite(uniqueName);
         }
-        if (atlas.empty()) {
-            createTextureAtlas();
+
+        if (pages.empty()) {
+            createPage();
+        }
+
+        auto quad = insert(*pages.back());
+        if (quad == nullptr && pages.back()->getUsage() > 0.f) {//full.. start a new page
+            createPage();
+            quad = insert(*pages.back());
         }
-		auto quad = atlas.back().addSprite(file);
+
         if (quad == nullptr) {
-            auto txt = createTextureAtlas();
-            quad = txt->addSprite(file);
+            LOGW("{0} can not be added to a {1}x{1} texture page", uniqueName, pageSize);
+            return nullptr;
         }
-		mapping[file] = &atlas.back();
-		return quad;
+
+        mapping[uniqueName] = static_cast<uint32_t>(pages.size() - 1);
+        return quad;
     }
 
-    auto TexturePool::addSprite(const std::string& uniqueName, const std::vector<uint8_t>& data, uint32_t w, uint32_t h) -> Quad2D*
+    auto TexturePool::flush() -> void
     {
-		if (auto iter = mapping.find(uniqueName); iter != mapping.end()) {
-			return iter->second->addSprite(uniqueName);
-		}
-
-		if (atlas.empty()) {
-			createTextureAtlas();
-		}
-		auto quad = atlas.back().addSprite(uniqueName, data,w,h);
-		if (quad == nullptr) {//full.. create a new one
-			auto txt = createTextureAtlas();
-			quad = txt->addSprite(uniqueName);
-		}
-		mapping[uniqueName] = &atlas.back();
-		return quad;
+        for (auto& page : pages)
+        {
+            page->flush();
+        }
     }
 
-    auto TexturePool::createTextureAtlas() -> TextureAtlas*
+    auto TexturePool::createPage() -> void
     {
-        return &atlas.emplace_back();
+        const auto layer = static_cast<uint32_t>(pages.size());
+        if (texture == nullptr)
+        {
+            texture = Texture2DArray::create(pageSize, pageSize, 1);
+        }
+        else
+        {
+            LOGI("Texture page {0} is full, usage : {1}%, wasted : {2} pixels", layer - 1, pages.back()->getUsage() * 100.f, pages.back()->getWasted());
+            //the new image copies the pages on the GPU, the copies in memory are not uploaded again
+            texture->resize(layer + 1);
+        }
+        pages.emplace_back(std::make_unique<TextureAtlas>(texture, layer));
     }
-};
\ No newline at end of file
+};
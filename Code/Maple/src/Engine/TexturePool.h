@@ -7,21 +7,36 @@
 #pragma once
 #include "TextureAtlas.h"
 #include <unordered_map>
+#include <functional>
+#include <memory>
 
 namespace Maple
 {
+	//Sprites are packed into pages, every page is a layer of the same texture array
+	//so all the sprites can be drawn with one descriptor set.
+	//The pages never move, the quads which have been handed out stay valid.
 	class MAPLE_EXPORT TexturePool final
 	{
 	public:
-		TexturePool() = default;
+		TexturePool(uint32_t pageSize = 4096);
 
 		auto addSprite(const std::string& file)->Quad2D*;
 		auto addSprite(const std::string& uniqueName, const std::vector<uint8_t>&, uint32_t w, uint32_t h)->Quad2D*;
+		//upload the sprites added this frame, before the frame is recorded.
+		auto flush() -> void;
+
+		//the pages, nullptr until the first sprite is added. the image is replaced when a page is added, see Texture::getVersion.
+		inline auto& getTexture() const { return texture; }
+		inline auto getPageCount() const { return static_cast<uint32_t>(pages.size()); }
 
 	private:
-		auto createTextureAtlas()->TextureAtlas*;
+		auto addSprite(const std::string& uniqueName, const std::function<Quad2D*(TextureAtlas&)>& insert)->Quad2D*;
+		auto createPage() -> void;
 
-		std::vector<TextureAtlas> atlas;
-		std::unordered_map<std::string, TextureAtlas*> mapping;
+		uint32_t pageSize;
+		std::shared_ptr<Texture2DArray> texture;
+		std::vector<std::unique_ptr<TextureAtlas>> pages;
+		//page of every sprite
+		std::unordered_map<std::string, uint32_t> mapping;
 	};
-};
\ No newline at end of file
+};
@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#include "VertexFormat.h"
+#include <glm/gtc/packing.hpp>
+#include <atomic>
+#include <cstddef>
+
+namespace Maple
+{
+	namespace
+	{
+		constexpr const char* ATTRIBUTE_NAMES[VertexFormat::AttributeCount] = {
+			"inPosition", "inColor", "inTexCoord", "inNormal", "inTangent"
+		};
+
+		inline auto signNotZero(const glm::vec2& v) -> glm::vec2
+		{
+			return { v.x >= 0.f ? 1.f : -1.f, v.y >= 0.f ? 1.f : -1.f };
+		}
+
+		std::atomic<bool> interleavedUsed{ false };
+	};
+
+	auto VertexFormat::encodeOctahedral(const glm::vec3& n) -> glm::vec2
+	{
+		const float sum = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+		//vertices without a normal (screen quads) decode to +z
+		if (sum <= 0.f)
+			return { 0.f, 0.f };
+
+		glm::vec2 p = glm::vec2(n) / sum;
+		if (n.z < 0.f)
+			p = (1.f - glm::abs(glm::vec2(p.y, p.x))) * signNotZero(p);
+		return p;
+	}
+
+	auto VertexFormat::decodeOctahedral(const glm::vec2& e) -> glm::vec3
+	{
+		glm::vec3 n(e.x, e.y, 1.f - glm::abs(e.x) - glm::abs(e.y));
+		const float t = glm::max(-n.z, 0.f);
+		n.x += n.x >= 0.f ? -t : t;
+		n.y += n.y >= 0.f ? -t : t;
+		return glm::normalize(n);
+	}
+
+	auto VertexFormat::pack(const Vertex& vertex) -> PackedAttributes
+	{
+		PackedAttributes packed;
+		packed.color = glm::packUnorm4x8(vertex.color);
+		packed.texCoord = glm::packHalf2x16(vertex.texCoord);
+		packed.normal = glm::packSnorm2x16(encodeOctahedral(vertex.normal));
+		packed.tangent = glm::packSnorm2x16(encodeOctahedral(vertex.tangent));
+		return packed;
+	}
+
+	auto VertexFormat::pack(const Vertex* vertices, uint32_t count, std::vector<glm::vec3>& positions, std::vector<PackedAttributes>& attributes) -> void
+	{
+		positions.resize(count);
+		attributes.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			positions[i] = vertices[i].pos;
+			attributes[i] = pack(vertices[i]);
+		}
+	}
+
+	auto VertexFormat::unpack(const glm::vec3& position, const PackedAttributes& attributes) -> Vertex
+	{
+		Vertex vertex;
+		vertex.pos = position;
+		vertex.color = glm::unpackUnorm4x8(attributes.color);
+		vertex.texCoord = glm::unpackHalf2x16(attributes.texCoord);
+		vertex.normal = decodeOctahedral(glm::unpackSnorm2x16(attributes.normal));
+		vertex.tangent = decodeOctahedral(glm::unpackSnorm2x16(attributes.tangent));
+		return vertex;
+	}
+
+	auto VertexFormat::getAttribute(const std::string& inputName) -> Attribute
+	{
+		for (uint32_t i = 0; i < AttributeCount; i++)
+		{
+			if (inputName == ATTRIBUTE_NAMES[i])
+				return static_cast<Attribute>(i);
+		}
+		return AttributeCount;
+	}
+
+	auto VertexFormat::getStream(Attribute attribute) -> Stream
+	{
+		return attribute == Position ? PositionStream : AttributeStream;
+	}
+
+	auto VertexFormat::getStride(Stream stream) -> uint32_t
+	{
+		return stream == PositionStream ? sizeof(glm::vec3) : sizeof(PackedAttributes);
+	}
+
+	auto VertexFormat::getAttributeDescription(Attribute attribute, uint32_t location) -> VkVertexInputAttributeDescription
+	{
+		VkVertexInputAttributeDescription description{};
+		description.location = location;
+		description.binding = getStream(attribute);
+		switch (attribute)
+		{
+		case Position:
+			description.format = VK_FORMAT_R32G32B32_SFLOAT;
+			description.offset = 0;
+			break;
+		case Color:
+			description.format = VK_FORMAT_R8G8B8A8_UNORM;
+			description.offset = offsetof(PackedAttributes, color);
+			break;
+		case TexCoord:
+			description.format = VK_FORMAT_R16G16_SFLOAT;
+			description.offset = offsetof(PackedAttributes, texCoord);
+			break;
+		case Normal:
+			description.format = VK_FORMAT_R16G16_SNORM;
+			description.offset = offsetof(PackedAttributes, normal);
+			break;
+		case Tangent:
+			description.format = VK_FORMAT_R16G16_SNORM;
+			description.offset = offsetof(PackedAttributes, tangent);
+			break;
+		default:
+			break;
+		}
+		return description;
+	}
+
+	auto VertexFormat::getComponentCount(Attribute attribute) -> uint32_t
+	{
+		switch (attribute)
+		{
+		case Position:
+			return 3;
+		case Color:
+			return 4;
+		default:
+			return 2;
+		}
+	}
+
+	auto VertexFormat::getInterleavedOffset(Attribute attribute) -> uint32_t
+	{
+		switch (attribute)
+		{
+		case Color:
+			return offsetof(Vertex, color);
+		case TexCoord:
+			return offsetof(Vertex, texCoord);
+		case Normal:
+			return offsetof(Vertex, normal);
+		case Tangent:
+			return offsetof(Vertex, tangent);
+		default:
+			return offsetof(Vertex, pos);
+		}
+	}
+
+	auto VertexFormat::setInterleavedUsed() -> void
+	{
+		interleavedUsed.store(true, std::memory_order_relaxed);
+	}
+
+	auto VertexFormat::isInterleavedUsed() -> bool
+	{
+		return interleavedUsed.load(std::memory_order_relaxed);
+	}
+};
@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Vertex.h"
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	//Meshes keep their vertices in two streams instead of one interleaved Vertex (60 bytes) :
+	//binding 0 : float3 position (12 bytes), everything a depth pass reads.
+	//binding 1 : rgba8 colour, half2 uv, octahedral snorm16x2 normal and tangent (16 bytes).
+	//Shaders which name their inputs after the mesh attributes (inPosition, inColor, inTexCoord, inNormal, inTangent)
+	//only get the streams they read. Normals and tangents are declared as vec2 and decoded in the shader.
+	//Shaders which still declare them as vec3 read an interleaved Vertex buffer instead, see setInterleavedUsed.
+	namespace VertexFormat
+	{
+		enum Stream : uint32_t
+		{
+			PositionStream,
+			AttributeStream,
+			StreamCount
+		};
+
+		enum Attribute : uint32_t
+		{
+			Position,
+			Color,
+			TexCoord,
+			Normal,
+			Tangent,
+			AttributeCount
+		};
+
+		struct PackedAttributes
+		{
+			uint32_t color;
+			uint32_t texCoord;
+			uint32_t normal;
+			uint32_t tangent;
+		};
+
+		static_assert(sizeof(PackedAttributes) == 16, "the attribute stream is tightly packed");
+
+		//unit vector -> [-1, 1]^2
+		auto encodeOctahedral(const glm::vec3& n) -> glm::vec2;
+		auto decodeOctahedral(const glm::vec2& e) -> glm::vec3;
+
+		auto pack(const Vertex& vertex) -> PackedAttributes;
+		auto pack(const Vertex* vertices, uint32_t count, std::vector<glm::vec3>& positions, std::vector<PackedAttributes>& attributes) -> void;
+		auto unpack(const glm::vec3& position, const PackedAttributes& attributes) -> Vertex;
+
+		//AttributeCount if the input is not named after a mesh attribute
+		auto getAttribute(const std::string& inputName) -> Attribute;
+		auto getStream(Attribute attribute) -> Stream;
+		auto getStride(Stream stream) -> uint32_t;
+		auto getAttributeDescription(Attribute attribute, uint32_t location) -> VkVertexInputAttributeDescription;
+		//float components the shader has to declare to read the packed streams (vec3 position, vec4 colour, vec2 otherwise)
+		auto getComponentCount(Attribute attribute) -> uint32_t;
+		//offset of the attribute in Vertex
+		auto getInterleavedOffset(Attribute attribute) -> uint32_t;
+
+		//set once a shader reads the interleaved layout, meshes uploaded from then on keep an interleaved buffer as well.
+		auto setInterleavedUsed() -> void;
+		auto isInterleavedUsed() -> bool;
+	};
+};
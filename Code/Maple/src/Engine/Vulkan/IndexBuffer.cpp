@@ -9,14 +9,14 @@ namespace Maple
 {
 	IndexBuffer::IndexBuffer(const uint16_t* data, uint32_t count)
 		: VulkanBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			count * sizeof(uint16_t), data)
+			count * sizeof(uint16_t), data, true)
 		, count(count)
 	{
 	}
 
 	IndexBuffer::IndexBuffer(const uint32_t* data, uint32_t count)
 		: VulkanBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			count * sizeof(uint32_t), data),
+			count * sizeof(uint32_t), data, true),
 		 count(count)
 	{
 	}
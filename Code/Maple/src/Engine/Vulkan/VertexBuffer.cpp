@@ -5,17 +5,33 @@
 #include "VertexBuffer.h"
 #include "VulkanCommandBuffer.h"
 #include "VulkanPipeline.h"
+#include "Engine/Core.h"
+#include "Others/Console.h"
+#include <cstring>
 namespace Maple
 {
 	VertexBuffer::VertexBuffer()
 	{
 		this->usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		deviceLocal = true;
 	}
 
 	VertexBuffer::VertexBuffer(const BufferUsage& usage)
 		:bufferUsage(usage)
 	{
 		this->usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		deviceLocal = usage == BufferUsage::STATIC;
+	}
+
+	auto VertexBuffer::allocateFrameSpan(uint32_t size) -> bool
+	{
+		if (bufferUsage == BufferUsage::STATIC)
+			return false;
+
+		auto ring = VulkanRingBuffer::get();
+		frameSpan = ring->allocate(size);
+		spanFrame = frameSpan ? ring->getFrameIndex() : UINT64_MAX;
+		return frameSpan;
 	}
 
 	VertexBuffer::~VertexBuffer()
@@ -25,6 +41,12 @@ namespace Maple
 
 	auto VertexBuffer::setData(uint32_t size, const void* data) -> void
 	{
+		if (allocateFrameSpan(size))
+		{
+			memcpy(frameSpan.data, data, size);
+			return;
+		}
+
 		if (size != this->size)
 		{
 			this->size = size;
@@ -39,20 +61,29 @@ namespace Maple
 
 	auto VertexBuffer::setSubData(uint32_t size, const void* data, uint32_t offset) -> void
 	{
-		if (size != this->size)
+		if (frameSpan && spanFrame == VulkanRingBuffer::get()->getFrameIndex())
 		{
-			this->size = size;
-			VulkanBuffer::resize(size, data);
+			memcpy(static_cast<uint8_t*>(frameSpan.data) + offset, data, size);
+			return;
 		}
-		else
+
+		if (offset + size > this->size)
 		{
-			VulkanBuffer::setData(size, data);
+			//the old content is gone once the buffer grows
+			this->size = offset + size;
+			VulkanBuffer::resize(offset + size, nullptr);
 		}
+		VulkanBuffer::setData(size, data, offset);
 	}
 
 	auto VertexBuffer::releasePointer() -> void
 	{
-		if (mappedBuffer)
+		if (mappedBuffer && frameSpan)
+		{
+			//ring memory is coherent
+			mappedBuffer = false;
+		}
+		else if (mappedBuffer)
 		{
 			VulkanBuffer::flush(size);
 			VulkanBuffer::unmap();
@@ -60,11 +91,25 @@ namespace Maple
 		}
 	}
 
-	auto VertexBuffer::bind(CommandBuffer* commandBuffer, Pipeline* pipeline) -> void
+	auto VertexBuffer::bind(CommandBuffer* commandBuffer, Pipeline* pipeline, uint32_t binding) -> void
 	{
-		VkDeviceSize offsets[1] = { 0 };
-		if (commandBuffer)
-			vkCmdBindVertexBuffers(*static_cast<VulkanCommandBuffer*>(commandBuffer), 0, 1, &buffer, offsets);
+		if (commandBuffer == nullptr)
+			return;
+
+		if (frameSpan && spanFrame == VulkanRingBuffer::get()->getFrameIndex())
+		{
+			vkCmdBindVertexBuffers(*static_cast<VulkanCommandBuffer*>(commandBuffer), binding, 1, &frameSpan.buffer, &frameSpan.offset);
+		}
+		else
+		{
+			//the span of the last setData belongs to a previous frame and no device buffer was ever created
+			MAPLE_ASSERT(buffer != VK_NULL_HANDLE, "DYNAMIC/STREAM vertex buffers have to be refilled every frame they are drawn");
+			if (buffer == VK_NULL_HANDLE)
+				return;
+
+			VkDeviceSize offsets[1] = { 0 };
+			vkCmdBindVertexBuffers(*static_cast<VulkanCommandBuffer*>(commandBuffer), binding, 1, &buffer, offsets);
+		}
 
 	}
 
@@ -76,10 +121,12 @@ namespace Maple
 	{
 		if (!mappedBuffer)
 		{
-			VulkanBuffer::map();
 			mappedBuffer = true;
+			if (allocateFrameSpan(size))
+				return frameSpan.data;
+			VulkanBuffer::map();
 		}
-		return mapped;
+		return frameSpan ? frameSpan.data : mapped;
 	}
 
 	auto VertexBuffer::create(const BufferUsage& usage) ->std::shared_ptr<VertexBuffer>
@@ -6,6 +6,7 @@
 #pragma once
 #include <memory>
 #include "VulkanBuffer.h"
+#include "VulkanRingBuffer.h"
 
 
 namespace Maple
@@ -14,6 +15,9 @@ namespace Maple
 	class Pipeline;
    /**
 	* VertexBuffer for Vulkan
+	* STATIC buffers live in device local memory.
+	* DYNAMIC/STREAM data is written into the frame ring buffer, so it is only valid for the frame it was written in.
+	* They have to be refilled every frame they are drawn.
 	*/
 	class VertexBuffer : public VulkanBuffer
 	{
@@ -31,14 +35,18 @@ namespace Maple
 		/**
 		 * bind to cmd 
 		 */
-		auto bind(CommandBuffer* commandBuffer, Pipeline* pipeline) -> void;
+		auto bind(CommandBuffer* commandBuffer, Pipeline* pipeline, uint32_t binding = 0) -> void;
 		auto unbind() -> void;
 		auto getPointer() -> void*;
 
 		static auto create(const BufferUsage& usage)->std::shared_ptr<VertexBuffer>;
 
 	protected:
+		auto allocateFrameSpan(uint32_t size) -> bool;
+
 		bool mappedBuffer = false;
 		BufferUsage bufferUsage = BufferUsage::STATIC;
+		VulkanRingBuffer::Span frameSpan;
+		uint64_t spanFrame = UINT64_MAX;
 	};
 };
\ No newline at end of file
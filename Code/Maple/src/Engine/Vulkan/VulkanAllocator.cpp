@@ -0,0 +1,390 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#include "VulkanAllocator.h"
+#include "VulkanDevice.h"
+#include "VulkanHelper.h"
+#include "Others/Console.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Maple
+{
+	namespace
+	{
+		inline auto alignUp(uint64_t value, uint64_t alignment) -> uint64_t
+		{
+			return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+		}
+	};
+
+	MemoryBlock::MemoryBlock(uint64_t size)
+		:size(size)
+	{
+		if (size > 0)
+			freeRanges.push_back({ 0, size });
+	}
+
+	auto MemoryBlock::allocate(uint64_t size, uint64_t alignment) -> uint64_t
+	{
+		int32_t best = -1;
+		uint64_t bestWaste = UINT64_MAX;
+
+		for (int32_t i = 0; i < static_cast<int32_t>(freeRanges.size()); i++)
+		{
+			const auto& range = freeRanges[i];
+			const uint64_t aligned = alignUp(range.offset, alignment);
+			const uint64_t padding = aligned - range.offset;
+			if (range.size < padding + size)
+				continue;
+
+			const uint64_t waste = range.size - size;
+			if (waste < bestWaste)
+			{
+				best = i;
+				bestWaste = waste;
+				if (waste == padding)
+					break;
+			}
+		}
+
+		if (best < 0)
+			return INVALID_OFFSET;
+
+		const auto range = freeRanges[best];
+		const uint64_t aligned = alignUp(range.offset, alignment);
+		const uint64_t padding = aligned - range.offset;
+		const uint64_t tail = range.size - padding - size;
+
+		//the alignment padding stays in the free list
+		if (padding > 0 && tail > 0)
+		{
+			freeRanges[best].size = padding;
+			freeRanges.insert(freeRanges.begin() + best + 1, { aligned + size, tail });
+		}
+		else if (padding > 0)
+		{
+			freeRanges[best].size = padding;
+		}
+		else if (tail > 0)
+		{
+			freeRanges[best] = { aligned + size, tail };
+		}
+		else
+		{
+			freeRanges.erase(freeRanges.begin() + best);
+		}
+
+		used += size;
+		allocationCount++;
+		return aligned;
+	}
+
+	auto MemoryBlock::free(uint64_t offset, uint64_t size) -> void
+	{
+		auto iter = std::lower_bound(freeRanges.begin(), freeRanges.end(), offset, [](const Range& range, uint64_t offset) {
+			return range.offset < offset;
+		});
+
+		iter = freeRanges.insert(iter, { offset, size });
+
+		//merge with the next range
+		auto next = iter + 1;
+		if (next != freeRanges.end() && iter->offset + iter->size == next->offset)
+		{
+			iter->size += next->size;
+			iter = freeRanges.erase(next) - 1;
+		}
+		//merge with the previous range
+		if (iter != freeRanges.begin())
+		{
+			auto prev = iter - 1;
+			if (prev->offset + prev->size == iter->offset)
+			{
+				prev->size += iter->size;
+				freeRanges.erase(iter);
+			}
+		}
+
+		used -= size;
+		allocationCount--;
+	}
+
+	auto MemoryBlock::getLargestFree() const -> uint64_t
+	{
+		uint64_t largest = 0;
+		for (auto& range : freeRanges)
+			largest = std::max(largest, range.size);
+		return largest;
+	}
+
+	std::shared_ptr<VulkanAllocator> VulkanAllocator::instance;
+
+	VulkanAllocator::VulkanAllocator(const std::vector<VkMemoryPropertyFlags>& memoryTypes, const Backend& backend, VkDeviceSize blockSize, VkDeviceSize atomSize)
+		:memoryTypes(memoryTypes), backend(backend), blockSize(blockSize), atomSize(std::max<VkDeviceSize>(atomSize, 1))
+	{
+		pools.resize(memoryTypes.size() * 2);
+	}
+
+	VulkanAllocator::~VulkanAllocator()
+	{
+		for (auto& pool : pools)
+		{
+			for (auto& block : pool.blocks)
+			{
+				if (block)
+					backend.free(block->memory);
+			}
+			if (pool.dedicatedCount > 0)
+				LOGW("VulkanAllocator : {0} dedicated allocations were not freed", pool.dedicatedCount);
+		}
+	}
+
+	auto VulkanAllocator::get() -> std::shared_ptr<VulkanAllocator>
+	{
+		if (instance == nullptr)
+		{
+			auto device = VulkanDevice::get();
+			VkPhysicalDeviceMemoryProperties memProperties;
+			vkGetPhysicalDeviceMemoryProperties(*device->getPhysicalDevice(), &memProperties);
+
+			std::vector<VkMemoryPropertyFlags> types;
+			for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+			{
+				types.emplace_back(memProperties.memoryTypes[i].propertyFlags);
+			}
+
+			Backend backend;
+			backend.allocate = [](uint32_t memoryType, VkDeviceSize size) {
+				VkMemoryAllocateInfo allocInfo = {};
+				allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+				allocInfo.allocationSize = size;
+				allocInfo.memoryTypeIndex = memoryType;
+				VkDeviceMemory memory = VK_NULL_HANDLE;
+				if (vkAllocateMemory(*VulkanDevice::get(), &allocInfo, nullptr, &memory) != VK_SUCCESS)
+					return (VkDeviceMemory)VK_NULL_HANDLE;
+				return memory;
+			};
+			backend.free = [](VkDeviceMemory memory) {
+				vkFreeMemory(*VulkanDevice::get(), memory, nullptr);
+			};
+			backend.map = [](VkDeviceMemory memory) {
+				void* data = nullptr;
+				VK_CHECK_RESULT(vkMapMemory(*VulkanDevice::get(), memory, 0, VK_WHOLE_SIZE, 0, &data));
+				return data;
+			};
+
+			instance = std::make_shared<VulkanAllocator>(types, backend, DEFAULT_BLOCK_SIZE,
+				device->getPhysicalDevice()->getProperties().limits.nonCoherentAtomSize);
+		}
+		return instance;
+	}
+
+	auto VulkanAllocator::release() -> void
+	{
+		instance.reset();
+	}
+
+	auto VulkanAllocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const -> int32_t
+	{
+		for (uint32_t i = 0; i < memoryTypes.size(); i++)
+		{
+			if ((typeBits & (1 << i)) && (memoryTypes[i] & properties) == properties)
+				return i;
+		}
+		return -1;
+	}
+
+	auto VulkanAllocator::map(VkDeviceMemory memory, uint32_t memoryType) -> uint8_t*
+	{
+		if (memoryTypes[memoryType] & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			return static_cast<uint8_t*>(backend.map(memory));
+		return nullptr;
+	}
+
+	auto VulkanAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear) -> VulkanAllocation
+	{
+		const int32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+		if (memoryType < 0)
+		{
+			throw std::runtime_error("failed to find suitable memory type!");
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		VulkanAllocation allocation;
+		allocation.pool = memoryType * 2 + (linear ? 1 : 0);
+		auto& pool = pools[allocation.pool];
+
+		const bool hostVisible = memoryTypes[memoryType] & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		const VkDeviceSize alignment = hostVisible ? std::max(requirements.alignment, atomSize) : requirements.alignment;
+		const VkDeviceSize size = hostVisible ? alignUp(requirements.size, atomSize) : requirements.size;
+
+		//large resources get their own memory, they would waste most of a block.
+		if (size > blockSize / 2)
+		{
+			allocation.memory = backend.allocate(memoryType, size);
+			if (allocation.memory == VK_NULL_HANDLE)
+			{
+				throw std::runtime_error("failed to allocate device memory!");
+			}
+			allocation.size = size;
+			allocation.mapped = map(allocation.memory, memoryType);
+			pool.dedicatedCount++;
+			pool.dedicatedSize += size;
+			return allocation;
+		}
+
+		int32_t freeSlot = -1;
+		for (int32_t i = 0; i < static_cast<int32_t>(pool.blocks.size()); i++)
+		{
+			auto& block = pool.blocks[i];
+			if (block == nullptr)
+			{
+				freeSlot = freeSlot < 0 ? i : freeSlot;
+				continue;
+			}
+			const auto offset = block->allocator.allocate(size, alignment);
+			if (offset != MemoryBlock::INVALID_OFFSET)
+			{
+				allocation.memory = block->memory;
+				allocation.offset = offset;
+				allocation.size = size;
+				allocation.block = i;
+				allocation.mapped = block->mapped ? block->mapped + offset : nullptr;
+				return allocation;
+			}
+		}
+
+		auto block = std::make_unique<Block>();
+		block->memory = backend.allocate(memoryType, blockSize);
+		if (block->memory == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("failed to allocate device memory!");
+		}
+		block->allocator = MemoryBlock(blockSize);
+		block->mapped = map(block->memory, memoryType);
+
+		allocation.memory = block->memory;
+		allocation.offset = block->allocator.allocate(size, alignment);
+		allocation.size = size;
+		allocation.mapped = block->mapped ? block->mapped + allocation.offset : nullptr;
+
+		if (freeSlot < 0)
+		{
+			freeSlot = static_cast<int32_t>(pool.blocks.size());
+			pool.blocks.emplace_back();
+		}
+		allocation.block = freeSlot;
+		pool.blocks[freeSlot] = std::move(block);
+		return allocation;
+	}
+
+	auto VulkanAllocator::free(VulkanAllocation& allocation) -> void
+	{
+		if (!allocation)
+			return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto& pool = pools[allocation.pool];
+		if (allocation.block < 0)
+		{
+			backend.free(allocation.memory);
+			pool.dedicatedCount--;
+			pool.dedicatedSize -= allocation.size;
+		}
+		else
+		{
+			auto& block = pool.blocks[allocation.block];
+			block->allocator.free(allocation.offset, allocation.size);
+
+			//keep one empty block per pool around, so a resource which is recreated every frame does not hit the driver.
+			if (block->allocator.isEmpty())
+			{
+				for (int32_t i = 0; i < static_cast<int32_t>(pool.blocks.size()); i++)
+				{
+					if (i != allocation.block && pool.blocks[i] && pool.blocks[i]->allocator.isEmpty())
+					{
+						backend.free(block->memory);
+						block.reset();
+						break;
+					}
+				}
+			}
+		}
+		allocation = {};
+	}
+
+	auto VulkanAllocator::allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties) -> VulkanAllocation
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(*VulkanDevice::get(), buffer, &memRequirements);
+		auto allocation = allocate(memRequirements, properties, true);
+		VK_CHECK_RESULT(vkBindBufferMemory(*VulkanDevice::get(), buffer, allocation.memory, allocation.offset));
+		return allocation;
+	}
+
+	auto VulkanAllocator::allocateImage(VkImage image, VkMemoryPropertyFlags properties) -> VulkanAllocation
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(*VulkanDevice::get(), image, &memRequirements);
+		auto allocation = allocate(memRequirements, properties, false);
+		VK_CHECK_RESULT(vkBindImageMemory(*VulkanDevice::get(), image, allocation.memory, allocation.offset));
+		return allocation;
+	}
+
+	auto VulkanAllocator::defragment() -> uint32_t
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		uint32_t released = 0;
+		for (auto& pool : pools)
+		{
+			for (auto& block : pool.blocks)
+			{
+				if (block && block->allocator.isEmpty())
+				{
+					backend.free(block->memory);
+					block.reset();
+					released++;
+				}
+			}
+			while (!pool.blocks.empty() && pool.blocks.back() == nullptr)
+				pool.blocks.pop_back();
+		}
+		return released;
+	}
+
+	auto VulkanAllocator::getPoolStats() const -> std::vector<PoolStats>
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<PoolStats> stats;
+		for (uint32_t i = 0; i < pools.size(); i++)
+		{
+			auto& pool = pools[i];
+			PoolStats stat;
+			stat.memoryType = i / 2;
+			stat.flags = memoryTypes[i / 2];
+			stat.linear = i % 2 == 1;
+			stat.dedicatedCount = pool.dedicatedCount;
+			stat.allocationCount = pool.dedicatedCount;
+			stat.reserved = pool.dedicatedSize;
+			stat.used = pool.dedicatedSize;
+
+			for (auto& block : pool.blocks)
+			{
+				if (block == nullptr)
+					continue;
+				stat.blockCount++;
+				stat.allocationCount += block->allocator.getAllocationCount();
+				stat.freeRangeCount += block->allocator.getFreeRangeCount();
+				stat.reserved += block->allocator.getSize();
+				stat.used += block->allocator.getUsed();
+				stat.largestFree = std::max<VkDeviceSize>(stat.largestFree, block->allocator.getLargestFree());
+			}
+
+			if (stat.reserved > 0)
+				stats.emplace_back(stat);
+		}
+		return stats;
+	}
+};
@@ -0,0 +1,140 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+namespace Maple
+{
+	//Offset allocator for a single memory block (best fit, neighbours are merged on free).
+	//No Vulkan calls, the bookkeeping can be exercised without a device.
+	class MemoryBlock
+	{
+	public:
+		static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+		MemoryBlock(uint64_t size = 0);
+
+		//returns INVALID_OFFSET if the block has no room.
+		auto allocate(uint64_t size, uint64_t alignment) -> uint64_t;
+		auto free(uint64_t offset, uint64_t size) -> void;
+		auto getLargestFree() const -> uint64_t;
+
+		inline auto getSize() const { return size; }
+		inline auto getUsed() const { return used; }
+		inline auto getAllocationCount() const { return allocationCount; }
+		inline auto getFreeRangeCount() const { return static_cast<uint32_t>(freeRanges.size()); }
+		inline auto isEmpty() const { return allocationCount == 0; }
+
+	private:
+		struct Range
+		{
+			uint64_t offset;
+			uint64_t size;
+		};
+		//sorted by offset
+		std::vector<Range> freeRanges;
+		uint64_t size = 0;
+		uint64_t used = 0;
+		uint32_t allocationCount = 0;
+	};
+
+	struct VulkanAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		//persistent mapping of host visible memory, already moved to offset.
+		void* mapped = nullptr;
+		int32_t pool = -1;
+		//-1 for a dedicated allocation
+		int32_t block = -1;
+
+		inline operator bool() const { return memory != VK_NULL_HANDLE; }
+	};
+
+	//Block based sub-allocator. Every memory type has two pools, linear (buffers) and optimal (images),
+	//so bufferImageGranularity never has to be considered inside a block.
+	//Host visible blocks are mapped once and stay mapped.
+	class VulkanAllocator final
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+		//device memory entry points, replaced by a mock to run the allocator on the CPU.
+		struct Backend
+		{
+			std::function<VkDeviceMemory(uint32_t memoryType, VkDeviceSize size)> allocate;
+			std::function<void(VkDeviceMemory memory)> free;
+			std::function<void*(VkDeviceMemory memory)> map;
+		};
+
+		struct PoolStats
+		{
+			uint32_t memoryType = 0;
+			VkMemoryPropertyFlags flags = 0;
+			bool linear = false;
+			uint32_t blockCount = 0;
+			uint32_t dedicatedCount = 0;
+			uint32_t allocationCount = 0;
+			uint32_t freeRangeCount = 0;
+			VkDeviceSize reserved = 0;
+			VkDeviceSize used = 0;
+			VkDeviceSize largestFree = 0;
+		};
+
+		//atomSize : alignment of allocations in host visible memory (nonCoherentAtomSize), so flushes stay inside the allocation.
+		VulkanAllocator(const std::vector<VkMemoryPropertyFlags>& memoryTypes, const Backend& backend, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE, VkDeviceSize atomSize = 1);
+		~VulkanAllocator();
+
+		auto allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear) -> VulkanAllocation;
+		auto free(VulkanAllocation& allocation) -> void;
+
+		//allocate and bind
+		auto allocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties) -> VulkanAllocation;
+		auto allocateImage(VkImage image, VkMemoryPropertyFlags properties) -> VulkanAllocation;
+
+		//give the empty blocks back to the driver, returns the number of released blocks.
+		//live allocations are not moved, their owners would need to recreate the resources.
+		auto defragment() -> uint32_t;
+
+		auto getPoolStats() const -> std::vector<PoolStats>;
+		auto findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const -> int32_t;
+		inline auto getBlockSize() const { return blockSize; }
+
+		static auto get() -> std::shared_ptr<VulkanAllocator>;
+		static auto release() -> void;
+
+	private:
+		struct Block
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			MemoryBlock allocator;
+			uint8_t* mapped = nullptr;
+		};
+
+		struct Pool
+		{
+			std::vector<std::unique_ptr<Block>> blocks;
+			uint32_t dedicatedCount = 0;
+			VkDeviceSize dedicatedSize = 0;
+		};
+
+		auto map(VkDeviceMemory memory, uint32_t memoryType) -> uint8_t*;
+
+		std::vector<VkMemoryPropertyFlags> memoryTypes;
+		std::vector<Pool> pools;
+		Backend backend;
+		VkDeviceSize blockSize;
+		VkDeviceSize atomSize;
+		mutable std::mutex mutex;
+
+		static std::shared_ptr<VulkanAllocator> instance;
+	};
+};
@@ -4,7 +4,9 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "VulkanBuffer.h"
 #include "VulkanDevice.h"
+#include "VulkanContext.h"
 #include "VulkanHelper.h"
+#include "VulkanUploadQueue.h"
 #include "Others/Console.h"
 namespace Maple
 {
@@ -12,8 +14,8 @@ namespace Maple
 	{
 	}
 
-	VulkanBuffer::VulkanBuffer(VkBufferUsageFlags usage, uint32_t size, const void* data)
-		:usage(usage),size(size)
+	VulkanBuffer::VulkanBuffer(VkBufferUsageFlags usage, uint32_t size, const void* data, bool deviceLocal)
+		:deviceLocal(deviceLocal),size(size),usage(usage)
 	{
 		init(usage, size, data);
 	}
@@ -31,47 +33,40 @@ namespace Maple
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		bufferInfo.size = size;
-		bufferInfo.usage = usage;
+		bufferInfo.usage = deviceLocal ? usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT : usage;
 		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 
 		VK_CHECK_RESULT(vkCreateBuffer(*VulkanDevice::get(), &bufferInfo, nullptr, &buffer));
 
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(*VulkanDevice::get(), buffer, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = VulkanHelper::findMemoryType(
-			memRequirements.memoryTypeBits,
+		allocation = VulkanAllocator::get()->allocateBuffer(buffer, deviceLocal ?
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT :
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-		VK_CHECK_RESULT(vkAllocateMemory(*VulkanDevice::get(), &allocInfo, nullptr, &memory));
-		//bind buffer -> 
-		vkBindBufferMemory(*VulkanDevice::get(), buffer, memory, 0);
 		//if the data is not nullptr, upload the data.
 		if (data != nullptr)
 			setData(size, data);
 	}
 
 	/**
-	 * map the data
+	 * map the data, host visible memory stays mapped so this only hands out the pointer.
 	 */
 	auto VulkanBuffer::map(VkDeviceSize size, VkDeviceSize offset) -> VkResult
 	{
-		return vkMapMemory(*VulkanDevice::get(), memory, offset, size, 0, &mapped);
+		if (allocation.mapped == nullptr)
+		{
+			LOGE("VulkanBuffer : device local buffers can not be mapped");
+			return VK_ERROR_MEMORY_MAP_FAILED;
+		}
+		mapped = allocation.mapped;
+		return VK_SUCCESS;
 	}
 	/**
 	 * unmap the data.
 	 */
 	auto VulkanBuffer::unmap() -> void
 	{
-		if (mapped)
-		{
-			vkUnmapMemory(*VulkanDevice::get(), memory);
-			mapped = nullptr;
-		}
+		mapped = nullptr;
 	}
 
 
@@ -79,9 +74,9 @@ namespace Maple
 	{
 		VkMappedMemoryRange mappedRange = {};
 		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
+		mappedRange.memory = allocation.memory;
+		mappedRange.offset = allocation.offset + offset;
+		mappedRange.size = size == VK_WHOLE_SIZE ? allocation.size - offset : size;
 		VK_CHECK_RESULT(vkFlushMappedMemoryRanges(*VulkanDevice::get(), 1, &mappedRange));
 	}
 
@@ -89,17 +84,92 @@ namespace Maple
 	{
 		VkMappedMemoryRange mappedRange = {};
 		mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		mappedRange.memory = memory;
-		mappedRange.offset = offset;
-		mappedRange.size = size;
+		mappedRange.memory = allocation.memory;
+		mappedRange.offset = allocation.offset + offset;
+		mappedRange.size = size == VK_WHOLE_SIZE ? allocation.size - offset : size;
 		VK_CHECK_RESULT(vkInvalidateMappedMemoryRanges(*VulkanDevice::get(), 1, &mappedRange));
 	}
 
 	auto VulkanBuffer::setData(uint32_t size, const void * data, uint32_t offset ) -> void
 	{
-		map(size, offset);
-		memcpy(reinterpret_cast<uint8_t*>(mapped) + offset, data, size);
-		unmap();
+		if (!deviceLocal)
+		{
+			map(size, offset);
+			memcpy(reinterpret_cast<uint8_t*>(mapped) + offset, data, size);
+			unmap();
+			return;
+		}
+
+		auto stagingBuffer = std::make_unique<VulkanBuffer>(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size, data);
+		auto src = stagingBuffer->getBuffer();
+		auto dst = buffer;
+		VulkanUploadQueue::get()->enqueue([=](VkCommandBuffer commandBuffer) {
+			//earlier frames may still read the old content
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			VkBufferCopy region = {};
+			region.srcOffset = 0;
+			region.dstOffset = offset;
+			region.size = size;
+			vkCmdCopyBuffer(commandBuffer, src, dst, 1, &region);
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}, std::move(stagingBuffer));
+	}
+
+	auto VulkanBuffer::setDataRanges(const void* data, const std::vector<BufferRange>& ranges) -> void
+	{
+		if (ranges.empty())
+			return;
+
+		auto src = static_cast<const uint8_t*>(data);
+		if (!deviceLocal)
+		{
+			map();
+			for (auto& range : ranges)
+				memcpy(reinterpret_cast<uint8_t*>(mapped) + range.offset, src + range.offset, range.size);
+			unmap();
+			return;
+		}
+
+		//the ranges are packed one after another in the staging buffer
+		std::vector<VkBufferCopy> regions(ranges.size());
+		uint32_t stagingSize = 0;
+		for (size_t i = 0; i < ranges.size(); i++)
+		{
+			regions[i].srcOffset = stagingSize;
+			regions[i].dstOffset = ranges[i].offset;
+			regions[i].size = ranges[i].size;
+			stagingSize += ranges[i].size;
+		}
+
+		auto stagingBuffer = std::make_unique<VulkanBuffer>(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingSize, nullptr);
+		stagingBuffer->map();
+		for (size_t i = 0; i < ranges.size(); i++)
+			memcpy(reinterpret_cast<uint8_t*>(stagingBuffer->mapped) + regions[i].srcOffset, src + ranges[i].offset, ranges[i].size);
+		stagingBuffer->unmap();
+
+		auto stagingHandle = stagingBuffer->getBuffer();
+		auto dst = buffer;
+		VulkanUploadQueue::get()->enqueue([=](VkCommandBuffer commandBuffer) {
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			vkCmdCopyBuffer(commandBuffer, stagingHandle, dst, static_cast<uint32_t>(regions.size()), regions.data());
+
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}, std::move(stagingBuffer));
 	}
 
 	auto VulkanBuffer::resize(uint32_t size, const void* data) -> void
@@ -112,12 +182,15 @@ namespace Maple
 	{
 		if (buffer)
 		{
-			vkDestroyBuffer(*VulkanDevice::get(), buffer, nullptr);
-
-			if (memory)
-			{
-				vkFreeMemory(*VulkanDevice::get(), memory, nullptr);
-			}
+			//frames in flight or a pending staging copy may still reference the buffer
+			auto oldBuffer = buffer;
+			auto oldAllocation = allocation;
+			VulkanContext::get()->deferRelease([=]() mutable {
+				vkDestroyBuffer(*VulkanDevice::get(), oldBuffer, nullptr);
+				VulkanAllocator::get()->free(oldAllocation);
+			});
+			buffer = VK_NULL_HANDLE;
+			allocation = {};
 		}
 	}
-};
\ No newline at end of file
+};
@@ -4,6 +4,8 @@
 //////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "vulkan/vulkan.h"
+#include "VulkanAllocator.h"
+#include <vector>
 namespace Maple
 {
 	enum class BufferUsage
@@ -11,12 +13,19 @@ namespace Maple
 		STATIC, DYNAMIC, STREAM
 	};
 
+	struct BufferRange
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
+
 
 	class VulkanBuffer
 	{
 	public:
 		VulkanBuffer();
-		VulkanBuffer(VkBufferUsageFlags usage, uint32_t size, const void* data);
+		//deviceLocal buffers are not mappable, setData goes through a staging copy in the upload queue.
+		VulkanBuffer(VkBufferUsageFlags usage, uint32_t size, const void* data, bool deviceLocal = false);
 		virtual ~VulkanBuffer();
 		auto init(VkBufferUsageFlags usage, uint32_t size, const void* data) -> void;
 		auto map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)->VkResult;
@@ -24,9 +33,12 @@ namespace Maple
 		auto flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) -> void;
 		auto invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) -> void;
 		auto setData(uint32_t size, const void* data,uint32_t offset = 0)->void;
+		//uploads the ranges of data to the same offsets of the buffer, device local buffers use one staging copy for all of them.
+		auto setDataRanges(const void* data, const std::vector<BufferRange>& ranges) -> void;
 
 		inline auto setUsage(VkBufferUsageFlags flags) { usage = flags; }
 		inline auto getSize() const { return size; }
+		inline auto isDeviceLocal() const { return deviceLocal; }
 		inline auto& getBuffer() { return buffer; }
 		inline const auto& getBuffer() const { return buffer; }
 		inline const auto& getBufferInfo() const { return desciptorBufferInfo; }
@@ -37,7 +49,8 @@ namespace Maple
 
 		VkDescriptorBufferInfo desciptorBufferInfo{};
 		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VulkanAllocation allocation;
+		bool deviceLocal = false;
 		VkDeviceSize size = 0;
 		VkDeviceSize alignment = 0;
 		void* mapped = nullptr;
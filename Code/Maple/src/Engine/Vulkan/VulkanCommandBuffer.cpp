@@ -7,6 +7,7 @@
 #include "VulkanCommandPool.h"
 #include "VulkanFrameBuffer.h"
 #include "VulkanRenderPass.h"
+#include "VulkanUploadQueue.h"
 #include "Others/Console.h"
 
 namespace Maple
@@ -16,6 +17,16 @@ namespace Maple
 		init(primary);
 	}
 
+	VulkanCommandBuffer::VulkanCommandBuffer(bool primary, VkCommandPool cmdPool)
+	{
+		init(primary, cmdPool);
+	}
+
+	VulkanCommandBuffer::VulkanCommandBuffer(VkCommandBuffer commandBuffer)
+		:commandBuffer(commandBuffer)
+	{
+	}
+
 	VulkanCommandBuffer::~VulkanCommandBuffer()
 	{
 		unload();
@@ -42,6 +53,7 @@ namespace Maple
 	auto VulkanCommandBuffer::init(bool primary, VkCommandPool cmdPool) -> bool
 	{
 		this->primary = primary;
+		commandPool = cmdPool;
 		VkCommandBufferAllocateInfo cmdBufferCI{};
 
 		cmdBufferCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -67,12 +79,18 @@ namespace Maple
 	 */
 	auto VulkanCommandBuffer::unload() -> void
 	{
+		//wrapped command buffers have neither a fence nor a pool
+		if (commandPool == VK_NULL_HANDLE)
+			return;
 		vkDestroyFence(*VulkanDevice::get(), fence, nullptr);
-		vkFreeCommandBuffers(*VulkanDevice::get(), *VulkanDevice::get()->getCommandPool(), 1, &commandBuffer);
+		vkFreeCommandBuffers(*VulkanDevice::get(), commandPool, 1, &commandBuffer);
 	}
 
 	auto VulkanCommandBuffer::beginRecording() -> void
 	{
+		//a command buffer executed with waitFence may still be pending
+		VK_CHECK_RESULT(vkWaitForFences(*VulkanDevice::get(), 1, &fence, VK_TRUE, UINT64_MAX));
+
 		VkCommandBufferBeginInfo beginCI{};
 		beginCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
@@ -80,22 +98,39 @@ namespace Maple
 	}
 
 	auto VulkanCommandBuffer::beginRecordingSecondary(VulkanRenderPass* renderPass, VulkanFrameBuffer* framebuffer) -> void
+	{
+		beginRecordingSecondary(*renderPass, *framebuffer);
+	}
+
+	auto VulkanCommandBuffer::beginRecordingSecondary(VkRenderPass renderPass, VkFramebuffer framebuffer) -> void
 	{
 
 		VkCommandBufferInheritanceInfo inheritanceInfo{};
 		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
 		inheritanceInfo.subpass = 0;
-		inheritanceInfo.renderPass = *renderPass;
-		inheritanceInfo.framebuffer = *framebuffer;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.framebuffer = framebuffer;
 
 		VkCommandBufferBeginInfo beginCI{};
 		beginCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginCI.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (renderPass != VK_NULL_HANDLE)
+			beginCI.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 		beginCI.pInheritanceInfo = &inheritanceInfo;
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginCI));
 	}
 
+	auto VulkanCommandBuffer::beginRenderPass(const VkRenderPassBeginInfo& info, VkSubpassContents contents) -> void
+	{
+		vkCmdBeginRenderPass(commandBuffer, &info, contents);
+	}
+
+	auto VulkanCommandBuffer::endRenderPass() -> void
+	{
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
 	auto VulkanCommandBuffer::endRecording() -> void
 	{
 		VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
@@ -135,6 +170,9 @@ namespace Maple
 
 	auto VulkanCommandBuffer::executeInternal(VkPipelineStageFlags flags, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, bool waitFence) -> void
 	{
+		//uploads and single time commands recorded so far have to run first.
+		VulkanUploadQueue::get()->flush();
+
 		uint32_t waitSemaphoreCount = waitSemaphore ? 1 : 0, signalSemaphoreCount = signalSemaphore ? 1 : 0;
 
 		VkSubmitInfo submitInfo = {};
@@ -148,19 +186,15 @@ namespace Maple
 		submitInfo.signalSemaphoreCount = signalSemaphoreCount;
 		submitInfo.pSignalSemaphores = &signalSemaphore;
 
-		//VK_CHECK_RESULT(vkQueueSubmit(VulkanDevice::get()->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE));
-
+		//the previous submission of this command buffer, the fence is signaled after creation.
+		VK_CHECK_RESULT(vkWaitForFences(*VulkanDevice::get(), 1, &fence, VK_TRUE, UINT64_MAX));
+		VK_CHECK_RESULT(vkResetFences(*VulkanDevice::get(), 1, &fence));
+		VK_CHECK_RESULT(vkQueueSubmit(VulkanDevice::get()->getGraphicsQueue(), 1, &submitInfo, fence));
 
-		if (waitFence)
-		{
-			VK_CHECK_RESULT(vkWaitForFences(*VulkanDevice::get(), 1, &fence, VK_TRUE, 100000000000));
-			VK_CHECK_RESULT(vkQueueSubmit(VulkanDevice::get()->getGraphicsQueue(), 1, &submitInfo, fence));
-			VK_CHECK_RESULT(vkResetFences(*VulkanDevice::get(), 1, &fence));
-		}
-		else
+		//only wait for this submission instead of draining the queue, the frames in flight keep running.
+		if (!waitFence)
 		{
-			VK_CHECK_RESULT(vkQueueSubmit(VulkanDevice::get()->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE));
-			VK_CHECK_RESULT(vkQueueWaitIdle(VulkanDevice::get()->getGraphicsQueue()));
+			VK_CHECK_RESULT(vkWaitForFences(*VulkanDevice::get(), 1, &fence, VK_TRUE, UINT64_MAX));
 		}
 	}
 };
\ No newline at end of file
@@ -16,6 +16,7 @@ namespace Maple
 	{
 	public:
 		VulkanCommandBuffer(bool primary = true);
+		VulkanCommandBuffer(bool primary, VkCommandPool cmdPool);
 		~VulkanCommandBuffer();
 
 
@@ -25,8 +26,14 @@ namespace Maple
 
 		virtual auto unload() -> void;
 		virtual auto beginRecordingSecondary(VulkanRenderPass* renderPass, VulkanFrameBuffer* framebuffer) -> void;
+		//renderPass is VK_NULL_HANDLE for a secondary command buffer executed outside of a render pass.
+		virtual auto beginRecordingSecondary(VkRenderPass renderPass, VkFramebuffer framebuffer) -> void;
 		virtual auto executeSecondary(VulkanCommandBuffer* primaryCmdBuffer) -> void;
 
+		//called by VulkanRenderPass, a recorder splits the work into secondary command buffers here.
+		virtual auto beginRenderPass(const VkRenderPassBeginInfo& info, VkSubpassContents contents) -> void;
+		virtual auto endRenderPass() -> void;
+
 
 		auto updateViewport(uint32_t width, uint32_t height) -> void override;
 		auto beginRecording() -> void override;
@@ -39,9 +46,14 @@ namespace Maple
 
 		autoUnpack(commandBuffer);
 		auto executeInternal(VkPipelineStageFlags flags, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, bool waitFence) -> void;
-	private:
+	protected:
+		//wraps a command buffer which is owned by someone else.
+		explicit VulkanCommandBuffer(VkCommandBuffer commandBuffer);
+
 		VkCommandBuffer commandBuffer = nullptr;
+	private:
 		VkFence fence = nullptr;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
 		bool primary = false;
 	};
 };
\ No newline at end of file
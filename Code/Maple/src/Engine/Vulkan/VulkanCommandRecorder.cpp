@@ -0,0 +1,153 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#include "VulkanCommandRecorder.h"
+#include "VulkanContext.h"
+#include "VulkanSwapChain.h"
+#include "Others/Console.h"
+#include "Engine/Profiler.h"
+#include "Application.h"
+
+namespace Maple
+{
+	VulkanCommandRecorder::VulkanCommandRecorder()
+		:VulkanCommandBuffer(static_cast<VkCommandBuffer>(VK_NULL_HANDLE))
+	{
+	}
+
+	VulkanCommandRecorder::~VulkanCommandRecorder()
+	{
+	}
+
+	auto VulkanCommandRecorder::beginRecording() -> void
+	{
+		segments.clear();
+		inRenderPass = false;
+		secondaryCount = 0;
+		segments.emplace_back();
+		beginSecondary();
+	}
+
+	auto VulkanCommandRecorder::endRecording() -> void
+	{
+		if (inRenderPass)
+		{
+			LOGE("VulkanCommandRecorder : recording ended inside a render pass");
+			inRenderPass = false;
+		}
+		endSecondary();
+	}
+
+	auto VulkanCommandRecorder::execute(bool waitFence) -> void
+	{
+		LOGE("VulkanCommandRecorder : a recorder can not be submitted, use executeInto");
+	}
+
+	auto VulkanCommandRecorder::updateViewport(uint32_t width, uint32_t height) -> void
+	{
+		//chunks recorded later in the pass set the same viewport, dynamic state is not inherited.
+		viewportWidth = width;
+		viewportHeight = height;
+		VulkanCommandBuffer::updateViewport(width, height);
+	}
+
+	auto VulkanCommandRecorder::beginRenderPass(const VkRenderPassBeginInfo& info, VkSubpassContents contents) -> void
+	{
+		endSecondary();
+
+		auto& segment = segments.emplace_back();
+		segment.renderPass = true;
+		segment.beginInfo = info;
+		segment.clearValues.assign(info.pClearValues, info.pClearValues + info.clearValueCount);
+		inRenderPass = true;
+		beginSecondary();
+	}
+
+	auto VulkanCommandRecorder::endRenderPass() -> void
+	{
+		endSecondary();
+		inRenderPass = false;
+		segments.emplace_back();
+		beginSecondary();
+	}
+
+	auto VulkanCommandRecorder::beginSecondary(VulkanCommandBuffer* cmd) -> void
+	{
+		auto& segment = segments.back();
+		if (segment.renderPass)
+			cmd->beginRecordingSecondary(segment.beginInfo.renderPass, segment.beginInfo.framebuffer);
+		else
+			cmd->beginRecordingSecondary(static_cast<VkRenderPass>(VK_NULL_HANDLE), static_cast<VkFramebuffer>(VK_NULL_HANDLE));
+	}
+
+	auto VulkanCommandRecorder::beginSecondary() -> void
+	{
+		auto cmd = std::static_pointer_cast<VulkanSwapChain>(VulkanContext::get()->getSwapChain())->getSecondaryCommandBuffer();
+		beginSecondary(cmd);
+		commandBuffer = *cmd;
+		segments.back().commandBuffers.emplace_back(commandBuffer);
+		secondaryCount++;
+	}
+
+	auto VulkanCommandRecorder::endSecondary() -> void
+	{
+		if (commandBuffer == VK_NULL_HANDLE)
+			return;
+		VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
+		commandBuffer = VK_NULL_HANDLE;
+	}
+
+	auto VulkanCommandRecorder::recordParallel(int32_t begin, int32_t end, const RecordCallback& record, int32_t grainSize) -> void
+	{
+		PROFILE_FUNCTION();
+		if (!inRenderPass || end - begin <= grainSize)
+		{
+			record(this, begin, end);
+			return;
+		}
+
+		//what has been recorded so far goes first, then the chunks, then a new buffer for the rest of the pass.
+		endSecondary();
+
+		std::vector<std::pair<int32_t, int32_t>> chunks;
+		for (int32_t i = begin; i < end; i += grainSize)
+		{
+			chunks.emplace_back(i, std::min(i + grainSize, end));
+		}
+
+		std::vector<VkCommandBuffer> recorded(chunks.size());
+		Application::get()->getThreadPool()->parallelFor(0, static_cast<int32_t>(chunks.size()), [&](int32_t i) {
+			//the buffer comes from the pool of the thread which runs the chunk.
+			auto cmd = std::static_pointer_cast<VulkanSwapChain>(VulkanContext::get()->getSwapChain())->getSecondaryCommandBuffer();
+			beginSecondary(cmd);
+			cmd->updateViewport(viewportWidth, viewportHeight);
+			record(cmd, chunks[i].first, chunks[i].second);
+			cmd->endRecording();
+			recorded[i] = *cmd;
+		}, 1);
+
+		auto& buffers = segments.back().commandBuffers;
+		buffers.insert(buffers.end(), recorded.begin(), recorded.end());
+		secondaryCount += static_cast<uint32_t>(recorded.size());
+		beginSecondary();
+		VulkanCommandBuffer::updateViewport(viewportWidth, viewportHeight);
+	}
+
+	auto VulkanCommandRecorder::executeInto(VulkanCommandBuffer* primary) -> void
+	{
+		for (auto& segment : segments)
+		{
+			if (segment.renderPass)
+			{
+				segment.beginInfo.pClearValues = segment.clearValues.data();
+				primary->beginRenderPass(segment.beginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			}
+
+			vkCmdExecuteCommands(*primary, static_cast<uint32_t>(segment.commandBuffers.size()), segment.commandBuffers.data());
+
+			if (segment.renderPass)
+				primary->endRenderPass();
+		}
+	}
+};
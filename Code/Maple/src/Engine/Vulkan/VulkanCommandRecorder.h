@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "VulkanCommandBuffer.h"
+#include <vector>
+#include <functional>
+
+namespace Maple
+{
+	//Stands in for the primary command buffer while a renderer is recorded on a worker thread.
+	//Everything is recorded into secondary command buffers of the calling thread, split at every render pass.
+	//executeInto() replays the render passes into the primary command buffer in the order they were recorded.
+	class VulkanCommandRecorder final : public VulkanCommandBuffer
+	{
+	public:
+		using RecordCallback = std::function<void(CommandBuffer*, int32_t, int32_t)>;
+
+		VulkanCommandRecorder();
+		~VulkanCommandRecorder();
+
+		auto beginRecording() -> void override;
+		auto endRecording() -> void override;
+		auto execute(bool waitFence) -> void override;
+		auto updateViewport(uint32_t width, uint32_t height) -> void override;
+
+		auto beginRenderPass(const VkRenderPassBeginInfo& info, VkSubpassContents contents) -> void override;
+		auto endRenderPass() -> void override;
+
+		//records [begin, end) in chunks on the worker threads, each chunk into its own secondary command buffer
+		//which inherits the current render pass and viewport. the chunks are executed in order.
+		auto recordParallel(int32_t begin, int32_t end, const RecordCallback& record, int32_t grainSize) -> void;
+
+		//main thread, after the recording has finished.
+		auto executeInto(VulkanCommandBuffer* primary) -> void;
+
+		inline auto isInRenderPass() const { return inRenderPass; }
+		inline auto getSecondaryCount() const { return secondaryCount; }
+
+	private:
+		struct Segment
+		{
+			bool renderPass = false;
+			VkRenderPassBeginInfo beginInfo{};
+			std::vector<VkClearValue> clearValues;
+			std::vector<VkCommandBuffer> commandBuffers;
+		};
+
+		auto beginSecondary() -> void;
+		auto endSecondary() -> void;
+		auto beginSecondary(VulkanCommandBuffer* cmd) -> void;
+
+		std::vector<Segment> segments;
+		bool inRenderPass = false;
+		uint32_t viewportWidth = 0;
+		uint32_t viewportHeight = 0;
+		uint32_t secondaryCount = 0;
+	};
+};
@@ -16,6 +16,8 @@
 #endif
 
 #include "VulkanSwapChain.h"
+#include "Engine/Profiler.h"
+#include <algorithm>
 namespace Maple
 {
 
@@ -134,6 +136,9 @@ namespace Maple
 	 */
 	auto VulkanContext::resize(uint32_t width, uint32_t height) -> void
 	{
+		//the frame fences belong to the swap chain, nothing may be in flight when it is replaced.
+		waiteIdle();
+		swapChain.reset();
 		swapChain = SwapChain::create();
 		swapChain->init();
 	}
@@ -141,6 +146,50 @@ namespace Maple
 	auto VulkanContext::waiteIdle() -> void
 	{
 		vkDeviceWaitIdle(*VulkanDevice::get());
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			runReleases(i);
+		}
+	}
+
+	auto VulkanContext::setFramesInFlight(uint32_t count) -> void
+	{
+		if (swapChain != nullptr)
+		{
+			LOGW("VulkanContext : frames in flight can not be changed after the swap chain is created");
+			return;
+		}
+		framesInFlight = std::max(1u, std::min(count, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)));
+	}
+
+	auto VulkanContext::nextFrame() -> void
+	{
+		PROFILE_FUNCTION();
+		currentFrame = (currentFrame + 1) % framesInFlight;
+		std::static_pointer_cast<VulkanSwapChain>(swapChain)->waitFrame(currentFrame);
+
+		//the last frame which used this slot has finished, so have the ones before it.
+		runReleases(currentFrame);
+	}
+
+	auto VulkanContext::runReleases(uint32_t frame) -> void
+	{
+		//a deleter may release more resources, those wait for the next round.
+		auto pending = std::move(releases[frame]);
+		releases[frame].clear();
+		for (auto& deleter : pending)
+			deleter();
+	}
+
+	auto VulkanContext::deferRelease(const std::function<void()>& deleter) -> void
+	{
+		if (swapChain == nullptr)
+		{
+			deleter();
+			return;
+		}
+		std::lock_guard<std::mutex> lock(releaseMutex);
+		releases[currentFrame].emplace_back(deleter);
 	}
 
 	auto VulkanContext::get() ->std::shared_ptr<VulkanContext>
@@ -8,12 +8,16 @@
 #include <memory>
 #include <vector>
 #include <optional>
+#include <functional>
+#include <mutex>
 #include <vulkan/vulkan.h>
 #include "Engine/Core.h"
 
 struct GLFWwindow;
 namespace Maple
 {
+#define MAX_FRAMES_IN_FLIGHT 3
+
 	class SwapChain;
 
 	class MAPLE_EXPORT VulkanContext
@@ -29,6 +33,16 @@ namespace Maple
 		auto resize(uint32_t width, uint32_t height) -> void;
 		auto waiteIdle() -> void;
 
+		//number of frames the CPU may record ahead of the GPU, only takes effect before the swap chain is created.
+		auto setFramesInFlight(uint32_t count) -> void;
+		inline auto getFramesInFlight() const { return framesInFlight; }
+		//slot of the frame being recorded, in [0, getFramesInFlight())
+		inline auto getCurrentFrame() const { return currentFrame; }
+		//move to the next slot, blocks until the GPU has finished the frame which used it last.
+		auto nextFrame() -> void;
+		//destroy a resource once the frames which may still reference it have finished on the GPU.
+		auto deferRelease(const std::function<void()>& deleter) -> void;
+
 		inline const auto getVkInstance() const { return vkInstance; }
 		inline auto getVkInstance() { return vkInstance; }
 		inline auto getVkSurface() { return surface; }
@@ -42,6 +56,7 @@ namespace Maple
 	private:
 		auto setupDebug() -> void;
 		auto getRequireExtensions()->std::vector<const char*>;
+		auto runReleases(uint32_t frame) -> void;
 		static std::shared_ptr<VulkanContext> instance;
 
 		bool enableValidation = false;
@@ -56,6 +71,12 @@ namespace Maple
 
 		std::shared_ptr<SwapChain> swapChain;
 
+		uint32_t framesInFlight = 2;
+		uint32_t currentFrame = 0;
+		std::vector<std::function<void()>> releases[MAX_FRAMES_IN_FLIGHT];
+		//resources can be released while renderers are recorded on the worker threads.
+		std::mutex releaseMutex;
+
 	};
 
 };
\ No newline at end of file
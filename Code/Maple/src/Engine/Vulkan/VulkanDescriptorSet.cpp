@@ -13,43 +13,35 @@
 #include "VulkanUniformBuffer.h"
 #include <array>
 
-#define MAX_BUFFER_INFOS 16
-#define MAX_IMAGE_INFOS 16
-#define MAX_WRITE_DESCTIPTORS 16
-
 namespace Maple
 {
 
 	/**
-	 * create the descriptor set
+	 * create the descriptor sets, one for each frame in flight
 	 */
 	VulkanDescriptorSet::VulkanDescriptorSet(const DescriptorInfo& info)
 	{
 
 		auto vkPipeline = static_cast<VulkanPipeline*>(info.pipeline);
+		frames = VulkanContext::get()->getFramesInFlight();
 
-		VkDescriptorSetAllocateInfo descriptorSetAllocateInfo;
-		descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		descriptorSetAllocateInfo.descriptorPool = vkPipeline->getDescriptorPool();
 		/**
 		 * the pipeline would contain different layout.
 		 */
-		descriptorSetAllocateInfo.pSetLayouts = vkPipeline->getDescriptorLayout(info.layoutIndex);
-		descriptorSetAllocateInfo.descriptorSetCount = info.count;
-		descriptorSetAllocateInfo.pNext = nullptr;
+		std::vector<VkDescriptorSetLayout> layouts(frames, *vkPipeline->getDescriptorLayout(info.layoutIndex));
 
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(*VulkanDevice::get(), &descriptorSetAllocateInfo, &descriptorSet));
+		VkDescriptorSetAllocateInfo descriptorSetAllocateInfo;
+		descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptorSetAllocateInfo.descriptorPool = vkPipeline->getDescriptorPool();
+		descriptorSetAllocateInfo.pSetLayouts = layouts.data();
+		descriptorSetAllocateInfo.descriptorSetCount = frames;
+		descriptorSetAllocateInfo.pNext = nullptr;
 
-		bufferInfoPool = new VkDescriptorBufferInfo[MAX_BUFFER_INFOS];
-		imageInfoPool = new VkDescriptorImageInfo[MAX_IMAGE_INFOS];
-		writeDescriptorSetPool = new VkWriteDescriptorSet[MAX_WRITE_DESCTIPTORS];
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(*VulkanDevice::get(), &descriptorSetAllocateInfo, descriptorSets));
 	}
 
 	VulkanDescriptorSet::~VulkanDescriptorSet()
 	{
-		delete[] bufferInfoPool;
-		delete[] imageInfoPool;
-		delete[] writeDescriptorSetPool;
 	}
 
 	auto VulkanDescriptorSet::update(const std::vector<ImageInfo>& imageInfos, const std::vector<BufferInfo>& bufferInfos) -> void
@@ -77,42 +69,39 @@ namespace Maple
 		return dynamicOffset;
 	}
 
+	auto VulkanDescriptorSet::getBinding(uint32_t binding) -> Binding&
+	{
+		for (auto& b : bindings)
+		{
+			if (b.binding == binding)
+				return b;
+		}
+		auto& b = bindings.emplace_back();
+		b.binding = binding;
+		return b;
+	}
+
 	auto VulkanDescriptorSet::updateInternal(const std::vector<ImageInfo>* imageInfos, const std::vector<BufferInfo>* bufferInfos) -> void
 	{
+		std::lock_guard<std::mutex> lock(mutex);
 		dynamic = false;
-		int32_t descriptorWritesCount = 0;
 
 		/**
 		 * update the images (texture sampler)
 		 */
 		if (imageInfos != nullptr)
 		{
-			int32_t imageIndex = 0;
-
 			for (auto& imageInfo : *imageInfos)
 			{
-				int32_t descriptorCount = 0;
-				for (auto i = 0; i < imageInfo.textures.size(); i++)
+				auto& binding = getBinding(imageInfo.binding);
+				binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				binding.buffer.reset();
+				binding.images.clear();
+				for (auto& texture : imageInfo.textures)
 				{
-					if (imageInfo.textures[i] != nullptr) {
-						VkDescriptorImageInfo& des = *static_cast<VkDescriptorImageInfo*>(imageInfo.textures[i]->getHandle());
-						imageInfoPool[i + imageIndex] = des;
-						descriptorCount++;
-					}
+					if (texture != nullptr)
+						binding.images.emplace_back(*static_cast<VkDescriptorImageInfo*>(texture->getHandle()));
 				}
-
-
-				VkWriteDescriptorSet writeDescriptorSet{};
-				writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				writeDescriptorSet.dstSet = descriptorSet;
-				writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				writeDescriptorSet.dstBinding = imageInfo.binding;
-				writeDescriptorSet.pImageInfo = &imageInfoPool[imageIndex];
-				writeDescriptorSet.descriptorCount = descriptorCount;
-
-				writeDescriptorSetPool[descriptorWritesCount] = writeDescriptorSet;
-				imageIndex++;
-				descriptorWritesCount++;
 			}
 		}
 		/**
@@ -120,32 +109,76 @@ namespace Maple
 		 */
 		if (bufferInfos != nullptr)
 		{
-			int index = 0;
-
 			for (auto& bufferInfo : *bufferInfos)
 			{
-				bufferInfoPool[index].buffer = std::static_pointer_cast<VulkanUniformBuffer>(bufferInfo.buffer)->getBuffer();
-				bufferInfoPool[index].offset = bufferInfo.offset;
-				bufferInfoPool[index].range = bufferInfo.size;
-
-				VkWriteDescriptorSet writeDescriptorSet{};
-				writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				writeDescriptorSet.dstSet = descriptorSet;
-				writeDescriptorSet.descriptorType = VkConverter::descriptorTypeToVK(bufferInfo.type);
-				writeDescriptorSet.dstBinding = bufferInfo.binding;
-				writeDescriptorSet.pBufferInfo = &bufferInfoPool[index];
-				writeDescriptorSet.descriptorCount = 1;
-
-				writeDescriptorSetPool[descriptorWritesCount] = writeDescriptorSet;
-				index++;
-				descriptorWritesCount++;
+				auto& binding = getBinding(bufferInfo.binding);
+				binding.type = VkConverter::descriptorTypeToVK(bufferInfo.type);
+				binding.images.clear();
+				binding.buffer = std::static_pointer_cast<VulkanUniformBuffer>(bufferInfo.buffer);
+				binding.offset = bufferInfo.offset;
+				binding.range = bufferInfo.size;
 
 				if (bufferInfo.type == DescriptorType::UNIFORM_BUFFER_DYNAMIC)
 					dynamic = true;
 			}
 		}
 
-		vkUpdateDescriptorSets(*VulkanDevice::get(), descriptorWritesCount,
-			writeDescriptorSetPool, 0, nullptr);
+		dirty = (1u << frames) - 1;
+	}
+
+	auto VulkanDescriptorSet::write(uint32_t frame) -> void
+	{
+		//reserved up front, the writes point into these arrays.
+		bufferInfoPool.clear();
+		bufferInfoPool.reserve(bindings.size());
+		writeDescriptorSetPool.clear();
+
+		for (auto& binding : bindings)
+		{
+			VkWriteDescriptorSet writeDescriptorSet{};
+			writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSet.dstSet = descriptorSets[frame];
+			writeDescriptorSet.descriptorType = binding.type;
+			writeDescriptorSet.dstBinding = binding.binding;
+
+			if (binding.buffer != nullptr)
+			{
+				auto& info = bufferInfoPool.emplace_back();
+				info.buffer = binding.buffer->getBuffer();
+				info.offset = binding.offset + binding.buffer->getStride() * frame;
+				info.range = binding.range;
+				writeDescriptorSet.pBufferInfo = &info;
+				writeDescriptorSet.descriptorCount = 1;
+			}
+			else
+			{
+				if (binding.images.empty())
+					continue;
+				writeDescriptorSet.pImageInfo = binding.images.data();
+				writeDescriptorSet.descriptorCount = static_cast<uint32_t>(binding.images.size());
+			}
+			writeDescriptorSetPool.emplace_back(writeDescriptorSet);
+		}
+
+		vkUpdateDescriptorSets(*VulkanDevice::get(), static_cast<uint32_t>(writeDescriptorSetPool.size()),
+			writeDescriptorSetPool.data(), 0, nullptr);
+	}
+
+	auto VulkanDescriptorSet::getCurrentSet() -> VkDescriptorSet
+	{
+		const auto frame = VulkanContext::get()->getCurrentFrame() % frames;
+		std::lock_guard<std::mutex> lock(mutex);
+		if (dirty & (1u << frame))
+		{
+			write(frame);
+			dirty &= ~(1u << frame);
+		}
+
+		for (auto& binding : bindings)
+		{
+			if (binding.buffer != nullptr)
+				binding.buffer->sync(frame);
+		}
+		return descriptorSets[frame];
 	}
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
 //////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "VulkanHelper.h"
+#include <mutex>
+#include "VulkanContext.h"
 #include "Engine/Renderer/RenderParam.h"
 #include "Engine/Interface/DescriptorSet.h"
 
@@ -11,7 +13,10 @@ namespace Maple
 {
 
 	class VulkanShader;
+	class VulkanUniformBuffer;
 
+	//One VkDescriptorSet per frame in flight. update() only records the bindings,
+	//the set of the current frame is written when it is bound, so a set is never changed while a frame in flight uses it.
 	class VulkanDescriptorSet final : public DescriptorSet
 	{
 	public:
@@ -28,19 +33,34 @@ namespace Maple
 
 		inline auto isDynamic()const { return dynamic; }
 
-		/*inline auto& getPushConstants() const { return pushConstants; }*/
-		inline auto getDescriptorSet() { return &descriptorSet; }
-
-		autoUnpack(descriptorSet);
+		//set of the current frame, written if it is out of date. the uniform buffers it references are synced as well.
+		//thread safe, renderers bind the same sets from several threads.
+		auto getCurrentSet() -> VkDescriptorSet;
 	private:
+		struct Binding
+		{
+			uint32_t binding = 0;
+			VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			std::vector<VkDescriptorImageInfo> images;
+			std::shared_ptr<VulkanUniformBuffer> buffer;
+			VkDeviceSize offset = 0;
+			VkDeviceSize range = 0;
+		};
+
 		auto updateInternal(const std::vector<ImageInfo>* imageInfos, const std::vector<BufferInfo>* bufferInfos) -> void;
+		auto getBinding(uint32_t binding) -> Binding&;
+		auto write(uint32_t frame) -> void;
 
-		VkDescriptorSet descriptorSet;
+		VkDescriptorSet descriptorSets[MAX_FRAMES_IN_FLIGHT] = {};
+		uint32_t frames = 1;
+		//one bit per frame
+		uint32_t dirty = 0;
+		std::mutex mutex;
 		uint32_t dynamicOffset = 0;
 		std::shared_ptr<VulkanShader> shader;
 		bool dynamic = false;
-		VkDescriptorBufferInfo* bufferInfoPool = nullptr;
-		VkDescriptorImageInfo* imageInfoPool = nullptr;
-		VkWriteDescriptorSet* writeDescriptorSetPool = nullptr;
+		std::vector<Binding> bindings;
+		std::vector<VkDescriptorBufferInfo> bufferInfoPool;
+		std::vector<VkWriteDescriptorSet> writeDescriptorSetPool;
 	};
-};
\ No newline at end of file
+};
@@ -4,14 +4,90 @@
 
 ////////////////////////////////////////////////////////////////////////////// 
 #include <stdexcept>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
 #include "VulkanDevice.h"
 #include "VulkanContext.h"
 #include "VulkanHelper.h"
 #include "VulkanCommandPool.h"
+#include "Others/Console.h"
 
 
 namespace Maple
 {
+	namespace
+	{
+		constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x4D504C43;//MPLC
+
+		//written in front of the cache data. vkGetPipelineCacheData only stores the vendor/device/uuid,
+		//the driver version is kept as well so a driver update starts from a clean cache.
+		struct PipelineCacheHeader
+		{
+			uint32_t magic = PIPELINE_CACHE_MAGIC;
+			uint32_t vendorID = 0;
+			uint32_t deviceID = 0;
+			uint32_t driverVersion = 0;
+			uint8_t uuid[VK_UUID_SIZE] = {};
+			uint64_t dataSize = 0;
+		};
+
+		inline auto makeCacheHeader(const VkPhysicalDeviceProperties& properties) -> PipelineCacheHeader
+		{
+			PipelineCacheHeader header;
+			header.vendorID = properties.vendorID;
+			header.deviceID = properties.deviceID;
+			header.driverVersion = properties.driverVersion;
+			std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+			return header;
+		}
+
+		inline auto readPipelineCache(const VkPhysicalDeviceProperties& properties) -> std::vector<uint8_t>
+		{
+			std::ifstream in(VulkanDevice::PIPELINE_CACHE_FILE, std::ios::binary);
+			if (!in)
+				return {};
+
+			PipelineCacheHeader header;
+			const auto expected = makeCacheHeader(properties);
+			if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+				header.magic != expected.magic ||
+				header.vendorID != expected.vendorID ||
+				header.deviceID != expected.deviceID ||
+				header.driverVersion != expected.driverVersion ||
+				std::memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0)
+			{
+				LOGW("Pipeline cache : {0} was created by another device or driver, ignored", VulkanDevice::PIPELINE_CACHE_FILE);
+				return {};
+			}
+
+			std::vector<uint8_t> data(header.dataSize);
+			if (!in.read(reinterpret_cast<char*>(data.data()), data.size()))
+			{
+				LOGW("Pipeline cache : {0} is truncated, ignored", VulkanDevice::PIPELINE_CACHE_FILE);
+				return {};
+			}
+
+			//the data begins with the VK_PIPELINE_CACHE_HEADER_VERSION_ONE header, the driver checks it again but a broken file should not reach it.
+			struct
+			{
+				uint32_t headerSize;
+				uint32_t headerVersion;
+				uint32_t vendorID;
+				uint32_t deviceID;
+				uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			} vkHeader{};
+			if (data.size() < sizeof(vkHeader))
+				return {};
+			std::memcpy(&vkHeader, data.data(), sizeof(vkHeader));
+			if (vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+				std::memcmp(vkHeader.pipelineCacheUUID, expected.uuid, VK_UUID_SIZE) != 0)
+				return {};
+
+			return data;
+		}
+	};
+
 	const std::vector<const char*> deviceExtensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 		VK_KHR_SHADER_NON_SEMANTIC_INFO_EXTENSION_NAME,
@@ -38,8 +114,14 @@ namespace Maple
 			queueCreateInfos.emplace_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(*physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures{};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		//used by shadow passes to pancake casters in front of the near plane
+		deviceFeatures.depthClamp = supportedFeatures.depthClamp;
+		enabledFeatures = deviceFeatures;
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -143,16 +225,63 @@ namespace Maple
 	VulkanDevice::~VulkanDevice()
 	{
 		commandPool.reset();
+		if (pipelineCache != VK_NULL_HANDLE)
+		{
+			savePipelineCache();
+			vkDestroyPipelineCache(device, pipelineCache, nullptr);
+		}
 		if (device != nullptr)
 			vkDestroyDevice(device, nullptr);
 	}
 
 	auto VulkanDevice::createPipelineCache() -> void
 	{
+		auto data = readPipelineCache(physicalDevice->getProperties());
+
 		VkPipelineCacheCreateInfo pipelineCacheCI{};
 		pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
 		pipelineCacheCI.pNext = NULL;
-		vkCreatePipelineCache(device, &pipelineCacheCI, VK_NULL_HANDLE, &pipelineCache);
+		pipelineCacheCI.initialDataSize = data.size();
+		pipelineCacheCI.pInitialData = data.empty() ? nullptr : data.data();
+
+		if (vkCreatePipelineCache(device, &pipelineCacheCI, VK_NULL_HANDLE, &pipelineCache) != VK_SUCCESS && !data.empty())
+		{
+			//the driver rejected the data, start with an empty cache.
+			pipelineCacheCI.initialDataSize = 0;
+			pipelineCacheCI.pInitialData = nullptr;
+			data.clear();
+			VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCI, VK_NULL_HANDLE, &pipelineCache));
+		}
+		loadedPipelineCacheSize = data.size();
+		LOGI("Pipeline cache : {0} bytes loaded from {1}", loadedPipelineCacheSize, PIPELINE_CACHE_FILE);
+	}
+
+	auto VulkanDevice::savePipelineCache() -> void
+	{
+		size_t size = 0;
+		if (pipelineCache == VK_NULL_HANDLE || vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+			return;
+
+		std::vector<uint8_t> data(size);
+		if (vkGetPipelineCacheData(device, pipelineCache, &size, data.data()) != VK_SUCCESS)
+			return;
+
+		auto header = makeCacheHeader(physicalDevice->getProperties());
+		header.dataSize = size;
+
+		//write to a temporary file first, a crash while saving must not leave a broken cache behind.
+		const std::string tmp = std::string(PIPELINE_CACHE_FILE) + ".tmp";
+		{
+			std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+			if (!out)
+				return;
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(data.data()), size);
+			if (!out)
+				return;
+		}
+		std::remove(PIPELINE_CACHE_FILE);
+		std::rename(tmp.c_str(), PIPELINE_CACHE_FILE);
 	}
 
 	std::shared_ptr<VulkanDevice> VulkanDevice::instance;
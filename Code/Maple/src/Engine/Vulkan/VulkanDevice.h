@@ -43,12 +43,19 @@ namespace Maple
 		inline auto getPresentQueue() { return presentQueue; }
 		inline auto getCommandPool() { return commandPool; }
 		inline auto getPipelineCache() const { return pipelineCache; }
+		inline auto& getEnabledFeatures() const { return enabledFeatures; }
 
 		static auto get()->std::shared_ptr<VulkanDevice>;
 
 		inline operator auto() const { return device; }
 		static auto release() -> void;
+		//loads the cache from PIPELINE_CACHE_FILE if it was written by the same device and driver.
 		auto createPipelineCache() -> void;
+		auto savePipelineCache() -> void;
+		//size of the cache data loaded from disk, 0 for a cold start.
+		inline auto getLoadedPipelineCacheSize() const { return loadedPipelineCacheSize; }
+
+		static constexpr const char* PIPELINE_CACHE_FILE = "pipeline.cache";
 	private:
 		std::shared_ptr<VulkanPhysicalDevice> physicalDevice;
 		VkDevice device = nullptr;
@@ -58,6 +65,8 @@ namespace Maple
 		static std::shared_ptr<VulkanDevice> instance;
 
 
-		VkPipelineCache pipelineCache;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+		size_t loadedPipelineCacheSize = 0;
+		VkPhysicalDeviceFeatures enabledFeatures{};
 	};
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#include "VulkanFence.h"
+#include "VulkanDevice.h"
+#include "Others/Console.h"
+
+namespace Maple
+{
+	VulkanFence::VulkanFence(bool signaled)
+		:signaled(signaled)
+	{
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0;
+		VK_CHECK_RESULT(vkCreateFence(*VulkanDevice::get(), &fenceInfo, nullptr, &fence));
+	}
+
+	VulkanFence::~VulkanFence()
+	{
+		vkDestroyFence(*VulkanDevice::get(), fence, nullptr);
+	}
+
+	auto VulkanFence::isSignaled() -> bool
+	{
+		if (!signaled)
+			signaled = vkGetFenceStatus(*VulkanDevice::get(), fence) == VK_SUCCESS;
+		return signaled;
+	}
+
+	auto VulkanFence::wait(uint64_t timeout) -> bool
+	{
+		if (!signaled)
+			signaled = vkWaitForFences(*VulkanDevice::get(), 1, &fence, VK_TRUE, timeout) == VK_SUCCESS;
+		return signaled;
+	}
+
+	auto VulkanFence::reset() -> void
+	{
+		if (signaled)
+			VK_CHECK_RESULT(vkResetFences(*VulkanDevice::get(), 1, &fence));
+		signaled = false;
+	}
+};
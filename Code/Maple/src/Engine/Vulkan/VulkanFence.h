@@ -0,0 +1,24 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "VulkanHelper.h"
+namespace Maple
+{
+	class VulkanFence
+	{
+	public:
+		VulkanFence(bool signaled = false);
+		~VulkanFence();
+
+		auto isSignaled() -> bool;
+		auto wait(uint64_t timeout = UINT64_MAX) -> bool;
+		auto reset() -> void;
+		autoUnpack(fence);
+	private:
+		VkFence fence = VK_NULL_HANDLE;
+		bool signaled = false;
+	};
+};
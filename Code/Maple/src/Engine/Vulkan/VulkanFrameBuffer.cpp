@@ -8,6 +8,7 @@
 #include "VulkanRenderPass.h"
 #include "VulkanFrameBuffer.h"
 #include "VulkanDevice.h"
+#include "VulkanContext.h"
 #include "VulkanTexture.h"
 #include "Others/Console.h"
 
@@ -53,7 +54,9 @@ namespace Maple
 
 	VulkanFrameBuffer::~VulkanFrameBuffer()
 	{
-		vkDestroyFramebuffer(*VulkanDevice::get(), buffer, VK_NULL_HANDLE);
+		VulkanContext::get()->deferRelease([buffer = buffer]() {
+			vkDestroyFramebuffer(*VulkanDevice::get(), buffer, VK_NULL_HANDLE);
+		});
 	}
 
 };
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "Others/Console.h"
 #include "VulkanDevice.h"
 #include "VulkanCommandPool.h"
+#include "VulkanUploadQueue.h"
+#include "VulkanAllocator.h"
 #include "Application.h"
 #include "Engine/Vertex.h"
 
@@ -184,7 +186,7 @@ namespace Maple
 		return indices;
 	}
 
-	auto VulkanHelper::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageType imageType, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t arrayLayers, VkImageCreateFlags flags) -> uint64_t
+	auto VulkanHelper::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageType imageType, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VulkanAllocation& imageMemory, uint32_t arrayLayers, VkImageCreateFlags flags) -> uint64_t
 	{
 		VkImageCreateInfo imageInfo = {};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -206,21 +208,8 @@ namespace Maple
 			throw std::runtime_error("failed to create image!");
 		}
 
-		vkCreateImage(*VulkanDevice::get(), &imageInfo, nullptr, &image);
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(*VulkanDevice::get(), image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		VK_CHECK_RESULT(vkAllocateMemory(*VulkanDevice::get(), &allocInfo, nullptr, &imageMemory));
-		VK_CHECK_RESULT(vkBindImageMemory(*VulkanDevice::get(), image, imageMemory, 0));
-
-
-		return memRequirements.size;
+		imageMemory = VulkanAllocator::get()->allocateImage(image, properties);
+		return imageMemory.size;
 	}
 
 	auto VulkanHelper::createImageView(VkImage image, VkFormat format, uint32_t mipLevels, VkImageViewType viewType, VkImageAspectFlags aspectMask, uint32_t layerCount, uint32_t baseArrayLayer) -> VkImageView
@@ -244,7 +233,7 @@ namespace Maple
 		return imageView;
 	}
 
-	auto VulkanHelper::createBuffer(VkBuffer& buffer, VkDeviceMemory& bufferMemory, VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBufferCreateFlags flags /*= 0*/, VkSharingMode sharingMode /*= VK_SHARING_MODE_EXCLUSIVE*/, const std::vector<uint32_t>& queueFamilyIndices /*= {}*/) -> void
+	auto VulkanHelper::createBuffer(VkBuffer& buffer, VulkanAllocation& bufferMemory, VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBufferCreateFlags flags /*= 0*/, VkSharingMode sharingMode /*= VK_SHARING_MODE_EXCLUSIVE*/, const std::vector<uint32_t>& queueFamilyIndices /*= {}*/) -> void
 	{
 		VkBufferCreateInfo bufferInfo = {};
 		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -260,20 +249,7 @@ namespace Maple
 			throw std::runtime_error("failed to create buffer!");
 		}
 
-		VkMemoryRequirements memRequirements;
-		vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to allocate buffer memory!");
-		}
-
-		vkBindBufferMemory(device, buffer, bufferMemory, 0);
+		bufferMemory = VulkanAllocator::get()->allocateBuffer(buffer, properties);
 	}
 
 	auto VulkanHelper::physicalDeviceTypeString(VkPhysicalDeviceType type) ->std::string
@@ -538,38 +514,13 @@ namespace Maple
 
 
 	auto VulkanHelper::beginSingleTimeCommands() -> VkCommandBuffer {
-
-
-		VkCommandBufferAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = *VulkanDevice::get()->getCommandPool();
-		allocInfo.commandBufferCount = 1;
-
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(*VulkanDevice::get(), &allocInfo, &commandBuffer);
-
-		VkCommandBufferBeginInfo beginInfo{};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-		return commandBuffer;
+		//recorded into the upload batch, which is submitted before the next command buffer.
+		//resources used by the commands are only destroyed after the frame (see VulkanContext::deferRelease),
+		//so nothing has to wait for the GPU here.
+		return VulkanUploadQueue::get()->getCommandBuffer();
 	}
 
 	auto VulkanHelper::endSingleTimeCommands(VkCommandBuffer commandBuffer) -> void {
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		vkQueueSubmit(VulkanDevice::get()->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(VulkanDevice::get()->getGraphicsQueue());
-
-		vkFreeCommandBuffers(*VulkanDevice::get(), *VulkanDevice::get()->getCommandPool(), 1, &commandBuffer);
 	}
 
 	auto VulkanHelper::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, int32_t offsetX , int32_t offsetY) -> void
@@ -954,6 +905,7 @@ namespace Maple
 			case DescriptorType::UNIFORM_BUFFER: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 			case DescriptorType::UNIFORM_BUFFER_DYNAMIC: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			case DescriptorType::IMAGE_SAMPLER: return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			case DescriptorType::STORAGE_BUFFER: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 			}
 
 			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
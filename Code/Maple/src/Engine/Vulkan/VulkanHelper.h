@@ -31,6 +31,7 @@ namespace Maple
 
 	class VulkanDevice;
 	class VulkanBuffer;
+	struct VulkanAllocation;
 	class VulkanImage;
 	class VulkanImageView;
 	class VulkanInstance;
@@ -68,11 +69,11 @@ namespace Maple
 
 
 		auto createImage(
-			uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageType imageType, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t arrayLayers, VkImageCreateFlags flags) ->uint64_t;
+			uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format, VkImageType imageType, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VulkanAllocation& imageMemory, uint32_t arrayLayers, VkImageCreateFlags flags) ->uint64_t;
 
 		auto createImageView(VkImage image, VkFormat format, uint32_t mipLevels, VkImageViewType viewType, VkImageAspectFlags aspectMask, uint32_t layerCount, uint32_t baseArrayLayer = 0)->VkImageView;
 
-		auto createBuffer(VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+		auto createBuffer(VkBuffer& buffer, VulkanAllocation& bufferMemory,
 			VkPhysicalDevice physicalDevice, VkDevice device,
 			VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBufferCreateFlags flags = 0,
 			VkSharingMode sharingMode = VK_SHARING_MODE_EXCLUSIVE, const std::vector<uint32_t>& queueFamilyIndices = {}) -> void;
@@ -13,12 +13,51 @@
 #include "VulkanShader.h"
 
 #include "Engine/Vertex.h"
+#include "Engine/Profiler.h"
 #include "Others/Console.h"
+#include "Application.h"
 
 #include <memory>
 
 namespace Maple
 {
+	namespace
+	{
+		std::atomic<int32_t> compiling{ 0 };
+
+		//everything VkGraphicsPipelineCreateInfo points to.
+		struct PipelineState
+		{
+			PipelineInfo info;
+			std::vector<VkDynamicState> dynamicStateDescriptors;
+			std::vector<VkPipelineColorBlendAttachmentState> blendAttachState;
+
+			VkPipelineVertexInputStateCreateInfo vi{};
+			VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+			VkPipelineDynamicStateCreateInfo dynamicStateCI{};
+			VkPipelineViewportStateCreateInfo vp{};
+			VkPipelineDepthStencilStateCreateInfo ds{};
+			VkPipelineMultisampleStateCreateInfo ms{};
+			VkPipelineRasterizationStateCreateInfo rs{};
+			VkPipelineColorBlendStateCreateInfo cb{};
+			VkGraphicsPipelineCreateInfo pipelineInfo{};
+		};
+
+		inline auto getThreadPool() -> ThreadPool*
+		{
+			auto app = Application::get();
+			return app != nullptr ? app->getThreadPool().get() : nullptr;
+		}
+
+		//run other jobs while waiting, the job we are waiting for may still be queued.
+		inline auto helpOrYield() -> void
+		{
+			auto pool = getThreadPool();
+			if (pool == nullptr || !pool->helpOne())
+				std::this_thread::yield();
+		}
+	};
+
 	VulkanPipeline::VulkanPipeline(const PipelineInfo& info)
 	{
 		init(info);
@@ -34,13 +73,18 @@ namespace Maple
 	 */
 	auto VulkanPipeline::unload() const -> void
 	{
-		vkDestroyDescriptorPool(*VulkanDevice::get(), descriptorPool, nullptr);
-		vkDestroyPipelineLayout(*VulkanDevice::get(), pipeLayout, nullptr);
-		for (auto a : descriptorSetLayouts)
-		{
-			vkDestroyDescriptorSetLayout(*VulkanDevice::get(),a, nullptr);
-		}
-		vkDestroyPipeline(*VulkanDevice::get(), graphicsPipeline, nullptr);
+		waitCompiled();
+		//frames in flight may still use the pipeline and its descriptor sets
+		VulkanContext::get()->deferRelease([descriptorPool = descriptorPool, pipeLayout = pipeLayout,
+			layouts = descriptorSetLayouts, pipeline = graphicsPipeline]() {
+			vkDestroyDescriptorPool(*VulkanDevice::get(), descriptorPool, nullptr);
+			vkDestroyPipelineLayout(*VulkanDevice::get(), pipeLayout, nullptr);
+			for (auto a : layouts)
+			{
+				vkDestroyDescriptorSetLayout(*VulkanDevice::get(), a, nullptr);
+			}
+			vkDestroyPipeline(*VulkanDevice::get(), pipeline, nullptr);
+		});
 	}
 
 
@@ -53,57 +97,47 @@ namespace Maple
 		createDescriptorSet();
 	
 
-		std::vector<VkDynamicState> dynamicStateDescriptors;
-		std::vector<VkPipelineColorBlendAttachmentState> blendAttachState;
-
+		auto state = std::make_shared<PipelineState>();
+		state->info = info;
 
-		VkPipelineVertexInputStateCreateInfo vi{};
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-		VkPipelineDynamicStateCreateInfo dynamicStateCI{};
-		VkPipelineViewportStateCreateInfo vp{};
-		VkPipelineDepthStencilStateCreateInfo ds{};
-		VkPipelineMultisampleStateCreateInfo ms{};
-		VkPipelineRasterizationStateCreateInfo rs{};
-		VkPipelineColorBlendStateCreateInfo cb{};
-		
-		
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VkConverter::drawTypeToTopology(info.drawType);
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
+		state->inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		state->inputAssembly.topology = VkConverter::drawTypeToTopology(info.drawType);
+		state->inputAssembly.primitiveRestartEnable = VK_FALSE;
 
 
-		createVertexLayout(vi);
-		createRasterization(rs, info);
-		createColorBlend(cb, blendAttachState, info);
-		createViewport(vp, dynamicStateDescriptors);
+		createVertexLayout(state->vi);
+		createRasterization(state->rs, info);
+		createColorBlend(state->cb, state->blendAttachState, info);
+		createViewport(state->vp, state->dynamicStateDescriptors);
 		if (info.depthBiasEnabled)
-			dynamicStateDescriptors.emplace_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
-		createDepthStencil(ds);
-		createMultisample(ms);
+			state->dynamicStateDescriptors.emplace_back(VK_DYNAMIC_STATE_DEPTH_BIAS);
+		createDepthStencil(state->ds);
+		createMultisample(state->ms);
 
 
+		auto& dynamicStateCI = state->dynamicStateCI;
 		dynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 		dynamicStateCI.pNext = NULL;
-		dynamicStateCI.dynamicStateCount = uint32_t(dynamicStateDescriptors.size());
-		dynamicStateCI.pDynamicStates = dynamicStateDescriptors.data();
+		dynamicStateCI.dynamicStateCount = uint32_t(state->dynamicStateDescriptors.size());
+		dynamicStateCI.pDynamicStates = state->dynamicStateDescriptors.data();
 
 
-		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		auto& pipelineInfo = state->pipelineInfo;
 
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineInfo.pNext = NULL;
 		pipelineInfo.layout = pipeLayout;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineInfo.basePipelineIndex = -1;
-		pipelineInfo.pVertexInputState = &vi;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pRasterizationState = &rs;
-		pipelineInfo.pColorBlendState = &cb;
+		pipelineInfo.pVertexInputState = &state->vi;
+		pipelineInfo.pInputAssemblyState = &state->inputAssembly;
+		pipelineInfo.pRasterizationState = &state->rs;
+		pipelineInfo.pColorBlendState = &state->cb;
 		pipelineInfo.pTessellationState = VK_NULL_HANDLE;
-		pipelineInfo.pMultisampleState = &ms;
+		pipelineInfo.pMultisampleState = &state->ms;
 		pipelineInfo.pDynamicState = &dynamicStateCI;
-		pipelineInfo.pViewportState = &vp;
-		pipelineInfo.pDepthStencilState = &ds;
+		pipelineInfo.pViewportState = &state->vp;
+		pipelineInfo.pDepthStencilState = &state->ds;
 		auto vkShader = std::static_pointer_cast<VulkanShader>(shader);
 
 		pipelineInfo.pStages =		vkShader->getStageInfos().data();
@@ -112,12 +146,52 @@ namespace Maple
 		pipelineInfo.renderPass = *std::static_pointer_cast<VulkanRenderPass>(info.renderPass);
 		pipelineInfo.subpass = 0;
 
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(*VulkanDevice::get(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline));
+		compiled = std::make_shared<std::atomic<bool>>(false);
+		compiling.fetch_add(1);
+
+		auto pool = getThreadPool();
+		if (pool == nullptr)
+		{
+			compile(pipelineInfo);
+			return true;
+		}
+
+		//the state is captured so the create info stays valid, the destructor waits so this does too.
+		pool->addTask([this, state]() -> void* {
+			compile(state->pipelineInfo);
+			return nullptr;
+		});
 
 		return true;
 	}
 
 
+	auto VulkanPipeline::compile(const VkGraphicsPipelineCreateInfo& pipelineInfo) -> void
+	{
+		PROFILE_FUNCTION();
+		auto device = VulkanDevice::get();
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(*device, device->getPipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline));
+		compiled->store(true, std::memory_order_release);
+		compiling.fetch_sub(1, std::memory_order_release);
+	}
+
+	auto VulkanPipeline::waitCompiled() const -> void
+	{
+		while (compiled != nullptr && !compiled->load(std::memory_order_acquire))
+		{
+			helpOrYield();
+		}
+	}
+
+	auto VulkanPipeline::waitAllCompiled() -> void
+	{
+		PROFILE_FUNCTION();
+		while (compiling.load(std::memory_order_acquire) > 0)
+		{
+			helpOrYield();
+		}
+	}
+
 	auto VulkanPipeline::createDepthStencil(VkPipelineDepthStencilStateCreateInfo& ds) -> void
 	{
 		ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
@@ -154,15 +228,13 @@ namespace Maple
 	auto VulkanPipeline::createVertexLayout(VkPipelineVertexInputStateCreateInfo& vi) -> void
 	{
 		auto vkShader = std::static_pointer_cast<VulkanShader>(shader);
-		vertexBindingDescription.binding = 0;
-		vertexBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		vertexBindingDescription.stride = vkShader->getVertexInputStride();
+		auto & vertexBindingDescriptions = vkShader->getVertexInputBindingDescriptions();
 		auto & vertexInputAttributeDescription = vkShader->getVertexInputAttributeDescription();
 
 		vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vi.pNext = NULL;
-		vi.vertexBindingDescriptionCount = 1;
-		vi.pVertexBindingDescriptions = &vertexBindingDescription;
+		vi.vertexBindingDescriptionCount = uint32_t(vertexBindingDescriptions.size());
+		vi.pVertexBindingDescriptions = vertexBindingDescriptions.data();
 		vi.vertexAttributeDescriptionCount = uint32_t(vertexInputAttributeDescription.size());
 		vi.pVertexAttributeDescriptions = vertexInputAttributeDescription.data();
 
@@ -179,7 +251,7 @@ namespace Maple
 		//http://anki3d.org/vulkan-coordinate-system/
 		rs.frontFace = VK_FRONT_FACE_CLOCKWISE;
 
-		rs.depthClampEnable = VK_FALSE;
+		rs.depthClampEnable = (info.depthClampEnabled && VulkanDevice::get()->getEnabledFeatures().depthClamp) ? VK_TRUE : VK_FALSE;
 		rs.rasterizerDiscardEnable = VK_FALSE;
 		rs.depthBiasEnable = (info.depthBiasEnabled ? VK_TRUE : VK_FALSE);
 		rs.depthBiasConstantFactor = 0;
@@ -304,21 +376,23 @@ namespace Maple
 
 	auto VulkanPipeline::createDescriptorPool() -> void
 	{
-		constexpr std::array<VkDescriptorPoolSize, 6> poolSizes =
+		constexpr std::array<VkDescriptorPoolSize, 7> poolSizes =
 		{
-			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLER,                   200 },
-			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,    200 },
-			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,             200 },
-			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,             200 },
-			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,            200 },
-			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,    200 }
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLER,                   200 * MAX_FRAMES_IN_FLIGHT },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,    200 * MAX_FRAMES_IN_FLIGHT },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,             200 * MAX_FRAMES_IN_FLIGHT },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,             200 * MAX_FRAMES_IN_FLIGHT },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,            200 * MAX_FRAMES_IN_FLIGHT },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,    200 * MAX_FRAMES_IN_FLIGHT },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,            200 * MAX_FRAMES_IN_FLIGHT }
 		};
 		VkDescriptorPoolCreateInfo poolInfo = {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 		poolInfo.flags = 0;
 		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = MAX_DESCRIPTOR_SET;
+		//every descriptor set holds one VkDescriptorSet per frame in flight
+		poolInfo.maxSets = MAX_DESCRIPTOR_SET * MAX_FRAMES_IN_FLIGHT;
 		VK_CHECK_RESULT(vkCreateDescriptorPool(*VulkanDevice::get(), &poolInfo, nullptr, &descriptorPool));
 	}
 
@@ -334,6 +408,6 @@ namespace Maple
 
 	auto VulkanPipeline::bind(CommandBuffer* buffer) -> void
 	{
-		vkCmdBindPipeline(*static_cast<VulkanCommandBuffer*>(buffer), VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		vkCmdBindPipeline(*static_cast<VulkanCommandBuffer*>(buffer), VK_PIPELINE_BIND_POINT_GRAPHICS, getGraphicsPipeline());
 	}
 };
\ No newline at end of file
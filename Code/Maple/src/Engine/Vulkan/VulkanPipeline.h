@@ -9,6 +9,7 @@
 #include "VulkanHelper.h"
 #include <memory>
 #include <functional>
+#include <atomic>
 
 namespace Maple
 {
@@ -39,7 +40,11 @@ namespace Maple
 		inline const auto& getDescriptorPool() const { return descriptorPool; };
 		inline auto& getDescriptorPool() { return descriptorPool; };
 
-		inline const auto& getGraphicsPipeline() const { return graphicsPipeline; };
+		//blocks until the pipeline has been compiled.
+		inline const auto& getGraphicsPipeline() const { waitCompiled(); return graphicsPipeline; };
+		auto waitCompiled() const -> void;
+		//blocks until all the pipelines created so far have been compiled.
+		static auto waitAllCompiled() -> void;
 
 		inline const auto getDescriptorLayout(uint32_t layoutIndex) const {
 			return &descriptorSetLayouts[layoutIndex];
@@ -62,6 +67,10 @@ namespace Maple
 		auto createPipelineLayout() -> void;
 		auto createDescriptorPool() -> void;
 		auto createDescriptorSet() -> void;
+		auto compile(const VkGraphicsPipelineCreateInfo& pipelineInfo) -> void;
+
+		//vkCreateGraphicsPipelines runs on a worker thread, the create info is kept alive until it finishes.
+		std::shared_ptr<std::atomic<bool>> compiled;
 
 		VkPipelineLayout pipeLayout = nullptr;
 		VkPipeline graphicsPipeline = nullptr;
@@ -70,6 +79,5 @@ namespace Maple
 		std::shared_ptr<Shader> shader;
 		std::shared_ptr<DescriptorSet> descriptorSet;
 		std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
-		VkVertexInputBindingDescription vertexBindingDescription;
 	};
 };
\ No newline at end of file
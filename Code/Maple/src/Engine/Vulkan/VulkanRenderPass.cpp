@@ -191,7 +191,6 @@ namespace Maple
 	{
 		if (beginCommandBuffer)
 			commandBuffer->beginRecording();
-		commandBuffer->updateViewport(width, height);
 
 		//clear color
 		if (!depthOnly)
@@ -222,12 +221,14 @@ namespace Maple
 		rpBegin.clearValueCount = uint32_t(clearCount);
 		rpBegin.pClearValues = clearValue;
 
-		vkCmdBeginRenderPass(*static_cast<VulkanCommandBuffer*>(commandBuffer), &rpBegin, subPassContentsToVK(contents));
+		static_cast<VulkanCommandBuffer*>(commandBuffer)->beginRenderPass(rpBegin, subPassContentsToVK(contents));
+		//after the begin, a recorder has switched to the secondary command buffer of the pass by now.
+		commandBuffer->updateViewport(width, height);
 	}
 
 	auto VulkanRenderPass::endRenderpass(CommandBuffer* commandBuffer, bool endCommandBuffer /*= true*/) -> void
 	{
-		vkCmdEndRenderPass(*static_cast<VulkanCommandBuffer*>(commandBuffer));
+		static_cast<VulkanCommandBuffer*>(commandBuffer)->endRenderPass();
 		if (endCommandBuffer)
 			commandBuffer->endRecording();
 	}
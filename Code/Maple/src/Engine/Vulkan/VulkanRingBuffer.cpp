@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#include "VulkanRingBuffer.h"
+#include "VulkanDevice.h"
+#include "VulkanHelper.h"
+#include "Others/Console.h"
+#include "Engine/Profiler.h"
+
+namespace Maple
+{
+	std::shared_ptr<VulkanRingBuffer> VulkanRingBuffer::instance;
+
+	VulkanRingBuffer::VulkanRingBuffer(VkBufferUsageFlags usage, VkDeviceSize frameSize, uint32_t frames)
+		:frameSize(frameSize), frames(frames)
+	{
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = frameSize * frames;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VK_CHECK_RESULT(vkCreateBuffer(*VulkanDevice::get(), &bufferInfo, nullptr, &buffer));
+		allocation = VulkanAllocator::get()->allocateBuffer(buffer, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	}
+
+	VulkanRingBuffer::~VulkanRingBuffer()
+	{
+		vkDestroyBuffer(*VulkanDevice::get(), buffer, nullptr);
+		VulkanAllocator::get()->free(allocation);
+	}
+
+	auto VulkanRingBuffer::get() -> std::shared_ptr<VulkanRingBuffer>
+	{
+		if (instance == nullptr)
+		{
+			instance = std::make_shared<VulkanRingBuffer>(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		}
+		return instance;
+	}
+
+	auto VulkanRingBuffer::release() -> void
+	{
+		instance.reset();
+	}
+
+	auto VulkanRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment) -> Span
+	{
+		VkDeviceSize current = head.load(std::memory_order_relaxed);
+		VkDeviceSize offset;
+		do
+		{
+			offset = (current + alignment - 1) / alignment * alignment;
+			if (offset + size > frameSize)
+				return {};
+		} while (!head.compare_exchange_weak(current, offset + size, std::memory_order_relaxed));
+
+		const VkDeviceSize base = frame * frameSize + offset;
+		return { buffer, base, static_cast<uint8_t*>(allocation.mapped) + base };
+	}
+
+	auto VulkanRingBuffer::nextFrame() -> void
+	{
+		PROFILE_PLOT("Ring Buffer Bytes", static_cast<int64_t>(getUsed()));
+		frame = (frame + 1) % frames;
+		frameIndex++;
+		head.store(0, std::memory_order_relaxed);
+	}
+};
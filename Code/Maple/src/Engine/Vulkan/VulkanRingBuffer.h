@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "VulkanAllocator.h"
+#include "VulkanContext.h"
+#include <atomic>
+
+namespace Maple
+{
+	//Persistently mapped host visible buffer split into one segment per frame.
+	//Data written into a segment must be consumed by the frame which allocated it.
+	class VulkanRingBuffer final
+	{
+	public:
+		static constexpr uint32_t FRAME_COUNT = 3;
+		static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 16 * 1024 * 1024;
+		//a segment is reused FRAME_COUNT frames later, the frame which wrote it must have finished by then.
+		static_assert(FRAME_COUNT >= MAX_FRAMES_IN_FLIGHT, "ring buffer segments are shared by the frames in flight");
+
+		struct Span
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			void* data = nullptr;
+			inline operator bool() const { return data != nullptr; }
+		};
+
+		VulkanRingBuffer(VkBufferUsageFlags usage, VkDeviceSize frameSize = DEFAULT_FRAME_SIZE, uint32_t frames = FRAME_COUNT);
+		~VulkanRingBuffer();
+
+		//an empty span when the segment of the current frame is full, callers fall back to their own buffer.
+		//lock free, renderers allocate from several threads.
+		auto allocate(VkDeviceSize size, VkDeviceSize alignment = 16) -> Span;
+		//called at the beginning of the frame, the oldest segment is reused.
+		auto nextFrame() -> void;
+
+		inline auto getFrame() const { return frame; }
+		//increases every frame, used to tell whether a span is still valid.
+		inline auto getFrameIndex() const { return frameIndex; }
+		inline auto getUsed() const { return head.load(std::memory_order_relaxed); }
+		inline auto getFrameSize() const { return frameSize; }
+
+		static auto get() -> std::shared_ptr<VulkanRingBuffer>;
+		static auto release() -> void;
+
+	private:
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VulkanAllocation allocation;
+		VkDeviceSize frameSize;
+		uint32_t frames;
+		uint32_t frame = 0;
+		uint64_t frameIndex = 0;
+		std::atomic<VkDeviceSize> head{ 0 };
+
+		static std::shared_ptr<VulkanRingBuffer> instance;
+	};
+};
@@ -9,6 +9,8 @@
 #include "FileSystem/File.h"
 #include "Others/StringUtils.h"
 #include "Others/Console.h"
+#include "Engine/VertexFormat.h"
+#include <algorithm>
 #include <spirv_cross.hpp>
 
 namespace Maple
@@ -34,6 +36,8 @@ namespace Maple
 			return sizeof(glm::ivec3);
 		case VK_FORMAT_R32G32B32A32_SINT:
 			return sizeof(glm::ivec4);
+		case VK_FORMAT_R32_UINT:
+			return sizeof(uint32_t);
 		case VK_FORMAT_R32G32_UINT:
 			return sizeof(glm::ivec2);
 		case VK_FORMAT_R32G32B32_UINT:
@@ -216,16 +220,86 @@ namespace Maple
 
 		if (shaderType == VERTEX_SHADER)
 		{
-			vertexInputStride = 0;
+			vertexInputBindingDescriptions.clear();
+			vertexInputAttributeDescriptions.clear();
+			vertexStreams = 0;
+			interleavedMesh = false;
+
+			//inputs named after the mesh attributes read the vertex streams of the mesh, see VertexFormat.
+			//if their types do not match the packed formats (e.g. vec3 normals), the shader reads the interleaved Vertex.
+			bool meshLayout = !resources.stage_inputs.empty();
+			bool packedTypes = true;
 			for (const auto & resource : resources.stage_inputs)
 			{
+				const auto attribute = VertexFormat::getAttribute(resource.name);
+				if (attribute == VertexFormat::AttributeCount)
+				{
+					meshLayout = false;
+					continue;
+				}
 				auto & inputType = comp.get_type(resource.type_id);
-				VkVertexInputAttributeDescription & description = vertexInputAttributeDescriptions.emplace_back();
-				description.binding = comp.get_decoration(resource.id, spv::DecorationBinding);
-				description.location = comp.get_decoration(resource.id, spv::DecorationLocation);
-				description.offset = vertexInputStride;
-				description.format = getVulkanFormat(inputType);
-				vertexInputStride += getStrideFromVulkanFormat(description.format);
+				if (inputType.basetype != spirv_cross::SPIRType::Float || inputType.columns != 1 || inputType.vecsize != VertexFormat::getComponentCount(attribute))
+					packedTypes = false;
+			}
+
+			if (meshLayout && !packedTypes)
+			{
+				LOGW("{0} : the vertex inputs do not match VertexFormat, using the interleaved Vertex layout", path);
+				VertexFormat::setInterleavedUsed();
+				interleavedMesh = true;
+				for (const auto & resource : resources.stage_inputs)
+				{
+					VkVertexInputAttributeDescription & description = vertexInputAttributeDescriptions.emplace_back();
+					description.binding = 0;
+					description.location = comp.get_decoration(resource.id, spv::DecorationLocation);
+					description.offset = VertexFormat::getInterleavedOffset(VertexFormat::getAttribute(resource.name));
+					description.format = getVulkanFormat(comp.get_type(resource.type_id));
+				}
+				vertexStreams = 1;
+				vertexInputBindingDescriptions.push_back({ 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX });
+			}
+			else if (meshLayout)
+			{
+				for (const auto & resource : resources.stage_inputs)
+				{
+					const auto location = comp.get_decoration(resource.id, spv::DecorationLocation);
+					auto & description = vertexInputAttributeDescriptions.emplace_back(VertexFormat::getAttributeDescription(VertexFormat::getAttribute(resource.name), location));
+					vertexStreams |= 1u << description.binding;
+				}
+
+				for (uint32_t stream = 0; stream < VertexFormat::StreamCount; stream++)
+				{
+					if (vertexStreams & (1u << stream))
+						vertexInputBindingDescriptions.push_back({ stream, VertexFormat::getStride(static_cast<VertexFormat::Stream>(stream)), VK_VERTEX_INPUT_RATE_VERTEX });
+				}
+			}
+			else
+			{
+				//one interleaved binding, the members follow the locations.
+				//inputs named inst* are interleaved in binding 1 and advance per instance.
+				std::vector<spirv_cross::Resource> inputs(resources.stage_inputs.begin(), resources.stage_inputs.end());
+				std::sort(inputs.begin(), inputs.end(), [&](const auto& a, const auto& b) {
+					return comp.get_decoration(a.id, spv::DecorationLocation) < comp.get_decoration(b.id, spv::DecorationLocation);
+				});
+
+				uint32_t strides[2] = { 0, 0 };
+				for (const auto & resource : inputs)
+				{
+					auto & inputType = comp.get_type(resource.type_id);
+					const uint32_t binding = StringUtils::startWith(resource.name, "inst") ? 1 : 0;
+					VkVertexInputAttributeDescription & description = vertexInputAttributeDescriptions.emplace_back();
+					description.binding = binding;
+					description.location = comp.get_decoration(resource.id, spv::DecorationLocation);
+					description.offset = strides[binding];
+					description.format = getVulkanFormat(inputType);
+					strides[binding] += getStrideFromVulkanFormat(description.format);
+					vertexStreams |= 1u << binding;
+				}
+
+				if (vertexStreams & 1)
+					vertexInputBindingDescriptions.push_back({ 0, strides[0], VK_VERTEX_INPUT_RATE_VERTEX });
+				if (vertexStreams & 2)
+					vertexInputBindingDescriptions.push_back({ 1, strides[1], VK_VERTEX_INPUT_RATE_INSTANCE });
 			}
 		}
 
@@ -247,6 +321,7 @@ namespace Maple
 
 		addLayout(resources.uniform_buffers, DescriptorType::UNIFORM_BUFFER);
 		addLayout(resources.sampled_images, DescriptorType::IMAGE_SAMPLER);
+		addLayout(resources.storage_buffers, DescriptorType::STORAGE_BUFFER);
 
 		for (auto& buffer : resources.push_constant_buffers)
 		{
@@ -19,8 +19,12 @@ namespace Maple
 		~VulkanShader();
 		inline auto& getStageInfos() const { return stageInfos; }
         inline auto& getDescriptorLayoutInfo() const { return descriptorLayoutInfo; }
-		inline auto getVertexInputStride() const { return vertexInputStride; }
+		inline auto& getVertexInputBindingDescriptions() const { return vertexInputBindingDescriptions; }
 		inline auto& getVertexInputAttributeDescription() const { return vertexInputAttributeDescriptions; };
+		//one bit per binding the vertex shader reads (VertexFormat::Stream for mesh shaders)
+		inline auto getVertexStreams() const { return vertexStreams; }
+		//mesh shader compiled against the interleaved Vertex, binding 0 is the interleaved buffer of the mesh
+		inline auto isInterleavedMesh() const { return interleavedMesh; }
 
 
 		auto bind() const -> void override;
@@ -36,7 +40,9 @@ namespace Maple
 		std::unordered_map<ShaderType, VkShaderModule> shaderModules;
 		std::vector<VkPipelineShaderStageCreateInfo> stageInfos;
 	
-		uint32_t vertexInputStride = 0;
+		uint32_t vertexStreams = 0;
+		bool interleavedMesh = false;
+		std::vector<VkVertexInputBindingDescription> vertexInputBindingDescriptions;
 		std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;
 		std::vector<DescriptorLayoutInfo> descriptorLayoutInfo;
 
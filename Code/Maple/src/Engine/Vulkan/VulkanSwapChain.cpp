@@ -12,6 +12,8 @@
 #include "Others/Console.h"
 
 #include "Application.h"
+#include "Engine/Profiler.h"
+#include <chrono>
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
@@ -26,6 +28,23 @@ namespace Maple
 
 	VulkanSwapChain::~VulkanSwapChain()
 	{
+		vkDeviceWaitIdle(*VulkanDevice::get());
+		for (uint32_t i = 0; i < frameCount; i++)
+		{
+			auto& frame = frames[i];
+			frame.commandBuffer.reset();
+			vkDestroyCommandPool(*VulkanDevice::get(), frame.commandPool, nullptr);
+			for (auto& pool : frame.secondaryPools)
+			{
+				pool.commandBuffers.clear();
+				vkDestroyCommandPool(*VulkanDevice::get(), pool.commandPool, nullptr);
+			}
+			vkDestroyFence(*VulkanDevice::get(), frame.renderFence, nullptr);
+			vkDestroySemaphore(*VulkanDevice::get(), frame.presentSemaphore, nullptr);
+			vkDestroySemaphore(*VulkanDevice::get(), frame.renderSemaphore, nullptr);
+			if (frame.queryPool != VK_NULL_HANDLE)
+				vkDestroyQueryPool(*VulkanDevice::get(), frame.queryPool, nullptr);
+		}
 		vkDestroySwapchainKHR(*VulkanDevice::get(), swapChain, VK_NULL_HANDLE);
 	}
 
@@ -85,6 +104,7 @@ namespace Maple
 		swapChainImageFormat = surfaceFormat.format;
 		swapChainExtent = extent;
 		createImageView();
+		createFrameData();
 	}
 
 	auto VulkanSwapChain::createImageView() -> void
@@ -96,8 +116,31 @@ namespace Maple
 			swapChainBuffers.emplace_back(std::make_shared<VulkanTexture2D>(
 				swapChainImages[i], iv
 			));
+		}
+		imageFences.assign(swapChainImages.size(), VK_NULL_HANDLE);
+	}
+
+	auto VulkanSwapChain::createFrameData() -> void
+	{
+		auto& limits = VulkanDevice::get()->getPhysicalDevice()->getProperties().limits;
+		timestampPeriod = limits.timestampComputeAndGraphics ? limits.timestampPeriod : 0.f;
 
+		frameCount = VulkanContext::get()->getFramesInFlight();
+		//the thread which created the pool and every worker
+		const auto threadCount = Application::get()->getThreadPool()->getThreadCount() + 1;
 
+		auto createPool = [](VkCommandPoolCreateFlags flags) {
+			VkCommandPoolCreateInfo cmdPoolCI{};
+			cmdPoolCI.queueFamilyIndex = VulkanDevice::get()->getPhysicalDevice()->getQueueFamilyIndices().graphicsFamily.value();
+			cmdPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			cmdPoolCI.flags = flags;
+			VkCommandPool pool;
+			VK_CHECK_RESULT(vkCreateCommandPool(*VulkanDevice::get(), &cmdPoolCI, nullptr, &pool));
+			return pool;
+		};
+
+		for (uint32_t i = 0; i < frameCount; i++)
+		{
 			VkSemaphoreCreateInfo semaphoreInfo = {};
 			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 			semaphoreInfo.pNext = nullptr;
@@ -110,23 +153,119 @@ namespace Maple
 			VK_CHECK_RESULT(vkCreateSemaphore(*VulkanDevice::get(), &semaphoreInfo, nullptr, &frames[i].presentSemaphore));
 			VK_CHECK_RESULT(vkCreateSemaphore(*VulkanDevice::get(), &semaphoreInfo, nullptr, &frames[i].renderSemaphore));
 
-			VkCommandPoolCreateInfo cmdPoolCI{};
+			frames[i].commandPool = createPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+			frames[i].commandBuffer = std::make_shared<VulkanCommandBuffer>(true, frames[i].commandPool);
+
+			frames[i].secondaryPools.resize(threadCount);
+			for (auto& pool : frames[i].secondaryPools)
+			{
+				pool.commandPool = createPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+			}
+
+			if (timestampPeriod > 0.f)
+			{
+				VkQueryPoolCreateInfo queryPoolCI{};
+				queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+				queryPoolCI.queryCount = 2;
+				VK_CHECK_RESULT(vkCreateQueryPool(*VulkanDevice::get(), &queryPoolCI, nullptr, &frames[i].queryPool));
+			}
+		}
+	}
 
-			cmdPoolCI.queueFamilyIndex = VulkanDevice::get()->getPhysicalDevice()->getQueueFamilyIndices().graphicsFamily.value();
-			cmdPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-			cmdPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	auto VulkanSwapChain::acquireNextImage(VkSemaphore signalSemaphore) -> VkResult
+	{
+		auto result = vkAcquireNextImageKHR(*VulkanDevice::get(), swapChain, UINT64_MAX, getFrameData().presentSemaphore, VK_NULL_HANDLE, &acquireImageIndex);
+		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			return result;
+
+		currentBuffer = acquireImageIndex;
+
+		auto& imageFence = imageFences[acquireImageIndex];
+		if (imageFence != VK_NULL_HANDLE && imageFence != getFrameData().renderFence)
+		{
+			PROFILE_SCOPE("Wait Image Fence");
+			const auto start = std::chrono::high_resolution_clock::now();
+			VK_CHECK_RESULT(vkWaitForFences(*VulkanDevice::get(), 1, &imageFence, VK_TRUE, UINT64_MAX));
+			timings.cpuWait += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		imageFence = getFrameData().renderFence;
+		return result;
+	}
 
-			VK_CHECK_RESULT(vkCreateCommandPool(*VulkanDevice::get(), &cmdPoolCI, nullptr, &frames[i].commandPool));
+	auto VulkanSwapChain::waitFrame(uint32_t frame) -> void
+	{
+		PROFILE_FUNCTION();
+		auto& data = frames[frame];
 
-			frames[i].commandBuffer = CommandBuffer::create(true);
-			((VulkanCommandBuffer*)frames[i].commandBuffer.get())->init(true, frames[i].commandPool);
+		const auto start = std::chrono::high_resolution_clock::now();
+		VK_CHECK_RESULT(vkWaitForFences(*VulkanDevice::get(), 1, &data.renderFence, VK_TRUE, UINT64_MAX));
+		timings.cpuWait = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 
+		readTimestamps(data);
+		VK_CHECK_RESULT(vkResetCommandPool(*VulkanDevice::get(), data.commandPool, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT));
+		for (auto& pool : data.secondaryPools)
+		{
+			if (pool.used > 0)
+			{
+				VK_CHECK_RESULT(vkResetCommandPool(*VulkanDevice::get(), pool.commandPool, 0));
+				pool.used = 0;
+			}
 		}
 	}
 
-	auto VulkanSwapChain::acquireNextImage(VkSemaphore signalSemaphore) -> VkResult
+	auto VulkanSwapChain::getSecondaryCommandBuffer() -> VulkanCommandBuffer*
 	{
-		return vkAcquireNextImageKHR(*VulkanDevice::get(), swapChain, UINT64_MAX, getFrameData().presentSemaphore, VK_NULL_HANDLE, &acquireImageIndex);
+		const auto index = Application::get()->getThreadPool()->getWorkerIndex();
+		if (index < 0)
+		{
+			LOGE("VulkanSwapChain : secondary command buffers can only be recorded on the threads of the thread pool");
+			return nullptr;
+		}
+
+		auto& pool = getFrameData().secondaryPools[index];
+		if (pool.used == pool.commandBuffers.size())
+		{
+			pool.commandBuffers.emplace_back(std::make_shared<VulkanCommandBuffer>(false, pool.commandPool));
+		}
+		return static_cast<VulkanCommandBuffer*>(pool.commandBuffers[pool.used++].get());
+	}
+
+	auto VulkanSwapChain::writeTimestamp(FrameQuery query) -> void
+	{
+		auto& data = getFrameData();
+		if (data.queryPool == VK_NULL_HANDLE)
+			return;
+
+		auto cmd = *static_cast<VulkanCommandBuffer*>(data.commandBuffer.get());
+		if (query == FrameBegin)
+		{
+			vkCmdResetQueryPool(cmd, data.queryPool, 0, 2);
+			vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, data.queryPool, FrameBegin);
+		}
+		else
+		{
+			vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, data.queryPool, FrameEnd);
+			data.queryWritten = true;
+		}
+	}
+
+	auto VulkanSwapChain::readTimestamps(FrameData& data) -> void
+	{
+		if (!data.queryWritten)
+			return;
+		data.queryWritten = false;
+
+		//the fence has been waited on, so the results are available.
+		uint64_t ticks[2] = {};
+		if (vkGetQueryPoolResults(*VulkanDevice::get(), data.queryPool, 0, 2, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+			return;
+
+		const float toMs = timestampPeriod / 1000000.f;
+		timings.gpuFrame = (ticks[FrameEnd] - ticks[FrameBegin]) * toMs;
+		//slots finish in order, so the previous read is the previous frame.
+		timings.gpuIdle = lastFrameEnd != 0 && ticks[FrameBegin] > lastFrameEnd ? (ticks[FrameBegin] - lastFrameEnd) * toMs : 0.f;
+		lastFrameEnd = ticks[FrameEnd];
 	}
 
 	auto VulkanSwapChain::getCurrentCommandBuffer() -> CommandBuffer* 
@@ -155,14 +294,14 @@ namespace Maple
 		submitInfo.signalSemaphoreCount = 1;
 		submitInfo.pSignalSemaphores = &getFrameData().renderSemaphore;
 		
+		//the fence was waited on in waitFrame, the CPU does not wait for this frame here.
 		VK_CHECK_RESULT(vkResetFences(*VulkanDevice::get(), 1, &getFrameData().renderFence));
 
 		VK_CHECK_RESULT(vkQueueSubmit(VulkanDevice::get()->getGraphicsQueue(), 1, &submitInfo, getFrameData().renderFence));
-		
-		VK_CHECK_RESULT(vkWaitForFences(*VulkanDevice::get(), 1, &getFrameData().renderFence, true, UINT32_MAX));
-
-		VK_CHECK_RESULT(vkResetCommandPool(*VulkanDevice::get(), getFrameData().commandPool, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT));
 
+		PROFILE_PLOT("CPU Wait (ms)", timings.cpuWait);
+		PROFILE_PLOT("GPU Idle (ms)", timings.gpuIdle);
+		PROFILE_PLOT("GPU Frame (ms)", timings.gpuFrame);
 
 
 		VkPresentInfoKHR present;
@@ -189,15 +328,14 @@ namespace Maple
 			VK_CHECK_RESULT(error);
 		}
 
-		currentBuffer = (currentBuffer + 1) % swapChainBuffers.size();
-
 		return error;
 	}
 
 	auto VulkanSwapChain::getFrameData() -> FrameData&
 	{
-		MAPLE_ASSERT(currentBuffer < swapChainBuffers.size(), "invaild swapchain buffer index");
-		return frames[currentBuffer];
+		const auto frame = VulkanContext::get()->getCurrentFrame();
+		MAPLE_ASSERT(frame < frameCount, "invaild frame index");
+		return frames[frame];
 	}
 
 	auto VulkanSwapChain::resize(uint32_t width, uint32_t height) -> void
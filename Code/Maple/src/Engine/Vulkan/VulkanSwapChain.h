@@ -6,12 +6,22 @@
 
 #pragma once
 #include "VulkanHelper.h"
+#include "VulkanContext.h"
 #include "Engine/Interface/SwapChain.h"
 
 namespace Maple
 {
-#define MAX_SWAPCHAIN_BUFFERS 3
+	class VulkanCommandBuffer;
 
+	//secondary command buffers of one thread, recycled when the frame slot comes round again.
+	struct SecondaryPool
+	{
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		std::vector<std::shared_ptr<CommandBuffer>> commandBuffers;
+		uint32_t used = 0;
+	};
+
+	//one per frame in flight, the swap chain images are tracked separately.
 	struct FrameData
 	{
 		VkSemaphore presentSemaphore;
@@ -19,6 +29,20 @@ namespace Maple
 		VkFence		renderFence;
 		VkCommandPool commandPool;
 		std::shared_ptr<CommandBuffer> commandBuffer;
+		//indexed by ThreadPool::getWorkerIndex(), command pools must not be shared between threads.
+		std::vector<SecondaryPool> secondaryPools;
+		//begin/end timestamps of the frame command buffer
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		bool queryWritten = false;
+	};
+
+	struct FrameTimings
+	{
+		//CPU blocked on the fences of the frame slot and of the acquired image
+		float cpuWait = 0.f;
+		//gap between the end of the previous frame and the start of this one on the GPU
+		float gpuIdle = 0.f;
+		float gpuFrame = 0.f;
 	};
 
 	class VulkanSwapChain final : public SwapChain
@@ -37,14 +61,32 @@ namespace Maple
 		auto acquireNextImage(VkSemaphore signalSemaphore)->VkResult;
 
 		auto getCurrentCommandBuffer()->CommandBuffer* override;
+		//secondary command buffer from the pool of the calling thread, valid for the current frame.
+		auto getSecondaryCommandBuffer() -> VulkanCommandBuffer*;
 
 		auto present(VkSemaphore waitSemaphore)->VkResult;
 
 		auto getFrameData() -> FrameData&;
 		virtual auto resize(uint32_t width, uint32_t height) -> void override;
+
+		//wait until the GPU has finished the last frame recorded in the slot, then recycle its command pool.
+		auto waitFrame(uint32_t frame) -> void;
+		enum FrameQuery : uint32_t { FrameBegin, FrameEnd };
+		auto writeTimestamp(FrameQuery query) -> void;
+		inline auto& getTimings() const { return timings; }
 	private:
 		auto createImageView() -> void;
-		FrameData frames[MAX_SWAPCHAIN_BUFFERS];
+		auto createFrameData() -> void;
+		auto readTimestamps(FrameData& frame) -> void;
+
+		FrameData frames[MAX_FRAMES_IN_FLIGHT];
+		uint32_t frameCount = 0;
+		//fence of the frame which renders into each image, the acquired image can still be in use by another slot.
+		std::vector<VkFence> imageFences;
+
+		FrameTimings timings;
+		float timestampPeriod = 0.f;
+		uint64_t lastFrameEnd = 0;
 
 		VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 		VkFormat swapChainImageFormat;
@@ -9,20 +9,35 @@
 #include "VulkanDevice.h"
 #include "VulkanFrameBuffer.h"
 #include "Others/Console.h"
+#include "Engine/Profiler.h"
 #include "Others/StringUtils.h"
 #include "FileSystem/ImageLoader.h"
 #include "FileSystem/Image.h"
 #include "VulkanDevice.h"
 #include "VulkanCommandBuffer.h"
+#include "VulkanUploadQueue.h"
+#include "VulkanAllocator.h"
 
 #include <ktx.h>
 #include <cassert>
+#include <cstring>
 
 
 
 namespace Maple
 {
-	auto generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) -> void
+	//frames in flight may still sample the image, so it is destroyed once they have finished.
+	auto releaseImage(VkSampler sampler, VkImageView view, VkImage image, VulkanAllocation memory) -> void
+	{
+		VulkanContext::get()->deferRelease([=]() mutable {
+			if (sampler) vkDestroySampler(*VulkanDevice::get(), sampler, nullptr);
+			if (view) vkDestroyImageView(*VulkanDevice::get(), view, nullptr);
+			if (image) vkDestroyImage(*VulkanDevice::get(), image, nullptr);
+			VulkanAllocator::get()->free(memory);
+		});
+	}
+
+	auto recordMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) -> void
 	{
 		VkFormatProperties formatProperties;
 		vkGetPhysicalDeviceFormatProperties(*VulkanDevice::get()->getPhysicalDevice(), imageFormat, &formatProperties);
@@ -32,8 +47,6 @@ namespace Maple
 			LOGE("Texture image format does not support linear blitting!");
 		}
 
-		VkCommandBuffer commandBuffer = VulkanHelper::beginSingleTimeCommands();
-
 		VkImageMemoryBarrier barrier{};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.image = image;
@@ -128,12 +141,96 @@ namespace Maple
 			nullptr,
 			1,
 			&barrier);
+	}
 
-		VulkanHelper::endSingleTimeCommands(commandBuffer);
+	//staging copy, layout transitions and the mip chain are recorded into the batched upload queue.
+	//all the levels are in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL once the batch is executed.
+	auto recordUpload(VkImage image, VkFormat format, const uint8_t* pixels, uint32_t size, uint32_t width, uint32_t height, uint32_t mipLevels, const std::function<void()>& complete = nullptr) -> void
+	{
+		auto stagingBuffer = std::make_unique<VulkanBuffer>(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size, pixels);
+		auto buffer = stagingBuffer->getBuffer();
+
+		VulkanUploadQueue::get()->enqueue([=](VkCommandBuffer commandBuffer) {
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.baseMipLevel = 0;
+			subresourceRange.levelCount = mipLevels;
+			subresourceRange.layerCount = 1;
+
+			VulkanHelper::setImageLayout(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+
+			VkBufferImageCopy region = {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = 0;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { width, height, 1 };
+			vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+			if (mipLevels > 1)
+				recordMipmaps(commandBuffer, image, format, width, height, mipLevels);
+			else
+				VulkanHelper::setImageLayout(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+		}, std::move(stagingBuffer), complete);
 	}
 
 
 
+	//the regions of pixels are packed into one staging buffer and copied into a layer with one command.
+	//the image is cleared first when oldLayout is VK_IMAGE_LAYOUT_UNDEFINED, it is in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL after the batch.
+	auto recordRegions(VkImage image, uint32_t width, uint32_t layer, uint32_t layerCount, uint32_t mipLevels, VkImageLayout oldLayout, const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void
+	{
+		uint32_t size = 0;
+		for (auto& region : regions)
+			size += region.w * region.h * 4;
+
+		std::vector<uint8_t> staging(size);
+		std::vector<VkBufferImageCopy> copies;
+		copies.reserve(regions.size());
+
+		uint32_t offset = 0;
+		for (auto& region : regions)
+		{
+			const uint32_t rowSize = region.w * 4;
+			for (uint32_t row = 0; row < region.h; row++)
+			{
+				std::memcpy(staging.data() + offset + row * rowSize, pixels + ((region.y + row) * width + region.x) * 4, rowSize);
+			}
+
+			VkBufferImageCopy copy = {};
+			copy.bufferOffset = offset;
+			copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy.imageSubresource.mipLevel = 0;
+			copy.imageSubresource.baseArrayLayer = layer;
+			copy.imageSubresource.layerCount = 1;
+			copy.imageOffset = { static_cast<int32_t>(region.x), static_cast<int32_t>(region.y), 0 };
+			copy.imageExtent = { region.w, region.h, 1 };
+			copies.emplace_back(copy);
+			offset += rowSize * region.h;
+		}
+
+		auto stagingBuffer = std::make_unique<VulkanBuffer>(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size, staging.data());
+		auto buffer = stagingBuffer->getBuffer();
+
+		VulkanUploadQueue::get()->enqueue([=](VkCommandBuffer commandBuffer) {
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.baseMipLevel = 0;
+			subresourceRange.levelCount = mipLevels;
+			subresourceRange.layerCount = layerCount;
+
+			VulkanHelper::setImageLayout(commandBuffer, image, oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+			if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				VkClearColorValue clear = {};
+				vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &subresourceRange);
+			}
+			vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copies.size()), copies.data());
+			VulkanHelper::setImageLayout(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+		}, std::move(stagingBuffer));
+	}
+
+
 	VulkanTexture2D::VulkanTexture2D(uint32_t width, uint32_t height, const void* data, TextureParameters parameters, TextureLoadOptions loadOptions)
 		:
 		parameters(parameters),
@@ -238,20 +335,10 @@ namespace Maple
 
 	VulkanTexture2D::~VulkanTexture2D()
 	{
-		if (textureSampler)
-			vkDestroySampler(*VulkanDevice::get(), textureSampler, nullptr);
-
-		if (textureImageView)
-			vkDestroyImageView(*VulkanDevice::get(), textureImageView, nullptr);
-
 		if (deleteImage)
-		{
-			vkDestroyImage(*VulkanDevice::get(), textureImage, nullptr);
-			if (textureImageMemory)
-			{
-				vkFreeMemory(*VulkanDevice::get(), textureImageMemory, nullptr);
-			}
-		}
+			releaseImage(textureSampler, textureImageView, textureImage, textureImageMemory);
+		else
+			releaseImage(textureSampler, textureImageView, VK_NULL_HANDLE, {});
 	}
 
 	auto VulkanTexture2D::update(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint8_t* data) -> void
@@ -265,6 +352,74 @@ namespace Maple
 			mipLevels);
 	}
 
+	auto VulkanTexture2D::update(const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void
+	{
+		PROFILE_FUNCTION();
+		if (regions.empty())
+			return;
+
+		//an image which has never been written has no content to keep, it starts cleared.
+		recordRegions(textureImage, width, 0, 1, mipLevels, imageLayout, pixels, regions);
+		imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+
+	auto VulkanTexture2D::uploadAsync(uint32_t w, uint32_t h, const uint8_t* data, bool mipmaps, const std::function<void()>& onReady) -> void
+	{
+		PROFILE_FUNCTION();
+		const auto format = VkConverter::textureFormatToVK(TextureFormat::RGBA8, parameters.srgb);
+		const uint32_t levels = mipmaps ? static_cast<uint32_t>(std::floor(std::log2(std::max(w, h)))) + 1 : 1;
+
+		VkImage image = VK_NULL_HANDLE;
+		VulkanAllocation memory;
+		VulkanHelper::createImage(w, h, levels, format,
+			VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory, 1, 0);
+
+		std::weak_ptr<bool> token = alive;
+		//the swap happens in VulkanUploadQueue::update, before anything of the frame is recorded,
+		//so the old image is only referenced by the frames which are already submitted.
+		recordUpload(image, format, data, w * h * 4, w, h, levels, [=]() mutable {
+			if (token.expired())
+			{
+				vkDestroyImage(*VulkanDevice::get(), image, nullptr);
+				VulkanAllocator::get()->free(memory);
+				return;
+			}
+
+			auto oldImage = deleteImage ? textureImage : VK_NULL_HANDLE;
+			auto oldMemory = deleteImage ? textureImageMemory : VulkanAllocation{};
+			auto oldView = textureImageView;
+			auto oldSampler = textureSampler;
+			VulkanUploadQueue::get()->release([=]() mutable {
+				if (oldSampler) vkDestroySampler(*VulkanDevice::get(), oldSampler, nullptr);
+				if (oldView) vkDestroyImageView(*VulkanDevice::get(), oldView, nullptr);
+				if (oldImage) vkDestroyImage(*VulkanDevice::get(), oldImage, nullptr);
+				VulkanAllocator::get()->free(oldMemory);
+			});
+
+			width = w;
+			height = h;
+			mipLevels = levels;
+			parameters.format = TextureFormat::RGBA8;
+			textureImage = image;
+			textureImageMemory = memory;
+			deleteImage = true;
+			textureImageView = VulkanHelper::createImageView(image, format, levels, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+			textureSampler = VulkanHelper::createTextureSampler(
+				VkConverter::textureFilterToVK(parameters.magFilter),
+				VkConverter::textureFilterToVK(parameters.minFilter), 0.0f, static_cast<float>(levels), true,
+				VulkanDevice::get()->getPhysicalDevice()->getProperties().limits.maxSamplerAnisotropy,
+				VkConverter::textureWrapToVK(parameters.wrap),
+				VkConverter::textureWrapToVK(parameters.wrap),
+				VkConverter::textureWrapToVK(parameters.wrap));
+			updateDescriptor();
+			version++;
+
+			if (onReady)
+				onReady();
+		});
+	}
+
 	auto VulkanTexture2D::loadKTX() -> void
 	{
 		VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
@@ -385,24 +540,13 @@ namespace Maple
 		}
 
 
-		auto size = VulkanHelper::createImage(width, height, mipLevels, 
-			VkConverter::textureFormatToVK(parameters.format, parameters.srgb), 
+		const auto format = VkConverter::textureFormatToVK(parameters.format, parameters.srgb);
+
+		VulkanHelper::createImage(width, height, mipLevels, format,
 			VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 1, 0);
-		
-		
-		auto stagingBuffer = std::make_unique<VulkanBuffer>(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, imageSize, pixel);
-		
-		VulkanHelper::transitionImageLayout(textureImage, VkConverter::textureFormatToVK(parameters.format, parameters.srgb), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
-		VulkanHelper::copyBufferToImage(stagingBuffer->getBuffer(), textureImage, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
-		VulkanHelper::transitionImageLayout(textureImage, VkConverter::textureFormatToVK(parameters.format), 
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			 mipLevels);
-
-		if(loadOptions.generateMipMaps)
-			generateMipmaps(textureImage, VkConverter::textureFormatToVK(parameters.format, parameters.srgb), width, height, mipLevels);
 
+		recordUpload(textureImage, format, pixel, imageSize, width, height, mipLevels);
 		return true;
 	}
 
@@ -415,29 +559,20 @@ namespace Maple
 
 	auto VulkanTexture2D::buildTexture(TextureFormat internalformat, uint32_t width, uint32_t height, bool srgb, bool depth, bool samplerShadow) -> void
 	{
-		if (textureSampler)
-			vkDestroySampler(*VulkanDevice::get(), textureSampler, nullptr);
-
-		if (textureImageView)
-			vkDestroyImageView(*VulkanDevice::get(), textureImageView, nullptr);
-
 		if (deleteImage)
-		{
-			vkDestroyImage(*VulkanDevice::get(), textureImage, nullptr);
-
-			if (textureImageMemory)
-			{
-				vkFreeMemory(*VulkanDevice::get(), textureImageMemory, nullptr);
-			}
-		}
+			releaseImage(textureSampler, textureImageView, textureImage, textureImageMemory);
+		else
+			releaseImage(textureSampler, textureImageView, VK_NULL_HANDLE, {});
+		textureImageMemory = {};
 
 		this->width = width;
 		this->height = height;
 		handle = 0;
 		deleteImage = true;
 		mipLevels = 1;
+		imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-		VulkanHelper::createImage(width, height, mipLevels, VkConverter::textureFormatToVK(internalformat, srgb), VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 1, 0);
+		VulkanHelper::createImage(width, height, mipLevels, VkConverter::textureFormatToVK(internalformat, srgb), VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 1, 0);
 
 		textureImageView = VulkanHelper::createImageView(textureImage, VkConverter::textureFormatToVK(internalformat, srgb), mipLevels, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 		textureSampler = VulkanHelper::createTextureSampler(
@@ -463,14 +598,9 @@ namespace Maple
 
 	auto VulkanTextureDepth::release() -> void
 	{
-		auto device = VulkanDevice::get();
-
-		if (textureSampler)
-			vkDestroySampler(*device, textureSampler, nullptr);
-
-		vkDestroyImageView(*device, textureImageView, nullptr);
-		vkDestroyImage(*device, textureImage, nullptr);
-		vkFreeMemory(*device, textureImageMemory, nullptr);
+		releaseImage(textureSampler, textureImageView, textureImage, textureImageMemory);
+		textureSampler = VK_NULL_HANDLE;
+		textureImageMemory = {};
 	}
 
 
@@ -535,17 +665,10 @@ namespace Maple
 
 	VulkanTextureCube::~VulkanTextureCube()
 	{
-		if (textureSampler)
-			vkDestroySampler(*VulkanDevice::get(), textureSampler, nullptr);
-
-		if (textureImageView)
-			vkDestroyImageView(*VulkanDevice::get(), textureImageView, nullptr);
-
 		if (deleteImg)
-		{
-			vkDestroyImage(*VulkanDevice::get(), textureImage, nullptr);
-			vkFreeMemory(*VulkanDevice::get(), textureImageMemory, nullptr);
-		}
+			releaseImage(textureSampler, textureImageView, textureImage, textureImageMemory);
+		else
+			releaseImage(textureSampler, textureImageView, VK_NULL_HANDLE, {});
 	}
 
 	auto VulkanTextureCube::updateDescriptor() -> void
@@ -791,6 +914,98 @@ namespace Maple
 	}
 
 
+	VulkanTexture2DArray::VulkanTexture2DArray(uint32_t width, uint32_t height, uint32_t count)
+	{
+		this->width = width;
+		this->height = height;
+		format = VkConverter::textureFormatToVK(TextureFormat::RGBA8, true);
+		textureSampler = VulkanHelper::createTextureSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR, 0.0f, 1.0f, false, 1.0f,
+			VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+		resize(count);
+	}
+
+	VulkanTexture2DArray::~VulkanTexture2DArray()
+	{
+		releaseImage(textureSampler, textureImageView, textureImage, textureImageMemory);
+	}
+
+	auto VulkanTexture2DArray::update(uint32_t layer, const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void
+	{
+		PROFILE_FUNCTION();
+		if (regions.empty() || layer >= count)
+			return;
+		recordRegions(textureImage, width, layer, count, 1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, pixels, regions);
+	}
+
+	auto VulkanTexture2DArray::resize(uint32_t newCount) -> void
+	{
+		PROFILE_FUNCTION();
+		VkImage image = VK_NULL_HANDLE;
+		VulkanAllocation memory;
+		VulkanHelper::createImage(width, height, 1, format, VK_IMAGE_TYPE_2D, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory, newCount, 0);
+
+		//the new layers start cleared, the kept ones are copied on the GPU
+		const auto oldImage = textureImage;
+		const auto kept = oldImage != VK_NULL_HANDLE ? std::min(count, newCount) : 0;
+		const auto w = width;
+		const auto h = height;
+
+		VulkanUploadQueue::get()->enqueue([=](VkCommandBuffer commandBuffer) {
+			VkImageSubresourceRange subresourceRange = {};
+			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			subresourceRange.levelCount = 1;
+			subresourceRange.layerCount = newCount;
+
+			VulkanHelper::setImageLayout(commandBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+			VkClearColorValue clear = {};
+			vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &subresourceRange);
+
+			if (kept > 0)
+			{
+				VkImageSubresourceRange oldRange = subresourceRange;
+				oldRange.layerCount = kept;
+				VulkanHelper::setImageLayout(commandBuffer, oldImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, oldRange);
+
+				VkImageCopy copy = {};
+				copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				copy.srcSubresource.layerCount = kept;
+				copy.dstSubresource = copy.srcSubresource;
+				copy.extent = { w, h, 1 };
+				vkCmdCopyImage(commandBuffer, oldImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+			}
+
+			VulkanHelper::setImageLayout(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+		});
+
+		//the old image is read by the copy above and the frames in flight
+		if (oldImage != VK_NULL_HANDLE)
+		{
+			auto oldView = textureImageView;
+			auto oldMemory = textureImageMemory;
+			VulkanUploadQueue::get()->release([=]() mutable {
+				vkDestroyImageView(*VulkanDevice::get(), oldView, nullptr);
+				vkDestroyImage(*VulkanDevice::get(), oldImage, nullptr);
+				VulkanAllocator::get()->free(oldMemory);
+			});
+			version++;
+		}
+
+		count = newCount;
+		textureImage = image;
+		textureImageMemory = memory;
+		textureImageView = VulkanHelper::createImageView(image, format, 1, VK_IMAGE_VIEW_TYPE_2D_ARRAY, VK_IMAGE_ASPECT_COLOR_BIT, newCount);
+		updateDescriptor();
+	}
+
+	auto VulkanTexture2DArray::updateDescriptor() -> void
+	{
+		descriptor.sampler = textureSampler;
+		descriptor.imageView = textureImageView;
+		descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+
 	VulkanTextureDepthArray::VulkanTextureDepthArray(uint32_t width, uint32_t height, uint32_t count)
 		:width(width),height(height),count(count)
 	{
@@ -799,14 +1014,11 @@ namespace Maple
 
 	VulkanTextureDepthArray::~VulkanTextureDepthArray()
 	{
-		vkDestroyImageView(*VulkanDevice::get(), textureImageView, nullptr);
-		vkDestroyImage(*VulkanDevice::get(), textureImage, nullptr);
-		vkFreeMemory  (*VulkanDevice::get(), textureImageMemory, nullptr);
-		vkDestroySampler(*VulkanDevice::get(), textureSampler, nullptr);
-		for (uint32_t i = 0; i < count; i++)
+		for (auto view : imageViews)
 		{
-			vkDestroyImageView(*VulkanDevice::get(), imageViews[i], nullptr);
+			releaseImage(VK_NULL_HANDLE, view, VK_NULL_HANDLE, {});
 		}
+		releaseImage(textureSampler, textureImageView, textureImage, textureImageMemory);
 	}
 
 	auto VulkanTextureDepthArray::resize(uint32_t width, uint32_t height, uint32_t count) -> void 
@@ -815,12 +1027,13 @@ namespace Maple
 		this->height = height;
 		this->count = count;
 
-		if (textureSampler)
-			vkDestroySampler(*VulkanDevice::get(), textureSampler, nullptr);
-
-		vkDestroyImageView(*VulkanDevice::get(), textureImageView, nullptr);
-		vkDestroyImage(*VulkanDevice::get(), textureImage, nullptr);
-		vkFreeMemory(*VulkanDevice::get(), textureImageMemory, nullptr);
+		for (auto view : imageViews)
+		{
+			releaseImage(VK_NULL_HANDLE, view, VK_NULL_HANDLE, {});
+		}
+		imageViews.clear();
+		releaseImage(textureSampler, textureImageView, textureImage, textureImageMemory);
+		textureImageMemory = {};
 
 		init();
 	}
@@ -6,6 +6,7 @@
 
 #pragma once
 #include "VulkanHelper.h"
+#include "VulkanAllocator.h"
 #include "Engine/Interface/Texture.h"
 
 namespace Maple
@@ -21,6 +22,8 @@ namespace Maple
 		~VulkanTexture2D();
 
 		auto update(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint8_t* data) -> void override;
+		auto update(const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void override;
+		auto uploadAsync(uint32_t w, uint32_t h, const uint8_t* data, bool mipmaps, const std::function<void()>& onReady = nullptr) -> void override;
 
 		auto bind(uint32_t slot = 0) const -> void override {}
 		auto unbind(uint32_t slot = 0) const -> void override {}
@@ -56,14 +59,16 @@ namespace Maple
 		VkImage textureImage = VK_NULL_HANDLE;
 		VkImageView textureImageView = VK_NULL_HANDLE;
 
-		VkImageLayout imageLayout;
-		VkDeviceMemory textureImageMemory = VK_NULL_HANDLE;
+		VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VulkanAllocation textureImageMemory;
 		VkSampler textureSampler = VK_NULL_HANDLE;
 		VkDescriptorImageInfo descriptor{};
 
 		bool deleteImage = false;
 
 		uint32_t layerCount = 1;
+		//pending async uploads check it before touching the texture.
+		std::shared_ptr<bool> alive = std::make_shared<bool>(true);
 	};
 
 
@@ -124,7 +129,7 @@ namespace Maple
 
 
 		VkImage textureImage{};
-		VkDeviceMemory textureImageMemory{};
+		VulkanAllocation textureImageMemory;
 		VkImageView textureImageView{};
 		VkSampler textureSampler{};
 		VkDescriptorImageInfo descriptor{};
@@ -186,7 +191,7 @@ namespace Maple
 
 		VkImage textureImage = nullptr;
 		VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		VkDeviceMemory textureImageMemory = nullptr;
+		VulkanAllocation textureImageMemory;
 		VkImageView textureImageView = nullptr;
 		VkSampler textureSampler;
 		VkDescriptorImageInfo descriptor;
@@ -196,6 +201,33 @@ namespace Maple
 
 
 
+	class VulkanTexture2DArray : public Texture2DArray
+	{
+	public:
+		VulkanTexture2DArray(uint32_t width, uint32_t height, uint32_t count);
+		~VulkanTexture2DArray();
+
+		auto bind(uint32_t slot = 0) const -> void override {};
+		auto unbind(uint32_t slot = 0) const -> void override {};
+		auto update(uint32_t layer, const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void override;
+		auto resize(uint32_t count) -> void override;
+
+		auto getHandle() const -> void* override { return (void*)&descriptor; }
+		inline auto getImage() const { return textureImage; }
+		inline auto getImageView() const { return textureImageView; }
+		inline auto getSampler() const { return textureSampler; }
+		inline auto getDescriptor() const { return &descriptor; }
+		auto updateDescriptor() -> void;
+
+	private:
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkImage textureImage = VK_NULL_HANDLE;
+		VulkanAllocation textureImageMemory;
+		VkImageView textureImageView = VK_NULL_HANDLE;
+		VkSampler textureSampler = VK_NULL_HANDLE;
+		VkDescriptorImageInfo descriptor{};
+	};
+
 	class VulkanTextureDepthArray : public TextureDepthArray 
 	{
 	public:
@@ -225,7 +257,7 @@ namespace Maple
 		uint32_t count = 0;
 
 		VkImage textureImage{};
-		VkDeviceMemory textureImageMemory{};
+		VulkanAllocation textureImageMemory;
 		VkImageView textureImageView{};
 		VkSampler textureSampler{};
 		VkDescriptorImageInfo descriptor{};
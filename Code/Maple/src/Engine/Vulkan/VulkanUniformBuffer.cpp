@@ -3,13 +3,19 @@
 // Copyright ?2020-2022 Tian Zeng                                           //
 //////////////////////////////////////////////////////////////////////////////
 #include "VulkanUniformBuffer.h"
+#include "VulkanDevice.h"
 #include <memory.h>
 namespace Maple
 {
 
 	VulkanUniformBuffer::VulkanUniformBuffer(uint32_t size, const void* data)
 	{
-		VulkanBuffer::init(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size, data);
+		create(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size, data);
+	}
+
+	VulkanUniformBuffer::VulkanUniformBuffer(VkBufferUsageFlags usage, uint32_t size, const void* data)
+	{
+		create(usage, size, data);
 	}
 
 	VulkanUniformBuffer::VulkanUniformBuffer()
@@ -22,20 +28,75 @@ namespace Maple
 
 	auto VulkanUniformBuffer::init(uint32_t size, const void* data) -> void
 	{
-		VulkanBuffer::init(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size, data);
+		create(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size, data);
+	}
+
+	auto VulkanUniformBuffer::create(VkBufferUsageFlags usage, uint32_t size, const void* data) -> void
+	{
+		auto& limits = VulkanDevice::get()->getPhysicalDevice()->getProperties().limits;
+		const auto alignment = (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) ?
+			limits.minStorageBufferOffsetAlignment : limits.minUniformBufferOffsetAlignment;
+
+		frames = VulkanContext::get()->getFramesInFlight();
+		stride = alignment > 0 ? (size + alignment - 1) & ~(alignment - 1) : size;
+		VulkanBuffer::init(usage, static_cast<uint32_t>(stride * frames), nullptr);
+		//the size of one copy, which is what the users see.
+		this->size = size;
+
+		shadow.assign(size, 0);
+		if (data != nullptr)
+			memcpy(shadow.data(), data, size);
+
+		version = 0;
+		for (uint32_t i = 0; i < frames; i++)
+		{
+			copy(i, size, 0);
+			versions[i] = version;
+		}
+	}
+
+	auto VulkanUniformBuffer::resize(uint32_t size, const void* data) -> void
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		release();
+		create(usage, size, data);
+	}
+
+	auto VulkanUniformBuffer::copy(uint32_t frame, uint32_t size, uint32_t offset) -> void
+	{
+		map();
+		memcpy(reinterpret_cast<uint8_t*>(mapped) + frame * stride + offset, shadow.data() + offset, size);
+		unmap();
+	}
+
+	auto VulkanUniformBuffer::sync(uint32_t frame) -> void
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (versions[frame] != version)
+		{
+			copy(frame, static_cast<uint32_t>(shadow.size()), 0);
+			versions[frame] = version;
+		}
 	}
 
 	auto VulkanUniformBuffer::setDynamicData(uint32_t size, uint32_t typeSize, const void* data) -> void
 	{
-		VulkanBuffer::map();
-		memcpy(mapped, data, size);
-		VulkanBuffer::flush(size);
-		VulkanBuffer::unmap();
+		setData(size, data);
 	}
 
 	auto VulkanUniformBuffer::setData(uint32_t size, const void* data, uint32_t offset /*= 0*/) -> void
 	{
-		VulkanBuffer::setData(size, data, offset);
+		std::lock_guard<std::mutex> lock(mutex);
+		memcpy(shadow.data() + offset, data, size);
+
+		//the copy of the current frame is free (its last frame has been waited for),
+		//only the written range is needed if it has not missed an earlier write.
+		const auto frame = VulkanContext::get()->getCurrentFrame() % frames;
+		if (versions[frame] == version)
+			copy(frame, size, offset);
+		else
+			copy(frame, static_cast<uint32_t>(shadow.size()), 0);
+		versions[frame] = ++version;
 	}
 
-};
\ No newline at end of file
+};
@@ -5,19 +5,42 @@
 ////////////////////////////////////////////////////////////////////////////// 
 
 #include "VulkanBuffer.h"
+#include "VulkanContext.h"
 #include "Engine/Interface/UniformBuffer.h"
+#include <vector>
+#include <mutex>
 
 namespace Maple
 {
+	//One copy of the data per frame in flight, so writing the next frame never races with the GPU reading the previous ones.
+	//Writes go to a CPU shadow and to the copy of the current frame, the other copies are brought up to date
+	//by sync() when a descriptor set referencing them is bound.
+	//Renderers record on several threads, so writes and syncs are serialised.
 	class VulkanUniformBuffer : public VulkanBuffer, public UniformBuffer
 	{
 	public:
 		VulkanUniformBuffer(uint32_t size, const void* data);
+		VulkanUniformBuffer(VkBufferUsageFlags usage, uint32_t size, const void* data);
 		VulkanUniformBuffer();
 		~VulkanUniformBuffer();
 		auto init(uint32_t size, const void* data) -> void;
 		auto setDynamicData(uint32_t size, uint32_t typeSize, const void* data) -> void;
 		auto setData(uint32_t size, const void* data, uint32_t offset = 0) -> void override;
-		inline auto getMemory() { return &memory; }
+		auto resize(uint32_t size, const void* data) -> void override;
+		//copy the latest data into the copy of the frame if it is out of date.
+		auto sync(uint32_t frame) -> void;
+		//distance between two copies, the copy of a frame starts at frame * stride.
+		inline auto getStride() const { return stride; }
+		inline auto getMemory() { return &allocation; }
+	private:
+		auto create(VkBufferUsageFlags usage, uint32_t size, const void* data) -> void;
+		auto copy(uint32_t frame, uint32_t size, uint32_t offset) -> void;
+
+		std::vector<uint8_t> shadow;
+		VkDeviceSize stride = 0;
+		uint32_t frames = 1;
+		uint64_t version = 0;
+		uint64_t versions[MAX_FRAMES_IN_FLIGHT] = {};
+		std::mutex mutex;
 	};
 };
\ No newline at end of file
@@ -0,0 +1,209 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#include "VulkanUploadQueue.h"
+#include "VulkanDevice.h"
+#include "VulkanBuffer.h"
+#include "VulkanFence.h"
+#include "Others/Console.h"
+#include "Engine/Profiler.h"
+
+namespace Maple
+{
+	std::shared_ptr<VulkanUploadQueue> VulkanUploadQueue::instance;
+
+	VulkanUploadQueue::VulkanUploadQueue()
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = VulkanDevice::get()->getPhysicalDevice()->getQueueFamilyIndices().graphicsFamily.value();
+		VK_CHECK_RESULT(vkCreateCommandPool(*VulkanDevice::get(), &poolInfo, nullptr, &commandPool));
+	}
+
+	VulkanUploadQueue::~VulkanUploadQueue()
+	{
+		flush();
+		waitIdle();
+		vkDestroyCommandPool(*VulkanDevice::get(), commandPool, nullptr);
+	}
+
+	auto VulkanUploadQueue::get() -> std::shared_ptr<VulkanUploadQueue>
+	{
+		if (instance == nullptr)
+		{
+			instance = std::make_shared<VulkanUploadQueue>();
+		}
+		return instance;
+	}
+
+	auto VulkanUploadQueue::release() -> void
+	{
+		instance.reset();
+	}
+
+	auto VulkanUploadQueue::beginBatch() -> void
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = 1;
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(*VulkanDevice::get(), &allocInfo, &pending.commandBuffer));
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(pending.commandBuffer, &beginInfo));
+	}
+
+	auto VulkanUploadQueue::enqueue(const RecordCallback& record, std::unique_ptr<VulkanBuffer> staging, const std::function<void()>& complete) -> void
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pending.commandBuffer == VK_NULL_HANDLE)
+		{
+			beginBatch();
+		}
+
+		record(pending.commandBuffer);
+
+		if (staging)
+		{
+			pendingBytes += staging->getSize();
+			pending.stagingBuffers.emplace_back(std::move(staging));
+		}
+		if (complete)
+		{
+			pending.completes.emplace_back(complete);
+		}
+	}
+
+	auto VulkanUploadQueue::getCommandBuffer() -> VkCommandBuffer
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pending.commandBuffer == VK_NULL_HANDLE)
+		{
+			beginBatch();
+		}
+		return pending.commandBuffer;
+	}
+
+	auto VulkanUploadQueue::release(const std::function<void()>& deleter) -> void
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.releases.emplace_back(deleter);
+	}
+
+	auto VulkanUploadQueue::flush() -> void
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (pending.commandBuffer == VK_NULL_HANDLE)
+		{
+			if (pending.releases.empty())
+				return;
+			//nothing recorded, submit a barrier so the releases wait for the work which is already in the queue
+			beginBatch();
+			vkCmdPipelineBarrier(pending.commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+		}
+
+		PROFILE_FUNCTION();
+		VK_CHECK_RESULT(vkEndCommandBuffer(pending.commandBuffer));
+
+		if (freeFences.empty())
+		{
+			pending.fence = std::make_unique<VulkanFence>();
+		}
+		else
+		{
+			pending.fence = std::move(freeFences.back());
+			freeFences.pop_back();
+			pending.fence->reset();
+		}
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &pending.commandBuffer;
+		VK_CHECK_RESULT(vkQueueSubmit(VulkanDevice::get()->getGraphicsQueue(), 1, &submitInfo, *pending.fence));
+
+		PROFILE_PLOT("Upload Bytes", static_cast<int64_t>(pendingBytes));
+		inFlight.emplace_back(std::move(pending));
+		pending = Batch{};
+		pendingBytes = 0;
+	}
+
+	auto VulkanUploadQueue::recycle(Batch& batch) -> void
+	{
+		if (batch.commandBuffer != VK_NULL_HANDLE)
+		{
+			vkFreeCommandBuffers(*VulkanDevice::get(), commandPool, 1, &batch.commandBuffer);
+			batch.commandBuffer = VK_NULL_HANDLE;
+		}
+		batch.stagingBuffers.clear();
+
+		if (batch.fence)
+		{
+			freeFences.emplace_back(std::move(batch.fence));
+		}
+	}
+
+	auto VulkanUploadQueue::retire(Batch& batch) -> void
+	{
+		for (auto& complete : batch.completes)
+		{
+			complete();
+		}
+		for (auto& deleter : batch.releases)
+		{
+			deleter();
+		}
+		batch.completes.clear();
+		batch.releases.clear();
+	}
+
+	auto VulkanUploadQueue::update() -> void
+	{
+		PROFILE_FUNCTION();
+		std::vector<Batch> finished;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			//batches are submitted to the same queue, so they finish in order
+			while (!inFlight.empty() && inFlight.front().fence->isSignaled())
+			{
+				finished.emplace_back(std::move(inFlight.front()));
+				inFlight.pop_front();
+				recycle(finished.back());
+			}
+		}
+		//outside the lock, the callbacks may enqueue or release again
+		for (auto& batch : finished)
+		{
+			retire(batch);
+		}
+	}
+
+	auto VulkanUploadQueue::waitIdle() -> void
+	{
+		std::deque<Batch> batches;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			batches.swap(inFlight);
+		}
+		for (auto& batch : batches)
+		{
+			batch.fence->wait();
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto& batch : batches)
+			{
+				recycle(batch);
+			}
+		}
+		for (auto& batch : batches)
+		{
+			retire(batch);
+		}
+	}
+};
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "VulkanHelper.h"
+#include <memory>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace Maple
+{
+	class VulkanBuffer;
+	class VulkanFence;
+
+	//Collects the transfer work of a frame (staging copies, layout transitions, mip generation)
+	//into one command buffer which is submitted with a fence instead of draining the queue per upload.
+	//every call takes the lock, so work can be enqueued while renderers are recorded on the worker threads.
+	//completion callbacks and deleters run outside the lock and may enqueue again.
+	class VulkanUploadQueue final
+	{
+	public:
+		using RecordCallback = std::function<void(VkCommandBuffer)>;
+
+		VulkanUploadQueue();
+		~VulkanUploadQueue();
+
+		//record commands into the pending batch. the staging buffer is kept alive until the batch has finished on the GPU,
+		//complete is called from update() after that.
+		auto enqueue(const RecordCallback& record, std::unique_ptr<VulkanBuffer> staging = nullptr, const std::function<void()>& complete = nullptr) -> void;
+		//command buffer of the pending batch, for commands which are recorded in place.
+		//recording into it is not guarded by the lock, so it stays on the main thread, use enqueue() elsewhere.
+		auto getCommandBuffer() -> VkCommandBuffer;
+		//destroy a resource once the pending batch has finished. the batch starts after the work already submitted,
+		//so the resource must not be referenced by commands recorded after this call.
+		auto release(const std::function<void()>& deleter) -> void;
+
+		//submit the pending batch, called before the frame command buffer is submitted.
+		auto flush() -> void;
+		//retire the finished batches, called at the beginning of the frame before anything is recorded.
+		auto update() -> void;
+		auto waitIdle() -> void;
+
+		//statistics, read without the lock
+		inline auto getInFlightCount() const { return inFlight.size(); }
+		inline auto getPendingBytes() const { return pendingBytes; }
+
+		static auto get()->std::shared_ptr<VulkanUploadQueue>;
+		//wait for the in-flight batches and destroy the queue, must be called before the device is destroyed.
+		static auto release() -> void;
+	private:
+		struct Batch
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			std::unique_ptr<VulkanFence> fence;
+			std::vector<std::unique_ptr<VulkanBuffer>> stagingBuffers;
+			std::vector<std::function<void()>> completes;
+			std::vector<std::function<void()>> releases;
+		};
+
+		auto beginBatch() -> void;
+		//free the command buffer, staging buffers and fence of a finished batch, called with the lock held.
+		auto recycle(Batch& batch) -> void;
+		//run the completion callbacks and deleters of a finished batch, called without the lock.
+		auto retire(Batch& batch) -> void;
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		Batch pending;
+		std::deque<Batch> inFlight;
+		std::vector<std::unique_ptr<VulkanFence>> freeFences;
+		uint64_t pendingBytes = 0;
+		std::mutex mutex;
+
+		static std::shared_ptr<VulkanUploadQueue> instance;
+	};
+};
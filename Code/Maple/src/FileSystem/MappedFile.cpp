@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+#include "Others/Console.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Maple
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& file)
+	{
+		fileHandle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			fileHandle = nullptr;
+			LOGW("Failed to open {0}", file);
+			return;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+			return;
+
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr)
+		{
+			LOGW("Failed to map {0}", file);
+			return;
+		}
+
+		data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		size = data != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+		if (mappingHandle != nullptr)
+			CloseHandle(mappingHandle);
+		if (fileHandle != nullptr)
+			CloseHandle(fileHandle);
+	}
+#else
+	MappedFile::MappedFile(const std::string& file)
+	{
+		fd = open(file.c_str(), O_RDONLY);
+		if (fd == -1)
+		{
+			LOGW("Failed to open {0}", file);
+			return;
+		}
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0)
+			return;
+
+		auto ptr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr == MAP_FAILED)
+		{
+			LOGW("Failed to map {0}", file);
+			return;
+		}
+		madvise(ptr, info.st_size, MADV_SEQUENTIAL);
+		data = static_cast<const uint8_t*>(ptr);
+		size = static_cast<size_t>(info.st_size);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (data != nullptr)
+			munmap(const_cast<uint8_t*>(data), size);
+		if (fd != -1)
+			close(fd);
+	}
+#endif
+};
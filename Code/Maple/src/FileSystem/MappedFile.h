@@ -0,0 +1,36 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <cstdint>
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	//read-only memory mapped file, the data stays valid until the object is destroyed.
+	class MAPLE_EXPORT MappedFile
+	{
+	public:
+		MappedFile(const std::string& file);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+		inline auto isValid() const { return data != nullptr; }
+		inline auto getData() const { return data; }
+		inline auto getSize() const { return size; }
+
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#else
+		int32_t fd = -1;
+#endif
+	};
+};
@@ -0,0 +1,294 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "Others/StringUtils.h"
+#include "Others/Console.h"
+#include "Engine/Profiler.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+namespace Maple
+{
+	namespace
+	{
+		//| FileHeader | MeshRecord * meshCount | MaterialRecord * materialCount | strings | buffers |
+		//every buffer starts at a multiple of BUFFER_ALIGNMENT from the beginning of the file.
+		constexpr uint64_t BUFFER_ALIGNMENT = 16;
+
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t sourceHash;
+			uint64_t sourceSize;
+			uint32_t meshCount;
+			uint32_t materialCount;
+			//the streams are stored as they are laid out in memory
+			uint32_t positionSize;
+			uint32_t attributeSize;
+			uint32_t stringSize;
+		};
+
+		struct StringRecord
+		{
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		struct MeshRecord
+		{
+			StringRecord name;
+			uint64_t positionOffset;
+			uint64_t attributeOffset;
+			uint64_t indexOffset;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			float min[3];
+			float max[3];
+			int32_t material;
+			uint32_t lodCount;
+			MeshLod lods[MeshSimplifier::MAX_LODS];
+		};
+
+		struct MaterialRecord
+		{
+			StringRecord textures[MeshCache::TextureCount];
+		};
+
+		inline auto align(uint64_t offset) -> uint64_t
+		{
+			return (offset + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+		}
+	};
+
+	MeshCache::Reader::Reader(const std::string& file)
+	{
+		PROFILE_FUNCTION();
+		if (!StringUtils::endWith(file, EXTENSION) || !std::ifstream(file).good())
+			return;
+
+		mapped = std::make_unique<MappedFile>(file);
+		if (!mapped->isValid() || mapped->getSize() < sizeof(FileHeader))
+			return;
+
+		const auto data = mapped->getData();
+		const auto size = mapped->getSize();
+
+		FileHeader header;
+		memcpy(&header, data, sizeof(FileHeader));
+		if (header.magic != MAGIC || header.version != VERSION ||
+			header.positionSize != sizeof(glm::vec3) || header.attributeSize != sizeof(VertexFormat::PackedAttributes))
+		{
+			LOGW("{0} is not a cooked mesh or has an old version ({1})", file, header.version);
+			return;
+		}
+
+		const uint64_t recordsSize = sizeof(FileHeader) + sizeof(MeshRecord) * header.meshCount + sizeof(MaterialRecord) * header.materialCount;
+		if (recordsSize + header.stringSize > size)
+		{
+			LOGW("{0} is truncated", file);
+			return;
+		}
+
+		auto meshRecords = reinterpret_cast<const MeshRecord*>(data + sizeof(FileHeader));
+		auto materialRecords = reinterpret_cast<const MaterialRecord*>(meshRecords + header.meshCount);
+		auto strings = reinterpret_cast<const char*>(data + recordsSize);
+
+		auto readString = [&](const StringRecord& record) {
+			if (uint64_t(record.offset) + record.length > header.stringSize)
+				return std::string();
+			return std::string(strings + record.offset, record.length);
+		};
+
+		materials.resize(header.materialCount);
+		for (uint32_t i = 0; i < header.materialCount; i++)
+		{
+			for (uint32_t j = 0; j < TextureCount; j++)
+			{
+				materials[i].textures[j] = readString(materialRecords[i].textures[j]);
+			}
+		}
+
+		meshes.resize(header.meshCount);
+		for (uint32_t i = 0; i < header.meshCount; i++)
+		{
+			auto& record = meshRecords[i];
+			if (record.positionOffset + uint64_t(record.vertexCount) * sizeof(glm::vec3) > size ||
+				record.attributeOffset + uint64_t(record.vertexCount) * sizeof(VertexFormat::PackedAttributes) > size ||
+				record.indexOffset + uint64_t(record.indexCount) * sizeof(uint32_t) > size)
+			{
+				LOGW("{0} is truncated", file);
+				meshes.clear();
+				return;
+			}
+
+			auto& mesh = meshes[i];
+			mesh.name = readString(record.name);
+			mesh.positions = reinterpret_cast<const glm::vec3*>(data + record.positionOffset);
+			mesh.attributes = reinterpret_cast<const VertexFormat::PackedAttributes*>(data + record.attributeOffset);
+			mesh.vertexCount = record.vertexCount;
+			mesh.indices = reinterpret_cast<const uint32_t*>(data + record.indexOffset);
+			mesh.indexCount = record.indexCount;
+			mesh.box = { glm::vec3(record.min[0], record.min[1], record.min[2]), glm::vec3(record.max[0], record.max[1], record.max[2]) };
+			mesh.material = record.material < static_cast<int32_t>(header.materialCount) ? record.material : -1;
+			for (uint32_t j = 0; j < std::min<uint32_t>(record.lodCount, MeshSimplifier::MAX_LODS); j++)
+			{
+				if (uint64_t(record.lods[j].indexOffset) + record.lods[j].indexCount <= record.indexCount)
+					mesh.lods.emplace_back(record.lods[j]);
+			}
+		}
+
+		sourceHash = header.sourceHash;
+		sourceSize = header.sourceSize;
+		valid = true;
+	}
+
+	MeshCache::Reader::~Reader()
+	{
+	}
+
+	auto MeshCache::getCookedPath(const std::string& source) -> std::string
+	{
+		if (StringUtils::endWith(source, EXTENSION))
+			return source;
+		return StringUtils::removeExtension(source) + EXTENSION;
+	}
+
+	auto MeshCache::hashFile(const std::string& file, uint64_t& size) -> uint64_t
+	{
+		PROFILE_FUNCTION();
+		size = 0;
+		if (!std::ifstream(file).good())
+			return 0;
+
+		MappedFile mapped(file);
+		if (!mapped.isValid())
+			return 0;
+
+		//FNV-1a over 8 byte words, the source only has to be told apart from the one which was cooked.
+		constexpr uint64_t PRIME = 0x100000001B3ull;
+		uint64_t hash = 0xCBF29CE484222325ull;
+
+		const auto data = mapped.getData();
+		size = mapped.getSize();
+		const size_t words = size / sizeof(uint64_t);
+		for (size_t i = 0; i < words; i++)
+		{
+			uint64_t word;
+			memcpy(&word, data + i * sizeof(uint64_t), sizeof(uint64_t));
+			hash = (hash ^ word) * PRIME;
+		}
+		for (size_t i = words * sizeof(uint64_t); i < size; i++)
+		{
+			hash = (hash ^ data[i]) * PRIME;
+		}
+		return hash == 0 ? 1 : hash;
+	}
+
+	auto MeshCache::write(const std::string& file, const ModelData& model, uint64_t sourceHash, uint64_t sourceSize) -> bool
+	{
+		PROFILE_FUNCTION();
+		std::string strings;
+		auto addString = [&](const std::string& str) {
+			StringRecord record{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(str.size()) };
+			strings += str;
+			return record;
+		};
+
+		std::vector<MaterialRecord> materialRecords(model.materials.size());
+		for (size_t i = 0; i < model.materials.size(); i++)
+		{
+			for (uint32_t j = 0; j < TextureCount; j++)
+			{
+				materialRecords[i].textures[j] = addString(model.materials[i].textures[j]);
+			}
+		}
+
+		FileHeader header{};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.sourceHash = sourceHash;
+		header.sourceSize = sourceSize;
+		header.meshCount = static_cast<uint32_t>(model.meshes.size());
+		header.materialCount = static_cast<uint32_t>(model.materials.size());
+		header.positionSize = sizeof(glm::vec3);
+		header.attributeSize = sizeof(VertexFormat::PackedAttributes);
+
+		std::vector<MeshRecord> meshRecords(model.meshes.size());
+		for (size_t i = 0; i < model.meshes.size(); i++)
+		{
+			meshRecords[i].name = addString(model.meshes[i].name);
+		}
+		header.stringSize = static_cast<uint32_t>(strings.size());
+
+		uint64_t offset = sizeof(FileHeader) + sizeof(MeshRecord) * meshRecords.size() + sizeof(MaterialRecord) * materialRecords.size() + strings.size();
+		for (size_t i = 0; i < model.meshes.size(); i++)
+		{
+			auto& mesh = model.meshes[i];
+			auto& record = meshRecords[i];
+			record.vertexCount = static_cast<uint32_t>(mesh.positions.size());
+			record.positionOffset = align(offset);
+			record.attributeOffset = align(record.positionOffset + sizeof(glm::vec3) * mesh.positions.size());
+			record.indexOffset = align(record.attributeOffset + sizeof(VertexFormat::PackedAttributes) * mesh.attributes.size());
+			record.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			offset = record.indexOffset + sizeof(uint32_t) * mesh.indices.size();
+			memcpy(record.min, &mesh.box.min, sizeof(record.min));
+			memcpy(record.max, &mesh.box.max, sizeof(record.max));
+			record.material = mesh.material;
+			record.lodCount = static_cast<uint32_t>(std::min<size_t>(mesh.lods.size(), MeshSimplifier::MAX_LODS));
+			std::copy(mesh.lods.begin(), mesh.lods.begin() + record.lodCount, record.lods);
+		}
+
+		//write to a temporary file first, a crash while cooking must not leave a broken file behind.
+		const std::string tmp = file + ".tmp";
+		{
+			std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				LOGW("Failed to write {0}", file);
+				return false;
+			}
+
+			uint64_t written = 0;
+			auto output = [&](const void* data, uint64_t size) {
+				out.write(reinterpret_cast<const char*>(data), size);
+				written += size;
+			};
+			auto pad = [&](uint64_t to) {
+				static const char zeros[BUFFER_ALIGNMENT] = {};
+				output(zeros, to - written);
+			};
+
+			output(&header, sizeof(FileHeader));
+			output(meshRecords.data(), sizeof(MeshRecord) * meshRecords.size());
+			output(materialRecords.data(), sizeof(MaterialRecord) * materialRecords.size());
+			output(strings.data(), strings.size());
+
+			for (size_t i = 0; i < model.meshes.size(); i++)
+			{
+				auto& mesh = model.meshes[i];
+				pad(meshRecords[i].positionOffset);
+				output(mesh.positions.data(), sizeof(glm::vec3) * mesh.positions.size());
+				pad(meshRecords[i].attributeOffset);
+				output(mesh.attributes.data(), sizeof(VertexFormat::PackedAttributes) * mesh.attributes.size());
+				pad(meshRecords[i].indexOffset);
+				output(mesh.indices.data(), sizeof(uint32_t) * mesh.indices.size());
+			}
+
+			if (!out)
+			{
+				LOGW("Failed to write {0}", file);
+				return false;
+			}
+		}
+		std::remove(file.c_str());
+		std::rename(tmp.c_str(), file.c_str());
+		return true;
+	}
+};
@@ -0,0 +1,105 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Engine/Vertex.h"
+#include "Engine/VertexFormat.h"
+#include "Engine/MeshSimplifier.h"
+#include "Math/BoundingBox.h"
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	class MappedFile;
+
+	//Cooked models : the vertex streams (see VertexFormat) and index buffer of every mesh as they are uploaded, their level of detail chain, their bounds and the
+	//texture names of their materials, next to a hash of the source file so a changed source is cooked again.
+	//The buffers are read in place from the mapped file.
+	namespace MeshCache
+	{
+		static constexpr uint32_t MAGIC = 0x48534D4D;//MMSH
+		static constexpr uint32_t VERSION = 4;
+		static constexpr const char* EXTENSION = ".mmesh";
+
+		enum MaterialTexture : uint32_t
+		{
+			Albedo,
+			Normal,
+			Roughness,
+			Metallic,
+			TextureCount
+		};
+
+		//texture names are relative to the directory of the model
+		struct MaterialData
+		{
+			std::string textures[TextureCount];
+		};
+
+		struct MeshData
+		{
+			std::string name;
+			std::vector<glm::vec3> positions;
+			std::vector<VertexFormat::PackedAttributes> attributes;
+			//every level of detail, lods holds their ranges
+			std::vector<uint32_t> indices;
+			std::vector<MeshLod> lods;
+			BoundingBox box;
+			int32_t material = -1;
+		};
+
+		struct ModelData
+		{
+			std::vector<MeshData> meshes;
+			std::vector<MaterialData> materials;
+		};
+
+		//a cooked file mapped into memory, the views are valid as long as the reader is alive.
+		class MAPLE_EXPORT Reader
+		{
+		public:
+			struct MeshView
+			{
+				std::string name;
+				const glm::vec3* positions = nullptr;
+				const VertexFormat::PackedAttributes* attributes = nullptr;
+				uint32_t vertexCount = 0;
+				const uint32_t* indices = nullptr;
+				uint32_t indexCount = 0;
+				std::vector<MeshLod> lods;
+				BoundingBox box;
+				int32_t material = -1;
+			};
+
+			Reader(const std::string& file);
+			~Reader();
+
+			//false if the file is missing, broken or has been written by another version
+			inline auto isValid() const { return valid; }
+			inline auto getSourceHash() const { return sourceHash; }
+			inline auto getSourceSize() const { return sourceSize; }
+			inline auto& getMeshes() const { return meshes; }
+			inline auto& getMaterials() const { return materials; }
+
+		private:
+			std::unique_ptr<MappedFile> mapped;
+			std::vector<MeshView> meshes;
+			std::vector<MaterialData> materials;
+			uint64_t sourceHash = 0;
+			uint64_t sourceSize = 0;
+			bool valid = false;
+		};
+
+		//model.obj -> model.mmesh
+		auto getCookedPath(const std::string& source) -> std::string;
+		//hash of the content, 0 if the file can not be read.
+		auto hashFile(const std::string& file, uint64_t& size) -> uint64_t;
+		auto write(const std::string& file, const ModelData& model, uint64_t sourceHash, uint64_t sourceSize) -> bool;
+	};
+};
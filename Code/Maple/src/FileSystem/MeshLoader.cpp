@@ -5,12 +5,20 @@
 
 
 #include "MeshLoader.h"
+#include "MeshCache.h"
+#include "VertexWelder.h"
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 #include "Engine/Material.h"
 #include "Others/StringUtils.h"
 #include "Engine/Interface/Texture.h"
 #include "Engine/Profiler.h"
+#include "Engine/MeshSimplifier.h"
+#include "Engine/MeshOptimizer.h"
+#include "Others/Console.h"
+#include <cstring>
+#include "Thread/ThreadPool.h"
+#include "Application.h"
 namespace Maple
 {
 	namespace MeshLoader
@@ -30,19 +38,21 @@ namespace Maple
 
 			{ // If texture hasn't been loaded already, load it
 				TextureLoadOptions options(false, true);
-				auto texture = std::shared_ptr<Texture2D>(Texture2D::create(typeName, directory + "/" + name));
+				auto texture = Application::get()->getAssetStreamer()->loadTexture(directory + "/" + name)->getTexture();
 				texturesLoaded.push_back(texture); // Store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
 				return texture;
 			}
 		}
 
-		auto load(const std::string& obj, std::unordered_map<std::string, std::shared_ptr<Mesh>>& meshes) -> void
+		auto getDirectory(const std::string& obj) -> std::string
 		{
-			PROFILE_FUNCTION();
-			std::string resolvedPath = obj;
-			auto directory = resolvedPath.substr(0, resolvedPath.find_last_of(StringUtils::delimiter));
-			std::string name = directory.substr(directory.find_last_of(StringUtils::delimiter) + 1);
+			return obj.substr(0, obj.find_last_of(StringUtils::delimiter));
+		}
 
+		auto parse(const std::string& obj, MeshCache::ModelData& model) -> void
+		{
+			PROFILE_FUNCTION();
+			auto directory = getDirectory(obj);
 
 			tinyobj::attrib_t attrib;
 			std::vector<tinyobj::shape_t> shapes;
@@ -53,10 +63,31 @@ namespace Maple
 				throw std::runtime_error(warn + err);
 			}
 
-			for (const auto& shape : shapes) {
+			for (auto& mp : materials)
+			{
+				auto& material = model.materials.emplace_back();
+				material.textures[MeshCache::Albedo] = mp.diffuse_texname;
+				material.textures[MeshCache::Normal] = mp.bump_texname;
+				material.textures[MeshCache::Roughness] = mp.roughness_texname;
+				material.textures[MeshCache::Metallic] = !mp.specular_highlight_texname.empty() ? mp.specular_highlight_texname : mp.metallic_texname;
+			}
+
+			//shapes are independent, every one is welded, shaded and simplified by its own job.
+			//the meshes keep the order of the shapes so the result does not depend on the scheduling.
+			model.meshes.resize(shapes.size());
+			std::vector<MeshOptimizer::CacheStatistics> before(shapes.size());
+			std::vector<MeshOptimizer::CacheStatistics> after(shapes.size());
+			const bool hasNormals = !attrib.normals.empty();
+
+			Application::get()->getThreadPool()->parallelFor(0, static_cast<int32_t>(shapes.size()), [&](int32_t i) {
+				PROFILE_SCOPE("MeshLoader::parse shape");
+				const auto& shape = shapes[i];
+				auto& mesh = model.meshes[i];
 				std::vector<Vertex> vertices;
-				std::vector<uint32_t> indices;
-				std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+				auto& indices = mesh.indices;
+
+				VertexWelder welder(shape.mesh.indices.size());
+				indices.reserve(shape.mesh.indices.size());
 
 				for (const auto& index : shape.mesh.indices) {
 					Vertex vertex{};
@@ -82,72 +113,116 @@ namespace Maple
 
 					vertex.color = { 1.0f, 1.0f, 1.0f,1.f };
 
-					if (uniqueVertices.count(vertex) == 0) {
-						uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-						vertices.push_back(vertex);
-					}
-
-					indices.emplace_back(uniqueVertices[vertex]);
+					bool inserted = false;
+					indices.emplace_back(welder.insert(vertex, vertices, inserted));
+					if (inserted)
+						mesh.box.merge(vertex.pos);
 				}
 
-				if (attrib.normals.empty())
+				if (!hasNormals)
 					Mesh::generateNormals(vertices, indices);
 
 				Mesh::generateTangents(vertices, indices);
 
-				auto pbrMaterial = std::make_shared<Material>();
+				mesh.name = shape.name;
+				mesh.material = shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[0];
 
-				PBRMataterialTextures textures;
+				const auto vertexCount = static_cast<uint32_t>(vertices.size());
+				before[i] = MeshOptimizer::analyzeVertexCache(indices.data(), static_cast<uint32_t>(indices.size()), vertexCount);
 
-				if (shape.mesh.material_ids[0] >= 0)
-				{
-					tinyobj::material_t* mp = &materials[shape.mesh.material_ids[0]];
+				MeshSimplifier::buildLods(vertices, indices, mesh.lods);
+				MeshOptimizer::optimize(vertices, indices, mesh.lods);
 
-					if (mp->diffuse_texname.length() > 0)
-					{
-						std::shared_ptr<Texture2D> texture = loadMaterialTextures("Albedo", texturesCache, mp->diffuse_texname, directory, TextureParameters(TextureFilter::NEAREST, TextureFilter::NEAREST, mp->diffuse_texopt.clamp ? TextureWrap::CLAMP_TO_EDGE : TextureWrap::REPEAT));
-						if (texture)
-							textures.albedo = texture;
-					}
+				after[i] = MeshOptimizer::analyzeVertexCache(indices.data(), mesh.lods[0].indexCount, vertexCount);
 
-					if (mp->bump_texname.length() > 0)
-					{
-						std::shared_ptr<Texture2D> texture = loadMaterialTextures("Normal", texturesCache, mp->bump_texname, directory, TextureParameters(TextureFilter::NEAREST, TextureFilter::NEAREST, mp->bump_texopt.clamp ? TextureWrap::CLAMP_TO_EDGE : TextureWrap::REPEAT));
-						if (texture)
-							textures.normal = texture; //pbrMaterial->SetNormalMap(texture);
-					}
+				//packed once here, cached meshes are uploaded as they are read
+				VertexFormat::pack(vertices.data(), static_cast<uint32_t>(vertices.size()), mesh.positions, mesh.attributes);
+			});
 
-					if (mp->roughness_texname.length() > 0)
-					{
-						std::shared_ptr<Texture2D> texture = loadMaterialTextures("Roughness", texturesCache, mp->roughness_texname.c_str(), directory, TextureParameters(TextureFilter::NEAREST, TextureFilter::NEAREST, mp->roughness_texopt.clamp ? TextureWrap::CLAMP_TO_EDGE : TextureWrap::REPEAT));
-						if (texture)
-							textures.roughness = texture;
-					}
+			MeshOptimizer::CacheStatistics total[2];
+			for (size_t i = 0; i < model.meshes.size(); i++)
+			{
+				total[0] += before[i];
+				total[1] += after[i];
+			}
+			LOGI("{0} : ACMR {1:.3f} -> {2:.3f}, ATVR {3:.3f} -> {4:.3f}", obj,
+				total[0].getAcmr(), total[1].getAcmr(), total[0].getAtvr(), total[1].getAtvr());
+		}
 
-					if (mp->metallic_texname.length() > 0)
+		auto createMaterial(const MeshCache::MaterialData* material, const std::string& directory) -> std::shared_ptr<Material>
+		{
+			auto pbrMaterial = std::make_shared<Material>();
+			PBRMataterialTextures textures;
+
+			if (material != nullptr)
+			{
+				std::shared_ptr<Texture2D>* targets[MeshCache::TextureCount] = { &textures.albedo, &textures.normal, &textures.roughness, &textures.metallic };
+				const char* names[MeshCache::TextureCount] = { "Albedo", "Normal", "Roughness", "Metallic" };
+				for (uint32_t i = 0; i < MeshCache::TextureCount; i++)
+				{
+					if (material->textures[i].length() > 0)
 					{
-						std::shared_ptr<Texture2D> texture = loadMaterialTextures("Metallic", texturesCache, mp->metallic_texname, directory, TextureParameters(TextureFilter::NEAREST, TextureFilter::NEAREST, mp->metallic_texopt.clamp ? TextureWrap::CLAMP_TO_EDGE : TextureWrap::REPEAT));
+						std::shared_ptr<Texture2D> texture = loadMaterialTextures(names[i], texturesCache, material->textures[i], directory, TextureParameters(TextureFilter::NEAREST, TextureFilter::NEAREST, TextureWrap::REPEAT));
 						if (texture)
-							textures.metallic = texture;
+							*targets[i] = texture;
 					}
+				}
+			}
+
+			pbrMaterial->setTextures(textures);
+			return pbrMaterial;
+		}
+
+		auto load(const std::string& obj, std::unordered_map<std::string, std::shared_ptr<Mesh>>& meshes) -> void
+		{
+			PROFILE_FUNCTION();
+			const auto directory = getDirectory(obj);
+			const auto cookedPath = MeshCache::getCookedPath(obj);
 
-					if (mp->specular_highlight_texname.length() > 0)
+			uint64_t sourceSize = 0;
+			const auto sourceHash = MeshCache::hashFile(obj, sourceSize);
+
+			{
+				MeshCache::Reader reader(cookedPath);
+				if (reader.isValid() && reader.getSourceHash() == sourceHash && reader.getSourceSize() == sourceSize)
+				{
+					auto& materials = reader.getMaterials();
+					for (auto& view : reader.getMeshes())
 					{
-						std::shared_ptr<Texture2D> texture = loadMaterialTextures("Metallic", texturesCache, mp->specular_highlight_texname, directory, TextureParameters(TextureFilter::NEAREST, TextureFilter::NEAREST, mp->specular_texopt.clamp ? TextureWrap::CLAMP_TO_EDGE : TextureWrap::REPEAT));
-						if (texture)
-							textures.metallic = texture;
+						auto mesh = std::make_shared<Mesh>(view.positions, view.attributes, view.vertexCount, view.indices, view.indexCount, view.box, view.lods);
+						mesh->setMaterial(createMaterial(view.material >= 0 ? &materials[view.material] : nullptr, directory));
+						mesh->setName(view.name);
+						meshes.emplace(view.name, mesh);
 					}
+					return;
 				}
-				pbrMaterial->setTextures(textures);
-
-				auto vb = std::make_shared<VertexBuffer>();
-				vb->setData(sizeof(vertices[0]) * vertices.size(), vertices.data());
-				auto ib = std::make_shared<IndexBuffer>(indices.data(), indices.size());
-				auto mesh = std::make_shared<Mesh>(vb, ib);
-				mesh->setMaterial(pbrMaterial);
-				mesh->setName(shape.name);
-				meshes.emplace(shape.name,mesh);
 			}
+
+			MeshCache::ModelData model;
+			parse(obj, model);
+			if (sourceHash != 0)
+				MeshCache::write(cookedPath, model, sourceHash, sourceSize);
+
+			for (auto& data : model.meshes)
+			{
+				auto mesh = std::make_shared<Mesh>(data.positions.data(), data.attributes.data(), static_cast<uint32_t>(data.positions.size()),
+					data.indices.data(), static_cast<uint32_t>(data.indices.size()), data.box, data.lods);
+				mesh->setMaterial(createMaterial(data.material >= 0 ? &model.materials[data.material] : nullptr, directory));
+				mesh->setName(data.name);
+				meshes.emplace(data.name, mesh);
+			}
+		}
+
+		auto cook(const std::string& obj) -> bool
+		{
+			uint64_t sourceSize = 0;
+			const auto sourceHash = MeshCache::hashFile(obj, sourceSize);
+			if (sourceHash == 0)
+				return false;
+
+			MeshCache::ModelData model;
+			parse(obj, model);
+			return MeshCache::write(MeshCache::getCookedPath(obj), model, sourceHash, sourceSize);
 		}
 
 	};
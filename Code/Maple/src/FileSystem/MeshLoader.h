@@ -15,6 +15,9 @@ namespace Maple
 {
 	namespace MeshLoader
 	{
+		//loads the cooked model next to the obj if it has been cooked from the same file, otherwise parses and cooks it.
 		auto load(const std::string& obj, std::unordered_map<std::string, std::shared_ptr<Mesh>>&)-> void;
+		//writes the cooked model (model.obj -> model.mmesh), returns false if the source can not be read.
+		auto cook(const std::string& obj) -> bool;
 	};
 };
@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "Engine/Vertex.h"
+
+namespace Maple
+{
+	//Vertex welding with open addressing, the table holds indices into the vertex list.
+	//Keys are the packed bits of the attributes the obj can set, equality is the one of Vertex.
+	//The numbering is the one of first occurrence, the same as welding with std::unordered_map.
+	class VertexWelder
+	{
+	public:
+		VertexWelder(size_t maxVertices)
+		{
+			size_t capacity = 16;
+			while (capacity < maxVertices * 2)
+				capacity *= 2;
+			slots.assign(capacity, EMPTY);
+			mask = capacity - 1;
+		}
+
+		auto insert(const Vertex& vertex, std::vector<Vertex>& vertices, bool& inserted) -> uint32_t
+		{
+			for (auto i = hash(vertex) & mask;; i = (i + 1) & mask)
+			{
+				const auto slot = slots[i];
+				if (slot == EMPTY)
+				{
+					slots[i] = static_cast<uint32_t>(vertices.size());
+					vertices.emplace_back(vertex);
+					inserted = true;
+					return slots[i];
+				}
+
+				if (vertices[slot] == vertex)
+				{
+					inserted = false;
+					return slot;
+				}
+			}
+		}
+
+	private:
+		static constexpr uint32_t EMPTY = UINT32_MAX;
+
+		//-0 and 0 are the same vertex
+		static inline auto floatBits(float value) -> uint64_t
+		{
+			if (value == 0.f)
+				return 0;
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(float));
+			return bits;
+		}
+
+		static inline auto hash(const Vertex& vertex) -> uint64_t
+		{
+			const uint64_t keys[4] = {
+				(floatBits(vertex.pos.x) << 32) | floatBits(vertex.pos.y),
+				(floatBits(vertex.pos.z) << 32) | floatBits(vertex.normal.x),
+				(floatBits(vertex.normal.y) << 32) | floatBits(vertex.normal.z),
+				(floatBits(vertex.texCoord.x) << 32) | floatBits(vertex.texCoord.y)
+			};
+
+			uint64_t h = 0;
+			for (auto key : keys)
+			{
+				h = (h ^ key) * 0x9E3779B97F4A7C15ull;
+				h ^= h >> 29;
+			}
+			return h;
+		}
+
+		std::vector<uint32_t> slots;
+		size_t mask = 0;
+	};
+};
@@ -2,11 +2,16 @@
 
 namespace Maple 
 {
-	auto BoundingBox::transform(const glm::mat4& transform) -> BoundingBox
+	auto BoundingBox::transform(const glm::mat4& transform) const -> BoundingBox
 	{
-		auto min = transform * glm::vec4(this->min, 1.f);
-		auto max = transform * glm::vec4(this->max, 1.f);
-		return {min,max};
+		if (!isDefined())
+			return {};
+		//transform the center and extent instead of two corners, so rotated boxes stay conservative.
+		const glm::vec3 center = transform * glm::vec4(this->center(), 1.f);
+		const glm::vec3 extent = size() * 0.5f;
+		const glm::mat3 absMat = { glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])) };
+		const glm::vec3 newExtent = absMat * extent;
+		return { center - newExtent, center + newExtent };
 	}
 };
 
@@ -54,7 +54,7 @@ namespace Maple
 				max.z = box.max.z;
 		}
 
-		auto transform(const glm::mat4 & transform) ->BoundingBox;
+		auto transform(const glm::mat4 & transform) const ->BoundingBox;
 
 		inline auto clear() -> void
 		{
@@ -0,0 +1,269 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicAABBTree.h"
+#include <algorithm>
+
+namespace Maple
+{
+	namespace
+	{
+		inline auto surfaceArea(const BoundingBox& box) -> float
+		{
+			const auto d = box.max - box.min;
+			return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		inline auto combine(const BoundingBox& a, const BoundingBox& b) -> BoundingBox
+		{
+			return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+		}
+
+		inline auto contains(const BoundingBox& outer, const BoundingBox& inner) -> bool
+		{
+			return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+				inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+		}
+	};
+
+	DynamicAABBTree::DynamicAABBTree(float margin)
+		:margin(margin)
+	{
+	}
+
+	auto DynamicAABBTree::createProxy(const BoundingBox& box, uint32_t userData) -> int32_t
+	{
+		const int32_t proxyId = allocateNode();
+		auto& node = nodes[proxyId];
+		node.box = { box.min - glm::vec3(margin), box.max + glm::vec3(margin) };
+		node.userData = userData;
+		node.height = 0;
+		insertLeaf(proxyId);
+		proxyCount++;
+		return proxyId;
+	}
+
+	auto DynamicAABBTree::destroyProxy(int32_t proxyId) -> void
+	{
+		removeLeaf(proxyId);
+		freeNode(proxyId);
+		proxyCount--;
+	}
+
+	auto DynamicAABBTree::moveProxy(int32_t proxyId, const BoundingBox& box) -> bool
+	{
+		if (contains(nodes[proxyId].box, box))
+			return false;
+
+		removeLeaf(proxyId);
+		nodes[proxyId].box = { box.min - glm::vec3(margin), box.max + glm::vec3(margin) };
+		insertLeaf(proxyId);
+		return true;
+	}
+
+	auto DynamicAABBTree::clear() -> void
+	{
+		nodes.clear();
+		root = NULL_NODE;
+		freeList = NULL_NODE;
+		proxyCount = 0;
+	}
+
+	auto DynamicAABBTree::allocateNode() -> int32_t
+	{
+		if (freeList == NULL_NODE)
+		{
+			nodes.emplace_back();
+			return static_cast<int32_t>(nodes.size() - 1);
+		}
+		const int32_t id = freeList;
+		freeList = nodes[id].parent;
+		nodes[id] = Node{};
+		return id;
+	}
+
+	auto DynamicAABBTree::freeNode(int32_t node) -> void
+	{
+		nodes[node].parent = freeList;
+		nodes[node].height = -1;
+		freeList = node;
+	}
+
+	auto DynamicAABBTree::insertLeaf(int32_t leaf) -> void
+	{
+		if (root == NULL_NODE)
+		{
+			root = leaf;
+			nodes[root].parent = NULL_NODE;
+			return;
+		}
+
+		// Find the best sibling with the surface area heuristic.
+		const auto leafBox = nodes[leaf].box;
+		int32_t index = root;
+		while (!nodes[index].isLeaf())
+		{
+			const auto& node = nodes[index];
+			const int32_t child1 = node.child1;
+			const int32_t child2 = node.child2;
+
+			const float area = surfaceArea(node.box);
+			const float combinedArea = surfaceArea(combine(node.box, leafBox));
+
+			// Cost of creating a new parent for this node and the new leaf
+			const float cost = 2.0f * combinedArea;
+			// Minimum cost of pushing the leaf further down the tree
+			const float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](int32_t child) {
+				const auto box = combine(leafBox, nodes[child].box);
+				if (nodes[child].isLeaf())
+					return surfaceArea(box) + inheritanceCost;
+				return surfaceArea(box) - surfaceArea(nodes[child].box) + inheritanceCost;
+			};
+
+			const float cost1 = descendCost(child1);
+			const float cost2 = descendCost(child2);
+
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = cost1 < cost2 ? child1 : child2;
+		}
+
+		const int32_t sibling = index;
+		const int32_t oldParent = nodes[sibling].parent;
+		const int32_t newParent = allocateNode();
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].box = combine(leafBox, nodes[sibling].box);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].child1 = sibling;
+		nodes[newParent].child2 = leaf;
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		if (oldParent != NULL_NODE)
+		{
+			if (nodes[oldParent].child1 == sibling)
+				nodes[oldParent].child1 = newParent;
+			else
+				nodes[oldParent].child2 = newParent;
+		}
+		else
+		{
+			root = newParent;
+		}
+
+		// Walk back up the tree fixing heights and boxes
+		index = nodes[leaf].parent;
+		while (index != NULL_NODE)
+		{
+			index = balance(index);
+			auto& node = nodes[index];
+			node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+			node.box = combine(nodes[node.child1].box, nodes[node.child2].box);
+			index = node.parent;
+		}
+	}
+
+	auto DynamicAABBTree::removeLeaf(int32_t leaf) -> void
+	{
+		if (leaf == root)
+		{
+			root = NULL_NODE;
+			return;
+		}
+
+		const int32_t parent = nodes[leaf].parent;
+		const int32_t grandParent = nodes[parent].parent;
+		const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+		if (grandParent != NULL_NODE)
+		{
+			if (nodes[grandParent].child1 == parent)
+				nodes[grandParent].child1 = sibling;
+			else
+				nodes[grandParent].child2 = sibling;
+			nodes[sibling].parent = grandParent;
+			freeNode(parent);
+
+			int32_t index = grandParent;
+			while (index != NULL_NODE)
+			{
+				index = balance(index);
+				auto& node = nodes[index];
+				node.box = combine(nodes[node.child1].box, nodes[node.child2].box);
+				node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+				index = node.parent;
+			}
+		}
+		else
+		{
+			root = sibling;
+			nodes[sibling].parent = NULL_NODE;
+			freeNode(parent);
+		}
+	}
+
+	// Perform a left or right rotation if node A is imbalanced.
+	// Returns the new root index.
+	auto DynamicAABBTree::balance(int32_t iA) -> int32_t
+	{
+		auto& A = nodes[iA];
+		if (A.isLeaf() || A.height < 2)
+			return iA;
+
+		const int32_t iB = A.child1;
+		const int32_t iC = A.child2;
+
+		const int32_t diff = nodes[iC].height - nodes[iB].height;
+
+		auto rotate = [&](int32_t iUp, int32_t iDown) -> int32_t {
+			// iUp is the taller child and becomes the new root of the subtree, iDown stays under A.
+			auto& up = nodes[iUp];
+			const int32_t iF = up.child1;
+			const int32_t iG = up.child2;
+
+			up.child1 = iA;
+			up.parent = A.parent;
+			A.parent = iUp;
+
+			if (up.parent != NULL_NODE)
+			{
+				if (nodes[up.parent].child1 == iA)
+					nodes[up.parent].child1 = iUp;
+				else
+					nodes[up.parent].child2 = iUp;
+			}
+			else
+			{
+				root = iUp;
+			}
+
+			const bool keepF = nodes[iF].height > nodes[iG].height;
+			const int32_t iKeep = keepF ? iF : iG;
+			const int32_t iMove = keepF ? iG : iF;
+
+			up.child2 = iKeep;
+			if (A.child1 == iUp)
+				A.child1 = iMove;
+			else
+				A.child2 = iMove;
+			nodes[iMove].parent = iA;
+
+			A.box = combine(nodes[iDown].box, nodes[iMove].box);
+			up.box = combine(A.box, nodes[iKeep].box);
+			A.height = 1 + std::max(nodes[iDown].height, nodes[iMove].height);
+			up.height = 1 + std::max(A.height, nodes[iKeep].height);
+			return iUp;
+		};
+
+		if (diff > 1)
+			return rotate(iC, iB);
+		if (diff < -1)
+			return rotate(iB, iC);
+		return iA;
+	}
+};
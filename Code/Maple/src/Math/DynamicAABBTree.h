@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "Frustum.h"
+#include "Ray.h"
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	//Dynamic AABB tree (incremental insert/remove with AVL rotations).
+	//Leaves store a fat box so small movements do not touch the tree.
+	class MAPLE_EXPORT DynamicAABBTree
+	{
+	public:
+		static constexpr int32_t NULL_NODE = -1;
+
+		DynamicAABBTree(float margin = 0.1f);
+
+		auto createProxy(const BoundingBox& box, uint32_t userData) -> int32_t;
+		auto destroyProxy(int32_t proxyId) -> void;
+		//returns true if the proxy was re-inserted.
+		auto moveProxy(int32_t proxyId, const BoundingBox& box) -> bool;
+		auto clear() -> void;
+
+		inline auto getUserData(int32_t proxyId) const { return nodes[proxyId].userData; }
+		inline auto& getFatBox(int32_t proxyId) const { return nodes[proxyId].box; }
+		inline auto getProxyCount() const { return proxyCount; }
+		inline auto getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+		//callback : (int32_t proxyId) -> bool, return false to stop the query.
+		template<typename Callback>
+		auto query(const BoundingBox& box, Callback&& callback) const -> void;
+
+		template<typename Callback>
+		auto query(const glm::vec3& center, float radius, Callback&& callback) const -> void;
+
+		template<typename Callback>
+		auto query(const Frustum& frustum, Callback&& callback, bool testNear = true) const -> void;
+
+		//callback : (int32_t proxyId, float maxDistance) -> float, returns the new max distance (clipping the ray).
+		//return 0 to stop the cast.
+		template<typename Callback>
+		auto rayCast(const Ray& ray, Callback&& callback, float maxDistance = INFINITY) const -> void;
+
+	private:
+		struct Node
+		{
+			BoundingBox box;
+			uint32_t userData = 0;
+			//parent, or next free node when the node is in the free list.
+			int32_t parent = NULL_NODE;
+			int32_t child1 = NULL_NODE;
+			int32_t child2 = NULL_NODE;
+			//leaf = 0, free node = -1
+			int32_t height = -1;
+
+			inline auto isLeaf() const { return child1 == NULL_NODE; }
+		};
+
+		template<typename Visit, typename Callback>
+		auto traverse(Visit&& visit, Callback&& callback) const -> void;
+
+		auto allocateNode() -> int32_t;
+		auto freeNode(int32_t node) -> void;
+		auto insertLeaf(int32_t leaf) -> void;
+		auto removeLeaf(int32_t leaf) -> void;
+		auto balance(int32_t node) -> int32_t;
+
+		std::vector<Node> nodes;
+		int32_t root = NULL_NODE;
+		int32_t freeList = NULL_NODE;
+		uint32_t proxyCount = 0;
+		float margin = 0.1f;
+	};
+
+	template<typename Visit, typename Callback>
+	auto DynamicAABBTree::traverse(Visit&& visit, Callback&& callback) const -> void
+	{
+		if (root == NULL_NODE)
+			return;
+
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+		stack.emplace_back(root);
+
+		while (!stack.empty())
+		{
+			const int32_t id = stack.back();
+			stack.pop_back();
+
+			const auto& node = nodes[id];
+			if (!visit(node.box))
+				continue;
+
+			if (node.isLeaf())
+			{
+				if (!callback(id))
+					return;
+			}
+			else
+			{
+				stack.emplace_back(node.child1);
+				stack.emplace_back(node.child2);
+			}
+		}
+	}
+
+	template<typename Callback>
+	auto DynamicAABBTree::query(const BoundingBox& box, Callback&& callback) const -> void
+	{
+		traverse([&](const BoundingBox& nodeBox) {
+			return !(nodeBox.max.x < box.min.x || nodeBox.min.x > box.max.x ||
+				nodeBox.max.y < box.min.y || nodeBox.min.y > box.max.y ||
+				nodeBox.max.z < box.min.z || nodeBox.min.z > box.max.z);
+		}, callback);
+	}
+
+	template<typename Callback>
+	auto DynamicAABBTree::query(const glm::vec3& center, float radius, Callback&& callback) const -> void
+	{
+		const float radius2 = radius * radius;
+		traverse([&](const BoundingBox& nodeBox) {
+			const auto dist = glm::clamp(center, nodeBox.min, nodeBox.max) - center;
+			return glm::dot(dist, dist) <= radius2;
+		}, callback);
+	}
+
+	template<typename Callback>
+	auto DynamicAABBTree::query(const Frustum& frustum, Callback&& callback, bool testNear) const -> void
+	{
+		traverse([&](const BoundingBox& nodeBox) {
+			return frustum.isInside(nodeBox, testNear);
+		}, callback);
+	}
+
+	template<typename Callback>
+	auto DynamicAABBTree::rayCast(const Ray& ray, Callback&& callback, float maxDistance) const -> void
+	{
+		traverse([&](const BoundingBox& nodeBox) {
+			const float dist = ray.hit(nodeBox);
+			return dist < INFINITY && dist <= maxDistance;
+		}, [&](int32_t proxyId) {
+			maxDistance = callback(proxyId, maxDistance);
+			return maxDistance > 0.f;
+		});
+	}
+};
@@ -4,7 +4,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "Frustum.h"
-
+#include "BoundingBox.h"
 
 namespace Maple
 {
@@ -28,6 +28,65 @@ namespace Maple
 			auto invCorner = projInverse * glm::vec4(frustumCorners[j], 1.0f);
 			vertices[j] = invCorner / invCorner.w;
 		}
+
+		// Gribb-Hartmann plane extraction, the depth range is [0,1] (Vulkan).
+		const glm::vec4 row0 = { projection[0][0], projection[1][0], projection[2][0], projection[3][0] };
+		const glm::vec4 row1 = { projection[0][1], projection[1][1], projection[2][1], projection[3][1] };
+		const glm::vec4 row2 = { projection[0][2], projection[1][2], projection[2][2], projection[3][2] };
+		const glm::vec4 row3 = { projection[0][3], projection[1][3], projection[2][3], projection[3][3] };
+
+		planes[PLANE_NEAR]  = row2;
+		planes[PLANE_LEFT]  = row3 + row0;
+		planes[PLANE_RIGHT] = row3 - row0;
+		planes[PLANE_UP]    = row3 - row1;
+		planes[PLANE_DOWN]  = row3 + row1;
+		planes[PLANE_FAR]   = row3 - row2;
+
+		for (auto & plane : planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	auto Frustum::isInside(const glm::vec3& point) const -> bool
+	{
+		for (auto& plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), point) + plane.w < 0.f)
+				return false;
+		}
+		return true;
+	}
+
+	auto Frustum::isInside(const glm::vec3& center, float radius, bool testNear) const -> bool
+	{
+		for (uint32_t i = testNear ? PLANE_NEAR : PLANE_NEAR + 1; i < FRUSTUM_PLANES; i++)
+		{
+			auto& plane = planes[i];
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+		return true;
+	}
+
+	auto Frustum::isInside(const BoundingBox& box, bool testNear) const -> bool
+	{
+		if (!box.isDefined())
+			return true;
+
+		const auto center = box.center();
+		const auto extent = box.size() * 0.5f;
+
+		for (uint32_t i = testNear ? PLANE_NEAR : PLANE_NEAR + 1; i < FRUSTUM_PLANES; i++)
+		{
+			auto& plane = planes[i];
+			const glm::vec3 normal = plane;
+			//projected radius of the box onto the plane normal
+			const float radius = glm::dot(extent, glm::abs(normal));
+			if (glm::dot(normal, center) + plane.w < -radius)
+				return false;
+		}
+		return true;
 	}
 
-};
\ No newline at end of file
+};
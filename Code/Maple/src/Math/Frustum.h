@@ -10,6 +10,17 @@
 #include "Engine/Core.h"
 namespace Maple
 {
+	class BoundingBox;
+
+	enum FrustumPlane
+	{
+		PLANE_NEAR = 0,
+		PLANE_LEFT,
+		PLANE_RIGHT,
+		PLANE_UP,
+		PLANE_DOWN,
+		PLANE_FAR,
+	};
 
 	class MAPLE_EXPORT Frustum
 	{
@@ -19,15 +30,25 @@ namespace Maple
 		friend class ShadowRenderer;
 
 		static constexpr uint32_t FRUSTUM_VERTICES = 8;
+		static constexpr uint32_t FRUSTUM_PLANES = 6;
 
 		Frustum() noexcept = default;
 		
 		auto from(const glm::mat4 & projection) -> void;
 
+		//plane test, returns false only when the volume is completely outside one of the planes.
+		//testNear = false extends the volume infinitely behind the near plane (e.g. shadow casters).
+		auto isInside(const glm::vec3& point) const -> bool;
+		auto isInside(const glm::vec3& center, float radius, bool testNear = true) const -> bool;
+		auto isInside(const BoundingBox& box, bool testNear = true) const -> bool;
 
+		inline auto& getPlane(FrustumPlane plane) const { return planes[plane]; }
+		inline auto& getVertices() const { return vertices; }
 
 	private:
 		glm::vec3 vertices[FRUSTUM_VERTICES];
+		//xyz is the normal pointing inside, w is the distance.
+		glm::vec4 planes[FRUSTUM_PLANES];
 	};
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Game Engine			                    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+#include <streambuf>
+#include <vector>
+#include <entt/entt.hpp>
+#include <cereal/cereal.hpp>
+#include <cereal/archives/binary.hpp>
+
+namespace Maple
+{
+	//layout of the registry in a .mscene file, the header and the scene settings are written by Serialization.
+	namespace BinaryScene
+	{
+		//cereal reads straight from the mapped file, nothing is copied.
+		class MemoryBuffer : public std::streambuf
+		{
+		public:
+			MemoryBuffer(const uint8_t* data, size_t size)
+			{
+				auto begin = reinterpret_cast<char*>(const_cast<uint8_t*>(data));
+				setg(begin, begin, begin + size);
+			}
+		};
+
+		//all entities, including the released ones so the identifiers and versions are kept
+		inline auto writeEntities(cereal::BinaryOutputArchive& output, entt::registry& registry) -> void
+		{
+			const uint32_t size = static_cast<uint32_t>(registry.size());
+			output(size);
+			output(cereal::binary_data(registry.data(), sizeof(entt::entity) * size));
+		}
+
+		inline auto readEntities(cereal::BinaryInputArchive& input, entt::registry& registry) -> void
+		{
+			uint32_t size = 0;
+			input(size);
+			std::vector<entt::entity> entities(size);
+			input(cereal::binary_data(entities.data(), sizeof(entt::entity) * size));
+			registry.assign(entities.begin(), entities.end());
+		}
+
+		//every component type is stored as one packed entity array followed by the components in the same order.
+		template<typename Component>
+		auto writeComponents(cereal::BinaryOutputArchive& output, entt::registry& registry) -> void
+		{
+			auto view = registry.view<Component>();
+			const uint32_t size = static_cast<uint32_t>(view.size());
+			output(size);
+			output(cereal::binary_data(view.data(), sizeof(entt::entity) * size));
+			auto components = view.raw();
+			for (uint32_t i = 0; i < size; ++i)
+			{
+				output(components[i]);
+			}
+		}
+
+		template<typename Component>
+		auto readComponents(cereal::BinaryInputArchive& input, entt::registry& registry) -> void
+		{
+			uint32_t size = 0;
+			input(size);
+			std::vector<entt::entity> entities(size);
+			input(cereal::binary_data(entities.data(), sizeof(entt::entity) * size));
+			std::vector<Component> components(size);
+			for (auto& component : components)
+			{
+				input(component);
+			}
+			registry.insert<Component>(entities.begin(), entities.end(),
+				std::make_move_iterator(components.begin()), std::make_move_iterator(components.end()));
+		}
+
+		template<typename... Components>
+		auto writeAll(cereal::BinaryOutputArchive& output, entt::registry& registry) -> void
+		{
+			(writeComponents<Components>(output, registry), ...);
+		}
+
+		template<typename... Components>
+		auto readAll(cereal::BinaryInputArchive& input, entt::registry& registry) -> void
+		{
+			(readComponents<Components>(input, registry), ...);
+		}
+	};
+};
@@ -11,12 +11,20 @@
 #include "Engine/Camera.h"
 #include "Engine/Mesh.h"
 #include "FileSystem/File.h"
+#include "FileSystem/MappedFile.h"
+#include "Others/StringUtils.h"
+#include "Others/Console.h"
+#include "Others/Timer.h"
+#include "Others/BinaryScene.h"
+#include "Engine/Profiler.h"
 
 
 #include <cereal/cereal.hpp>
 #include <cereal/archives/json.hpp>
+#include <cereal/archives/binary.hpp>
 
 #include <sstream>
+#include <fstream>
 #include <filesystem>
 
 #define ALL_COMPONENTS Transform, \
@@ -33,6 +41,63 @@ Environment
 
 namespace Maple
 {
+	namespace
+	{
+		auto loadJson(Scene* scene, const std::string& file) -> void
+		{
+			File f(file);
+			auto buffer = f.getBuffer();
+			std::istringstream istr;
+			istr.str((const char*)buffer.get());
+			cereal::JSONInputArchive input(istr);
+			input(*scene);
+			entt::snapshot_loader{ scene->getRegistry() }.entities(input).component<ALL_COMPONENTS>(input);
+		}
+
+		auto loadBinary(Scene* scene, const std::string& file) -> bool
+		{
+			MappedFile mapped(file);
+			if (!mapped.isValid())
+				return false;
+
+			BinaryScene::MemoryBuffer buffer(mapped.getData(), mapped.getSize());
+			std::istream stream(&buffer);
+			cereal::BinaryInputArchive input(stream);
+
+			auto& registry = scene->getRegistry();
+			try
+			{
+				//a truncated file throws here as well and falls back to json
+				uint32_t magic = 0;
+				uint32_t version = 0;
+				input(magic, version);
+				if (magic != Serialization::BINARY_SCENE_MAGIC || version != Serialization::BINARY_SCENE_VERSION)
+				{
+					LOGW("{0} is not a binary scene or has an old version ({1})", file, version);
+					return false;
+				}
+
+				input(*scene);
+				BinaryScene::readEntities(input, registry);
+				BinaryScene::readAll<ALL_COMPONENTS>(input, registry);
+			}
+			catch (const cereal::Exception& e)
+			{
+				LOGE("Failed to load {0} : {1}", file, e.what());
+				registry.clear();
+				return false;
+			}
+			return true;
+		}
+	};
+
+	auto Serialization::getBinaryPath(const std::string& file) -> std::string
+	{
+		if (StringUtils::endWith(file, BINARY_SCENE_EXTENSION))
+			return file;
+		return StringUtils::removeExtension(file) + BINARY_SCENE_EXTENSION;
+	}
+
 	auto Serialization::serialize(Scene* scene) -> void
 	{
 		auto outPath = scene->getPath();
@@ -51,15 +116,63 @@ namespace Maple
 		file.write(storage.str());
 	}
 
+	auto Serialization::serializeBinary(Scene* scene, const std::string& file) -> void
+	{
+		PROFILE_FUNCTION();
+		std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+		if (!stream)
+		{
+			LOGE("Failed to open {0}", file);
+			return;
+		}
+
+		auto& registry = scene->getRegistry();
+		cereal::BinaryOutputArchive output{ stream };
+		output(BINARY_SCENE_MAGIC, BINARY_SCENE_VERSION);
+		output(*scene);
+		BinaryScene::writeEntities(output, registry);
+		BinaryScene::writeAll<ALL_COMPONENTS>(output, registry);
+	}
+
 	auto Serialization::loadScene(Scene* scene, const std::string& file) -> void
 	{
-		File f(file);
-		auto buffer = f.getBuffer();
-		std::istringstream istr;
-		istr.str((const char*)buffer.get());
-		cereal::JSONInputArchive input(istr);
-		input(*scene);
-		entt::snapshot_loader{ scene->getRegistry() }.entities(input).component<ALL_COMPONENTS>(input);
+		PROFILE_FUNCTION();
+		Timer timer;
+		const auto start = timer.current();
+
+		const auto binaryFile = getBinaryPath(file);
+		bool loaded = false;
+		if (File::fileExists(binaryFile))
+		{
+			//a cooked scene older than its json source is stale
+			std::error_code error;
+			const bool upToDate = binaryFile == file || !File::fileExists(file) ||
+				std::filesystem::last_write_time(binaryFile, error) >= std::filesystem::last_write_time(file, error);
+			if (upToDate)
+				loaded = loadBinary(scene, binaryFile);
+		}
+
+		if (!loaded && binaryFile != file)
+		{
+			loadJson(scene, file);
+		}
+
+		LOGI("Load scene {0} ({1}) : {2} ms", file, loaded ? "binary" : "json", timer.elapsed(start, timer.current()) / 1000.f);
 	}
 
+	auto Serialization::convertToBinary(const std::string& file, const std::string& outFile) -> bool
+	{
+		PROFILE_FUNCTION();
+		if (!File::fileExists(file))
+		{
+			LOGE("{0} does not exist", file);
+			return false;
+		}
+
+		Scene scene(StringUtils::removeExtension(StringUtils::getFileName(file)));
+		scene.setPath(file);
+		scene.loadFrom();
+		serializeBinary(&scene, outFile == "" ? getBinaryPath(file) : outFile);
+		return true;
+	}
 };
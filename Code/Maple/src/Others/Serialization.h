@@ -3,6 +3,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include <string>
+#include <cstdint>
 #include <glm/glm.hpp>
 
 
@@ -37,7 +38,17 @@ namespace Maple
 
 	namespace Serialization
 	{
+		//binary scenes start with this tag followed by the format version
+		static constexpr uint32_t BINARY_SCENE_MAGIC = 0x4E43534D;//MSCN
+		static constexpr uint32_t BINARY_SCENE_VERSION = 1;
+		static constexpr const char* BINARY_SCENE_EXTENSION = ".mscene";
+
 		auto serialize(Scene* scene) -> void;
+		auto serializeBinary(Scene* scene, const std::string& file) -> void;
+		//json or binary, a cooked .mscene newer than the json scene is loaded instead.
 		auto loadScene(Scene* scene,const std::string & file) -> void;
+		//cook a json scene into the binary format, outFile defaults to the scene path with the .mscene extension.
+		auto convertToBinary(const std::string& file, const std::string& outFile = "") -> bool;
+		auto getBinaryPath(const std::string& file) -> std::string;
 	};
 };
@@ -13,6 +13,16 @@
 
 namespace Maple
 {
+	namespace
+	{
+		uint32_t hierarchyVersion = 0;
+	};
+
+	auto Hierarchy::getVersion() -> uint32_t
+	{
+		return hierarchyVersion;
+	}
+
 	Hierarchy::Hierarchy(entt::entity p)
 		:parent(p)
 	{
@@ -56,6 +66,7 @@ namespace Maple
 
 	void Hierarchy::onConstruct(entt::registry& registry, entt::entity entity)
 	{
+		hierarchyVersion++;
 		auto& hierarchy = registry.get<Hierarchy>(entity);
 		if (hierarchy.parent != entt::null) 
 		{
@@ -83,6 +94,7 @@ namespace Maple
 
 	void Hierarchy::onDestroy(entt::registry& registry, entt::entity entity)
 	{
+		hierarchyVersion++;
 		auto& hierarchy = registry.get<Hierarchy>(entity);
 		if (hierarchy.prev == entt::null || !registry.valid(hierarchy.prev))
 		{
@@ -123,6 +135,7 @@ namespace Maple
 
 	void Hierarchy::onUpdate(entt::registry& registry, entt::entity entity)
 	{
+		hierarchyVersion++;
 		auto& hierarchy = registry.get<Hierarchy>(entity);
 		// if is the first child
 		if (hierarchy.prev == entt::null)
@@ -164,6 +177,7 @@ namespace Maple
 
 	void Hierarchy::reparent(entt::entity ent, entt::entity parent, entt::registry& registry, Hierarchy& hierarchy)
 	{
+		hierarchyVersion++;
 		Hierarchy::onDestroy(registry, ent);
 
 		hierarchy.parent = entt::null;
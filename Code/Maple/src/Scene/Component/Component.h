@@ -79,6 +79,9 @@ namespace Maple
 		//adjust the parent 
 		static auto reparent(entt::entity entity, entt::entity parent, entt::registry& registry, Hierarchy& hierarchy) -> void;
 
+		//increased every time a parent/child link changes, the SceneGraph rebuilds its node order when it differs.
+		static auto getVersion() -> uint32_t;
+
 		entt::entity parent = entt::null;
 		entt::entity first = entt::null;
 		entt::entity next = entt::null;
@@ -7,12 +7,20 @@
 #include "ImGui/ImGuiHelpers.h"
 #include "Scene/Component/Transform.h"
 #include "Engine/Mesh.h"
+#include "Math/BoundingBox.h"
 
 #include <imgui.h>
+#include <cmath>
 
 
 namespace Maple
 {
+	namespace
+	{
+		//a coarser level has to be clearly under the threshold, a mesh sitting on it would switch every frame
+		constexpr float LOD_HYSTERESIS = 0.75f;
+		constexpr float LOD_MIN_DISTANCE = 0.01f;
+	};
 
 	MeshRenderer::MeshRenderer(const std::shared_ptr<Mesh>& mesh)
 		:mesh(mesh)
@@ -52,6 +60,41 @@ namespace Maple
 		}
 	}
 
+	auto MeshRenderer::selectLod(const glm::mat4& transform, const glm::vec3& eye, float pixelsPerUnit, float bias) -> uint32_t
+	{
+		auto current = getMesh();
+		if (current == nullptr || current->getLodCount() == 1)
+			return lod = 0;
+
+		const auto& box = *current->getBoundingBox();
+		const float scale = std::max(glm::length(glm::vec3(transform[0])), std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+		const auto center = glm::vec3(transform * glm::vec4(box.center(), 1.f));
+		const float radius = glm::length(box.size()) * 0.5f * scale;
+		const float distance = std::max(glm::length(center - eye) - radius, LOD_MIN_DISTANCE);
+
+		const float threshold = std::exp2(bias);
+		auto projected = [&](uint32_t level) {
+			return current->getLod(level).error * scale * pixelsPerUnit / distance;
+		};
+
+		uint32_t target = 0;
+		for (uint32_t i = current->getLodCount() - 1; i > 0; i--)
+		{
+			if (projected(i) <= threshold)
+			{
+				target = i;
+				break;
+			}
+		}
+
+		//finer levels are taken at once, coarser ones only past the hysteresis
+		while (target > lod && projected(target) > threshold * LOD_HYSTERESIS)
+			target--;
+
+		lod = target;
+		return lod;
+	}
+
 	Model::Model(const std::string& file)
 		:filePath(file)
 	{
@@ -79,12 +79,18 @@ namespace Maple
 
 		inline auto getMesh() { if (mesh == nullptr) getMesh(meshName);  return mesh; }
 
+		//level of detail picked by the last selectLod
+		inline auto getLod() const { return lod; }
+		//picks the coarsest level whose error stays under 2^bias pixels on screen.
+		//pixelsPerUnit is the size of one unit at distance one, projection[1][1] * viewport height / 2.
+		auto selectLod(const glm::mat4& transform, const glm::vec3& eye, float pixelsPerUnit, float bias) -> uint32_t;
+
 	private:
 		std::shared_ptr<Mesh> mesh;
 		auto getMesh(const std::string& name) -> void;
 		std::string meshName;
 		std::shared_ptr<Material> material;
-
+		uint32_t lod = 0;
 	};
 
 };
@@ -76,24 +76,29 @@ namespace Maple
 		if (dirty)
 			updateLocalMatrix();
 		worldMatrix = mat * localMatrix;
+		worldDirty = false;
+		worldVersion++;
 	}
 
 	void Transform::setLocalTransform(const glm::mat4& localMat)
 	{
 		localMatrix = localMat;
 		hasUpdate = true;
+		worldDirty = true;
 		applyTransform();//decompose 
 	}
 
 	void Transform::setLocalPosition(const glm::vec3& localPos)
 	{
 		dirty = true;
+		worldDirty = true;
 		localPosition = localPos;
 	}
 
 	void Transform::setLocalScale(const glm::vec3& scale)
 	{
 		dirty = true;
+		worldDirty = true;
 		localScale = scale;
 	}
 
@@ -101,6 +106,7 @@ namespace Maple
 	void Transform::setLocalOrientation(const glm::vec3& rotation)
 	{
 		dirty = true;
+		worldDirty = true;
 		localOrientation = rotation;
 	}
 
@@ -141,6 +147,7 @@ namespace Maple
 	void Transform::resetTransform()
 	{
 		dirty = true;
+		worldDirty = true;
 		localPosition = initLocalPosition;
 		localScale = initLocalScale;
 		localOrientation = initLocalOrientation;
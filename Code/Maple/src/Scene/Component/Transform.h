@@ -50,6 +50,10 @@ namespace Maple
 		void resetTransform();
 		inline auto hasUpdated() const { return hasUpdate; }
 		inline void setHasUpdated(bool set) { hasUpdate = set; }
+		//the world matrix needs to be recomputed by the SceneGraph
+		inline auto isWorldDirty() const { return worldDirty; }
+		//bumped every time the world matrix is recomputed, worldDirty is already cleared when later systems run.
+		inline auto getWorldVersion() const { return worldVersion; }
 
 		void updateLocalMatrix();
 		void applyTransform();
@@ -73,6 +77,7 @@ namespace Maple
 		{
 			archive(cereal::make_nvp("Position", localPosition), cereal::make_nvp("Rotation", localOrientation), cereal::make_nvp("Scale",  localScale), cereal::make_nvp("Id", entity));
 			dirty = true;
+			worldDirty = true;
 			initLocalPosition = localPosition;
 			initLocalScale = localScale;
 			initLocalOrientation = localOrientation;
@@ -96,6 +101,8 @@ namespace Maple
 
 		bool hasUpdate = false;
 		bool dirty = false;
+		bool worldDirty = true;
+		uint32_t worldVersion = 0;
 	};
 
 
@@ -7,6 +7,7 @@
 #include "Entity/Entity.h"
 #include "Entity/EntityManager.h"
 #include "SceneGraph.h"
+#include "SceneBVH.h"
 #include "Scene/Component/Transform.h"
 #include "Scene/Component/Light.h"
 #include "Scene/Component/CameraControllerComponent.h"
@@ -48,6 +49,9 @@ namespace Maple {
 
 		sceneGraph = std::make_shared<SceneGraph>();
 		sceneGraph->init(entityManager->getRegistry());
+
+		sceneBVH = std::make_shared<SceneBVH>();
+		sceneBVH->init(entityManager->getRegistry());
 	}
 
 	entt::registry& Scene::getRegistry()
@@ -75,6 +79,9 @@ namespace Maple {
 				filePath = name + ".scene";
 			}
 			Serialization::serialize(this);
+			//the json file stays the source, the binary one is a cooked copy loaded in its place
+			if (binary)
+				Serialization::serializeBinary(this, Serialization::getBinaryPath(filePath));
 			dirty = false;
 		}
 	}
@@ -84,6 +91,7 @@ namespace Maple {
 		PROFILE_FUNCTION();
 		if(filePath != ""){
 			entityManager->clear();
+			sceneBVH->clear();
 			sceneGraph->disconnectOnConstruct(true, getRegistry());
 			Serialization::loadScene(this, filePath);
 			sceneGraph->disconnectOnConstruct(false, getRegistry());
@@ -185,6 +193,7 @@ namespace Maple {
 		PROFILE_FUNCTION();
 		updateCameraController(dt);
 		sceneGraph->update(entityManager->getRegistry());
+		sceneBVH->update(entityManager->getRegistry());
 		auto view = entityManager->getRegistry().group<AnimatedSprite>(entt::get<Transform>);
 		for (auto entity : view)
 		{
@@ -14,6 +14,7 @@ namespace Maple
 	class EntityManager;
 	class Entity;
 	class SceneGraph;
+	class SceneBVH;
 	class Camera;
 	class Transform;
 
@@ -34,6 +35,7 @@ namespace Maple
 		inline auto setGameView(bool gameView) { this->gameView = gameView; }
 
 		inline auto& getEntityManager() { return entityManager; }
+		inline auto& getBVH() { return sceneBVH; }
 		inline auto& getName() const { return name; };
 		inline auto& getPath() const { return filePath; };
 
@@ -75,6 +77,7 @@ namespace Maple
 		auto copyComponents(const Entity& from, const Entity& to )-> void;
 
 		std::shared_ptr<SceneGraph> sceneGraph;
+		std::shared_ptr<SceneBVH> sceneBVH;
 		std::shared_ptr<EntityManager> entityManager;
 		std::string name;
 		std::string filePath;
@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Game Engine			                    //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+#include "Component/Transform.h"
+#include "Component/MeshRenderer.h"
+#include "Engine/Mesh.h"
+#include "Engine/Profiler.h"
+#include <algorithm>
+
+namespace Maple
+{
+	auto SceneBVH::init(entt::registry& registry) -> void
+	{
+		registry.on_destroy<MeshRenderer>().connect<&SceneBVH::onMeshDestroy>(*this);
+		registry.on_destroy<Transform>().connect<&SceneBVH::onMeshDestroy>(*this);
+	}
+
+	auto SceneBVH::update(entt::registry& registry) -> void
+	{
+		PROFILE_FUNCTION();
+		uint32_t refitted = 0;
+		auto group = registry.group<MeshRenderer>(entt::get<Transform>);
+		for (auto entity : group)
+		{
+			const auto& [render, trans] = group.get<MeshRenderer, Transform>(entity);
+			const Mesh* mesh = render.getMesh().get();
+
+			auto iter = proxies.find(entity);
+			if (iter != proxies.end() && iter->second.mesh == mesh && iter->second.worldVersion == trans.getWorldVersion())
+				continue;
+
+			if (iter == proxies.end())
+				iter = proxies.emplace(entity, Proxy{}).first;
+
+			auto& proxy = iter->second;
+			proxy.mesh = mesh;
+			proxy.worldVersion = trans.getWorldVersion();
+			refitted++;
+
+			const BoundingBox* bb = mesh != nullptr ? mesh->getBoundingBox().get() : nullptr;
+			if (bb == nullptr || !bb->isDefined())
+			{
+				if (proxy.id != -1)
+				{
+					tree.destroyProxy(proxy.id);
+					proxy.id = -1;
+				}
+				//a missing mesh is neither culled nor reported
+				if (mesh != nullptr && std::find(unbounded.begin(), unbounded.end(), entity) == unbounded.end())
+					unbounded.emplace_back(entity);
+				else if (mesh == nullptr)
+					unbounded.erase(std::remove(unbounded.begin(), unbounded.end(), entity), unbounded.end());
+				continue;
+			}
+
+			const auto worldBox = bb->transform(trans.getWorldMatrix());
+
+			if (proxy.id != -1)
+			{
+				worldBoxes[proxy.id] = worldBox;
+				tree.moveProxy(proxy.id, worldBox);
+			}
+			else
+			{
+				unbounded.erase(std::remove(unbounded.begin(), unbounded.end(), entity), unbounded.end());
+				proxy.id = tree.createProxy(worldBox, static_cast<uint32_t>(entity));
+				if (proxy.id >= worldBoxes.size())
+					worldBoxes.resize(proxy.id + 1);
+				worldBoxes[proxy.id] = worldBox;
+			}
+		}
+		PROFILE_PLOT("BVH Refitted", static_cast<int64_t>(refitted));
+	}
+
+	auto SceneBVH::clear() -> void
+	{
+		tree.clear();
+		worldBoxes.clear();
+		proxies.clear();
+		unbounded.clear();
+	}
+
+	auto SceneBVH::onMeshDestroy(entt::registry& registry, entt::entity entity) -> void
+	{
+		removeProxy(entity);
+	}
+
+	auto SceneBVH::rayCast(const Ray& ray, float& distance) const -> entt::entity
+	{
+		entt::entity closest = entt::null;
+		distance = INFINITY;
+
+		tree.rayCast(ray, [&](int32_t proxyId, float maxDistance) {
+			const float dist = ray.hit(worldBoxes[proxyId]);
+			if (dist < maxDistance)
+			{
+				closest = static_cast<entt::entity>(tree.getUserData(proxyId));
+				distance = dist;
+				return dist;
+			}
+			return maxDistance;
+		});
+
+		return closest;
+	}
+
+	auto SceneBVH::removeProxy(entt::entity entity) -> void
+	{
+		if (auto iter = proxies.find(entity); iter != proxies.end())
+		{
+			if (iter->second.id != -1)
+				tree.destroyProxy(iter->second.id);
+			proxies.erase(iter);
+		}
+		unbounded.erase(std::remove(unbounded.begin(), unbounded.end(), entity), unbounded.end());
+	}
+};
@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Game Engine			                    //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <entt/entt.hpp>
+#include "Math/DynamicAABBTree.h"
+#include "Engine/Core.h"
+
+namespace Maple
+{
+	class Mesh;
+
+	//Scene level bounding volume hierarchy over every MeshRenderer.
+	//Shared by the picker, the renderers' culling and scripts.
+	class MAPLE_EXPORT SceneBVH final
+	{
+	public:
+		SceneBVH() = default;
+		~SceneBVH() = default;
+
+		auto init(entt::registry& registry) -> void;
+		//refit the proxies of the meshes whose world matrix or mesh changed.
+		auto update(entt::registry& registry) -> void;
+		auto clear() -> void;
+
+		//connected to the destruction of MeshRenderer and Transform
+		auto onMeshDestroy(entt::registry& registry, entt::entity entity) -> void;
+
+		//callback : (entt::entity entity, const BoundingBox& worldBox) -> void
+		template<typename Callback>
+		auto query(const Frustum& frustum, Callback&& callback, bool testNear = true) const -> void;
+
+		template<typename Callback>
+		auto query(const BoundingBox& box, Callback&& callback) const -> void;
+
+		template<typename Callback>
+		auto query(const glm::vec3& center, float radius, Callback&& callback) const -> void;
+
+		//closest entity hit by the ray, entt::null if nothing.
+		auto rayCast(const Ray& ray, float& distance) const->entt::entity;
+
+		inline auto& getTree() const { return tree; }
+		inline auto getCount() const { return static_cast<uint32_t>(tree.getProxyCount() + unbounded.size()); }
+
+	private:
+		auto removeProxy(entt::entity entity) -> void;
+
+		struct Proxy
+		{
+			//-1 when the mesh is missing or has no bounds
+			int32_t id = -1;
+			//Transform::getWorldVersion() of the last refit
+			uint32_t worldVersion = 0;
+			const Mesh* mesh = nullptr;
+		};
+
+		DynamicAABBTree tree;
+		//tight world bounds, indexed by proxy id.
+		std::vector<BoundingBox> worldBoxes;
+		std::unordered_map<entt::entity, Proxy> proxies;
+		//meshes without bounds can not be culled, they are reported by every query.
+		std::vector<entt::entity> unbounded;
+	};
+
+	template<typename Callback>
+	auto SceneBVH::query(const Frustum& frustum, Callback&& callback, bool testNear) const -> void
+	{
+		tree.query(frustum, [&](int32_t proxyId) {
+			auto& box = worldBoxes[proxyId];
+			if (frustum.isInside(box, testNear))
+				callback(static_cast<entt::entity>(tree.getUserData(proxyId)), box);
+			return true;
+		}, testNear);
+
+		for (auto entity : unbounded)
+			callback(entity, BoundingBox{});
+	}
+
+	template<typename Callback>
+	auto SceneBVH::query(const BoundingBox& box, Callback&& callback) const -> void
+	{
+		tree.query(box, [&](int32_t proxyId) {
+			auto& worldBox = worldBoxes[proxyId];
+			if (!(worldBox.max.x < box.min.x || worldBox.min.x > box.max.x ||
+				worldBox.max.y < box.min.y || worldBox.min.y > box.max.y ||
+				worldBox.max.z < box.min.z || worldBox.min.z > box.max.z))
+				callback(static_cast<entt::entity>(tree.getUserData(proxyId)), worldBox);
+			return true;
+		});
+
+		for (auto entity : unbounded)
+			callback(entity, BoundingBox{});
+	}
+
+	template<typename Callback>
+	auto SceneBVH::query(const glm::vec3& center, float radius, Callback&& callback) const -> void
+	{
+		tree.query(center, radius, [&](int32_t proxyId) {
+			auto& worldBox = worldBoxes[proxyId];
+			const auto dist = glm::clamp(center, worldBox.min, worldBox.max) - center;
+			if (glm::dot(dist, dist) <= radius * radius)
+				callback(static_cast<entt::entity>(tree.getUserData(proxyId)), worldBox);
+			return true;
+		});
+
+		for (auto entity : unbounded)
+			callback(entity, BoundingBox{});
+	}
+};
@@ -6,13 +6,25 @@
 #include "Component/Component.h"
 #include "Component/Transform.h"
 #include "Engine/Profiler.h"
+#include "Application.h"
+#include <atomic>
+
 namespace Maple 
 {
+	namespace
+	{
+		//below this size the update is cheaper than scheduling jobs.
+		constexpr int32_t PARALLEL_NODE_COUNT = 4096;
+	};
+
 	auto SceneGraph::init(entt::registry& registry) -> void
 	{
 		registry.on_construct<Hierarchy>().connect<&Hierarchy::onConstruct>();
 		registry.on_update<Hierarchy>().connect<&Hierarchy::onUpdate>();
 		registry.on_destroy<Hierarchy>().connect<&Hierarchy::onDestroy>();
+
+		registry.on_construct<Transform>().connect<&SceneGraph::onTransformChanged>(*this);
+		registry.on_destroy<Transform>().connect<&SceneGraph::onTransformChanged>(*this);
 	}
 
 	auto SceneGraph::disconnectOnConstruct(bool disable, entt::registry& registry)  -> void
@@ -21,29 +33,122 @@ namespace Maple
 			registry.on_construct<Hierarchy>().disconnect<&Hierarchy::onConstruct>();
 		else
 			registry.on_construct<Hierarchy>().connect<&Hierarchy::onConstruct>();
+		structureDirty = true;
+	}
+
+	auto SceneGraph::onTransformChanged(entt::registry& registry, entt::entity entity) -> void
+	{
+		structureDirty = true;
+	}
+
+	auto SceneGraph::rebuild(entt::registry& registry) -> void
+	{
+		PROFILE_FUNCTION();
+		nodes.clear();
+		subtrees.clear();
+
+		auto view = registry.view<Hierarchy>();
+		for (auto entity : view)
+		{
+			const auto& hierarchy = view.get<Hierarchy>(entity);
+			if (hierarchy.getParent() != entt::null)
+				continue;
+
+			const int32_t begin = static_cast<int32_t>(nodes.size());
+			if (registry.has<Transform>(entity))
+				nodes.push_back({ entity, -1 });
+			else
+				appendChildren(registry, entity, -1);
+
+			//breadth first, so every parent is already in the list when its children are appended.
+			for (int32_t i = begin; i < static_cast<int32_t>(nodes.size()); ++i)
+			{
+				appendChildren(registry, nodes[i].entity, i);
+			}
+			if (static_cast<int32_t>(nodes.size()) > begin)
+				subtrees.emplace_back(begin, static_cast<int32_t>(nodes.size()));
+		}
+
+		changed.assign(nodes.size(), 0);
+		hierarchyVersion = Hierarchy::getVersion();
+		structureDirty = false;
+	}
+
+	auto SceneGraph::appendChildren(entt::registry& registry, entt::entity entity, int32_t parent) -> void
+	{
+		entt::entity child = registry.get<Hierarchy>(entity).getFirst();
+		while (child != entt::null)
+		{
+			auto childHierarchy = registry.try_get<Hierarchy>(child);
+			if (childHierarchy == nullptr)
+				break;
+			if (registry.has<Transform>(child))
+				nodes.push_back({ child, parent });
+			else
+				//a child without a Transform is skipped, its children hang from the nearest ancestor that has one.
+				appendChildren(registry, child, parent);
+			child = childHierarchy->getNext();
+		}
+	}
+
+	auto SceneGraph::updateSubtree(entt::registry& registry, int32_t begin, int32_t end) -> uint32_t
+	{
+		uint32_t count = 0;
+		for (int32_t i = begin; i < end; ++i)
+		{
+			auto& node = nodes[i];
+			auto& transform = registry.get<Transform>(node.entity);
+			const bool parentChanged = node.parent != -1 && changed[node.parent];
+			changed[i] = parentChanged || transform.isWorldDirty();
+			if (changed[i])
+			{
+				transform.setWorldMatrix(node.parent != -1 ? registry.get<Transform>(nodes[node.parent].entity).getWorldMatrix() : glm::mat4{ 1.f });
+				count++;
+			}
+		}
+		return count;
 	}
 
 	auto SceneGraph::update(entt::registry& registry)  -> void
 	{
 		PROFILE_FUNCTION();
-		auto nonHierarchyView = registry.view<Transform>(entt::exclude<Hierarchy>);
+		updatedCount = 0;
 
+		auto nonHierarchyView = registry.view<Transform>(entt::exclude<Hierarchy>);
 		for (auto entity : nonHierarchyView)
 		{
-			registry.get<Transform>(entity).setWorldMatrix(glm::mat4{1.f});
+			auto& transform = nonHierarchyView.get<Transform>(entity);
+			if (transform.isWorldDirty())
+			{
+				transform.setWorldMatrix(glm::mat4{ 1.f });
+				updatedCount++;
+			}
 		}
 
-		auto view = registry.view<Transform, Hierarchy>();
-		for (auto entity : view)
+		if (structureDirty || hierarchyVersion != Hierarchy::getVersion())
 		{
-			const auto hierarchy = registry.try_get<Hierarchy>(entity);
-			if (hierarchy && hierarchy->getParent() == entt::null)
+			//every node is recomputed once after the order changes.
+			rebuild(registry);
+			for (auto& node : nodes)
 			{
-				//Recursively update children
-				updateTransform(entity, registry);
+				registry.get<Transform>(node.entity).setWorldMatrix(node.parent != -1 ? registry.get<Transform>(nodes[node.parent].entity).getWorldMatrix() : glm::mat4{ 1.f });
 			}
+			updatedCount += static_cast<uint32_t>(nodes.size());
 		}
-
+		else if (nodes.size() < PARALLEL_NODE_COUNT || subtrees.size() < 2)
+		{
+			updatedCount += updateSubtree(registry, 0, static_cast<int32_t>(nodes.size()));
+		}
+		else
+		{
+			//root subtrees are independent of each other
+			std::atomic<uint32_t> count{ 0 };
+			Application::get()->getThreadPool()->parallelRange(0, static_cast<int32_t>(subtrees.size()), [&](int32_t begin, int32_t end) {
+				count.fetch_add(updateSubtree(registry, subtrees[begin].first, subtrees[end - 1].second), std::memory_order_relaxed);
+			});
+			updatedCount += count.load();
+		}
+		PROFILE_PLOT("Transforms Updated", static_cast<int64_t>(updatedCount));
 	}
 
 	auto SceneGraph::updateTransform(entt::entity entity, entt::registry& registry)  -> void
@@ -55,18 +160,16 @@ namespace Maple
 			auto transform = registry.try_get<Transform>(entity);
 			if (transform)
 			{
-				if (hierarchyComponent->getParent() != entt::null)
-				{
-					auto parentTransform = registry.try_get<Transform>(hierarchyComponent->getParent());
-					if (parentTransform)
-					{
-						transform->setWorldMatrix(parentTransform->getWorldMatrix());
-					}
-				}
-				else
+				//the nearest ancestor with a Transform, the same parent rebuild() gives the node
+				Transform* parentTransform = nullptr;
+				auto parent = hierarchyComponent->getParent();
+				while (parent != entt::null && parentTransform == nullptr)
 				{
-					transform->setWorldMatrix(glm::mat4{1.f});
+					parentTransform = registry.try_get<Transform>(parent);
+					auto parentHierarchy = registry.try_get<Hierarchy>(parent);
+					parent = parentHierarchy ? parentHierarchy->getParent() : entt::null;
 				}
+				transform->setWorldMatrix(parentTransform ? parentTransform->getWorldMatrix() : glm::mat4{ 1.f });
 			}
 
 			entt::entity child = hierarchyComponent->getFirst();
@@ -80,6 +183,3 @@ namespace Maple
 		}
 	}
 };
-
-
-
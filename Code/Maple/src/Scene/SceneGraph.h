@@ -4,12 +4,16 @@
 
 #pragma once
 #include <string>
+#include <vector>
 #include "Engine/Core.h"
 
 #include <entt/entity/fwd.hpp>
+#include <entt/entity/entity.hpp>
 
 namespace Maple
 {
+	class Transform;
+
 	class MAPLE_EXPORT SceneGraph final
 	{
 	public:
@@ -17,8 +21,34 @@ namespace Maple
 		~SceneGraph() = default;
 		void init(entt::registry & registry);
 		void disconnectOnConstruct(bool disable, entt::registry & registry);
+		//only the dirty transforms and their descendants are recomputed.
 		void update(entt::registry & registry);
+		//force the update of an entity and all its children
 		void updateTransform(entt::entity entity, entt::registry & registry);
+
+		inline auto getUpdatedCount() const { return updatedCount; }
+	private:
+		void onTransformChanged(entt::registry& registry, entt::entity entity);
+		void rebuild(entt::registry& registry);
+		void appendChildren(entt::registry& registry, entt::entity entity, int32_t parent);
+		uint32_t updateSubtree(entt::registry& registry, int32_t begin, int32_t end);
+
+		//only the entity is kept, owning groups (e.g. group<Light, Transform>) reorder the Transform storage.
+		struct Node
+		{
+			entt::entity entity;
+			//index of the parent in nodes, -1 for roots
+			int32_t parent = -1;
+		};
+
+		//parents always come before their children, every root subtree is a contiguous range.
+		std::vector<Node> nodes;
+		std::vector<std::pair<int32_t, int32_t>> subtrees;
+		std::vector<uint8_t> changed;
+
+		bool structureDirty = true;
+		uint32_t hierarchyVersion = 0;
+		uint32_t updatedCount = 0;
 	};
 
 };
\ No newline at end of file
@@ -2,12 +2,20 @@
 #include "QuadCollapseMesh.h"
 #include "Others/Console.h"
 #include "Engine/Camera.h"
+#include "Math/BoundingBox.h"
+#include "Math/Frustum.h"
+#include "Engine/Profiler.h"
 #include <imgui.h>
+#include <algorithm>
 
 namespace Maple 
 {
 	static const float	ACTIVE_SCALE = 16.0f;
 	static const int	MAX_LENGTH = 4097;
+	static const uint32_t FREE_SLOT = UINT32_MAX;
+	static const uint32_t MIN_SLOTS = 4096;
+	//the morph factor moves in steps, so a quad is only uploaded again once the camera moved far enough to matter
+	static const float MORPH_STEPS = 32.0f;
 
 	bool isPowerOf2(int32_t n) {
 		return n && !(n & (n - 1));
@@ -32,9 +40,8 @@ namespace Maple
 			uint32_t	level : 4;
 			uint32_t	adjcentQuadsCount : 3;
 		};
-		Vertex originalVertex;
-		float interpolationFactor;	// position interpolation
-		Vertex interpolatedVertex;
+		uint32_t vertex;			// index in the height field
+		float interpolationFactor;	// 0 at the parent, 1 at the vertex
 
 		VertNode* parent = nullptr;
 		VertNode* firstChild = nullptr;
@@ -164,13 +171,14 @@ namespace Maple
 	{
 	}
 
-	auto QuadCollapseMesh::build(const std::vector<Vertex>& vertices, uint32_t width, uint32_t height) -> bool
+	auto QuadCollapseMesh::build(std::vector<Vertex> vertices, uint32_t width, uint32_t height) -> bool
 	{
-		this->vertices = vertices;
+		this->vertices = std::move(vertices);
 
-		for (auto i = 0; i < vertices.size(); i++)
+		boundingBox = std::make_shared<BoundingBox>();
+		for (auto& vertex : this->vertices)
 		{
-			lodIndices.emplace_back(i);
+			boundingBox->merge(vertex.pos);
 		}
 
 		uint32_t numIndices = (width - 1) * (height - 1) * 6;
@@ -202,6 +210,7 @@ namespace Maple
 
 		indexBuffer = std::make_shared<IndexBuffer>(indices.data(), indices.size());
 		vertexBuffer = std::make_shared<VertexBuffer>();
+		attributeBuffer = std::make_shared<VertexBuffer>();
 
 		maxLevelVerticesLength = width;
 		if (maxLevelVerticesLength < 2 /*|| !isPowerOf2(maxLevelVerticesLength - 1)*/) {
@@ -238,7 +247,7 @@ namespace Maple
 		for (int i = 0; i < levelCount; ++i) {
 			float quadSize = (float)((maxLevelVerticesLength - 1) >> i);
 			float quadHalfSize = quadSize * 0.5f;
-			float quadNodeCullRadius = std::sqrtf(quadHalfSize * quadSize * 2.0f);
+			float quadNodeCullRadius = std::sqrt(quadHalfSize * quadSize * 2.0f);
 
 			quadNodesCullRadius[i] = quadNodeCullRadius;
 			vertNodesActiveDistance[i] = quadNodeCullRadius * ACTIVE_SCALE;
@@ -267,39 +276,49 @@ namespace Maple
 		buildVertNodes();
 
 		rootQuadNode = recursiveBuildQuadNodes(0, 0, 0, maxLevelVerticesLength - 1);
+		quadSlots.assign(quadNodePool.size() + quadLeafPool.size(), FREE_SLOT);
 
 		return true;
 	}
 
 
-	auto QuadCollapseMesh::update(Camera* camera) -> void
+	auto QuadCollapseMesh::update(Camera* camera, const glm::mat4& modelView) -> void
 	{
+		PROFILE_FUNCTION();
 		updateFrame++;
+		uploadedVertices = 0;
 
 		if (lod)
 		{
+			if (!lodMesh)
+			{
+				resetSlots();
+				lodMesh = true;
+			}
+
+			const glm::vec3 eye = glm::inverse(modelView)[3];
+			const auto& frustum = camera->getFrustum(modelView);
+
 			for (auto i = 0; i < 4; ++i) {
-				rootVertNodes[i]->interpolatedVertex = rootVertNodes[i]->originalVertex;
-				recursiveUpdateVertNode(camera, rootVertNodes[i]);
+				recursiveUpdateVertNode(eye, frustum, rootVertNodes[i]);
 			}
-			activeVertices.clear();
 			recursiveSetActiveMesh(rootQuadNode);
-			if (activeVertices.size() != 0)
-			{
-				vertexBuffer->setData(sizeof(Vertex) * activeVertices.size(), activeVertices.data());
-				size = activeVertices.size();
-				if(indexBuffer->getSize() != sizeof(uint32_t) * lodIndices.size())
-					indexBuffer->setData(sizeof(uint32_t) * lodIndices.size(), lodIndices.data());
-			}
+			releaseInactiveQuads();
+			uploadSlots();
 		}
 		else 
 		{
-			if (sizeof(Vertex) * vertices.size() != vertexBuffer->getSize()) 
+			if (lodMesh || sizeof(glm::vec3) * vertices.size() != vertexBuffer->getSize())
 			{
-				vertexBuffer->setData(sizeof(Vertex) * vertices.size(), vertices.data());
+				//the index buffer holds the quads of the slots after the lod
+				const bool slotIndices = lodMesh;
+				lodMesh = false;
+				setVertices(vertices.data(), static_cast<uint32_t>(vertices.size()));
 				size = indices.size();
-				if (indexBuffer->getSize() != sizeof(uint32_t) * indices.size())
+				if (slotIndices || indexBuffer->getSize() != sizeof(uint32_t) * indices.size())
 					indexBuffer->setData(sizeof(uint32_t) * size, indices.data());
+				indexBuffer->setCount(size);
+				uploadedVertices = static_cast<uint32_t>(vertices.size());
 			}
 		}
 	}
@@ -325,9 +344,8 @@ namespace Maple
 					vertNode->state = 0;
 					vertNode->level = level;
 					vertNode->adjcentQuadsCount = 0;
-					vertNode->originalVertex = vertices[y * maxLevelVerticesLength + x];
+					vertNode->vertex = y * maxLevelVerticesLength + x;
 					vertNode->interpolationFactor = 1.0f;
-					vertNode->interpolatedVertex = vertNode->originalVertex;
 					vertNode->parent = nullptr;
 					vertNode->firstChild = nullptr;
 					vertNode->nextSibling = nullptr;
@@ -441,10 +459,10 @@ namespace Maple
 		}
 
 		if (!vertNodeChildBt->parent) {
-			auto delta1 = vertNodeChildBt->originalVertex - vertNodeParentSe->originalVertex;
-			auto delta2 = vertNodeChildBt->originalVertex - vertNodeParentSw->originalVertex;
+			auto delta1 = vertices[vertNodeChildBt->vertex].pos - vertices[vertNodeParentSe->vertex].pos;
+			auto delta2 = vertices[vertNodeChildBt->vertex].pos - vertices[vertNodeParentSw->vertex].pos;
 
-			if (glm::length(delta1.pos) < glm::length(delta2.pos)) {
+			if (glm::length(delta1) < glm::length(delta2)) {
 				vertNodeParentSe->addChild(vertNodeChildBt);
 			}
 			else {
@@ -453,10 +471,10 @@ namespace Maple
 		}
 
 		if (!vertNodeChildRt->parent) {
-			auto delta1 = vertNodeChildRt->originalVertex - vertNodeParentNe->originalVertex;
-			auto delta2 = vertNodeChildRt->originalVertex - vertNodeParentSe->originalVertex;
+			auto delta1 = vertices[vertNodeChildRt->vertex].pos - vertices[vertNodeParentNe->vertex].pos;
+			auto delta2 = vertices[vertNodeChildRt->vertex].pos - vertices[vertNodeParentSe->vertex].pos;
 
-			if (glm::length(delta1.pos) < glm::length(delta2.pos)) {
+			if (glm::length(delta1) < glm::length(delta2)) {
 				vertNodeParentNe->addChild(vertNodeChildRt);
 			}
 			else {
@@ -465,10 +483,10 @@ namespace Maple
 		}
 
 		if (!vertNodeChildTp->parent) {
-			auto delta1 = vertNodeChildTp->originalVertex - vertNodeParentNe->originalVertex;
-			auto delta2 = vertNodeChildTp->originalVertex - vertNodeParentNw->originalVertex;
+			auto delta1 = vertices[vertNodeChildTp->vertex].pos - vertices[vertNodeParentNe->vertex].pos;
+			auto delta2 = vertices[vertNodeChildTp->vertex].pos - vertices[vertNodeParentNw->vertex].pos;
 
-			if (glm::length(delta1.pos) < glm::length(delta2.pos)) {
+			if (glm::length(delta1) < glm::length(delta2)) {
 				vertNodeParentNe->addChild(vertNodeChildTp);
 			}
 			else {
@@ -477,10 +495,10 @@ namespace Maple
 		}
 
 		if (!vertNodeChildLf->parent) {
-			auto delta1 = vertNodeChildLf->originalVertex - vertNodeParentNw->originalVertex;
-			auto delta2 = vertNodeChildLf->originalVertex - vertNodeParentSw->originalVertex;
+			auto delta1 = vertices[vertNodeChildLf->vertex].pos - vertices[vertNodeParentNw->vertex].pos;
+			auto delta2 = vertices[vertNodeChildLf->vertex].pos - vertices[vertNodeParentSw->vertex].pos;
 
-			if (glm::length(delta1.pos) < glm::length(delta2.pos)) {
+			if (glm::length(delta1) < glm::length(delta2)) {
 				vertNodeParentNw->addChild(vertNodeChildLf);
 			}
 			else {
@@ -493,10 +511,10 @@ namespace Maple
 			&& vertNodeParentNe->hasChild(vertNodeChildRt)
 			&& vertNodeParentNe->hasChild(vertNodeChildTp))
 		{
-			auto delta1 = vertNodeChildCt->originalVertex - vertNodeParentSw->originalVertex;
-			auto delta2 = vertNodeChildCt->originalVertex - vertNodeParentNe->originalVertex;
+			auto delta1 = vertices[vertNodeChildCt->vertex].pos - vertices[vertNodeParentSw->vertex].pos;
+			auto delta2 = vertices[vertNodeChildCt->vertex].pos - vertices[vertNodeParentNe->vertex].pos;
 
-			if (glm::length(delta1.pos) < glm::length(delta2.pos)) {
+			if (glm::length(delta1) < glm::length(delta2)) {
 				vertNodeParentSw->addChild(vertNodeChildCt);
 			}
 			else {
@@ -509,10 +527,10 @@ namespace Maple
 			&& vertNodeParentNw->hasChild(vertNodeChildTp)
 			&& vertNodeParentNw->hasChild(vertNodeChildLf))
 		{
-			auto delta1 = vertNodeChildCt->originalVertex - vertNodeParentSe->originalVertex;
-			auto delta2 = vertNodeChildCt->originalVertex - vertNodeParentNw->originalVertex;
+			auto delta1 = vertices[vertNodeChildCt->vertex].pos - vertices[vertNodeParentSe->vertex].pos;
+			auto delta2 = vertices[vertNodeChildCt->vertex].pos - vertices[vertNodeParentNw->vertex].pos;
 
-			if (glm::length(delta1.pos) < glm::length(delta2.pos)) {
+			if (glm::length(delta1) < glm::length(delta2)) {
 				vertNodeParentSe->addChild(vertNodeChildCt);
 			}
 			else {
@@ -562,8 +580,8 @@ namespace Maple
 				VertNode * parents[4] = { vertNodeParentSw, vertNodeParentSe, vertNodeParentNe, vertNodeParentNw };
 
 				for (int i = 0; i < 4; ++i) {
-					auto delta = vertNodeChildCt->originalVertex - parents[i]->originalVertex;
-					dist[i] = glm::length(delta.pos);
+					auto delta = vertices[vertNodeChildCt->vertex].pos - vertices[parents[i]->vertex].pos;
+					dist[i] = glm::length(delta);
 				}
 
 				float minDist = dist[0];
@@ -680,7 +698,7 @@ namespace Maple
 		}
 	}
 
-	auto QuadCollapseMesh::recursiveUpdateVertNode(Camera* camera, VertNode* vertNode) -> void
+	auto QuadCollapseMesh::recursiveUpdateVertNode(const glm::vec3& eye, const Frustum& frustum, VertNode* vertNode) -> void
 	{
 		if (vertNode->activeFrame == updateFrame) {
 			return;
@@ -688,11 +706,13 @@ namespace Maple
 
 		vertNode->activeFrame = updateFrame;
 		vertNode->state = NS_BOUNDARY;
+		vertNode->interpolationFactor = 1.0f;
 
-		auto delta = glm::vec3(1) - vertNode->originalVertex.pos;
-		float dist = glm::length(delta);
+		const auto& position = vertices[vertNode->vertex].pos;
+		float dist = glm::length(eye - position);
 
-		if (dist < vertNodesActiveDistance[vertNode->level]) {
+		//terrain out of the frustum is not refined
+		if (dist < vertNodesActiveDistance[vertNode->level] && frustum.isInside(position, quadNodesCullRadius[vertNode->level], false)) {
 			if (vertNode->firstChild) {
 				vertNode->state = NS_ACTIVE;
 
@@ -701,65 +721,41 @@ namespace Maple
 					if (child->parent != vertNode) {
 						LOGE("child->parent != vert_node\n");
 					}
-					recursiveUpdateVertNode(camera, child);
+					recursiveUpdateVertNode(eye, frustum, child);
 					child = child->nextSibling;
 				}
-			}
-			else {
-				vertNode->interpolatedVertex= vertNode->originalVertex;
-				for (int32_t i = 0; i < (int32_t)vertNode->adjcentQuadsCount; ++i) {
-					quadNodeSetBoundary(camera, vertNode->adjcentQuads[i]);
-				}
+				return;
 			}
 		}
-		else {
-			if (vertNode->parent) {
-				// interpolate
-	
-				auto p = vertNode->parent;
-
-				auto o_minus_c = vertNode->originalVertex - p->originalVertex;
-
-				auto l = glm::vec3(1.f) - vertNode->originalVertex.pos;
-				l = glm::normalize(l);
-
-				float l_dot_o_minus_c = glm::dot(l, o_minus_c.pos);
-
-				float r = vertNodesActiveDistance[vertNode->level - 1];
+		else if (vertNode->parent) {
+			// interpolate between the parent and the vertex while the parent is active
+			const auto& parentPosition = vertices[vertNode->parent->vertex].pos;
+			auto o_minus_c = position - parentPosition;
+			auto l = glm::normalize(eye - position);
 
-				float sqrLength = glm::dot(o_minus_c.pos, o_minus_c.pos);
-				float temp = (l_dot_o_minus_c * l_dot_o_minus_c) - sqrLength + r * r;
+			float l_dot_o_minus_c = glm::dot(l, o_minus_c);
+			float r = vertNodesActiveDistance[vertNode->level - 1];
+			float sqrLength = glm::dot(o_minus_c, o_minus_c);
+			float temp = (l_dot_o_minus_c * l_dot_o_minus_c) - sqrLength + r * r;
 
-				float d = -l_dot_o_minus_c + std::sqrtf(temp);
-				float t = (d - dist) / (d - vertNodesActiveDistance[vertNode->level]);
-
-				auto pOrigin = p->originalVertex;
-				auto cOrigin = vertNode->originalVertex;
-
-				vertNode->interpolatedVertex = pOrigin +  (cOrigin - pOrigin) * t;
+			float d = -l_dot_o_minus_c + std::sqrt(std::max(temp, 0.f));
+			float t = (d - dist) / (d - vertNodesActiveDistance[vertNode->level]);
 
+			//a culled vertex in its active distance keeps its position
+			vertNode->interpolationFactor = t >= 0.f ? std::round(std::min(t, 1.f) * MORPH_STEPS) / MORPH_STEPS : 0.f;
+		}
 
-				for (uint32_t i = 0; i < vertNode->adjcentQuadsCount; ++i) {
-					quadNodeSetBoundary(camera, vertNode->adjcentQuads[i]);
-				}
-			}
-			else {
-				vertNode->interpolatedVertex = vertNode->originalVertex;
-				for (uint32_t i = 0; i < vertNode->adjcentQuadsCount; ++i) {
-					quadNodeSetBoundary(camera, vertNode->adjcentQuads[i]);
-				}
-			}
+		for (uint32_t i = 0; i < vertNode->adjcentQuadsCount; ++i) {
+			quadNodeSetBoundary(vertNode->adjcentQuads[i]);
 		}
 	}
 
-	auto QuadCollapseMesh::quadNodeSetBoundary(Camera* camera, QuadNode* quadNode) -> void
+	auto QuadCollapseMesh::quadNodeSetBoundary(QuadNode* quadNode) -> void
 	{
 		if (quadNode->activeFrame == updateFrame && quadNode->state == NS_ACTIVE) {
 			return; // already set
 		}
 
-		
-
 		quadNode->activeFrame = updateFrame;
 		quadNode->state = NS_BOUNDARY;
 
@@ -781,77 +777,185 @@ namespace Maple
 			return;
 		}
 
-		if (quadNode->activeFrame == updateFrame) {
-			if (quadNode->state == NS_BOUNDARY) {
-
-				if (quadNode->triangulationMode == TM_SW_NE) {
-					addActiveVertNode(quadNode->cornerVertNodes[0]);
-					addActiveVertNode(quadNode->cornerVertNodes[1]);
-					addActiveVertNode(quadNode->cornerVertNodes[2]);
-					addActiveVertNode(quadNode->cornerVertNodes[0]);
-					addActiveVertNode(quadNode->cornerVertNodes[2]);
-					addActiveVertNode(quadNode->cornerVertNodes[3]);
-				}
-				else {
-					addActiveVertNode(quadNode->cornerVertNodes[0]);
-					addActiveVertNode(quadNode->cornerVertNodes[1]);
-					addActiveVertNode(quadNode->cornerVertNodes[3]);
-					addActiveVertNode(quadNode->cornerVertNodes[1]);
-					addActiveVertNode(quadNode->cornerVertNodes[2]);
-					addActiveVertNode(quadNode->cornerVertNodes[3]);
-				}
-			}
-			else { // NS_ACTIVE
-				for (int32_t i = 0; i < 4; ++i) {
-					recursiveSetActiveMesh(quadNode->children[i]);
-				}
+		if (quadNode->activeFrame == updateFrame && quadNode->state == NS_ACTIVE) {
+			for (int32_t i = 0; i < 4; ++i) {
+				recursiveSetActiveMesh(quadNode->children[i]);
 			}
 		}
-		else { // not active, but a child of active quad
-			if (quadNode->triangulationMode == TM_SW_NE) {
-				addActiveVertNode(quadNode->cornerVertNodes[0]);
-				addActiveVertNode(quadNode->cornerVertNodes[1]);
-				addActiveVertNode(quadNode->cornerVertNodes[2]);
-				addActiveVertNode(quadNode->cornerVertNodes[0]);
-				addActiveVertNode(quadNode->cornerVertNodes[2]);
-				addActiveVertNode(quadNode->cornerVertNodes[3]);
+		else { // boundary, or not active but a child of an active quad
+			setActiveQuad(quadNode);
+		}
+	}
+
+	auto QuadCollapseMesh::getActiveVertex(const VertNode* vertNode) const -> Vertex
+	{
+		//a vertex which has not been updated is collapsed into its first active ancestor
+		auto node = vertNode;
+		while (node && node->activeFrame != updateFrame) {
+			node = node->parent;
+		}
+
+		if (node == nullptr) {
+			return vertices[vertNode->vertex];
+		}
+
+		const auto& vertex = vertices[node->vertex];
+		if (node->interpolationFactor >= 1.0f || node->parent == nullptr) {
+			return vertex;
+		}
+
+		const auto& parent = vertices[node->parent->vertex];
+		const float t = node->interpolationFactor;
+		Vertex result = vertex;
+		result.pos = glm::mix(parent.pos, vertex.pos, t);
+		result.color = glm::mix(parent.color, vertex.color, t);
+		result.texCoord = glm::mix(parent.texCoord, vertex.texCoord, t);
+		result.normal = glm::mix(parent.normal, vertex.normal, t);
+		return result;
+	}
+
+	auto QuadCollapseMesh::getQuadIndex(const QuadNode* quadNode) const -> uint32_t
+	{
+		//the children of the last level of nodes are leaves
+		if (quadNode >= quadNodePool.data() && quadNode < quadNodePool.data() + quadNodePool.size()) {
+			return static_cast<uint32_t>(quadNode - quadNodePool.data());
+		}
+		return static_cast<uint32_t>(quadNodePool.size() + (reinterpret_cast<const QuadLeaf*>(quadNode) - quadLeafPool.data()));
+	}
+
+	auto QuadCollapseMesh::setActiveQuad(QuadNode* quadNode) -> void
+	{
+		//the corners start at the diagonal, so every slot is drawn with the indices 0 1 2 0 2 3
+		const uint32_t first = quadNode->triangulationMode == TM_SW_NE ? 0 : 1;
+		Vertex corners[4];
+		for (uint32_t i = 0; i < 4; ++i) {
+			corners[i] = getActiveVertex(quadNode->cornerVertNodes[(first + i) & 3]);
+		}
+
+		const auto quad = getQuadIndex(quadNode);
+		auto slot = quadSlots[quad];
+		bool inserted = false;
+		if (slot == FREE_SLOT) {
+			if (!freeSlots.empty()) {
+				slot = freeSlots.back();
+				freeSlots.pop_back();
 			}
 			else {
-				addActiveVertNode(quadNode->cornerVertNodes[0]);
-				addActiveVertNode(quadNode->cornerVertNodes[1]);
-				addActiveVertNode(quadNode->cornerVertNodes[3]);
-				addActiveVertNode(quadNode->cornerVertNodes[1]);
-				addActiveVertNode(quadNode->cornerVertNodes[2]);
-				addActiveVertNode(quadNode->cornerVertNodes[3]);
+				slot = static_cast<uint32_t>(slotOwners.size());
+				slotOwners.emplace_back();
+				slotFrames.emplace_back();
+				slotPositions.resize(slotPositions.size() + 4);
+				slotAttributes.resize(slotAttributes.size() + 4);
 			}
+			quadSlots[quad] = slot;
+			slotOwners[slot] = quad;
+			inserted = true;
+		}
+		slotFrames[slot] = updateFrame;
+
+		//the corners of a quad are different vertices of the grid, so the same positions are the same vertices
+		auto positions = &slotPositions[slot * 4];
+		bool changed = inserted;
+		for (uint32_t i = 0; i < 4 && !changed; ++i) {
+			changed = positions[i] != corners[i].pos;
+		}
+
+		if (changed) {
+			for (uint32_t i = 0; i < 4; ++i) {
+				positions[i] = corners[i].pos;
+				slotAttributes[slot * 4 + i] = VertexFormat::pack(corners[i]);
+			}
+			dirtySlots.emplace_back(slot);
 		}
 	}
 
-	auto QuadCollapseMesh::addActiveVertNode(VertNode* vertNode) -> void
+	auto QuadCollapseMesh::releaseInactiveQuads() -> void
 	{
-		if (vertNode->activeFrame == updateFrame) {
-			activeVertices.emplace_back(vertNode->interpolatedVertex);
+		//the slot of a quad which is gone is left as a degenerate quad until it is used again
+		for (uint32_t slot = 0; slot < slotOwners.size(); ++slot) {
+			if (slotOwners[slot] != FREE_SLOT && slotFrames[slot] != updateFrame) {
+				quadSlots[slotOwners[slot]] = FREE_SLOT;
+				slotOwners[slot] = FREE_SLOT;
+				std::fill_n(&slotPositions[slot * 4], 4, glm::vec3(0.f));
+				std::fill_n(&slotAttributes[slot * 4], 4, VertexFormat::PackedAttributes{});
+				freeSlots.emplace_back(slot);
+				dirtySlots.emplace_back(slot);
+			}
 		}
-		else {
-			Vertex * pos = nullptr;
-			auto p = vertNode->parent;
+	}
 
-			while (p) {
-				if (p->activeFrame == updateFrame) {
-					pos = &p->interpolatedVertex;
-					break;
+	auto QuadCollapseMesh::uploadSlots() -> void
+	{
+		PROFILE_FUNCTION();
+		const auto count = static_cast<uint32_t>(slotOwners.size());
+		size = count * 6;
+
+		if (count > slotCapacity) {
+			//the new buffers start empty, so everything is uploaded
+			slotCapacity = std::max({ count, slotCapacity * 2, MIN_SLOTS });
+
+			std::vector<uint32_t> quadIndices(slotCapacity * 6);
+			for (uint32_t i = 0; i < slotCapacity; ++i) {
+				const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+				for (uint32_t j = 0; j < 6; ++j) {
+					quadIndices[i * 6 + j] = i * 4 + indices[j];
 				}
-				p = p->parent;
 			}
+			indexBuffer->setData(sizeof(uint32_t) * slotCapacity * 6, quadIndices.data());
 
-			if (pos) {
-				activeVertices.emplace_back(*pos);
-			}
-			else {
-				return;
+			vertexBuffer->resize(sizeof(glm::vec3) * slotCapacity * 4, nullptr);
+			attributeBuffer->resize(sizeof(VertexFormat::PackedAttributes) * slotCapacity * 4, nullptr);
+			vertexBuffer->setDataRanges(slotPositions.data(), { { 0, static_cast<uint32_t>(sizeof(glm::vec3) * count * 4) } });
+			attributeBuffer->setDataRanges(slotAttributes.data(), { { 0, static_cast<uint32_t>(sizeof(VertexFormat::PackedAttributes) * count * 4) } });
+
+			uploadedVertices = count * 4;
+			dirtySlots.clear();
+			indexBuffer->setCount(size);
+			return;
+		}
+
+		indexBuffer->setCount(size);
+		if (dirtySlots.empty()) {
+			return;
+		}
+
+		std::sort(dirtySlots.begin(), dirtySlots.end());
+		std::vector<BufferRange> positionRanges;
+		std::vector<BufferRange> attributeRanges;
+		auto addRange = [&](uint32_t first, uint32_t last) {
+			const uint32_t vertexCount = (last - first + 1) * 4;
+			positionRanges.push_back({ static_cast<uint32_t>(sizeof(glm::vec3) * first * 4), static_cast<uint32_t>(sizeof(glm::vec3) * vertexCount) });
+			attributeRanges.push_back({ static_cast<uint32_t>(sizeof(VertexFormat::PackedAttributes) * first * 4), static_cast<uint32_t>(sizeof(VertexFormat::PackedAttributes) * vertexCount) });
+			uploadedVertices += vertexCount;
+		};
+
+		//freed slots are reused in any order, so only runs of dirty slots are merged
+		uint32_t first = dirtySlots.front();
+		uint32_t last = first;
+		for (auto slot : dirtySlots) {
+			if (slot > last + 1) {
+				addRange(first, last);
+				first = slot;
 			}
+			last = slot;
 		}
+		addRange(first, last);
+
+		vertexBuffer->setDataRanges(slotPositions.data(), positionRanges);
+		attributeBuffer->setDataRanges(slotAttributes.data(), attributeRanges);
+		dirtySlots.clear();
 	}
 
-};
+	auto QuadCollapseMesh::resetSlots() -> void
+	{
+		slotPositions.clear();
+		slotAttributes.clear();
+		slotOwners.clear();
+		slotFrames.clear();
+		freeSlots.clear();
+		dirtySlots.clear();
+		std::fill(quadSlots.begin(), quadSlots.end(), FREE_SLOT);
+		slotCapacity = 0;
+	}
 
+};
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <vector>
 #include "Engine/Vertex.h"
 #include "Engine/Mesh.h"
+#include "Engine/VertexFormat.h"
 #define	MAX_QUAD_LEVEL_COUNT	13
 
 
@@ -16,17 +17,18 @@ namespace Maple
 	struct QuadLeaf;
 
 	class Camera;
+	class Frustum;
 	class QuadCollapseMesh  : public Mesh
 	{
 	public:
 		QuadCollapseMesh();
 		~QuadCollapseMesh();
 
-		auto build(const std::vector<Vertex>& vertices, uint32_t width, uint32_t height) -> bool;
+		auto build(std::vector<Vertex> vertices, uint32_t width, uint32_t height) -> bool;
 
-	
-
-		auto update(Camera* camera) -> void;
+		//modelView is the view matrix of the camera times the world matrix of the terrain,
+		//the lod follows the camera position in the terrain and skips what is out of its frustum.
+		auto update(Camera* camera, const glm::mat4& modelView) -> void;
 		auto getMaxLevelLength() const->int32_t;
 		auto getType()  -> MeshType override { return TERRAIN; }
 
@@ -36,6 +38,8 @@ namespace Maple
 
 		inline auto isLod() const { return lod; }
 		inline auto isCalInVertex() const { return calInVertex; }
+		//vertices written into the vertex buffer by the last update
+		inline auto getUploadedVertices() const { return uploadedVertices; }
 
 
 
@@ -45,10 +49,22 @@ namespace Maple
 		bool calInVertex = false;
 
 		std::vector<uint32_t> indices;
-		std::vector<uint32_t> lodIndices;
-
 		std::vector<Vertex> vertices;
-		std::vector<Vertex> activeVertices;
+
+		//the active quads live in slots of pooled buffers, 4 vertices each and the same 6 indices.
+		//only the slots of quads which appeared, morphed or went away are uploaded.
+		std::vector<glm::vec3> slotPositions;
+		std::vector<VertexFormat::PackedAttributes> slotAttributes;
+		//quad of every slot, the index of the quad in the node pool then the leaf pool
+		std::vector<uint32_t> slotOwners;
+		std::vector<uint32_t> slotFrames;
+		std::vector<uint32_t> quadSlots;
+		std::vector<uint32_t> freeSlots;
+		std::vector<uint32_t> dirtySlots;
+		uint32_t slotCapacity = 0;
+		uint32_t uploadedVertices = 0;
+		//the buffers hold the slots, not the full height field
+		bool lodMesh = false;
 
 		int32_t	maxLevelVerticesLength = 0;
 		uint32_t maxLevel = 0;
@@ -76,10 +92,15 @@ namespace Maple
 		auto allocQuadNode() ->QuadNode*;
 		auto allocQuadLeaf() ->QuadLeaf*;
 
-		auto recursiveUpdateVertNode(Camera* camera, VertNode* vertNode) -> void;
-		auto quadNodeSetBoundary(Camera* camera, QuadNode* quadNode) -> void;
+		auto recursiveUpdateVertNode(const glm::vec3& eye, const Frustum& frustum, VertNode* vertNode) -> void;
+		auto quadNodeSetBoundary(QuadNode* quadNode) -> void;
 		auto recursiveSetActiveMesh(QuadNode* quadNode) -> void;
-		auto addActiveVertNode(VertNode* vertNode)-> void;
+		auto getActiveVertex(const VertNode* vertNode) const -> Vertex;
+		auto setActiveQuad(QuadNode* quadNode) -> void;
+		auto getQuadIndex(const QuadNode* quadNode) const -> uint32_t;
+		auto releaseInactiveQuads() -> void;
+		auto uploadSlots() -> void;
+		auto resetSlots() -> void;
 
 	};
 };
\ No newline at end of file
@@ -85,7 +85,7 @@ namespace Maple
 		//terr->setIndicesSize(indices.size());
 		//terr->setTexture(Texture2D::create("default", "textures/terrain/rock.jpg"));
 		auto terr = std::make_shared<QuadCollapseMesh>();
-		terr->build(vertices, heightMap->getWidth(), heightMap->getHeight());
+		terr->build(std::move(vertices), heightMap->getWidth(), heightMap->getHeight());
 		terr->heightMap = Texture2D::create("height", name);
 		return terr;
 
@@ -6,174 +6,275 @@
 #include "ThreadPool.h"
 #include "Application.h"
 #include "Engine/Profiler.h"
+#include <algorithm>
 
 namespace Maple
 {
+	namespace
+	{
+		thread_local const ThreadPool* currentPool = nullptr;
+		thread_local int32_t currentIndex = -1;
+		//spin a little before going to sleep, jobs usually come in bursts.
+		constexpr int32_t SPIN_COUNT = 64;
+	};
+
 	auto Thread::sleep(int64_t ms) -> void
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 	}
 
-	Thread::Thread(const std::string& name)
-		:name(name)
+	TaskGroup::TaskGroup(ThreadPool& pool)
+		:pool(pool)
 	{
-		thread = std::make_shared<std::thread>(&Thread::run, this);
 	}
 
-	Thread::~Thread()
+	TaskGroup::~TaskGroup()
 	{
-		if (thread->joinable())
-		{
-			wait();
-			mutex.lock();
-			close = true;
-			condition.notify_one();
-			mutex.unlock();
-			thread->join();
-		}
+		wait();
 	}
 
-	auto Thread::wait() -> void
+	auto TaskGroup::run(const std::function<void()>& func) -> void
 	{
-		std::unique_lock<std::mutex> lock(mutex);
-		condition.wait(lock, [this]() {
-			return jobs.empty();
-			});
+		pending.fetch_add(1, std::memory_order_relaxed);
+		pool.push(new ThreadPool::Job{ func, this });
 	}
-	auto Thread::getTaskSize() -> int32_t
+
+	auto TaskGroup::wait() -> void
 	{
-		std::lock_guard<std::mutex> lock(mutex);
-		return jobs.size();
+		PROFILE_FUNCTION();
+		while (!isDone())
+		{
+			if (!pool.helpOne())
+				std::this_thread::yield();
+		}
 	}
 
-	auto Thread::addTask(const Task& task) -> void
+	ThreadPool::ThreadPool(int32_t count)
 	{
-		std::lock_guard<std::mutex> lock(mutex);
-		jobs.emplace_back(task);
-		condition.notify_one();
+		//queue 0 belongs to the thread which creates the pool (the main thread).
+		for (int32_t i = 0; i <= count; i++)
+		{
+			queues.emplace_back(std::make_unique<WorkStealingQueue<Job>>());
+		}
+
+		if (currentPool == nullptr)
+		{
+			currentPool = this;
+			currentIndex = 0;
+		}
+
+		for (int32_t i = 0; i < count; i++)
+		{
+			threads.emplace_back(&ThreadPool::run, this, i + 1);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		waitAll();
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			close = true;
+			condition.notify_all();
+		}
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		if (currentPool == this)
+		{
+			currentPool = nullptr;
+			currentIndex = -1;
+		}
 	}
 
-	auto Thread::addTask(const std::function<void*()> & job, const std::function<void(void*)> & complete) -> void
+	auto ThreadPool::getWorkerIndex() const -> int32_t
 	{
-		std::lock_guard<std::mutex> lock(mutex);
-		jobs.emplace_back(job, complete);
-		condition.notify_one();
+		return currentPool == this ? currentIndex : -1;
 	}
 
-	auto Thread::run() -> void
+	auto ThreadPool::push(Job* job) -> void
 	{
-		PROFILE_SETTHREADNAME(name.c_str());
-		PROFILE_FUNCTION();
-		while (true)
+		const int32_t index = getWorkerIndex();
+		if (index < 0 || !queues[index]->push(job))
 		{
-			Task task;
-			{
-				std::unique_lock<std::mutex> lock(mutex);
-				condition.wait(lock, [this] {
-					return !jobs.empty() || close;
-					});
+			std::lock_guard<std::mutex> lock(sharedMutex);
+			sharedQueue.emplace_back(job);
+			sharedCount.fetch_add(1, std::memory_order_relaxed);
+		}
 
-				if (close)
-				{
-					break;
-				}
+		pending.fetch_add(1);
+		if (sleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			condition.notify_one();
+		}
+	}
 
-				task = jobs.front();
-			}
+	auto ThreadPool::findJob(int32_t index) -> Job*
+	{
+		Job* job = nullptr;
 
-			if (task.job)
+		if (index >= 0)
+		{
+			job = queues[index]->pop();
+		}
+
+		if (job == nullptr && sharedCount.load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> lock(sharedMutex);
+			if (!sharedQueue.empty())
 			{
-				void* result = task.job();
-				if (task.complete)
-				{
-					Application::get()->postOnMainThread([=]() {
-						task.complete(result);
-						return true;
-					});
-					/*if (task.wait)
-					{
-						future.wait();
-					}*/
-				}
+				job = sharedQueue.front();
+				sharedQueue.pop_front();
+				sharedCount.fetch_sub(1, std::memory_order_relaxed);
 			}
+		}
+
+		if (job == nullptr)
+		{
+			const int32_t count = static_cast<int32_t>(queues.size());
+			const int32_t start = index < 0 ? 0 : index + 1;
+			for (int32_t i = 0; i < count && job == nullptr; ++i)
 			{
-				std::lock_guard<std::mutex> lock(mutex);
-				jobs.pop_front();
-				condition.notify_one();
+				const int32_t victim = (start + i) % count;
+				if (victim != index)
+					job = queues[victim]->steal();
 			}
 		}
-	}
 
+		if (job != nullptr)
+		{
+			pending.fetch_sub(1);
+		}
+		return job;
+	}
 
-	ThreadPool::ThreadPool(int32_t count)
+	auto ThreadPool::execute(Job* job) -> void
 	{
-		for (int32_t i = 0; i < count; i++)
+		job->func();
+		if (job->group != nullptr)
 		{
-			threads.emplace_back(std::make_shared<Thread>("Thread:"+std::to_string(i)));
+			job->group->pending.fetch_sub(1, std::memory_order_release);
 		}
+		delete job;
 	}
 
-	auto ThreadPool::waitAll() -> void
+	auto ThreadPool::helpOne() -> bool
 	{
-		for (auto& i : threads)
+		if (auto job = findJob(getWorkerIndex()))
 		{
-			i->wait();
+			execute(job);
+			return true;
 		}
+		return false;
 	}
 
-	auto ThreadPool::addTask(const std::function<void*()> & job, const std::function<void(void*)> & complete, int32_t threadIndex) -> void
+	auto ThreadPool::run(int32_t index) -> void
 	{
-		if (threadIndex >= 0 && threadIndex < threads.size())
+		currentPool = this;
+		currentIndex = index;
+		const std::string name = "Worker:" + std::to_string(index);
+		PROFILE_SETTHREADNAME(name.c_str());
+
+		int32_t spin = 0;
+		while (!close)
 		{
-			threads[threadIndex]->addTask(job, complete);
+			if (auto job = findJob(index))
+			{
+				execute(job);
+				spin = 0;
+				continue;
+			}
+
+			if (++spin < SPIN_COUNT)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			spin = 0;
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleeping.fetch_add(1);
+			condition.wait(lock, [this] {
+				return pending.load() > 0 || close;
+			});
+			sleeping.fetch_sub(1);
 		}
-		else
+	}
+
+	auto ThreadPool::waitAll() -> void
+	{
+		PROFILE_FUNCTION();
+		while (outstanding.load(std::memory_order_acquire) > 0)
 		{
-			int32_t minLen = INT32_MAX;
-			int32_t minIndex = -1;
+			if (!helpOne())
+				std::this_thread::yield();
+		}
+	}
+
+	auto ThreadPool::addTask(const std::function<void*()> & job, const std::function<void(void*)> & complete) -> void
+	{
+		addTask(Thread::Task(job, complete));
+	}
 
-			for (int32_t i = 0; i < threads.size(); ++i)
+	auto ThreadPool::addTask(const Thread::Task& task) -> void
+	{
+		outstanding.fetch_add(1, std::memory_order_relaxed);
+		push(new Job{ [this, task]() {
+			if (task.job)
 			{
-				auto len = threads[i]->getTaskSize();
-				if (minLen > len)
+				void* result = task.job();
+				if (task.complete)
 				{
-					minLen = len;
-					minIndex = i;
-					if (minLen == 0)
-					{
-						break;
-					}
+					Application::get()->postOnMainThread([=]() {
+						task.complete(result);
+						return true;
+					});
 				}
 			}
-			threads[minIndex]->addTask(job, complete);
-		}
+			outstanding.fetch_sub(1, std::memory_order_release);
+		} });
 	}
 
-	auto ThreadPool::addTask(const Thread::Task& task, int32_t threadIndex) -> void
+	auto ThreadPool::parallelRange(int32_t begin, int32_t end, const std::function<void(int32_t, int32_t)>& func, int32_t grainSize) -> void
 	{
-		if (threadIndex >= 0 && threadIndex < threads.size())
+		PROFILE_FUNCTION();
+		const int32_t count = end - begin;
+		if (count <= 0)
+			return;
+
+		//a few chunks per thread so stealing can even out uneven work.
+		const int32_t chunks = static_cast<int32_t>(queues.size()) * 4;
+		const int32_t grain = std::max(grainSize, (count + chunks - 1) / chunks);
+
+		if (count <= grain || threads.empty())
 		{
-			threads[threadIndex]->addTask(task);
+			func(begin, end);
+			return;
 		}
-		else
+
+		TaskGroup group(*this);
+		for (int32_t i = begin + grain; i < end; i += grain)
 		{
-			int32_t minLen = INT32_MAX;
-			int32_t minIndex = -1;
+			const int32_t rangeEnd = std::min(i + grain, end);
+			group.run([&func, i, rangeEnd]() {
+				func(i, rangeEnd);
+			});
+		}
+		func(begin, begin + grain);
+		group.wait();
+	}
 
-			for (int32_t i = 0; i < threads.size(); ++i)
+	auto ThreadPool::parallelFor(int32_t begin, int32_t end, const std::function<void(int32_t)>& func, int32_t grainSize) -> void
+	{
+		parallelRange(begin, end, [&func](int32_t rangeBegin, int32_t rangeEnd) {
+			for (int32_t i = rangeBegin; i < rangeEnd; ++i)
 			{
-				auto len = threads[i]->getTaskSize();
-				if (minLen > len)
-				{
-					minLen = len;
-					minIndex = i;
-					if (minLen == 0)
-					{
-						break;
-					}
-				}
+				func(i);
 			}
-			threads[minIndex]->addTask(task);
-		}
+		}, grainSize);
 	}
-};
\ No newline at end of file
+};
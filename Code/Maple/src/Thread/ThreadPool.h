@@ -8,14 +8,18 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
-#include <list>
+#include <deque>
 #include <functional>
 #include <vector>
+#include "WorkStealingQueue.h"
 #include "Engine/Core.h"
 
-namespace Maple 
+namespace Maple
 {
+	class ThreadPool;
+
 	class MAPLE_EXPORT Thread
 	{
 	public:
@@ -25,37 +29,82 @@ namespace Maple
 			Task(const std::function<void*()> & j, std::function<void(void*)> c) : job(j), complete(c) {};
 			std::function<void*()> job;
 			std::function<void(void*)> complete;
-			bool wait = false;
 		};
 
 		static auto sleep(int64_t ms) -> void;
-		Thread(const std::string & name);
-		~Thread();
+	};
+
+	//fork/join group. wait() runs pending jobs on the calling thread until all the jobs of the group are finished.
+	class MAPLE_EXPORT TaskGroup
+	{
+	public:
+		TaskGroup(ThreadPool& pool);
+		~TaskGroup();
+		TaskGroup(const TaskGroup&) = delete;
+		auto operator=(const TaskGroup&) -> TaskGroup& = delete;
+
+		auto run(const std::function<void()>& func) -> void;
 		auto wait() -> void;
-		auto getTaskSize()->int32_t;
-		auto addTask(const Task & task) -> void;
-		auto addTask(const std::function<void*()> & job, const std::function<void(void*)> & complete) -> void;
+		inline auto isDone() const { return pending.load(std::memory_order_acquire) == 0; }
 	private:
-		auto run() -> void;
-		std::shared_ptr<std::thread> thread;
-		std::list<Task> jobs;
-		std::mutex mutex;
-		std::condition_variable condition;
-		bool close = false;
-		std::string name;
+		friend class ThreadPool;
+		ThreadPool& pool;
+		std::atomic<int32_t> pending{ 0 };
 	};
 
+	//Work-stealing scheduler.
+	//Every worker (and the thread which created the pool) owns a lock-free deque, idle workers steal from the others.
+	//Threads without a deque submit through a shared queue.
 	class MAPLE_EXPORT ThreadPool
 	{
 	public:
 		ThreadPool(int32_t threadCount);
+		~ThreadPool();
+
+		//runs jobs on the calling thread until every task posted with addTask has finished.
 		auto waitAll() -> void;
-		auto addTask(const Thread::Task& task, int32_t threadIndex = -1)  -> void;
-		auto addTask(const std::function<void*()> & job, const std::function<void(void*)> & complete = nullptr, int32_t threadIndex = -1) -> void;
-		inline auto& getThreads() { return threads; };
+		//complete is called on the main thread with the result of the job.
+		auto addTask(const Thread::Task& task) -> void;
+		auto addTask(const std::function<void*()> & job, const std::function<void(void*)> & complete = nullptr) -> void;
+
+		//func(index) for every index in [begin, end). blocks until all of them are finished.
+		auto parallelFor(int32_t begin, int32_t end, const std::function<void(int32_t)>& func, int32_t grainSize = 0) -> void;
+		//func(rangeBegin, rangeEnd) for chunks of [begin, end).
+		auto parallelRange(int32_t begin, int32_t end, const std::function<void(int32_t, int32_t)>& func, int32_t grainSize = 0) -> void;
+
+		//execute one pending job on the calling thread, returns false if no job was found.
+		auto helpOne() -> bool;
+
 		inline auto getThreadCount() const { return threads.size(); }
+		//-1 if the calling thread does not belong to the pool, 0 for the thread which created the pool.
+		auto getWorkerIndex() const -> int32_t;
+
 	private:
-		std::vector<std::shared_ptr<Thread>> threads;
+		friend class TaskGroup;
+
+		struct Job
+		{
+			std::function<void()> func;
+			TaskGroup* group = nullptr;
+		};
+
+		auto push(Job* job) -> void;
+		auto findJob(int32_t index) -> Job*;
+		auto execute(Job* job) -> void;
+		auto run(int32_t index) -> void;
+
+		std::vector<std::thread> threads;
+		std::vector<std::unique_ptr<WorkStealingQueue<Job>>> queues;
+
+		std::mutex sharedMutex;
+		std::deque<Job*> sharedQueue;
+		std::atomic<int32_t> sharedCount{ 0 };
+
+		std::mutex sleepMutex;
+		std::condition_variable condition;
+		std::atomic<int32_t> pending{ 0 };
+		std::atomic<int32_t> sleeping{ 0 };
+		std::atomic<int32_t> outstanding{ 0 };
+		std::atomic<bool> close{ false };
 	};
 };
-
@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstdint>
+
+namespace Maple
+{
+	//Chase-Lev work-stealing deque with a fixed capacity.
+	//push/pop are only called by the owner thread, steal can be called from any thread.
+	template<typename T, int64_t Capacity = 4096>
+	class WorkStealingQueue
+	{
+		static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+	public:
+		//returns false if the queue is full.
+		inline auto push(T* item) -> bool
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed);
+			const int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= Capacity)
+				return false;
+
+			items[b & MASK].store(item, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		inline auto pop() -> T*
+		{
+			const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				//empty
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			T* item = items[b & MASK].load(std::memory_order_relaxed);
+			if (t == b)
+			{
+				//last item, race against the thieves
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					item = nullptr;
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		inline auto steal() -> T*
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t b = bottom.load(std::memory_order_acquire);
+
+			if (t >= b)
+				return nullptr;
+
+			T* item = items[t & MASK].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+			return item;
+		}
+
+		inline auto empty() const -> bool
+		{
+			return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+		}
+
+	private:
+		static constexpr int64_t MASK = Capacity - 1;
+		alignas(64) std::atomic<int64_t> top{ 0 };
+		alignas(64) std::atomic<int64_t> bottom{ 0 };
+		std::array<std::atomic<T*>, Capacity> items;
+	};
+};
@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//VulkanAllocator::get, allocateBuffer and allocateImage talk to the device, the check never calls them.
+//These definitions only satisfy the linker and abort if they are reached.
+
+#include <cstdio>
+#include <cstdlib>
+#include "Engine/Vulkan/VulkanDevice.h"
+#include "Engine/Vulkan/VulkanHelper.h"
+#include "Others/Console.h"
+
+namespace
+{
+	[[noreturn]] auto unreachable(const char* name) -> void
+	{
+		printf("%s called without a device\n", name);
+		abort();
+	}
+};
+
+namespace Maple
+{
+	std::shared_ptr<spdlog::logger> Console::logger = spdlog::default_logger();
+
+	auto VulkanDevice::get() -> std::shared_ptr<VulkanDevice>
+	{
+		unreachable("VulkanDevice::get");
+	}
+
+	auto VulkanHelper::errorString(VkResult errorCode) -> std::string
+	{
+		unreachable("VulkanHelper::errorString");
+	}
+};
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo*, const VkAllocationCallbacks*, VkDeviceMemory*)
+{
+	unreachable("vkAllocateMemory");
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory, const VkAllocationCallbacks*)
+{
+	unreachable("vkFreeMemory");
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void**)
+{
+	unreachable("vkMapMemory");
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory(VkDevice, VkBuffer, VkDeviceMemory, VkDeviceSize)
+{
+	unreachable("vkBindBufferMemory");
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory(VkDevice, VkImage, VkDeviceMemory, VkDeviceSize)
+{
+	unreachable("vkBindImageMemory");
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(VkDevice, VkBuffer, VkMemoryRequirements*)
+{
+	unreachable("vkGetBufferMemoryRequirements");
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(VkDevice, VkImage, VkMemoryRequirements*)
+{
+	unreachable("vkGetImageMemoryRequirements");
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties*)
+{
+	unreachable("vkGetPhysicalDeviceMemoryProperties");
+}
@@ -0,0 +1,371 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Checks MemoryBlock and VulkanAllocator on the CPU : best fit, alignment, dedicated allocations,
+//free and coalesce, the empty block kept per pool and defragment.
+//The device memory comes from a mock Backend which hands out host buffers and tracks what is still alive.
+//usage : AllocatorCheck
+//returns 0 if every test passes.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "Engine/Vulkan/VulkanAllocator.h"
+
+using namespace Maple;
+
+namespace
+{
+	std::mt19937 rng(3);
+
+	auto check(bool condition, const char* what) -> bool
+	{
+		if (!condition)
+			printf("  WRONG : %s\n", what);
+		return condition;
+	}
+
+	//device memory handed out as host buffers
+	struct MockDevice
+	{
+		struct Memory
+		{
+			uint32_t memoryType;
+			std::vector<uint8_t> data;
+		};
+
+		std::map<VkDeviceMemory, Memory> memories;
+		uint64_t nextHandle = 1;
+		uint32_t allocations = 0;
+		uint32_t frees = 0;
+		bool fail = false;
+
+		auto backend() -> VulkanAllocator::Backend
+		{
+			VulkanAllocator::Backend backend;
+			backend.allocate = [this](uint32_t memoryType, VkDeviceSize size) {
+				if (fail)
+					return (VkDeviceMemory)VK_NULL_HANDLE;
+				auto memory = reinterpret_cast<VkDeviceMemory>(nextHandle++);
+				memories[memory] = { memoryType, std::vector<uint8_t>(size) };
+				allocations++;
+				return memory;
+			};
+			backend.free = [this](VkDeviceMemory memory) {
+				if (memories.erase(memory) == 0)
+					printf("  WRONG : free of an unknown memory\n");
+				frees++;
+			};
+			backend.map = [this](VkDeviceMemory memory) -> void* {
+				return memories.at(memory).data.data();
+			};
+			return backend;
+		}
+
+		auto size(VkDeviceMemory memory) const -> VkDeviceSize
+		{
+			return memories.at(memory).data.size();
+		}
+	};
+
+	const std::vector<VkMemoryPropertyFlags> memoryTypes = {
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	};
+
+	constexpr VkDeviceSize BLOCK_SIZE = 1024 * 1024;
+	constexpr VkDeviceSize ATOM_SIZE = 256;
+
+	auto requirements(VkDeviceSize size, VkDeviceSize alignment, uint32_t typeBits = 0x3) -> VkMemoryRequirements
+	{
+		return { size, alignment, typeBits };
+	}
+
+	auto findStats(const VulkanAllocator& allocator, uint32_t memoryType, bool linear) -> VulkanAllocator::PoolStats
+	{
+		for (auto& stat : allocator.getPoolStats())
+		{
+			if (stat.memoryType == memoryType && stat.linear == linear)
+				return stat;
+		}
+		return {};
+	}
+
+	struct Live
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	//sorted by offset, neighbours must not overlap
+	auto overlapping(std::vector<Live> lives) -> bool
+	{
+		std::sort(lives.begin(), lives.end(), [](const Live& a, const Live& b) { return a.offset < b.offset; });
+		for (size_t i = 1; i < lives.size(); i++)
+		{
+			if (lives[i - 1].offset + lives[i - 1].size > lives[i].offset)
+				return true;
+		}
+		return false;
+	}
+
+	//[0,100) [100,400) [400,500) [500,700) [700,800), then the 300 and 200 holes are freed
+	auto checkBestFit() -> bool
+	{
+		MemoryBlock block(1000);
+		bool passed = true;
+		const uint64_t a = block.allocate(100, 1);
+		const uint64_t b = block.allocate(300, 1);
+		const uint64_t c = block.allocate(100, 1);
+		const uint64_t d = block.allocate(200, 1);
+		const uint64_t e = block.allocate(100, 1);
+		passed &= check(a == 0 && b == 100 && c == 400 && d == 500 && e == 700, "packed from the start");
+
+		block.free(b, 300);
+		block.free(d, 200);
+		passed &= check(block.getFreeRangeCount() == 3 && block.getUsed() == 300, "three free ranges");
+
+		//190 wastes 110 in the first hole and 10 in the other two, the first of those wins
+		const uint64_t x = block.allocate(190, 1);
+		passed &= check(x == 500, "smallest fitting hole");
+
+		//exact fit of the tail removes the range
+		const uint64_t y = block.allocate(200, 1);
+		passed &= check(y == 800 && block.getFreeRangeCount() == 2, "exact fit");
+
+		//the padding in front of an aligned allocation stays free
+		const uint64_t z = block.allocate(50, 64);
+		passed &= check(z == 128 && block.getFreeRangeCount() == 3, "alignment padding kept");
+		passed &= check(block.allocate(300, 1) == MemoryBlock::INVALID_OFFSET, "no room");
+		passed &= check(block.getAllocationCount() == 6 && block.getUsed() == 740, "allocation count and used");
+
+		const Live lives[] = { { a, 100 }, { c, 100 }, { e, 100 }, { x, 190 }, { y, 200 }, { z, 50 } };
+		for (auto& live : { lives[3], lives[0], lives[5], lives[2], lives[1], lives[4] })
+			block.free(live.offset, live.size);
+		passed &= check(block.isEmpty() && block.getUsed() == 0, "empty after free");
+		passed &= check(block.getFreeRangeCount() == 1 && block.getLargestFree() == 1000, "coalesced to one range");
+
+		printf("MemoryBlock best fit : %s\n", passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//random allocations and frees, everything must stay aligned, inside the block and apart
+	auto checkRandomBlock() -> bool
+	{
+		constexpr uint64_t size = 1 << 20;
+		MemoryBlock block(size);
+		std::vector<Live> lives;
+		bool passed = true;
+		uint32_t failed = 0;
+
+		for (int32_t i = 0; i < 20000 && passed; i++)
+		{
+			if (!lives.empty() && (rng() % 100 < 45 || lives.size() > 400))
+			{
+				const size_t index = rng() % lives.size();
+				block.free(lives[index].offset, lives[index].size);
+				lives[index] = lives.back();
+				lives.pop_back();
+				continue;
+			}
+			const uint64_t allocSize = 1 + rng() % 8192;
+			const uint64_t alignment = 1ull << (rng() % 9);
+			const uint64_t offset = block.allocate(allocSize, alignment);
+			if (offset == MemoryBlock::INVALID_OFFSET)
+			{
+				failed++;
+				continue;
+			}
+			passed &= check(offset % alignment == 0 && offset + allocSize <= size, "aligned and inside the block");
+			lives.push_back({ offset, allocSize });
+			if (i % 100 == 0)
+				passed &= check(!overlapping(lives), "allocations apart");
+		}
+
+		uint64_t used = 0;
+		for (auto& live : lives)
+			used += live.size;
+		passed &= check(!overlapping(lives) && block.getUsed() == used && block.getAllocationCount() == lives.size(), "bookkeeping matches");
+
+		for (auto& live : lives)
+			block.free(live.offset, live.size);
+		passed &= check(block.getFreeRangeCount() == 1 && block.getLargestFree() == size, "coalesced to one range");
+
+		printf("MemoryBlock random : %u full, %s\n", failed, passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	auto checkAllocate() -> bool
+	{
+		MockDevice device;
+		bool passed = true;
+		{
+			VulkanAllocator allocator(memoryTypes, device.backend(), BLOCK_SIZE, ATOM_SIZE);
+
+			//buffers and images of the same memory type live in different blocks
+			auto buffer0 = allocator.allocate(requirements(1000, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			auto buffer1 = allocator.allocate(requirements(1000, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			auto image = allocator.allocate(requirements(4096, 4096), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+			passed &= check(buffer0.memory == buffer1.memory && buffer0.offset == 0 && buffer1.offset == 1008, "buffers share a block");
+			passed &= check(buffer0.block == 0 && buffer0.mapped == nullptr, "device local is not mapped");
+			passed &= check(image.memory != buffer0.memory && image.pool != buffer0.pool, "images in their own pool");
+			passed &= check(device.allocations == 2 && device.size(buffer0.memory) == BLOCK_SIZE, "one block per pool");
+
+			//above half a block gets its own memory, half a block is still sub-allocated
+			auto large = allocator.allocate(requirements(BLOCK_SIZE / 2 + 1, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			auto half = allocator.allocate(requirements(BLOCK_SIZE / 2, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+			passed &= check(large.block == -1 && large.offset == 0 && device.size(large.memory) == BLOCK_SIZE / 2 + 1, "dedicated above half a block");
+			passed &= check(half.block == 0 && half.memory == buffer0.memory, "half a block sub-allocated");
+
+			auto stats = findStats(allocator, 0, true);
+			passed &= check(stats.blockCount == 1 && stats.dedicatedCount == 1 && stats.allocationCount == 4, "pool stats counts");
+			passed &= check(stats.reserved == BLOCK_SIZE + BLOCK_SIZE / 2 + 1 && stats.used == 2000 + BLOCK_SIZE / 2 + BLOCK_SIZE / 2 + 1, "pool stats sizes");
+
+			//host visible : sizes and offsets rounded to the atom, the mapping points at the offset
+			auto staging0 = allocator.allocate(requirements(100, 4), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			auto staging1 = allocator.allocate(requirements(100, 4), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			auto* base = device.memories.at(staging0.memory).data.data();
+			passed &= check(staging0.size == ATOM_SIZE && staging1.offset == ATOM_SIZE, "atom size alignment");
+			passed &= check(staging0.mapped == base && staging1.mapped == base + ATOM_SIZE, "mapped at the offset");
+			auto largeStaging = allocator.allocate(requirements(BLOCK_SIZE, 4), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+			passed &= check(largeStaging.mapped == device.memories.at(largeStaging.memory).data.data(), "dedicated host visible mapped");
+
+			//no matching type and a failing driver
+			bool thrown = false;
+			try { allocator.allocate(requirements(100, 4, 0x1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true); }
+			catch (const std::runtime_error&) { thrown = true; }
+			passed &= check(thrown && allocator.findMemoryType(0x1, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == -1, "no memory type");
+			device.fail = true;
+			thrown = false;
+			try { allocator.allocate(requirements(BLOCK_SIZE, 4), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true); }
+			catch (const std::runtime_error&) { thrown = true; }
+			passed &= check(thrown, "driver failure");
+			device.fail = false;
+
+			allocator.free(large);
+			passed &= check(!large && device.memories.size() == 4, "dedicated freed at once");
+
+			//the staging and image blocks stay allocated, the destructor gives them back
+			allocator.free(buffer0);
+			allocator.free(buffer1);
+			allocator.free(half);
+			stats = findStats(allocator, 0, true);
+			passed &= check(stats.blockCount == 1 && stats.allocationCount == 0 && stats.freeRangeCount == 1 && stats.largestFree == BLOCK_SIZE, "empty block coalesced and kept");
+			allocator.free(buffer0);
+			passed &= check(device.frees == 1, "double free ignored");
+		}
+		passed &= check(device.memories.size() == 1, "blocks freed by the destructor, the leaked dedicated one left");
+
+		printf("VulkanAllocator allocate : %s\n", passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//one empty block per pool survives free, defragment gives back the rest
+	auto checkRelease() -> bool
+	{
+		MockDevice device;
+		VulkanAllocator allocator(memoryTypes, device.backend(), BLOCK_SIZE, ATOM_SIZE);
+		bool passed = true;
+
+		const auto third = requirements(BLOCK_SIZE * 3 / 8, 256);
+		std::vector<VulkanAllocation> allocations;
+		for (int32_t i = 0; i < 5; i++)
+			allocations.emplace_back(allocator.allocate(third, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true));
+		passed &= check(findStats(allocator, 0, true).blockCount == 3 && allocations[4].block == 2, "two allocations per block");
+
+		//emptying block 2 while block 0 and 1 are in use keeps it
+		allocator.free(allocations[4]);
+		passed &= check(device.frees == 0 && findStats(allocator, 0, true).blockCount == 3, "first empty block kept");
+		//emptying block 0 with block 2 already empty releases it
+		allocator.free(allocations[0]);
+		allocator.free(allocations[1]);
+		passed &= check(device.frees == 1 && findStats(allocator, 0, true).blockCount == 2, "second empty block released");
+
+		//the released slot is used again before the pool grows
+		auto refill = allocator.allocate(requirements(BLOCK_SIZE / 2, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		auto fill = allocator.allocate(requirements(BLOCK_SIZE / 2, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		auto grow = allocator.allocate(requirements(BLOCK_SIZE / 2, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+		passed &= check(refill.block == 2 && fill.block == 2 && grow.block == 0 && device.allocations == 4, "released slot reused");
+
+		auto staging = allocator.allocate(requirements(100, 4), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+		allocator.free(staging);
+		allocator.free(refill);
+		allocator.free(fill);
+		allocator.free(grow);
+		passed &= check(device.frees == 2 && findStats(allocator, 0, true).blockCount == 2 && findStats(allocator, 1, true).blockCount == 1, "empty blocks before defragment");
+
+		//block 1 still holds two allocations, the empty block 2 and the staging block go
+		const uint32_t released = allocator.defragment();
+		auto stats = findStats(allocator, 0, true);
+		passed &= check(released == 2 && stats.blockCount == 1 && stats.allocationCount == 2, "defragment released the empty blocks");
+		passed &= check(findStats(allocator, 1, true).blockCount == 0 && device.memories.size() == 1, "only the used block left");
+
+		allocator.free(allocations[2]);
+		allocator.free(allocations[3]);
+		passed &= check(allocator.defragment() == 1 && device.memories.empty() && allocator.getPoolStats().empty(), "nothing left after the last defragment");
+
+		printf("VulkanAllocator free and defragment : %u blocks allocated, %u released, %s\n", device.allocations, device.frees, passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//random mixed traffic, no two live allocations overlap in the same memory
+	auto checkRandomAllocator() -> bool
+	{
+		MockDevice device;
+		VulkanAllocator allocator(memoryTypes, device.backend(), BLOCK_SIZE, ATOM_SIZE);
+		std::vector<VulkanAllocation> lives;
+		bool passed = true;
+
+		for (int32_t i = 0; i < 20000; i++)
+		{
+			if (!lives.empty() && (rng() % 100 < 45 || lives.size() > 300))
+			{
+				const size_t index = rng() % lives.size();
+				allocator.free(lives[index]);
+				lives[index] = lives.back();
+				lives.pop_back();
+				continue;
+			}
+			const VkDeviceSize size = rng() % 50 == 0 ? BLOCK_SIZE / 2 + rng() % BLOCK_SIZE : 1 + rng() % (BLOCK_SIZE / 16);
+			const VkDeviceSize alignment = 1ull << (rng() % 13);
+			const auto properties = rng() % 4 == 0 ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			auto allocation = allocator.allocate(requirements(size, alignment), properties, rng() % 2 == 0);
+			passed &= check(allocation.offset % alignment == 0 && allocation.size >= size, "aligned");
+			passed &= check(allocation.offset + allocation.size <= device.size(allocation.memory), "inside the memory");
+			lives.emplace_back(allocation);
+		}
+
+		std::map<VkDeviceMemory, std::vector<Live>> perMemory;
+		for (auto& live : lives)
+			perMemory[live.memory].push_back({ live.offset, live.size });
+		for (auto& memory : perMemory)
+			passed &= check(!overlapping(memory.second), "allocations apart");
+
+		const uint32_t peak = device.allocations;
+		for (auto& live : lives)
+			allocator.free(live);
+		allocator.defragment();
+		passed &= check(device.memories.empty(), "everything given back");
+
+		printf("VulkanAllocator random : %u device allocations, %s\n", peak, passed ? "ok" : "WRONG");
+		return passed;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	bool passed = checkBestFit();
+	passed &= checkRandomBlock();
+	passed &= checkAllocate();
+	passed &= checkRelease();
+	passed &= checkRandomAllocator();
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Maple
+{
+	//the part of Texture2D the streamer uses, uploadAsync goes to the upload queue of main.cpp instead of the GPU.
+	class Texture
+	{
+	public:
+		Texture() = default;
+		virtual ~Texture() = default;
+		inline auto getWidth() const { return width; }
+		inline auto getHeight() const { return height; }
+		inline auto getVersion() const { return version; }
+
+	protected:
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t version = 0;
+	};
+
+	class Texture2D : public Texture
+	{
+	public:
+		static auto createFromSource(uint32_t w, uint32_t h, const uint8_t* data)->std::shared_ptr<Texture2D>;
+
+		inline auto getFilePath() const -> const std::string& { return fileName; };
+		inline auto setFilePath(const std::string& path) -> void { fileName = path; };
+
+		virtual auto uploadAsync(uint32_t w, uint32_t h, const uint8_t* data, bool mipmaps, const std::function<void()>& onReady = nullptr) -> void;
+		//the swap done by the upload queue once the copy has finished
+		auto swap(uint32_t w, uint32_t h) -> void;
+
+	protected:
+		std::string fileName;
+	};
+};
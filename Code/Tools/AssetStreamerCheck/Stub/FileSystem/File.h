@@ -0,0 +1,17 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+
+namespace Maple
+{
+	//the files are the images registered in main.cpp
+	class File
+	{
+	public:
+		static auto fileExists(const std::string& file) -> bool;
+	};
+};
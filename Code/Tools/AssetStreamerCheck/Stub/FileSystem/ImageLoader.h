@@ -0,0 +1,19 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <memory>
+#include <string>
+#include "FileSystem/Image.h"
+
+namespace Maple
+{
+	//decodes the images registered in main.cpp, the pixels are a function of the position
+	class ImageLoader final
+	{
+	public:
+		static auto loadAsset(const std::string& name, bool mipmaps = true)->std::unique_ptr<Image>;
+	};
+};
@@ -0,0 +1,29 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace Maple
+{
+	class Texture;
+
+	class TextureCache
+	{
+	public:
+		static auto add(const std::string& id, const std::shared_ptr<Texture>& ptr) -> void
+		{
+			getCache()[id] = ptr;
+		}
+
+		static auto getCache() -> std::unordered_map<std::string, std::shared_ptr<Texture>>&
+		{
+			static std::unordered_map<std::string, std::shared_ptr<Texture>> cache;
+			return cache;
+		}
+	};
+};
@@ -0,0 +1,327 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Checks the AssetStreamer on the CPU : the low mip it builds, the placeholder -> Low -> Full transitions
+//and the per-frame byte budget of update(). Texture2D::uploadAsync is replaced by a queue which the
+//check finishes itself, the headers in Stub stand in for the renderer and the file system.
+//usage : AssetStreamerCheck
+//returns 0 if every test passes.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "Engine/AssetStreamer.h"
+#include "Engine/Interface/Texture.h"
+#include "FileSystem/File.h"
+#include "FileSystem/ImageLoader.h"
+#include "Resources/TextureCache.h"
+#include "Thread/ThreadPool.h"
+#include "Others/Console.h"
+
+namespace Maple
+{
+	std::shared_ptr<spdlog::logger> Console::logger = spdlog::default_logger();
+};
+
+using namespace Maple;
+
+namespace
+{
+	struct Upload
+	{
+		Texture2D* texture;
+		uint32_t width;
+		uint32_t height;
+		std::vector<uint8_t> pixels;
+		std::function<void()> onReady;
+	};
+
+	struct ImageInfo
+	{
+		uint32_t width;
+		uint32_t height;
+		TextureFormat format;
+	};
+
+	//submitted by uploadAsync, finished by the check as the upload queue would in a later frame
+	std::vector<Upload> uploads;
+	std::map<std::string, ImageInfo> images;
+
+	auto pixel(uint32_t x, uint32_t y, uint32_t c) -> uint8_t
+	{
+		return static_cast<uint8_t>((x * 7 + y * 13 + c * 61 + (x * y) % 17) & 0xff);
+	}
+
+	auto finishUploads() -> void
+	{
+		auto finished = std::move(uploads);
+		uploads.clear();
+		for (auto& upload : finished)
+		{
+			upload.texture->swap(upload.width, upload.height);
+			if (upload.onReady)
+				upload.onReady();
+		}
+	}
+};
+
+namespace Maple
+{
+	auto Texture2D::createFromSource(uint32_t w, uint32_t h, const uint8_t* data) -> std::shared_ptr<Texture2D>
+	{
+		auto texture = std::make_shared<Texture2D>();
+		texture->width = w;
+		texture->height = h;
+		return texture;
+	}
+
+	auto Texture2D::uploadAsync(uint32_t w, uint32_t h, const uint8_t* data, bool mipmaps, const std::function<void()>& onReady) -> void
+	{
+		uploads.push_back({ this, w, h, std::vector<uint8_t>(data, data + w * h * 4), onReady });
+	}
+
+	auto Texture2D::swap(uint32_t w, uint32_t h) -> void
+	{
+		width = w;
+		height = h;
+		version++;
+	}
+
+	auto File::fileExists(const std::string& file) -> bool
+	{
+		return images.find(file) != images.end();
+	}
+
+	auto ImageLoader::loadAsset(const std::string& name, bool mipmaps) -> std::unique_ptr<Image>
+	{
+		auto& info = images.at(name);
+		const uint32_t channels = info.format == TextureFormat::RGBA8 ? 4 : 3;
+		const uint32_t size = info.width * info.height * channels;
+		auto data = static_cast<uint8_t*>(malloc(size));
+		for (uint32_t y = 0; y < info.height; y++)
+			for (uint32_t x = 0; x < info.width; x++)
+				for (uint32_t c = 0; c < channels; c++)
+					data[(y * info.width + x) * channels + c] = pixel(x, y, c);
+		return std::make_unique<Image>(info.format, info.width, info.height, data, size, channels, mipmaps);
+	}
+};
+
+namespace
+{
+	auto check(bool condition, const char* what) -> bool
+	{
+		if (!condition)
+			printf("  WRONG : %s\n", what);
+		return condition;
+	}
+
+	//load the textures and run the decode jobs, nothing is uploaded before update()
+	auto load(AssetStreamer& streamer, ThreadPool& pool, const std::vector<std::string>& paths) -> std::vector<std::shared_ptr<StreamedTexture>>
+	{
+		std::vector<std::shared_ptr<StreamedTexture>> textures;
+		for (auto& path : paths)
+			textures.emplace_back(streamer.loadTexture(path));
+		pool.waitAll();
+		return textures;
+	}
+
+	//the low mip is the box filtered image, halved until the largest side fits LOW_MIP_SIZE
+	auto checkDownsample(ThreadPool& pool) -> bool
+	{
+		struct Case
+		{
+			uint32_t width;
+			uint32_t height;
+			uint32_t lowWidth;
+			uint32_t lowHeight;
+		};
+		const Case cases[] = {
+			{ 300, 200, 37, 25 },
+			{ 50, 10, 50, 10 },
+			{ 64, 64, 64, 64 },
+			{ 65, 64, 32, 32 },
+			{ 1, 1000, 1, 62 },
+			{ 1024, 512, 64, 32 },
+		};
+
+		bool passed = true;
+		for (auto& c : cases)
+		{
+			const std::string path = "downsample_" + std::to_string(c.width) + "x" + std::to_string(c.height) + ".png";
+			images[path] = { c.width, c.height, TextureFormat::RGBA8 };
+
+			AssetStreamer streamer(pool, UINT64_MAX);
+			auto texture = load(streamer, pool, { path })[0];
+			streamer.update();
+
+			//the low mip goes first, then the full image in the same frame
+			bool ok = check(uploads.size() == 2, "two uploads");
+			if (ok)
+			{
+				auto& low = uploads[0];
+				ok &= check(low.width == c.lowWidth && low.height == c.lowHeight, "low mip size");
+				uint32_t factor = c.width / c.lowWidth;
+				if (c.lowWidth == 1)
+					factor = c.height / c.lowHeight;
+
+				for (uint32_t y = 0; ok && y < low.height; y++)
+				{
+					for (uint32_t x = 0; ok && x < low.width; x++)
+					{
+						for (uint32_t ch = 0; ch < 4; ch++)
+						{
+							uint32_t sum = 0, count = 0;
+							for (uint32_t sy = y * factor; sy < std::min(c.height, (y + 1) * factor); sy++)
+								for (uint32_t sx = x * factor; sx < std::min(c.width, (x + 1) * factor); sx++, count++)
+									sum += pixel(sx, sy, ch);
+							if (low.pixels[(y * low.width + x) * 4 + ch] != sum / count)
+							{
+								ok = check(false, "low mip pixel");
+								break;
+							}
+						}
+					}
+				}
+				auto& full = uploads[1];
+				ok &= check(full.width == c.width && full.height == c.height && full.pixels.back() == pixel(c.width - 1, c.height - 1, 3), "full image");
+			}
+			finishUploads();
+			printf("downsample %ux%u -> %ux%u : %s\n", c.width, c.height, c.lowWidth, c.lowHeight, ok ? "ok" : "WRONG");
+			passed &= ok;
+		}
+		return passed;
+	}
+
+	auto checkTransitions(ThreadPool& pool) -> bool
+	{
+		images["transition.png"] = { 128, 96, TextureFormat::RGBA8 };
+		images["transition_late_low.png"] = { 128, 96, TextureFormat::RGBA8 };
+
+		AssetStreamer streamer(pool, UINT64_MAX);
+		auto texture = streamer.loadTexture("transition.png");
+		bool passed = check(texture->getQuality() == StreamedTexture::Quality::Placeholder, "placeholder after loadTexture");
+		passed &= check(texture->getTexture() != nullptr && texture->getTexture()->getWidth() == 1, "1x1 placeholder texture");
+		passed &= check(TextureCache::getCache()["transition.png"] == texture->getTexture(), "placeholder in the texture cache");
+		passed &= check(streamer.loadTexture("transition.png") == texture, "same handle for the same path");
+		pool.waitAll();
+		passed &= check(texture->getQuality() == StreamedTexture::Quality::Placeholder && uploads.empty(), "nothing uploaded before update");
+
+		streamer.update();
+		passed &= check(uploads.size() == 2 && texture->getQuality() == StreamedTexture::Quality::Placeholder, "placeholder until the low mip is uploaded");
+
+		//finish the low mip alone
+		auto full = std::move(uploads[1]);
+		uploads.pop_back();
+		finishUploads();
+		passed &= check(texture->getQuality() == StreamedTexture::Quality::Low && texture->getTexture()->getWidth() == 64, "low after the low mip upload");
+		passed &= check(texture->getFuture().wait_for(std::chrono::seconds(0)) == std::future_status::timeout, "future not ready at low");
+
+		uploads.emplace_back(std::move(full));
+		finishUploads();
+		passed &= check(texture->getQuality() == StreamedTexture::Quality::Full && texture->getTexture()->getWidth() == 128, "full after the full upload");
+		passed &= check(texture->getFuture().get() == texture->getTexture(), "future holds the texture");
+
+		//a low mip finishing after the full image does not downgrade it
+		auto late = streamer.loadTexture("transition_late_low.png");
+		pool.waitAll();
+		streamer.update();
+		std::swap(uploads[0], uploads[1]);
+		finishUploads();
+		passed &= check(late->getQuality() == StreamedTexture::Quality::Full, "full kept when the low mip finishes last");
+
+		printf("placeholder -> low -> full : %s\n", passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	auto checkFailures(ThreadPool& pool) -> bool
+	{
+		images["rgb.png"] = { 32, 32, TextureFormat::RGB8 };
+
+		AssetStreamer streamer(pool, UINT64_MAX);
+		auto textures = load(streamer, pool, { "missing.png", "rgb.png" });
+		streamer.update();
+		bool passed = check(uploads.empty(), "nothing uploaded");
+		for (auto& texture : textures)
+		{
+			passed &= check(texture->getQuality() == StreamedTexture::Quality::Failed, "failed quality");
+			passed &= check(texture->getFuture().get() == nullptr, "future holds nullptr");
+		}
+		passed &= check(streamer.getPendingCount() == 0, "nothing pending");
+		printf("missing file and 24 bit image : %s\n", passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//full images wait for a frame with budget left, one goes through per frame even when it is larger than the budget
+	auto checkBudget(ThreadPool& pool) -> bool
+	{
+		bool passed = true;
+		std::vector<std::string> paths;
+		for (int32_t i = 0; i < 5; i++)
+		{
+			paths.emplace_back("budget_" + std::to_string(i) + ".png");
+			images[paths.back()] = { 256, 256, TextureFormat::RGBA8 };
+		}
+		const uint64_t imageSize = 256 * 256 * 4;
+
+		struct Case
+		{
+			uint64_t budget;
+			std::vector<size_t> fullPerFrame;
+		};
+		const Case cases[] = {
+			{ imageSize * 2 + imageSize / 2, { 2, 2, 1 } },
+			{ imageSize * 2, { 2, 2, 1 } },
+			{ imageSize * 5, { 5 } },
+			{ 1000, { 1, 1, 1, 1, 1 } },
+		};
+
+		for (auto& c : cases)
+		{
+			AssetStreamer streamer(pool, c.budget);
+			auto textures = load(streamer, pool, paths);
+			std::vector<size_t> fullPerFrame;
+			for (int32_t frame = 0; frame < 8; frame++)
+			{
+				streamer.update();
+				size_t full = 0;
+				for (auto& upload : uploads)
+					full += upload.width == 256;
+				if (full > 0)
+					fullPerFrame.emplace_back(full);
+				//the 5 low mips all go out in the first frame
+				if (frame == 0)
+					passed &= check(uploads.size() - full == 5, "all low mips in the first frame");
+				finishUploads();
+			}
+
+			bool ok = check(fullPerFrame == c.fullPerFrame, "full images per frame");
+			for (auto& texture : textures)
+				ok &= check(texture->getQuality() == StreamedTexture::Quality::Full, "every texture full in the end");
+			printf("budget %llu bytes : full images per frame", static_cast<unsigned long long>(c.budget));
+			for (auto count : fullPerFrame)
+				printf(" %zu", count);
+			printf(" : %s\n", ok ? "ok" : "WRONG");
+			passed &= ok;
+		}
+		return passed;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	bool passed = true;
+	{
+		ThreadPool pool(2);
+		passed &= checkDownsample(pool);
+		passed &= checkTransitions(pool);
+		passed &= checkFailures(pool);
+		passed &= checkBudget(pool);
+	}
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Times the skyline TextureAtlas against the QuadTree packer it replaced (see Reference.h) : packing efficiency
+//and insert throughput on the same random sprites, until a page refuses 20 sprites in a row.
+//The atlas texture is an image in memory, an upload is a copy into it. The sprites are filled with their index,
+//so after the last flush every pixel of the texture has to belong to the one sprite placed over it.
+//usage : AtlasBenchmark [page size] [sprites per flush]
+//returns 0 if no sprites overlap and the flushed texture matches the placements.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "Engine/TextureAtlas.h"
+#include "Engine/Interface/Texture.h"
+#include "Reference.h"
+
+using namespace Maple;
+
+namespace
+{
+	//the atlas texture, uploads are copies into an image in memory
+	class MemoryTexture2D : public Texture2D
+	{
+	public:
+		auto buildTexture(TextureFormat internalformat, uint32_t width, uint32_t height, bool srgb, bool depth, bool samplerShadow) -> void override
+		{
+			this->width = width;
+			this->height = height;
+			image.assign(static_cast<size_t>(width) * height * 4, 0);
+		}
+
+		//a staging buffer, two transitions and a copy for every sprite on the device
+		auto update(uint32_t x, uint32_t y, uint32_t w, uint32_t h, const uint8_t* data) -> void override
+		{
+			for (uint32_t row = 0; row < h; row++)
+				std::memcpy(image.data() + ((static_cast<size_t>(y) + row) * width + x) * 4, data + static_cast<size_t>(row) * w * 4, w * 4);
+			uploads++;
+		}
+
+		//one staging buffer and one copy for all regions on the device
+		auto update(const uint8_t* pixels, const std::vector<TextureRegion>& regions) -> void override
+		{
+			for (auto& region : regions)
+			{
+				for (uint32_t row = 0; row < region.h; row++)
+				{
+					const size_t offset = ((static_cast<size_t>(region.y) + row) * width + region.x) * 4;
+					std::memcpy(image.data() + offset, pixels + offset, region.w * 4);
+				}
+			}
+			uploads++;
+		}
+
+		std::vector<uint8_t> image;
+		uint32_t uploads = 0;
+	};
+
+	std::mt19937 rng(21);
+
+	struct Sprite
+	{
+		std::string name;
+		uint32_t w;
+		uint32_t h;
+	};
+
+	struct Placement
+	{
+		uint32_t x;
+		uint32_t y;
+		uint32_t w;
+		uint32_t h;
+	};
+
+	struct Result
+	{
+		double ms = 0.0;
+		double flushMs = 0.0;
+		uint32_t inserted = 0;
+		uint64_t pixels = 0;
+		uint32_t uploads = 0;
+		std::vector<Placement> placements;
+		bool passed = true;
+	};
+
+	auto randomSprites(uint32_t count, uint32_t minSize, uint32_t maxSize) -> std::vector<Sprite>
+	{
+		std::uniform_int_distribution<uint32_t> size(minSize, maxSize);
+		std::vector<Sprite> sprites;
+		for (uint32_t i = 0; i < count; i++)
+			sprites.push_back({ "sprite_" + std::to_string(i), size(rng), size(rng) });
+		return sprites;
+	}
+
+	//the id of the sprite in every pixel, 0 is empty
+	auto fill(std::vector<uint8_t>& buffer, const Sprite& sprite, uint32_t id) -> void
+	{
+		auto pixels = reinterpret_cast<uint32_t*>(buffer.data());
+		std::fill(pixels, pixels + sprite.w * sprite.h, id);
+	}
+
+	auto placementOf(const Quad2D& quad, uint32_t size) -> Placement
+	{
+		auto& coords = quad.getTexCoords();
+		return { static_cast<uint32_t>(coords[3].x * size), static_cast<uint32_t>(coords[3].y * size), quad.getWidth(), quad.getHeight() };
+	}
+
+	//every sprite inside the page, no two over the same pixel, and the texture holds the id of the sprite over each pixel
+	auto verify(const Result& result, const MemoryTexture2D& texture, uint32_t size) -> bool
+	{
+		std::vector<uint32_t> owner(static_cast<size_t>(size) * size, 0);
+		uint32_t overlaps = 0;
+		for (uint32_t i = 0; i < result.placements.size(); i++)
+		{
+			auto& p = result.placements[i];
+			if (p.x + p.w > size || p.y + p.h > size)
+				return false;
+			for (uint32_t y = p.y; y < p.y + p.h; y++)
+			{
+				for (uint32_t x = p.x; x < p.x + p.w; x++)
+				{
+					overlaps += owner[static_cast<size_t>(y) * size + x] != 0;
+					owner[static_cast<size_t>(y) * size + x] = i + 1;
+				}
+			}
+		}
+		auto pixels = reinterpret_cast<const uint32_t*>(texture.image.data());
+		return overlaps == 0 && std::equal(owner.begin(), owner.end(), pixels);
+	}
+
+	template<typename Atlas, typename Flush>
+	auto run(Atlas& atlas, const std::vector<Sprite>& sprites, uint32_t perFlush, Flush&& flush) -> Result
+	{
+		Result result;
+		std::vector<uint8_t> buffer(512 * 512 * 4);
+		uint32_t failures = 0;
+		uint32_t sinceFlush = 0;
+		for (uint32_t i = 0; i < sprites.size() && failures < 20; i++)
+		{
+			auto& sprite = sprites[i];
+			fill(buffer, sprite, static_cast<uint32_t>(result.placements.size() + 1));
+
+			const auto start = std::chrono::high_resolution_clock::now();
+			auto quad = atlas.addSprite(sprite.name, buffer, sprite.w, sprite.h);
+			const auto inserted = std::chrono::high_resolution_clock::now();
+			if (quad != nullptr && ++sinceFlush == perFlush)
+			{
+				flush(atlas);
+				sinceFlush = 0;
+			}
+			const auto end = std::chrono::high_resolution_clock::now();
+			result.ms += std::chrono::duration<double, std::milli>(end - start).count();
+			result.flushMs += std::chrono::duration<double, std::milli>(end - inserted).count();
+
+			if (quad == nullptr)
+			{
+				failures++;
+				continue;
+			}
+			failures = 0;
+			result.inserted++;
+			result.pixels += static_cast<uint64_t>(sprite.w) * sprite.h;
+			result.placements.emplace_back(placementOf(*quad, std::static_pointer_cast<MemoryTexture2D>(atlas.getTexture())->getWidth()));
+		}
+		const auto start = std::chrono::high_resolution_clock::now();
+		flush(atlas);
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		result.ms += ms;
+		result.flushMs += ms;
+		return result;
+	}
+
+	auto benchmark(uint32_t size, uint32_t perFlush, uint32_t minSize, uint32_t maxSize) -> bool
+	{
+		const double area = static_cast<double>(size) * size;
+		const auto sprites = randomSprites(static_cast<uint32_t>(area / (minSize * minSize)) + 20, minSize, maxSize);
+
+		Reference::TextureAtlas reference(size, size);
+		auto old = run(reference, sprites, perFlush, [](Reference::TextureAtlas&) {});
+		auto oldTexture = std::static_pointer_cast<MemoryTexture2D>(reference.getTexture());
+		old.uploads = oldTexture->uploads;
+		old.passed = verify(old, *oldTexture, size);
+
+		TextureAtlas skyline(size, size);
+		auto current = run(skyline, sprites, perFlush, [](TextureAtlas& atlas) { atlas.flush(); });
+		auto texture = std::static_pointer_cast<MemoryTexture2D>(skyline.getTexture());
+		current.uploads = texture->uploads;
+		current.passed = verify(current, *texture, size);
+
+		const bool usage = std::abs(skyline.getUsage() - current.pixels / area) < 1e-4;
+		printf("sizes %u-%u :\n", minSize, maxSize);
+		printf("  quadtree : %.1f%% used, %u sprites, %.0f inserts/s, %u uploads%s\n",
+			100.0 * old.pixels / area, old.inserted, old.inserted / (old.ms / 1000.0), old.uploads, old.passed ? "" : ", OVERLAP");
+		printf("  skyline : %.1f%% used, %u sprites, %.0f inserts/s (%.0f without the flushes), %u uploads, %.1f%% wasted under the skyline%s\n",
+			100.0 * current.pixels / area, current.inserted, current.inserted / (current.ms / 1000.0), current.inserted / ((current.ms - current.flushMs) / 1000.0),
+			current.uploads, 100.0 * skyline.getWasted() / area, current.passed && usage ? "" : ", WRONG");
+		return current.passed && usage;
+	}
+};
+
+namespace Maple
+{
+	auto Texture2D::create() -> std::shared_ptr<Texture2D>
+	{
+		return std::make_shared<MemoryTexture2D>();
+	}
+};
+
+int main(int argc, char** argv)
+{
+	const uint32_t size = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 4096;
+	const uint32_t perFlush = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 100;
+
+	printf("%ux%u page, a flush every %u sprites\n", size, size, perFlush);
+	bool passed = benchmark(size, perFlush, 16, 64);
+	passed &= benchmark(size, perFlush, 8, 256);
+	passed &= benchmark(size, perFlush, 8, 512);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
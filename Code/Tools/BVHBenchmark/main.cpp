@@ -0,0 +1,301 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Times the scene BVH queries against the linear scans they replaced and checks both give the same entities.
+//The tree is used the way SceneBVH does : fat boxes in the DynamicAABBTree, the tight world box tested on the leaves.
+//usage : BVHBenchmark [entity count] [moving percent]
+//returns 0 if every query matches the linear scan.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Math/DynamicAABBTree.h"
+
+using namespace Maple;
+
+namespace
+{
+	std::mt19937 rng(11);
+
+	auto random(float min, float max) -> float
+	{
+		return std::uniform_real_distribution<float>(min, max)(rng);
+	}
+
+	auto randomVec3(float min, float max) -> glm::vec3
+	{
+		return { random(min, max), random(min, max), random(min, max) };
+	}
+
+	constexpr float WORLD_SIZE = 500.f;
+
+	struct Timer
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		auto ms() const -> double
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+	};
+
+	auto sphereOverlaps(const BoundingBox& box, const glm::vec3& center, float radius) -> bool
+	{
+		const auto dist = glm::clamp(center, box.min, box.max) - center;
+		return glm::dot(dist, dist) <= radius * radius;
+	}
+
+	//mesh bounds and world matrices, with the tight world boxes and proxies SceneBVH keeps
+	struct Scene
+	{
+		std::vector<BoundingBox> meshBoxes;
+		std::vector<glm::mat4> worlds;
+		std::vector<BoundingBox> boxes;
+		std::vector<int32_t> proxies;
+		DynamicAABBTree tree;
+
+		auto add(const BoundingBox& meshBox, const glm::mat4& world) -> void
+		{
+			const auto entity = static_cast<uint32_t>(boxes.size());
+			meshBoxes.emplace_back(meshBox);
+			worlds.emplace_back(world);
+			boxes.emplace_back(meshBox.transform(world));
+			proxies.emplace_back(tree.createProxy(boxes.back(), entity));
+		}
+	};
+
+	auto randomMeshBox() -> BoundingBox
+	{
+		const auto extent = randomVec3(0.5f, 4.f);
+		return { -extent, extent };
+	}
+
+	auto randomWorld() -> glm::mat4
+	{
+		const auto position = randomVec3(-WORLD_SIZE, WORLD_SIZE) * glm::vec3(1.f, 0.1f, 1.f);
+		return glm::rotate(glm::translate(glm::mat4(1.f), position), random(0.f, 6.28f), glm::vec3(0.f, 1.f, 0.f));
+	}
+
+	auto frustumQuery(const Scene& scene, const Frustum& frustum, std::vector<uint32_t>& out) -> void
+	{
+		out.clear();
+		scene.tree.query(frustum, [&](int32_t proxyId) {
+			const uint32_t entity = scene.tree.getUserData(proxyId);
+			if (frustum.isInside(scene.boxes[entity]))
+				out.emplace_back(entity);
+			return true;
+		});
+	}
+
+	auto frustumScan(const Scene& scene, const Frustum& frustum, std::vector<uint32_t>& out) -> void
+	{
+		out.clear();
+		for (uint32_t i = 0; i < scene.boxes.size(); i++)
+		{
+			if (frustum.isInside(scene.boxes[i]))
+				out.emplace_back(i);
+		}
+	}
+
+	//DeferredOffScreenRenderer::beginScene before the tree, every mesh box transformed and tested
+	auto frustumTransformScan(const Scene& scene, const Frustum& frustum, std::vector<uint32_t>& out) -> void
+	{
+		out.clear();
+		for (uint32_t i = 0; i < scene.meshBoxes.size(); i++)
+		{
+			if (frustum.isInside(scene.meshBoxes[i].transform(scene.worlds[i])))
+				out.emplace_back(i);
+		}
+	}
+
+	auto sphereQuery(const Scene& scene, const glm::vec3& center, float radius, std::vector<uint32_t>& out) -> void
+	{
+		out.clear();
+		scene.tree.query(center, radius, [&](int32_t proxyId) {
+			const uint32_t entity = scene.tree.getUserData(proxyId);
+			if (sphereOverlaps(scene.boxes[entity], center, radius))
+				out.emplace_back(entity);
+			return true;
+		});
+	}
+
+	auto sphereScan(const Scene& scene, const glm::vec3& center, float radius, std::vector<uint32_t>& out) -> void
+	{
+		out.clear();
+		for (uint32_t i = 0; i < scene.boxes.size(); i++)
+		{
+			if (sphereOverlaps(scene.boxes[i], center, radius))
+				out.emplace_back(i);
+		}
+	}
+
+	//SceneBVH::rayCast
+	auto pick(const Scene& scene, const Ray& ray, float& distance) -> int64_t
+	{
+		int64_t closest = -1;
+		distance = INFINITY;
+		scene.tree.rayCast(ray, [&](int32_t proxyId, float maxDistance) {
+			const uint32_t entity = scene.tree.getUserData(proxyId);
+			const float dist = ray.hit(scene.boxes[entity]);
+			if (dist < maxDistance)
+			{
+				closest = entity;
+				distance = dist;
+				return dist;
+			}
+			return maxDistance;
+		});
+		return closest;
+	}
+
+	//the editor picking before the tree
+	auto pickScan(const Scene& scene, const Ray& ray, float& distance) -> int64_t
+	{
+		int64_t closest = -1;
+		distance = INFINITY;
+		for (uint32_t i = 0; i < scene.boxes.size(); i++)
+		{
+			const float dist = ray.hit(scene.boxes[i]);
+			if (dist < distance)
+			{
+				closest = i;
+				distance = dist;
+			}
+		}
+		return closest;
+	}
+
+	auto sameSet(std::vector<uint32_t> a, std::vector<uint32_t> b) -> bool
+	{
+		std::sort(a.begin(), a.end());
+		std::sort(b.begin(), b.end());
+		return a == b;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 50000;
+	const float moving = (argc > 2 ? static_cast<float>(std::atof(argv[2])) : 10.f) / 100.f;
+
+	Scene scene;
+	Timer build;
+	for (uint32_t i = 0; i < count; i++)
+		scene.add(randomMeshBox(), randomWorld());
+	printf("build : %u proxies in %.3f ms, height %d\n", count, build.ms(), scene.tree.getHeight());
+
+	const auto movingCount = static_cast<uint32_t>(count * moving);
+	std::vector<glm::vec3> velocities(movingCount);
+	for (auto& velocity : velocities)
+		velocity = randomVec3(-0.05f, 0.05f) * glm::vec3(1.f, 0.2f, 1.f);
+
+	bool passed = true;
+	double refitMs = 0.0, frustumMs = 0.0, frustumScanMs = 0.0, frustumTransformMs = 0.0, sphereMs = 0.0, sphereScanMs = 0.0, pickMs = 0.0, pickScanMs = 0.0;
+	uint64_t reinserted = 0, moved = 0, visible = 0, lit = 0, picked = 0;
+	int32_t mismatches = 0;
+
+	const int32_t frames = 60;
+	const int32_t lightsPerFrame = 16;
+	const int32_t raysPerFrame = 16;
+	std::vector<uint32_t> treeResult, scanResult;
+	treeResult.reserve(count);
+	scanResult.reserve(count);
+
+	for (int32_t frame = 0; frame < frames; frame++)
+	{
+		//SceneBVH::update, the moving part of the scene walks at up to 3 units a second (60 frames)
+		{
+			Timer timer;
+			for (uint32_t i = 0; i < movingCount; i++)
+			{
+				scene.worlds[i][3] += glm::vec4(velocities[i], 0.f);
+				scene.boxes[i] = scene.meshBoxes[i].transform(scene.worlds[i]);
+				reinserted += scene.tree.moveProxy(scene.proxies[i], scene.boxes[i]);
+				moved++;
+			}
+			refitMs += timer.ms();
+		}
+
+		const auto eye = randomVec3(-WORLD_SIZE, WORLD_SIZE) * glm::vec3(1.f, 0.05f, 1.f);
+		const auto target = eye + glm::vec3(random(-1.f, 1.f), random(-0.2f, 0.1f), random(-1.f, 1.f));
+		Frustum frustum;
+		frustum.from(glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 300.f) * glm::lookAt(eye, target, glm::vec3(0.f, 1.f, 0.f)));
+
+		{
+			Timer timer;
+			frustumQuery(scene, frustum, treeResult);
+			frustumMs += timer.ms();
+		}
+		{
+			Timer timer;
+			frustumScan(scene, frustum, scanResult);
+			frustumScanMs += timer.ms();
+		}
+		mismatches += !sameSet(treeResult, scanResult);
+		visible += treeResult.size();
+		{
+			Timer timer;
+			frustumTransformScan(scene, frustum, scanResult);
+			frustumTransformMs += timer.ms();
+		}
+		mismatches += !sameSet(treeResult, scanResult);
+
+		for (int32_t l = 0; l < lightsPerFrame; l++)
+		{
+			const auto center = randomVec3(-WORLD_SIZE, WORLD_SIZE) * glm::vec3(1.f, 0.1f, 1.f);
+			const float radius = random(5.f, 40.f);
+			{
+				Timer timer;
+				sphereQuery(scene, center, radius, treeResult);
+				sphereMs += timer.ms();
+			}
+			{
+				Timer timer;
+				sphereScan(scene, center, radius, scanResult);
+				sphereScanMs += timer.ms();
+			}
+			mismatches += !sameSet(treeResult, scanResult);
+			lit += treeResult.size();
+		}
+
+		for (int32_t r = 0; r < raysPerFrame; r++)
+		{
+			const Ray ray(eye, glm::normalize(target - eye) + randomVec3(-0.3f, 0.3f));
+			float distance = 0.f, scanDistance = 0.f;
+			int64_t hit = 0, scanHit = 0;
+			{
+				Timer timer;
+				hit = pick(scene, ray, distance);
+				pickMs += timer.ms();
+			}
+			{
+				Timer timer;
+				scanHit = pickScan(scene, ray, scanDistance);
+				pickScanMs += timer.ms();
+			}
+			//overlapping boxes can be hit at the same distance, the distance decides
+			mismatches += (hit < 0) != (scanHit < 0) || distance != scanDistance;
+			picked += hit >= 0;
+		}
+	}
+	passed &= mismatches == 0;
+
+	printf("refit : %.1f%% moving, %.3f ms/frame, %.2f%% of the moves re-inserted\n",
+		moving * 100.f, refitMs / frames, moved ? 100.0 * reinserted / moved : 0.0);
+	printf("frustum : bvh %.3f ms, linear over world boxes %.3f ms (x%.1f), linear with transform %.3f ms (x%.1f), %.0f visible\n",
+		frustumMs / frames, frustumScanMs / frames, frustumScanMs / frustumMs, frustumTransformMs / frames, frustumTransformMs / frustumMs, static_cast<double>(visible) / frames);
+	printf("frustum + refit : bvh %.3f ms, linear with transform %.3f ms\n", (frustumMs + refitMs) / frames, frustumTransformMs / frames);
+	printf("sphere : bvh %.4f ms, linear %.4f ms (x%.1f), %.1f in range\n",
+		sphereMs / (frames * lightsPerFrame), sphereScanMs / (frames * lightsPerFrame), sphereScanMs / sphereMs, static_cast<double>(lit) / (frames * lightsPerFrame));
+	printf("pick : bvh %.4f ms, linear %.4f ms (x%.1f), %llu of %d rays hit\n",
+		pickMs / (frames * raysPerFrame), pickScanMs / (frames * raysPerFrame), pickScanMs / pickMs, static_cast<unsigned long long>(picked), frames * raysPerFrame);
+	printf("%d queries differ from the linear scan\n", mismatches);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,252 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Checks the frustum culling of the G-buffer draw list against brute force and times it.
+//usage : CullingCheck [entity count]
+//returns 0 if every test matches.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Math/Frustum.h"
+#include "Math/BoundingBox.h"
+
+using namespace Maple;
+
+namespace
+{
+	std::mt19937 rng(7);
+
+	auto random(float min, float max) -> float
+	{
+		return std::uniform_real_distribution<float>(min, max)(rng);
+	}
+
+	auto randomVec3(float min, float max) -> glm::vec3
+	{
+		return { random(min, max), random(min, max), random(min, max) };
+	}
+
+	auto randomBox() -> BoundingBox
+	{
+		const auto center = randomVec3(-2.f, 2.f);
+		const auto extent = randomVec3(0.01f, 1.5f);
+		return { center - extent, center + extent };
+	}
+
+	auto randomWorld() -> glm::mat4
+	{
+		auto world = glm::translate(glm::mat4(1.f), randomVec3(-60.f, 60.f));
+		world = glm::rotate(world, random(0.f, 6.28f), glm::normalize(randomVec3(-1.f, 1.f) + glm::vec3(0.f, 0.f, 0.01f)));
+		return glm::scale(world, randomVec3(0.2f, 3.f));
+	}
+
+	auto randomProjView() -> glm::mat4
+	{
+		const auto proj = glm::perspective(glm::radians(random(30.f, 100.f)), random(0.5f, 2.5f), random(0.05f, 1.f), random(50.f, 200.f));
+		const auto eye = randomVec3(-20.f, 20.f);
+		const auto view = glm::lookAt(eye, eye + glm::normalize(randomVec3(-1.f, 1.f) + glm::vec3(0.01f, 0.f, 0.f)), { 0.f, 1.f, 0.f });
+		return proj * view;
+	}
+
+	auto corners(const BoundingBox& box) -> std::vector<glm::vec3>
+	{
+		std::vector<glm::vec3> points;
+		for (int32_t i = 0; i < 8; i++)
+			points.push_back({ i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z });
+		return points;
+	}
+
+	//distance of the box to the plane, signed : negative when all corners are outside it
+	auto maxPlaneDistance(const glm::vec4& plane, const std::vector<glm::vec3>& points) -> float
+	{
+		float distance = -INFINITY;
+		for (auto& point : points)
+			distance = std::max(distance, glm::dot(glm::vec3(plane), point) + plane.w);
+		return distance;
+	}
+
+	//inside the Vulkan clip volume, with a small margin so points on the border are not counted
+	auto insideClip(const glm::mat4& projView, const glm::vec3& point) -> bool
+	{
+		const auto clip = projView * glm::vec4(point, 1.f);
+		const float w = clip.w * 0.999f;
+		return w > 0.f && clip.x > -w && clip.x < w && clip.y > -w && clip.y < w && clip.z > 0.001f * w && clip.z < w;
+	}
+
+	//BoundingBox::transform has to return the tight box of the transformed corners
+	auto checkTransform() -> bool
+	{
+		int32_t failures = 0;
+		for (int32_t i = 0; i < 10000; i++)
+		{
+			const auto box = randomBox();
+			const auto world = randomWorld();
+			BoundingBox expected;
+			for (auto& point : corners(box))
+				expected.merge(glm::vec3(world * glm::vec4(point, 1.f)));
+
+			const auto actual = box.transform(world);
+			const float tolerance = 1e-4f * (1.f + glm::length(expected.max - expected.min) + glm::length(expected.center()));
+			if (glm::any(glm::greaterThan(glm::abs(actual.min - expected.min), glm::vec3(tolerance))) ||
+				glm::any(glm::greaterThan(glm::abs(actual.max - expected.max), glm::vec3(tolerance))))
+				failures++;
+		}
+		printf("BoundingBox::transform : %d mismatches\n", failures);
+		return failures == 0;
+	}
+
+	//the plane test culls a box exactly when all its corners are outside one plane,
+	//and it never culls a box with a point inside the clip volume.
+	auto checkBoxes() -> bool
+	{
+		int32_t mismatches = 0;
+		int32_t falseNegatives = 0;
+		int32_t culled = 0;
+		const int32_t count = 20000;
+
+		for (int32_t i = 0; i < count; i++)
+		{
+			const auto projView = randomProjView();
+			Frustum frustum;
+			frustum.from(projView);
+
+			const auto box = randomBox().transform(randomWorld());
+			const auto points = corners(box);
+			const bool inside = frustum.isInside(box);
+			culled += !inside;
+
+			bool bruteInside = true;
+			bool ambiguous = false;
+			for (uint32_t p = 0; p < Frustum::FRUSTUM_PLANES; p++)
+			{
+				const float distance = maxPlaneDistance(frustum.getPlane(static_cast<FrustumPlane>(p)), points);
+				if (std::abs(distance) < 1e-3f)
+					ambiguous = true;
+				if (distance < 0.f)
+					bruteInside = false;
+			}
+			if (!ambiguous && inside != bruteInside)
+				mismatches++;
+
+			for (int32_t s = 0; s < 64 && !inside; s++)
+			{
+				const glm::vec3 point = box.min + (box.max - box.min) * randomVec3(0.f, 1.f);
+				if (insideClip(projView, point))
+				{
+					falseNegatives++;
+					break;
+				}
+			}
+		}
+		printf("Frustum::isInside(box) : %d boxes, %d culled, %d plane mismatches, %d visible boxes culled\n", count, culled, mismatches, falseNegatives);
+		return mismatches == 0 && falseNegatives == 0 && culled > 0 && culled < count;
+	}
+
+	auto checkSpheres() -> bool
+	{
+		int32_t failures = 0;
+		int32_t culled = 0;
+		const int32_t count = 20000;
+
+		for (int32_t i = 0; i < count; i++)
+		{
+			const auto projView = randomProjView();
+			Frustum frustum;
+			frustum.from(projView);
+
+			const auto center = randomVec3(-80.f, 80.f);
+			const float radius = random(0.1f, 10.f);
+			const bool inside = frustum.isInside(center, radius);
+			culled += !inside;
+
+			for (int32_t s = 0; s < 64 && !inside; s++)
+			{
+				const auto offset = randomVec3(-1.f, 1.f);
+				if (glm::length(offset) > 1.f)
+					continue;
+				if (insideClip(projView, center + offset * radius))
+				{
+					failures++;
+					break;
+				}
+			}
+			//a point is a sphere of radius 0
+			if (frustum.isInside(center) != frustum.isInside(center, 0.f))
+				failures++;
+		}
+		printf("Frustum::isInside(sphere) : %d spheres, %d culled, %d wrong\n", count, culled, failures);
+		return failures == 0 && culled > 0 && culled < count;
+	}
+
+	//shadow casters between the light and the near plane are kept with testNear = false
+	auto checkNearPlane() -> bool
+	{
+		Frustum frustum;
+		frustum.from(glm::perspective(glm::radians(60.f), 1.f, 1.f, 100.f));
+
+		const BoundingBox beforeNear({ -0.1f, -0.1f, -0.9f }, { 0.1f, 0.1f, -0.5f });
+		const bool passed = !frustum.isInside(beforeNear) && frustum.isInside(beforeNear, false) &&
+			!frustum.isInside(glm::vec3(0.f, 0.f, -0.6f), 0.2f) && frustum.isInside(glm::vec3(0.f, 0.f, -0.6f), 0.2f, false);
+		printf("testNear = false : %s\n", passed ? "kept" : "WRONG");
+		return passed;
+	}
+
+	struct Entity
+	{
+		BoundingBox box;
+		glm::mat4 world;
+	};
+
+	//the loop of DeferredOffScreenRenderer::beginScene
+	auto cull(const std::vector<Entity>& entities, const Frustum& frustum, std::vector<uint32_t>& visible) -> void
+	{
+		visible.clear();
+		for (uint32_t i = 0; i < entities.size(); i++)
+		{
+			if (frustum.isInside(entities[i].box.transform(entities[i].world)))
+				visible.emplace_back(i);
+		}
+	}
+
+	auto benchmark(uint32_t count) -> void
+	{
+		std::vector<Entity> entities(count);
+		for (auto& entity : entities)
+			entity = { randomBox(), randomWorld() };
+
+		Frustum frustum;
+		frustum.from(glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f) * glm::lookAt(glm::vec3(0.f, 5.f, 70.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f)));
+
+		std::vector<uint32_t> visible;
+		visible.reserve(count);
+		cull(entities, frustum, visible);
+
+		const int32_t runs = 20;
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (int32_t i = 0; i < runs; i++)
+			cull(entities, frustum, visible);
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / runs;
+
+		printf("culling %u entities : %.3f ms, %.0f entities/ms, %zu visible (%.1f%%)\n",
+			count, ms, count / ms, visible.size(), 100.0 * visible.size() / count);
+	}
+};
+
+int main(int argc, char** argv)
+{
+	bool passed = checkTransform();
+	passed &= checkBoxes();
+	passed &= checkSpheres();
+	passed &= checkNearPlane();
+
+	benchmark(argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 100000);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+namespace Maple
+{
+	//the part of the engine Application the thread pool uses : the main thread queue for the completion callbacks.
+	class Application
+	{
+	public:
+		static auto get() -> Application*
+		{
+			static Application application;
+			return &application;
+		}
+
+		auto postOnMainThread(const std::function<bool()>& mainCallback) -> std::future<bool>
+		{
+			std::promise<bool> promise;
+			std::future<bool> future = promise.get_future();
+			std::lock_guard<std::mutex> locker(executeMutex);
+			executeQueue.emplace(std::move(promise), mainCallback);
+			return future;
+		}
+
+		//runs the posted callbacks, returns how many ran
+		auto executeAll() -> int32_t
+		{
+			int32_t count = 0;
+			std::unique_lock<std::mutex> locker(executeMutex);
+			while (!executeQueue.empty())
+			{
+				auto execute = std::move(executeQueue.front());
+				executeQueue.pop();
+				locker.unlock();
+				execute.first.set_value(execute.second());
+				count++;
+				locker.lock();
+			}
+			return count;
+		}
+
+	private:
+		std::mutex executeMutex;
+		std::queue<std::pair<std::promise<bool>, std::function<bool()>>> executeQueue;
+	};
+};
@@ -0,0 +1,305 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Checks LightClusters on the default 16x9x24 grid : known point and spot light spheres have to land in the
+//clusters worked out by hand, and every point inside a light has to find the light in the cluster the
+//fragment shader looks it up in (DeferredLight.frag). The parallel build has to match the serial one.
+//usage : LightClustersCheck [random light count]
+//returns 0 if every test passes.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Engine/Renderer/LightClusters.h"
+#include "Thread/ThreadPool.h"
+
+using namespace Maple;
+
+namespace
+{
+	std::mt19937 rng(13);
+
+	auto random(float min, float max) -> float
+	{
+		return std::uniform_real_distribution<float>(min, max)(rng);
+	}
+
+	auto check(bool condition, const char* what) -> bool
+	{
+		if (!condition)
+			printf("  WRONG : %s\n", what);
+		return condition;
+	}
+
+	using Cluster = std::tuple<uint32_t, uint32_t, uint32_t>;
+
+	constexpr float NEAR = 0.1f;
+	constexpr float FAR = 100.f;
+	constexpr float FOV = 60.f;
+	constexpr float ASPECT = 16.f / 9.f;
+
+	//the camera sits at the origin and looks down -z, as Camera::getProjectionMatrix builds it
+	const glm::mat4 view = glm::mat4(1.f);
+	const glm::mat4 perspective = glm::perspective(glm::radians(FOV), ASPECT, NEAR, FAR);
+
+	//view depth where a slice starts, slices are exponential between near and far
+	auto sliceDepth(uint32_t slice) -> float
+	{
+		return NEAR * std::pow(FAR / NEAR, float(slice) / LightClusters::DEFAULT_Z);
+	}
+
+	//view space point at ndc x/y (y as the texture coordinate, 2 * v - 1) and view depth
+	auto viewPoint(float ndcX, float ndcY, float depth, const glm::mat4& projection) -> glm::vec3
+	{
+		return { ndcX * depth / projection[0][0], ndcY * depth / projection[1][1], -depth };
+	}
+
+	//the lookup of DeferredLight.frag for a view space position, false outside the frustum
+	auto shaderCluster(const LightClusters& clusters, const glm::mat4& projection, const glm::vec3& position, Cluster& cluster) -> bool
+	{
+		const auto clip = projection * glm::vec4(position, 1.f);
+		if (clip.w <= 0.f)
+			return false;
+		const auto ndc = glm::vec3(clip) / clip.w;
+		if (std::abs(ndc.x) >= 1.f || std::abs(ndc.y) >= 1.f || ndc.z < 0.f || ndc.z > 1.f)
+			return false;
+
+		const auto dimensions = clusters.getDimensions();
+		const auto params = clusters.getDepthParams();
+		const int32_t slice = int32_t(std::log(std::max(-position.z, params.x)) * params.z + params.w);
+		const auto texCoord = glm::vec2(ndc) * 0.5f + 0.5f;
+		cluster = {
+			std::clamp<int32_t>(int32_t(texCoord.x * dimensions.x), 0, dimensions.x - 1),
+			std::clamp<int32_t>(int32_t(texCoord.y * dimensions.y), 0, dimensions.y - 1),
+			std::clamp<int32_t>(slice, 0, dimensions.z - 1),
+		};
+		return true;
+	}
+
+	auto clustersOf(const LightClusters& clusters, uint32_t light) -> std::set<Cluster>
+	{
+		std::set<Cluster> result;
+		const auto dimensions = clusters.getDimensions();
+		for (uint32_t z = 0; z < dimensions.z; z++)
+		{
+			for (uint32_t y = 0; y < dimensions.y; y++)
+			{
+				for (uint32_t x = 0; x < dimensions.x; x++)
+				{
+					const auto range = clusters.getGrid()[clusters.getClusterIndex(x, y, z)];
+					const auto begin = clusters.getIndices().begin() + range.x;
+					if (std::find(begin, begin + range.y, light) != begin + range.y)
+						result.emplace(x, y, z);
+				}
+			}
+		}
+		return result;
+	}
+
+	auto contains(const LightClusters& clusters, const Cluster& cluster, uint32_t light) -> bool
+	{
+		const auto range = clusters.getGrid()[clusters.getClusterIndex(std::get<0>(cluster), std::get<1>(cluster), std::get<2>(cluster))];
+		const auto begin = clusters.getIndices().begin() + range.x;
+		return std::find(begin, begin + range.y, light) != begin + range.y;
+	}
+
+	struct Known
+	{
+		const char* name;
+		glm::vec4 sphere;
+		std::set<Cluster> expected;
+	};
+
+	//the default grid has a column edge at ndc x 0 (between column 7 and 8) and a row edge at ndc y 1/9 (row 4 and 5).
+	//a cluster is binned as the box around its froxel, which grows a column by a third of a slice towards the screen edges,
+	//so the lights with exact sets stay near the middle of the screen.
+	auto knownLights() -> std::vector<Known>
+	{
+		std::vector<Known> lights;
+
+		//small point light in the middle of cluster (7, 3, 10)
+		{
+			const float depth = std::sqrt(sliceDepth(10) * sliceDepth(11));
+			const auto center = viewPoint(2.f * 7.5f / 16.f - 1.f, 2.f * 3.5f / 9.f - 1.f, depth, perspective);
+			lights.push_back({ "point inside (7, 3, 10)", { center, 0.02f }, { { 7, 3, 10 } } });
+		}
+
+		//on the corner of 8 clusters : column 7/8, row 4/5, slice 10/11
+		{
+			const auto center = viewPoint(0.f, 1.f / 9.f, sliceDepth(11), perspective);
+			std::set<Cluster> expected;
+			for (uint32_t z = 10; z <= 11; z++)
+				for (uint32_t y = 4; y <= 5; y++)
+					for (uint32_t x = 7; x <= 8; x++)
+						expected.emplace(x, y, z);
+			lights.push_back({ "point on a cluster corner", { center, 0.01f }, expected });
+		}
+
+		//spot lights are binned by their range sphere, this one crosses the edge between slice 15 and 16 in column 8, row 4
+		{
+			const auto center = viewPoint(2.f * 8.5f / 16.f - 1.f, 0.f, sliceDepth(16), perspective);
+			lights.push_back({ "spot across a slice edge", { center, 0.25f }, { { 8, 4, 15 }, { 8, 4, 16 } } });
+		}
+
+		//outside the frustum, far enough from the sides for the boxes of the edge clusters
+		lights.push_back({ "behind the camera", { 0.f, 0.f, 2.f, 1.f }, {} });
+		lights.push_back({ "beyond far", { 0.f, 0.f, -FAR - 2.f, 1.f }, {} });
+		lights.push_back({ "left of the frustum", { viewPoint(-2.f, 0.f, 10.f, perspective), 1.f }, {} });
+		lights.push_back({ "below the frustum", { viewPoint(0.f, -2.f, 10.f, perspective), 1.f }, {} });
+		return lights;
+	}
+
+	auto checkKnown() -> bool
+	{
+		auto lights = knownLights();
+		std::vector<glm::vec4> spheres;
+		for (auto& light : lights)
+			spheres.emplace_back(light.sphere);
+
+		LightClusters clusters;
+		clusters.build(view, perspective, NEAR, FAR, spheres.data(), static_cast<uint32_t>(spheres.size()));
+
+		bool passed = check(clusters.getDimensions() == glm::uvec3(16, 9, 24), "default grid");
+		for (uint32_t slice = 0; slice < 24; slice++)
+		{
+			const float middle = std::sqrt(sliceDepth(slice) * sliceDepth(slice + 1));
+			passed &= check(clusters.getSlice(middle) == slice, "slice of the depth");
+		}
+
+		for (uint32_t i = 0; i < lights.size(); i++)
+		{
+			const auto found = clustersOf(clusters, i);
+			const bool ok = check(found == lights[i].expected, lights[i].name);
+			printf("%s : %zu clusters %s\n", lights[i].name, found.size(), ok ? "ok" : "WRONG");
+			passed &= ok;
+		}
+		return passed;
+	}
+
+	//spot light around the camera : the slices closer than half its range are covered completely, nothing past its range is touched
+	auto checkAroundCamera() -> bool
+	{
+		const glm::vec4 light = { 0.f, 0.f, 0.f, 1.f };
+		LightClusters clusters;
+		clusters.build(view, perspective, NEAR, FAR, &light, 1);
+
+		const auto found = clustersOf(clusters, 0);
+		bool passed = true;
+		uint32_t covered = 0;
+		for (uint32_t z = 0; sliceDepth(z + 1) <= 0.5f; z++, covered++)
+		{
+			for (uint32_t y = 0; y < 9; y++)
+				for (uint32_t x = 0; x < 16; x++)
+					passed &= check(found.count({ x, y, z }) == 1, "near slice covered");
+		}
+		for (auto& cluster : found)
+			passed &= check(sliceDepth(std::get<2>(cluster)) < 1.f, "nothing past the range");
+		printf("spot around the camera : %zu clusters, first %u slices complete %s\n", found.size(), covered, passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//ortho camera : columns and rows do not grow with depth
+	auto checkOrthographic() -> bool
+	{
+		const glm::mat4 ortho = glm::ortho(-16.f, 16.f, -9.f, 9.f, NEAR, FAR);
+		//one unit per row and two per column, a light in the middle of column 12, row 2 through every slice it spans
+		const glm::vec4 light = { 2.f * 12 - 16.f + 1.f, 2.f * 2 - 9.f + 1.f, -20.f, 0.4f };
+
+		LightClusters clusters;
+		clusters.build(view, ortho, NEAR, FAR, &light, 1);
+
+		std::set<Cluster> expected;
+		for (uint32_t z = clusters.getSlice(19.6f); z <= clusters.getSlice(20.4f); z++)
+			expected.emplace(12, 2, z);
+		const bool passed = check(clustersOf(clusters, 0) == expected, "orthographic light");
+		printf("orthographic : %zu clusters %s\n", expected.size(), passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//no light may be missing from the cluster the shader reads for any point inside it
+	auto checkRandom(uint32_t count) -> bool
+	{
+		std::vector<glm::vec4> spheres;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const float depth = random(-5.f, FAR + 5.f);
+			const auto center = viewPoint(random(-1.3f, 1.3f), random(-1.3f, 1.3f), std::max(depth, 1.f), perspective);
+			spheres.emplace_back(center.x, center.y, -depth, random(0.05f, 6.f));
+		}
+
+		LightClusters clusters;
+		clusters.build(view, perspective, NEAR, FAR, spheres.data(), count);
+
+		uint32_t samples = 0, missing = 0;
+		uint64_t binned = 0, touched = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			std::set<Cluster> hit;
+			for (int32_t s = 0; s < 400; s++)
+			{
+				//uniform in the sphere
+				glm::vec3 offset;
+				do
+				{
+					offset = { random(-1.f, 1.f), random(-1.f, 1.f), random(-1.f, 1.f) };
+				} while (glm::dot(offset, offset) > 1.f);
+
+				Cluster cluster;
+				if (!shaderCluster(clusters, perspective, glm::vec3(spheres[i]) + offset * spheres[i].w * 0.999f, cluster))
+					continue;
+				samples++;
+				hit.emplace(cluster);
+				missing += !contains(clusters, cluster, i);
+			}
+			binned += clustersOf(clusters, i).size();
+			touched += hit.size();
+		}
+
+		const bool passed = check(missing == 0, "light missing from a cluster");
+		printf("random : %u lights, %u samples, %u missed, %.1f clusters binned per light, %.1f hit by the samples\n",
+			count, samples, missing, double(binned) / count, double(touched) / count);
+		return passed;
+	}
+
+	//slices binned on the pool have to give the same grid and indices
+	auto checkParallel(uint32_t count) -> bool
+	{
+		std::vector<glm::vec4> spheres;
+		for (uint32_t i = 0; i < count; i++)
+			spheres.emplace_back(random(-60.f, 60.f), random(-30.f, 30.f), random(-FAR, 1.f), random(0.1f, 8.f));
+
+		LightClusters serial;
+		serial.build(view, perspective, NEAR, FAR, spheres.data(), count);
+
+		ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()));
+		LightClusters parallel;
+		parallel.build(view, perspective, NEAR, FAR, spheres.data(), count, &pool);
+
+		const bool passed = check(serial.getGrid() == parallel.getGrid() && serial.getIndices() == parallel.getIndices(), "parallel build");
+		printf("parallel : %zu indices, %u at most per cluster %s\n", parallel.getIndices().size(), parallel.getMaxLightsPerCluster(), passed ? "ok" : "WRONG");
+		return passed;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 500;
+
+	bool passed = checkKnown();
+	passed &= checkAroundCamera();
+	passed &= checkOrthographic();
+	passed &= checkRandom(count);
+	passed &= checkParallel(count);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
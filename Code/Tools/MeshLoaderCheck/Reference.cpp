@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Reference.h"
+
+namespace Maple
+{
+	namespace
+	{
+		inline auto generateTangent(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec2& ta, const glm::vec2& tb, const glm::vec2& tc) -> glm::vec3
+		{
+			const glm::vec2 coord1 = tb - ta;
+			const glm::vec2 coord2 = tc - ta;
+			const glm::vec3 vertex1 = b - a;
+			const glm::vec3 vertex2 = c - a;
+			const glm::vec3 axis =(vertex1 * coord2.y - vertex2 * coord1.y);
+			const float factor = 1.0f / (coord1.x * coord2.y - coord2.x * coord1.y);
+			return axis * factor;
+		}
+	};
+
+	auto Reference::Welder::insert(const Vertex& vertex, std::vector<Vertex>& vertices) -> uint32_t
+	{
+		if (uniqueVertices.count(vertex) == 0) {
+			uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(vertex);
+		}
+		return uniqueVertices[vertex];
+	}
+
+	auto Reference::generateNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void
+	{
+		std::vector<glm::vec3> normals(vertices.size());
+
+		if (!indices.empty())
+		{
+			for (uint32_t i = 0; i < indices.size(); i += 3)
+			{
+				const auto a = indices[i];
+				const auto b = indices[i + 1];
+				const auto c = indices[i + 2];
+				const auto normal = glm::cross((vertices[b].pos - vertices[a].pos), (vertices[c].pos - vertices[a].pos));
+				normals[a] += normal;
+				normals[b] += normal;
+				normals[c] += normal;
+			}
+		}
+		else
+		{
+			for (uint32_t i = 0; i < vertices.size(); i += 3)
+			{
+				auto& a = vertices[i];
+				auto& b = vertices[i + 1];
+				auto& c = vertices[i + 2];
+				const auto normal = glm::cross(b.pos - a.pos, c.pos - a.pos);
+				normals[i] = normal;
+				normals[i + 1] = normal;
+				normals[i + 2] = normal;
+			}
+		}
+		for (uint32_t i = 0; i < normals.size(); ++i)
+		{
+			vertices[i].normal = glm::normalize(normals[i]);
+		}
+	}
+
+	auto Reference::generateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void
+	{
+		std::vector<glm::vec3> tangents(vertices.size());
+
+		if (!indices.empty())
+		{
+			for (uint32_t i = 0; i < indices.size(); i += 3)
+			{
+				int a = indices[i];
+				int b = indices[i + 1];
+				int c = indices[i + 2];
+
+				const auto tangent =
+					generateTangent(vertices[a].pos, vertices[b].pos, vertices[c].pos, vertices[a].texCoord, vertices[b].texCoord, vertices[c].texCoord);
+
+				tangents[a] += tangent;
+				tangents[b] += tangent;
+				tangents[c] += tangent;
+			}
+		}
+		else
+		{
+			for (uint32_t i = 0; i < vertices.size(); i += 3)
+			{
+				const auto tangent = 
+					generateTangent(vertices[i].pos, vertices[i + 1].pos, vertices[i + 2].pos, vertices[i].texCoord, vertices[i + 1].texCoord,vertices[i + 2].texCoord);
+
+				tangents[i] += tangent;
+				tangents[i + 1] += tangent;
+				tangents[i + 2] += tangent;
+			}
+		}
+		for (uint32_t i = 0; i < vertices.size(); ++i)
+		{
+			vertices[i].tangent = glm::normalize(tangents[i]);
+		}
+	}
+};
@@ -0,0 +1,29 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "Engine/Vertex.h"
+
+namespace Maple
+{
+	//the obj loader before the parallel parse : std::unordered_map welding and the single loop normal/tangent generation.
+	//kept as it was, the current loader has to produce the same bits.
+	namespace Reference
+	{
+		class Welder
+		{
+		public:
+			auto insert(const Vertex& vertex, std::vector<Vertex>& vertices) -> uint32_t;
+		private:
+			std::unordered_map<Vertex, uint32_t> uniqueVertices;
+		};
+
+		auto generateNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void;
+		auto generateTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) -> void;
+	};
+};
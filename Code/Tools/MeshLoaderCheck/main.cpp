@@ -0,0 +1,163 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Checks that the obj loader welds and shades meshes bit for bit like the loader it replaced (see Reference.h).
+//usage : MeshLoaderCheck [model.obj ...]
+//without arguments randomized obj-like shapes are checked, with and without source normals.
+//returns 0 if every shape matches.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <tiny_obj_loader.h>
+#include "Engine/Mesh.h"
+#include "FileSystem/VertexWelder.h"
+#include "Reference.h"
+
+using namespace Maple;
+
+namespace
+{
+	struct Result
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	//as MeshLoader::parse builds the vertices of a shape
+	auto makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index) -> Vertex
+	{
+		Vertex vertex{};
+
+		vertex.pos = {
+			attrib.vertices[3 * index.vertex_index + 0],
+			attrib.vertices[3 * index.vertex_index + 1],
+			attrib.vertices[3 * index.vertex_index + 2]
+		};
+
+		if (index.normal_index >= 0)
+			vertex.normal = {
+				attrib.normals[3 * index.normal_index + 0],
+				attrib.normals[3 * index.normal_index + 1],
+				attrib.normals[3 * index.normal_index + 2]
+		};
+
+		if (index.texcoord_index >= 0)
+			vertex.texCoord = {
+				attrib.texcoords[2 * index.texcoord_index + 0],
+				1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+		};
+
+		vertex.color = { 1.0f, 1.0f, 1.0f,1.f };
+		return vertex;
+	}
+
+	auto loadReference(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::index_t>& shapeIndices) -> Result
+	{
+		Result result;
+		Reference::Welder welder;
+		for (const auto& index : shapeIndices)
+			result.indices.emplace_back(welder.insert(makeVertex(attrib, index), result.vertices));
+
+		if (attrib.normals.empty())
+			Reference::generateNormals(result.vertices, result.indices);
+		Reference::generateTangents(result.vertices, result.indices);
+		return result;
+	}
+
+	auto loadCurrent(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::index_t>& shapeIndices) -> Result
+	{
+		Result result;
+		VertexWelder welder(shapeIndices.size());
+		result.indices.reserve(shapeIndices.size());
+		for (const auto& index : shapeIndices)
+		{
+			bool inserted = false;
+			result.indices.emplace_back(welder.insert(makeVertex(attrib, index), result.vertices, inserted));
+		}
+
+		if (attrib.normals.empty())
+			Mesh::generateNormals(result.vertices, result.indices);
+		Mesh::generateTangents(result.vertices, result.indices);
+		return result;
+	}
+
+	auto check(const std::string& name, const tinyobj::attrib_t& attrib, const std::vector<tinyobj::index_t>& shapeIndices) -> bool
+	{
+		const auto expected = loadReference(attrib, shapeIndices);
+		const auto actual = loadCurrent(attrib, shapeIndices);
+
+		const bool same = expected.indices == actual.indices &&
+			expected.vertices.size() == actual.vertices.size() &&
+			std::memcmp(expected.vertices.data(), actual.vertices.data(), sizeof(Vertex) * expected.vertices.size()) == 0;
+
+		printf("%s : %zu indices, %zu vertices, %s\n", name.c_str(), shapeIndices.size(), actual.vertices.size(), same ? "identical" : "DIFFERENT");
+		return same;
+	}
+
+	//shared positions, normals and uvs with -0, zero uvs and missing attributes, like exported models have.
+	auto checkRandom() -> bool
+	{
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+		bool passed = true;
+		for (int32_t trial = 0; trial < 20; trial++)
+		{
+			const bool hasNormals = trial % 2;
+			tinyobj::attrib_t attrib;
+			for (int32_t i = 0; i < 500 * 3; i++)
+				attrib.vertices.emplace_back(rng() % 7 == 0 ? -0.f : dist(rng));
+			for (int32_t i = 0; hasNormals && i < 300 * 3; i++)
+				attrib.normals.emplace_back(dist(rng));
+			for (int32_t i = 0; i < 400 * 2; i++)
+				attrib.texcoords.emplace_back(rng() % 5 == 0 ? 0.f : dist(rng));
+
+			std::vector<tinyobj::index_t> shapeIndices(30000);
+			for (auto& index : shapeIndices)
+			{
+				index.vertex_index = static_cast<int>(rng() % 500);
+				index.normal_index = hasNormals ? static_cast<int>(rng() % 300) : -1;
+				index.texcoord_index = rng() % 3 ? static_cast<int>(rng() % 400) : -1;
+			}
+			passed &= check("random " + std::to_string(trial), attrib, shapeIndices);
+		}
+		return passed;
+	}
+
+	auto checkObj(const std::string& obj) -> bool
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+		const auto directory = obj.substr(0, obj.find_last_of("/\\"));
+
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, obj.c_str(), directory.c_str()))
+		{
+			printf("%s : %s%s\n", obj.c_str(), warn.c_str(), err.c_str());
+			return false;
+		}
+
+		bool passed = true;
+		for (const auto& shape : shapes)
+			passed &= check(obj + " " + shape.name, attrib, shape.mesh.indices);
+		return passed;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	bool passed = true;
+	if (argc < 2)
+		passed = checkRandom();
+
+	for (int32_t i = 1; i < argc; i++)
+		passed &= checkObj(argv[i]);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
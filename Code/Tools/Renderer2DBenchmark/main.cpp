@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Times the CPU side of the batched quads in Renderer2D (QuadBatch) against the code it replaced :
+//std::sort of the Command2D by depth against the radix sorted keys, and mat4 * vec4 per corner against writeQuads,
+//on one thread and on the pool. Checks the keys come out in a stable depth and layer order and the vertices
+//match the old ones.
+//usage : Renderer2DBenchmark [sprite count]
+//returns 0 if the order and the vertices are right.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Engine/Renderer/QuadBatch.h"
+#include "Engine/Interface/Texture.h"
+#include "Thread/ThreadPool.h"
+
+using namespace Maple;
+
+namespace
+{
+	std::mt19937 rng(23);
+
+	auto random(float min, float max) -> float
+	{
+		return std::uniform_real_distribution<float>(min, max)(rng);
+	}
+
+	//same grain as Renderer2D::submitQuad
+	constexpr int32_t QUAD_GRAIN = 2048;
+
+	//same count as Application
+	auto workerCount() -> int32_t
+	{
+		return std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+	}
+
+	struct Timer
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		auto ms() const -> double
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+	};
+
+	//best of a few runs
+	template<typename Run>
+	auto time(Run&& run, int32_t runs = 5) -> double
+	{
+		double best = INFINITY;
+		for (int32_t i = 0; i < runs; i++)
+		{
+			Timer timer;
+			run();
+			best = std::min(best, timer.ms());
+		}
+		return best;
+	}
+
+	//sprites of a few sheets in the texture pool, half of them on a handful of shared depths as in a tile map
+	auto createQuads(std::vector<Quad2D>& quads, const std::shared_ptr<Texture>& pages) -> void
+	{
+		for (uint32_t i = 0; i < quads.size(); i++)
+		{
+			auto& quad = quads[i];
+			if (i % 8 != 0)
+			{
+				quad.setTexture(pages);
+				quad.setLayer(i % 5);
+			}
+			quad.setColor({ random(0.f, 1.f), random(0.f, 1.f), random(0.f, 1.f), 1.f });
+			quad.setOffset({ random(-1.f, 0.f), random(-1.f, 0.f) });
+		}
+	}
+
+	auto createCommands(const std::vector<Quad2D>& quads, uint32_t count) -> std::vector<Command2D>
+	{
+		std::vector<Command2D> commands(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const float depth = i % 2 == 0 ? static_cast<float>(rng() % 4) : random(-10.f, 10.f);
+			auto transform = glm::translate(glm::mat4(1.f), { random(-500.f, 500.f), random(-300.f, 300.f), depth });
+			transform = glm::rotate(transform, random(0.f, 6.28f), { 0.f, 0.f, 1.f });
+			commands[i] = { &quads[rng() % quads.size()], glm::scale(transform, { random(0.5f, 4.f), random(0.5f, 4.f), 1.f }) };
+		}
+		return commands;
+	}
+
+	//Renderer2D::beginScene before the keys
+	auto sortCommands(std::vector<Command2D>& commands) -> void
+	{
+		std::sort(commands.begin(), commands.end(), [](Command2D& a, Command2D& b) {
+			return a.transform[3][2] < b.transform[3][2];
+		});
+	}
+
+	//Renderer2D::submitQuad before writeQuads
+	auto writeReference(Vertex2D* buffer, const std::vector<Command2D>& commands, const SortKey2D* keys) -> void
+	{
+		for (size_t i = 0; i < commands.size(); i++)
+		{
+			auto& command = commands[keys[i].command];
+			auto& quad2d = command.quad;
+			auto& transform = command.transform;
+
+			const glm::vec2& min = quad2d->getOffset();
+			glm::vec2 max = min + glm::vec2{ quad2d->getWidth(), quad2d->getHeight() };
+			const auto& color = quad2d->getColor();
+			const auto& uv = quad2d->getTexCoords();
+			const float layer = quad2d->getTexture() ? quad2d->getLayer() + 1.f : -1.f;
+
+			buffer->vertex = transform * glm::vec4(min.x, min.y, 0.0f, 1);
+			buffer->uv = glm::vec3(uv[0], layer);
+			buffer->color = color;
+			buffer++;
+
+			buffer->vertex = transform * glm::vec4(max.x, min.y, 0.0f, 1);
+			buffer->uv = glm::vec3(uv[1], layer);
+			buffer->color = color;
+			buffer++;
+
+			buffer->vertex = transform * glm::vec4(max.x, max.y, 0.0f, 1.0);
+			buffer->uv = glm::vec3(uv[2], layer);
+			buffer->color = color;
+			buffer++;
+
+			buffer->vertex = transform * glm::vec4(min.x, max.y, 0.0f, 1.0);
+			buffer->uv = glm::vec3(uv[3], layer);
+			buffer->color = color;
+			buffer++;
+		}
+	}
+
+	//depth first, then the layer of a textured quad, then the submit order
+	auto checkOrder(const std::vector<Command2D>& commands, const std::vector<SortKey2D>& keys) -> bool
+	{
+		auto layer = [&](const Command2D& command) {
+			return command.quad->getTexture() ? command.quad->getLayer() : 0;
+		};
+
+		std::vector<bool> seen(commands.size(), false);
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			if (keys[i].command >= commands.size() || seen[keys[i].command])
+				return false;
+			seen[keys[i].command] = true;
+			if (i == 0)
+				continue;
+
+			auto& a = commands[keys[i - 1].command];
+			auto& b = commands[keys[i].command];
+			const float depthA = a.transform[3][2], depthB = b.transform[3][2];
+			if (depthA > depthB)
+				return false;
+			if (depthA == depthB && (layer(a) > layer(b) || (layer(a) == layer(b) && keys[i - 1].command > keys[i].command)))
+				return false;
+		}
+		return keys.size() == commands.size();
+	}
+
+	auto maxDifference(const std::vector<Vertex2D>& a, const std::vector<Vertex2D>& b) -> float
+	{
+		float difference = 0.f;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			const auto vertex = glm::abs(a[i].vertex - b[i].vertex) / glm::max(glm::abs(b[i].vertex), glm::vec3(1.f));
+			difference = std::max({ difference, vertex.x, vertex.y, vertex.z });
+			if (a[i].uv != b[i].uv || a[i].color != b[i].color)
+				return INFINITY;
+		}
+		return difference;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 200000;
+
+	auto pages = std::make_shared<Texture>();
+	std::vector<Quad2D> quads(64);
+	createQuads(quads, pages);
+	const auto commands = createCommands(quads, count);
+
+	ThreadPool pool(workerCount());
+	bool passed = true;
+
+	//sort
+	std::vector<SortKey2D> keys, scratch;
+	const double sortMs = time([&]() {
+		auto sorted = commands;
+		sortCommands(sorted);
+	});
+	const double keysMs = time([&]() {
+		QuadBatch::buildSortKeys(commands, keys, pool);
+		QuadBatch::radixSort(keys, scratch, pool);
+	});
+	const bool ordered = checkOrder(commands, keys);
+	passed &= ordered;
+	printf("sort %u commands : std::sort of Command2D %.2f ms, keys + radix sort %.2f ms (x%.1f), order %s\n",
+		count, sortMs, keysMs, sortMs / keysMs, ordered ? "ok" : "WRONG");
+
+	//vertices, in the sorted order
+	std::vector<Vertex2D> reference(static_cast<size_t>(count) * 4);
+	std::vector<Vertex2D> vertices(static_cast<size_t>(count) * 4);
+	const double referenceMs = time([&]() {
+		writeReference(reference.data(), commands, keys.data());
+	});
+	const double serialMs = time([&]() {
+		QuadBatch::writeQuads(vertices.data(), commands, keys.data(), 0, static_cast<int32_t>(count));
+	});
+	const float serialDifference = maxDifference(vertices, reference);
+
+	std::fill(vertices.begin(), vertices.end(), Vertex2D{});
+	const double parallelMs = time([&]() {
+		pool.parallelRange(0, static_cast<int32_t>(count), [&](int32_t begin, int32_t end) {
+			QuadBatch::writeQuads(vertices.data(), commands, keys.data(), begin, end);
+		}, QUAD_GRAIN);
+	});
+	const float parallelDifference = maxDifference(vertices, reference);
+
+	const bool same = serialDifference < 1e-5f && parallelDifference < 1e-5f;
+	passed &= same;
+	printf("vertices : mat4 * vec4 %.0f quads/ms, writeQuads %.0f quads/ms (x%.1f), on %d workers %.0f quads/ms, relative difference %g %s\n",
+		count / referenceMs, count / serialMs, referenceMs / serialMs, workerCount(), count / parallelMs, std::max(serialDifference, parallelDifference),
+		same ? "ok" : "WRONG");
+
+	printf("sort + vertices : before %.2f ms, now %.2f ms\n", sortMs + referenceMs, keysMs + parallelMs);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
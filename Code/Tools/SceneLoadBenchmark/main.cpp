@@ -0,0 +1,217 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Times loading a scene from json against the cooked .mscene and checks both give the same registry.
+//The json is written and read as Serialization::serialize/loadJson do, the .mscene is cooked from the json
+//as Serialization::convertToBinary does and read through a MappedFile and BinaryScene.
+//Only the components which do not need the renderer are used : Transform, NameComponent and ActiveComponent.
+//usage : SceneLoadBenchmark [entity count] [directory]
+//returns 0 if the registries match.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cereal/cereal.hpp>
+#include <cereal/archives/json.hpp>
+#include <cereal/types/string.hpp>
+#include "Others/Serialization.h"
+#include "Others/BinaryScene.h"
+#include "Others/Console.h"
+#include "FileSystem/MappedFile.h"
+#include "Scene/Component/Component.h"
+#include "Scene/Component/Transform.h"
+
+#define CHECK_COMPONENTS Transform, \
+NameComponent, \
+ActiveComponent
+
+namespace Maple
+{
+	std::shared_ptr<spdlog::logger> Console::logger = spdlog::default_logger();
+};
+
+using namespace Maple;
+
+namespace
+{
+	std::mt19937 rng(5);
+
+	auto random(float min, float max) -> float
+	{
+		return std::uniform_real_distribution<float>(min, max)(rng);
+	}
+
+	auto randomVec3(float min, float max) -> glm::vec3
+	{
+		return { random(min, max), random(min, max), random(min, max) };
+	}
+
+	auto createScene(entt::registry& registry, uint32_t count) -> void
+	{
+		std::vector<entt::entity> entities(count);
+		registry.create(entities.begin(), entities.end());
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto& transform = registry.emplace<Transform>(entities[i]);
+			transform.setLocalPosition(randomVec3(-500.f, 500.f));
+			transform.setLocalOrientation(randomVec3(-3.f, 3.f));
+			transform.setLocalScale(randomVec3(0.1f, 4.f));
+			transform.getEntityId() = entities[i];
+			registry.emplace<NameComponent>(entities[i], "Entity " + std::to_string(i)).getEntityId() = entities[i];
+			if (i % 3 == 0)
+				registry.emplace<ActiveComponent>(entities[i], i % 2 == 0).getEntityId() = entities[i];
+		}
+		//released identifiers have to survive the round trip as well
+		for (uint32_t i = 0; i < count; i += 20)
+			registry.destroy(entities[i]);
+	}
+
+	//Serialization::serialize
+	auto writeJson(entt::registry& registry, const std::string& file) -> void
+	{
+		std::stringstream storage;
+		{
+			cereal::JSONOutputArchive output{ storage };
+			entt::snapshot{ registry }.entities(output).component<CHECK_COMPONENTS>(output);
+		}
+		std::ofstream(file, std::ios::binary | std::ios::trunc) << storage.str();
+	}
+
+	//Serialization::loadJson, the whole file is read first
+	auto loadJson(entt::registry& registry, const std::string& file) -> void
+	{
+		std::ifstream stream(file, std::ios::binary);
+		std::string buffer((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		std::istringstream istr;
+		istr.str(buffer);
+		cereal::JSONInputArchive input(istr);
+		entt::snapshot_loader{ registry }.entities(input).component<CHECK_COMPONENTS>(input);
+	}
+
+	//Serialization::serializeBinary
+	auto writeBinary(entt::registry& registry, const std::string& file) -> void
+	{
+		std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+		cereal::BinaryOutputArchive output{ stream };
+		output(Serialization::BINARY_SCENE_MAGIC, Serialization::BINARY_SCENE_VERSION);
+		BinaryScene::writeEntities(output, registry);
+		BinaryScene::writeAll<CHECK_COMPONENTS>(output, registry);
+	}
+
+	//Serialization::loadBinary
+	auto loadBinary(entt::registry& registry, const std::string& file) -> bool
+	{
+		MappedFile mapped(file);
+		if (!mapped.isValid())
+			return false;
+
+		BinaryScene::MemoryBuffer buffer(mapped.getData(), mapped.getSize());
+		std::istream stream(&buffer);
+		cereal::BinaryInputArchive input(stream);
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		input(magic, version);
+		if (magic != Serialization::BINARY_SCENE_MAGIC || version != Serialization::BINARY_SCENE_VERSION)
+			return false;
+
+		BinaryScene::readEntities(input, registry);
+		BinaryScene::readAll<CHECK_COMPONENTS>(input, registry);
+		return true;
+	}
+
+	auto sameEntities(const entt::registry& a, const entt::registry& b) -> bool
+	{
+		return a.size() == b.size() && std::equal(a.data(), a.data() + a.size(), b.data());
+	}
+
+	template<typename Component, typename Equal>
+	auto sameComponents(const entt::registry& a, const entt::registry& b, Equal&& equal) -> bool
+	{
+		auto viewA = a.view<const Component>();
+		auto viewB = b.view<const Component>();
+		if (viewA.size() != viewB.size())
+			return false;
+		for (auto entity : viewA)
+		{
+			if (!viewB.contains(entity) || !equal(viewA.template get<const Component>(entity), viewB.template get<const Component>(entity)))
+				return false;
+		}
+		return true;
+	}
+
+	auto sameScene(const entt::registry& a, const entt::registry& b) -> bool
+	{
+		return sameEntities(a, b) &&
+			sameComponents<Transform>(a, b, [](const Transform& x, const Transform& y) {
+				return x.getLocalPosition() == y.getLocalPosition() && x.getLocalOrientation() == y.getLocalOrientation() &&
+					x.getLocalScale() == y.getLocalScale() && x.getEntityId() == y.getEntityId();
+			}) &&
+			sameComponents<NameComponent>(a, b, [](const NameComponent& x, const NameComponent& y) {
+				return x.name == y.name && x.getEntityId() == y.getEntityId();
+			}) &&
+			sameComponents<ActiveComponent>(a, b, [](const ActiveComponent& x, const ActiveComponent& y) {
+				return x.active == y.active && x.getEntityId() == y.getEntityId();
+			});
+	}
+
+	//best of a few loads into a fresh registry, the file is in the page cache after the first one
+	template<typename Load>
+	auto time(Load&& load, int32_t runs) -> double
+	{
+		double best = INFINITY;
+		for (int32_t i = 0; i < runs; i++)
+		{
+			entt::registry registry;
+			const auto start = std::chrono::high_resolution_clock::now();
+			load(registry);
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 20000;
+	const std::filesystem::path directory = argc > 2 ? std::filesystem::path(argv[2]) : std::filesystem::temp_directory_path();
+	const auto jsonFile = (directory / "SceneLoadBenchmark.scene").string();
+	const auto binaryFile = (directory / "SceneLoadBenchmark").concat(Serialization::BINARY_SCENE_EXTENSION).string();
+
+	{
+		entt::registry registry;
+		createScene(registry, count);
+		writeJson(registry, jsonFile);
+	}
+
+	//Serialization::convertToBinary
+	entt::registry fromJson;
+	loadJson(fromJson, jsonFile);
+	writeBinary(fromJson, binaryFile);
+
+	entt::registry fromBinary;
+	bool passed = loadBinary(fromBinary, binaryFile);
+	passed &= sameScene(fromJson, fromBinary);
+	printf("json and .mscene registries : %s\n", passed ? "same" : "DIFFERENT");
+
+	const int32_t runs = 5;
+	const double jsonMs = time([&](entt::registry& registry) { loadJson(registry, jsonFile); }, runs);
+	const double binaryMs = time([&](entt::registry& registry) { loadBinary(registry, binaryFile); }, runs);
+	printf("%u entities : json %.2f ms (%.1f KB), .mscene %.2f ms (%.1f KB), x%.1f\n", count,
+		jsonMs, std::filesystem::file_size(jsonFile) / 1024.0, binaryMs, std::filesystem::file_size(binaryFile) / 1024.0, jsonMs / binaryMs);
+
+	std::filesystem::remove(jsonFile);
+	std::filesystem::remove(binaryFile);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
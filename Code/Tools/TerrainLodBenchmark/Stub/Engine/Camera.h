@@ -0,0 +1,32 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Math/Frustum.h"
+
+namespace Maple
+{
+	//the part of Camera the terrain uses, a fixed perspective projection
+	class Camera
+	{
+	public:
+		Camera(float fov, float near, float far, float aspect)
+			: projMatrix(glm::perspective(glm::radians(fov), aspect, near, far))
+		{
+		}
+
+		auto getFrustum(const glm::mat4& viewMatrix) -> const Frustum&
+		{
+			frustum.from(projMatrix * viewMatrix);
+			return frustum;
+		}
+
+	private:
+		glm::mat4 projMatrix;
+		Frustum frustum;
+	};
+};
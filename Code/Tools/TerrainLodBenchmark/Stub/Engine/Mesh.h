@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Engine/Vertex.h"
+#include "Engine/VertexFormat.h"
+#include "Engine/Vulkan/IndexBuffer.h"
+#include "Engine/Vulkan/VertexBuffer.h"
+
+namespace Maple
+{
+	enum MeshType
+	{
+		MESH,
+		TERRAIN,
+	};
+
+	class Texture;
+	class BoundingBox;
+
+	//the part of Mesh the terrain uses, without the renderer
+	class Mesh
+	{
+	public:
+		Mesh() = default;
+		virtual ~Mesh() = default;
+
+		inline auto getSize() { return size; }
+		inline auto& getIndexBuffer() { return indexBuffer; }
+		inline auto& getVertexBuffer() { return vertexBuffer; }
+		inline auto& getAttributeBuffer() { return attributeBuffer; }
+		inline auto& getBoundingBox() const { return boundingBox; }
+
+		//same streams as the engine
+		auto setVertices(const Vertex* vertices, uint32_t count) -> void
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<VertexFormat::PackedAttributes> attributes;
+			VertexFormat::pack(vertices, count, positions, attributes);
+			vertexBuffer->resize(sizeof(glm::vec3) * count, positions.data());
+			attributeBuffer->resize(sizeof(VertexFormat::PackedAttributes) * count, attributes.data());
+		}
+
+		virtual auto getType() -> MeshType { return MESH; }
+
+	protected:
+		std::shared_ptr<IndexBuffer> indexBuffer;
+		std::shared_ptr<VertexBuffer> vertexBuffer;
+		std::shared_ptr<VertexBuffer> attributeBuffer;
+		std::shared_ptr<BoundingBox> boundingBox;
+
+		uint32_t size = 0;
+	};
+};
@@ -0,0 +1,26 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "VulkanBuffer.h"
+
+namespace Maple
+{
+	class IndexBuffer : public VulkanBuffer
+	{
+	public:
+		IndexBuffer(const uint32_t* data, uint32_t count)
+			: count(count)
+		{
+			setData(sizeof(uint32_t) * count, data);
+		}
+
+		inline auto getCount() const { return count; }
+		inline auto setCount(uint32_t indexCount) { count = indexCount; }
+
+	private:
+		uint32_t count;
+	};
+};
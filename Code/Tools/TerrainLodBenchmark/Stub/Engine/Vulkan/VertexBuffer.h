@@ -0,0 +1,14 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "VulkanBuffer.h"
+
+namespace Maple
+{
+	class VertexBuffer : public VulkanBuffer
+	{
+	};
+};
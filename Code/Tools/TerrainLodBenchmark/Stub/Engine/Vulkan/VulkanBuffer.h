@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Maple
+{
+	struct BufferRange
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	//the part of VulkanBuffer the terrain uses, the device memory is a vector and every upload is counted.
+	class VulkanBuffer
+	{
+	public:
+		virtual ~VulkanBuffer() = default;
+
+		auto setData(uint32_t size, const void* data, uint32_t offset = 0) -> void
+		{
+			if (offset + size > memory.size())
+				memory.resize(offset + size);
+			if (data != nullptr)
+				std::memcpy(memory.data() + offset, data, size);
+			uploadedBytes += size;
+			uploads++;
+		}
+
+		auto setDataRanges(const void* data, const std::vector<BufferRange>& ranges) -> void
+		{
+			for (auto& range : ranges)
+			{
+				std::memcpy(memory.data() + range.offset, static_cast<const uint8_t*>(data) + range.offset, range.size);
+				uploadedBytes += range.size;
+			}
+			uploadedRanges += ranges.size();
+			uploads++;
+		}
+
+		//a new buffer, the old content is gone
+		virtual auto resize(uint32_t size, const void* data) -> void
+		{
+			memory.assign(size, 0);
+			if (data != nullptr)
+				setData(size, data);
+		}
+
+		inline auto getSize() const { return static_cast<uint64_t>(memory.size()); }
+		inline auto& getMemory() const { return memory; }
+
+		inline auto resetStats()
+		{
+			uploadedBytes = 0;
+			uploadedRanges = 0;
+			uploads = 0;
+		}
+
+		uint64_t uploadedBytes = 0;
+		uint64_t uploadedRanges = 0;
+		uint32_t uploads = 0;
+
+	protected:
+		std::vector<uint8_t> memory;
+	};
+};
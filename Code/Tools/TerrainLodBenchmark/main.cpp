@@ -0,0 +1,213 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Times the incremental lod of QuadCollapseMesh on a fly-through over a height field : the vertices uploaded
+//per frame against the rebuild it replaced, which uploaded 6 vertices for every active quad, and the time of update().
+//The buffers in Stub keep the device memory in vectors, so at the end of every flight the slots in the buffers are
+//checked against a rebuild of the lod from scratch at the same camera.
+//usage : TerrainLodBenchmark [height field size] [frames]
+//returns 0 if the uploaded slots always match the rebuild.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "Terrain/QuadCollapseMesh.h"
+#include "Engine/Camera.h"
+#include "Others/Console.h"
+
+namespace Maple
+{
+	std::shared_ptr<spdlog::logger> Console::logger = spdlog::default_logger();
+};
+
+using namespace Maple;
+
+namespace
+{
+	constexpr float ALTITUDE = 300.f;
+	constexpr float PITCH = -0.35f;
+
+	struct Quad
+	{
+		glm::vec3 positions[4];
+		VertexFormat::PackedAttributes attributes[4];
+	};
+
+	struct Flight
+	{
+		double ms = 0.0;
+		double maxMs = 0.0;
+		uint64_t uploaded = 0;
+		uint64_t rebuilt = 0;
+		uint32_t maxUploaded = 0;
+		uint64_t ranges = 0;
+	};
+
+	//hills and ridges, quantised to the 8 bits of the red channel TerrainBuilder reads
+	auto heightAt(int32_t x, int32_t y) -> float
+	{
+		const float fx = static_cast<float>(x);
+		const float fy = static_cast<float>(y);
+		float h = 128.f
+			+ 60.f * std::sin(fx * 0.0031f) * std::cos(fy * 0.0027f)
+			+ 30.f * std::sin(fx * 0.011f + fy * 0.007f)
+			+ 12.f * std::sin(fx * 0.043f) * std::sin(fy * 0.037f)
+			+ 4.f * std::cos(fx * 0.17f + fy * 0.13f);
+		return std::floor(std::min(std::max(h, 0.f), 255.f));
+	}
+
+	//same layout as TerrainBuilder::build
+	auto createVertices(int32_t size) -> std::vector<Vertex>
+	{
+		std::vector<Vertex> vertices(static_cast<size_t>(size) * size);
+		for (int32_t x = 0; x < size; x++)
+		{
+			for (int32_t y = 0; y < size; y++)
+			{
+				auto& vertex = vertices[static_cast<size_t>(x) * size + y];
+				const float height = heightAt(x, y);
+				vertex.pos = { x, y, height };
+				vertex.color = { height, height, height, 255.f };
+				vertex.texCoord = { x / (size - 1.f), y / (size - 1.f) };
+				vertex.normal = glm::normalize(glm::vec3{ (heightAt(x - 1, y) - heightAt(x + 1, y)) / 255.f, (heightAt(x, y - 1) - heightAt(x, y + 1)) / 255.f, 2.f });
+				vertex.tangent = {};
+			}
+		}
+		return vertices;
+	}
+
+	//a circle around the middle of the field, looking along it and down
+	auto viewAt(int32_t size, float distance) -> glm::mat4
+	{
+		const glm::vec2 center(size * 0.5f);
+		const float radius = size * 0.3f;
+		const float angle = distance / radius;
+		const glm::vec3 eye(center + radius * glm::vec2(std::cos(angle), std::sin(angle)), ALTITUDE);
+		const glm::vec2 along(-std::sin(angle), std::cos(angle));
+		const glm::vec3 forward(along * std::cos(PITCH), std::sin(PITCH));
+		return glm::lookAt(eye, eye + forward, { 0.f, 0.f, 1.f });
+	}
+
+	auto isFreed(const glm::vec3* positions, const VertexFormat::PackedAttributes* attributes) -> bool
+	{
+		const Quad freed{};
+		return std::memcmp(positions, freed.positions, sizeof(freed.positions)) == 0 && std::memcmp(attributes, freed.attributes, sizeof(freed.attributes)) == 0;
+	}
+
+	auto activeQuads(QuadCollapseMesh& mesh) -> uint32_t
+	{
+		auto positions = reinterpret_cast<const glm::vec3*>(mesh.getVertexBuffer()->getMemory().data());
+		auto attributes = reinterpret_cast<const VertexFormat::PackedAttributes*>(mesh.getAttributeBuffer()->getMemory().data());
+		uint32_t count = 0;
+		for (uint32_t slot = 0; slot < mesh.getSize() / 6; slot++)
+			count += !isFreed(positions + slot * 4, attributes + slot * 4);
+		return count;
+	}
+
+	//the quads drawn from the buffers, in the order of their content, the freed slots are left out
+	auto readQuads(QuadCollapseMesh& mesh) -> std::vector<Quad>
+	{
+		const uint32_t count = mesh.getSize() / 6;
+		auto positions = reinterpret_cast<const glm::vec3*>(mesh.getVertexBuffer()->getMemory().data());
+		auto attributes = reinterpret_cast<const VertexFormat::PackedAttributes*>(mesh.getAttributeBuffer()->getMemory().data());
+
+		std::vector<Quad> quads;
+		for (uint32_t slot = 0; slot < count; slot++)
+		{
+			if (isFreed(positions + slot * 4, attributes + slot * 4))
+				continue;
+			Quad quad;
+			std::copy_n(positions + slot * 4, 4, quad.positions);
+			std::copy_n(attributes + slot * 4, 4, quad.attributes);
+			quads.emplace_back(quad);
+		}
+		std::sort(quads.begin(), quads.end(), [](const Quad& a, const Quad& b) {
+			return std::memcmp(&a, &b, sizeof(Quad)) < 0;
+		});
+		return quads;
+	}
+
+	auto same(const std::vector<Quad>& a, const std::vector<Quad>& b) -> bool
+	{
+		return a.size() == b.size() && std::memcmp(a.data(), b.data(), sizeof(Quad) * a.size()) == 0;
+	}
+
+	auto fly(QuadCollapseMesh& mesh, Camera& camera, int32_t size, float speed, uint32_t frames) -> bool
+	{
+		auto& vertexBuffer = mesh.getVertexBuffer();
+		Flight flight;
+
+		//the first frame builds the slots, it is not part of the flight
+		mesh.update(&camera, viewAt(size, 0.f));
+		vertexBuffer->resetStats();
+
+		for (uint32_t frame = 1; frame <= frames; frame++)
+		{
+			const auto view = viewAt(size, speed * frame);
+			const auto start = std::chrono::high_resolution_clock::now();
+			mesh.update(&camera, view);
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+			flight.ms += ms;
+			flight.maxMs = std::max(flight.maxMs, ms);
+			flight.uploaded += mesh.getUploadedVertices();
+			flight.rebuilt += activeQuads(mesh) * 6;
+			flight.maxUploaded = std::max(flight.maxUploaded, mesh.getUploadedVertices());
+		}
+		flight.ranges = vertexBuffer->uploadedRanges;
+
+		//the bytes which went to the buffer are the vertices update() reported
+		bool ok = vertexBuffer->uploadedBytes == flight.uploaded * sizeof(glm::vec3);
+		ok &= mesh.getIndexBuffer()->getCount() == mesh.getSize();
+		const auto incremental = readQuads(mesh);
+
+		//the full height field, then the lod again from empty slots at the same camera
+		const auto view = viewAt(size, speed * frames);
+		mesh.setLod(false);
+		mesh.update(&camera, view);
+		mesh.setLod(true);
+		mesh.update(&camera, view);
+		ok &= mesh.getUploadedVertices() == mesh.getSize() / 6 * 4;
+		const auto rebuilt = readQuads(mesh);
+		ok &= !rebuilt.empty() && same(incremental, rebuilt);
+
+		printf("%g units/frame : %.0f vertices uploaded per frame (max %u, %.1f ranges), "
+			"the old rebuild %.0f (%.1f%%), update %.2f ms (max %.2f), %zu quads %s\n",
+			speed, static_cast<double>(flight.uploaded) / frames, flight.maxUploaded, static_cast<double>(flight.ranges) / frames,
+			static_cast<double>(flight.rebuilt) / frames, 100.0 * flight.uploaded / flight.rebuilt, flight.ms / frames, flight.maxMs,
+			rebuilt.size(), ok ? "ok" : "WRONG");
+		return ok;
+	}
+};
+
+int main(int argc, char** argv)
+{
+	const int32_t size = argc > 1 ? std::atoi(argv[1]) : 4097;
+	const uint32_t frames = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 600;
+
+	QuadCollapseMesh mesh;
+	const auto start = std::chrono::high_resolution_clock::now();
+	if (!mesh.build(createVertices(size), size, size))
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+	mesh.setLod(true);
+	printf("%dx%d height field, built in %.0f ms, %u frames per flight\n", size, size,
+		std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count(), frames);
+
+	Camera camera(60.f, 0.1f, 3000.f, 16.f / 9.f);
+	bool passed = true;
+	for (float speed : { 1.f, 4.f, 9.f })
+		passed &= fly(mesh, camera, size, speed, frames);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the Maple Engine                              //
+// Copyright ?2020-2022 Tian Zeng                                           //
+//////////////////////////////////////////////////////////////////////////////
+
+//Checks the work-stealing scheduler and times addTask against the pool it replaced (see Reference.h).
+//usage : ThreadPoolCheck [task count]
+//returns 0 if every test passes.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "Thread/ThreadPool.h"
+#include "Thread/WorkStealingQueue.h"
+#include "Application.h"
+#include "Reference.h"
+
+using namespace Maple;
+
+namespace
+{
+	//same count as Application
+	auto workerCount() -> int32_t
+	{
+		return std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+	}
+
+	//owner side alone : LIFO pop, FIFO steal, push fails once the queue is full
+	auto checkQueueSerial() -> bool
+	{
+		constexpr int64_t capacity = 64;
+		WorkStealingQueue<int32_t, capacity> queue;
+		std::vector<int32_t> items(capacity + 1);
+
+		bool passed = queue.empty() && queue.pop() == nullptr && queue.steal() == nullptr;
+		for (int64_t i = 0; i < capacity; i++)
+			passed &= queue.push(&items[i]);
+		passed &= !queue.push(&items[capacity]);
+
+		passed &= queue.steal() == &items[0];
+		passed &= queue.steal() == &items[1];
+		for (int64_t i = capacity - 1; i >= 2; i--)
+			passed &= queue.pop() == &items[i];
+		passed &= queue.empty() && queue.pop() == nullptr && queue.steal() == nullptr;
+
+		printf("WorkStealingQueue serial : %s\n", passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//the owner pushes and pops while thieves steal, every item has to come out exactly once
+	auto checkQueueConcurrent() -> bool
+	{
+		constexpr int32_t count = 1 << 20;
+		const int32_t thieves = std::max(workerCount(), 2);
+		WorkStealingQueue<int32_t> queue;
+		std::vector<int32_t> items(count);
+		std::vector<std::atomic<int32_t>> taken(count);
+		for (int32_t i = 0; i < count; i++)
+			items[i] = i;
+
+		std::atomic<bool> done{ false };
+		std::atomic<int32_t> stolen{ 0 };
+		std::vector<std::thread> threads;
+		for (int32_t t = 0; t < thieves; t++)
+		{
+			threads.emplace_back([&]() {
+				while (!done.load(std::memory_order_acquire) || !queue.empty())
+				{
+					if (auto item = queue.steal())
+					{
+						taken[*item].fetch_add(1, std::memory_order_relaxed);
+						stolen.fetch_add(1, std::memory_order_relaxed);
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		int32_t next = 0;
+		while (next < count)
+		{
+			//bursts of pushes, then pop about half of them back
+			for (int32_t i = 0; i < 64 && next < count; i++)
+			{
+				if (queue.push(&items[next]))
+					next++;
+			}
+			for (int32_t i = 0; i < 32; i++)
+			{
+				if (auto item = queue.pop())
+					taken[*item].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		while (auto item = queue.pop())
+			taken[*item].fetch_add(1, std::memory_order_relaxed);
+
+		done.store(true, std::memory_order_release);
+		for (auto& thread : threads)
+			thread.join();
+
+		int32_t wrong = 0;
+		for (auto& count : taken)
+			wrong += count.load() != 1;
+
+		printf("WorkStealingQueue concurrent : %d items, %d stolen by %d threads, %d not taken exactly once\n", count, stolen.load(), thieves, wrong);
+		return wrong == 0;
+	}
+
+	auto checkParallelFor(ThreadPool& pool) -> bool
+	{
+		constexpr int32_t count = 1 << 20;
+		std::vector<std::atomic<int32_t>> hits(count);
+		pool.parallelFor(0, count, [&](int32_t i) {
+			hits[i].fetch_add(1, std::memory_order_relaxed);
+		});
+
+		int32_t wrong = 0;
+		for (auto& hit : hits)
+			wrong += hit.load() != 1;
+
+		//the ranges cover [begin, end) without overlap and respect the grain size
+		std::atomic<int64_t> covered{ 0 };
+		std::atomic<int32_t> smallRanges{ 0 };
+		pool.parallelRange(100, 100 + count, [&](int32_t begin, int32_t end) {
+			covered.fetch_add(static_cast<int64_t>(end - begin), std::memory_order_relaxed);
+			if (end - begin < 1000 && end != 100 + count)
+				smallRanges.fetch_add(1, std::memory_order_relaxed);
+		}, 1000);
+
+		bool emptyCalled = false;
+		pool.parallelFor(5, 5, [&](int32_t) { emptyCalled = true; });
+
+		const bool passed = wrong == 0 && covered.load() == count && smallRanges.load() == 0 && !emptyCalled;
+		printf("parallelFor : %d indices, %d not run exactly once, %s\n", count, wrong, passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	auto fib(ThreadPool& pool, int32_t n) -> int64_t
+	{
+		if (n < 16)
+			return n < 2 ? n : fib(pool, n - 1) + fib(pool, n - 2);
+
+		int64_t a = 0;
+		TaskGroup group(pool);
+		group.run([&]() { a = fib(pool, n - 1); });
+		const int64_t b = fib(pool, n - 2);
+		group.wait();
+		return a + b;
+	}
+
+	//groups waited on from inside jobs, the waiting threads have to keep running other jobs
+	auto checkNested(ThreadPool& pool) -> bool
+	{
+		const int64_t result = fib(pool, 30);
+		const bool passed = result == 832040;
+		printf("nested TaskGroup fib(30) : %lld %s\n", static_cast<long long>(result), passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	//waitAll returns after every job, including jobs added by jobs, and complete runs on the main thread
+	auto checkTasks(ThreadPool& pool) -> bool
+	{
+		constexpr int32_t count = 2000;
+		std::atomic<int32_t> ran{ 0 };
+		std::atomic<int32_t> wrongThread{ 0 };
+		int64_t sum = 0;
+		const auto mainThread = std::this_thread::get_id();
+
+		for (int32_t i = 0; i < count; i++)
+		{
+			pool.addTask([&, i]() -> void* {
+				ran.fetch_add(1, std::memory_order_relaxed);
+				if (i % 2 == 0)
+				{
+					pool.addTask([&]() -> void* {
+						ran.fetch_add(1, std::memory_order_relaxed);
+						return nullptr;
+					});
+				}
+				return reinterpret_cast<void*>(static_cast<intptr_t>(i));
+			}, [&](void* result) {
+				if (std::this_thread::get_id() != mainThread)
+					wrongThread.fetch_add(1);
+				sum += reinterpret_cast<intptr_t>(result);
+			});
+		}
+		pool.waitAll();
+
+		const int32_t jobs = ran.load();
+		const int32_t completes = Application::get()->executeAll();
+		const int64_t expected = static_cast<int64_t>(count) * (count - 1) / 2;
+		const bool passed = jobs == count + count / 2 && completes == count && sum == expected && wrongThread.load() == 0;
+		printf("addTask : %d jobs run before waitAll returned, %d completes on the main thread, %s\n", jobs, completes, passed ? "ok" : "WRONG");
+		return passed;
+	}
+
+	template<typename Pool>
+	auto tasksPerSecond(Pool& pool, int32_t count) -> double
+	{
+		std::atomic<int32_t> ran{ 0 };
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (int32_t i = 0; i < count; i++)
+		{
+			pool.addTask([&]() -> void* {
+				ran.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			});
+		}
+		pool.waitAll();
+		const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		return ran.load() == count ? count / seconds : 0.0;
+	}
+
+	auto benchmark(int32_t count) -> void
+	{
+		double current = 0.0;
+		double reference = 0.0;
+		{
+			ThreadPool pool(workerCount());
+			tasksPerSecond(pool, count / 10);
+			current = tasksPerSecond(pool, count);
+		}
+		{
+			Reference::ThreadPool pool(workerCount());
+			tasksPerSecond(pool, count / 10);
+			reference = tasksPerSecond(pool, count);
+		}
+		printf("addTask %d empty tasks, %d workers : %.0f tasks/s, old pool %.0f tasks/s (x%.2f)\n",
+			count, workerCount(), current, reference, reference > 0.0 ? current / reference : 0.0);
+	}
+};
+
+int main(int argc, char** argv)
+{
+	bool passed = checkQueueSerial();
+	passed &= checkQueueConcurrent();
+	{
+		ThreadPool pool(workerCount());
+		passed &= checkParallelFor(pool);
+		passed &= checkNested(pool);
+		passed &= checkTasks(pool);
+	}
+
+	benchmark(argc > 1 ? std::atoi(argv[1]) : 200000);
+
+	printf("%s\n", passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}